@@ -0,0 +1,386 @@
+/**
+ * @file bench_checker.c
+ * @brief Checker throughput benchmark against the loopback mock farm
+ * @version 1.0.0
+ *
+ * Runs full sweeps over thousands of virtual hosts for every engine and
+ * thread count and reports checks/sec and sweep time percentiles.
+ * With --dying, some healthy hosts go dark after the warm-up sweeps, as
+ * mirrors with a good latency history that suddenly stop answering.
+ * With --loss, healthy hosts drop that share of requests, which the
+ * "retry" engine recovers with retries and hedged requests. The
+ * "priority" engine is "fastest" with servers checked best-first by their
+ * warm-up history and a short timeout for hosts that were dead throughout.
+ * The "autotune" engine starts at each thread count and lets the pool
+ * tune itself; the thread count it settled on is shown after the row.
+ */
+
+#include "bench_common.h"
+#include "../include/checker.h"
+#include "../include/uring.h"
+#include "../tests/mock_farm.h"
+#include <curl/curl.h>
+#include <getopt.h>
+
+#define BENCH_DEFAULT_HOSTS 2000
+#define BENCH_DEFAULT_SWEEPS 5
+#define BENCH_MAX_THREAD_COUNTS 16
+
+/**
+ * @brief Check engine under test
+ */
+typedef struct {
+    const char *name;
+    void (*configure)(CheckerConfig *config);
+    bool (*available)(void);        // Skipped when this returns false (NULL = always)
+} BenchEngine;
+
+static void configure_curl(CheckerConfig *config) {
+    UNUSED(config);
+}
+
+static void configure_tcp(CheckerConfig *config) {
+    config->engine = CHECK_ENGINE_TCP;
+}
+
+static void configure_adaptive(CheckerConfig *config) {
+    static AdaptiveTimeoutPolicy policy;
+    policy = checker_get_default_adaptive_timeout();
+    config->adaptive_timeout = &policy;
+}
+
+static void configure_fastest(CheckerConfig *config) {
+    config->top_k = 10;
+}
+
+static void configure_priority(CheckerConfig *config) {
+    config->top_k = 10;
+    config->prioritize = true;
+    config->dead_timeout_ms = 250;
+}
+
+static void configure_autotune(CheckerConfig *config) {
+    config->autotune_threads = true;
+}
+
+static RetryBudget *g_retry_budget;
+
+static void configure_retry(CheckerConfig *config) {
+    if (!g_retry_budget) {
+        RetryConfig retry = retry_get_default_config();
+        retry.max_retries = 2;
+        retry.hedge_quantile = 0.95;
+        g_retry_budget = retry_budget_create(&retry);
+    }
+    config->retry = g_retry_budget;
+}
+
+static void configure_uring(CheckerConfig *config) {
+    config->io_uring = true;
+}
+
+static void configure_uring_tcp(CheckerConfig *config) {
+    config->engine = CHECK_ENGINE_TCP;
+    config->io_uring = true;
+}
+
+static const BenchEngine g_engines[] = {
+    { "curl", configure_curl, NULL },
+    { "tcp", configure_tcp, NULL },
+    { "adaptive", configure_adaptive, NULL },
+    { "fastest", configure_fastest, NULL },
+    { "priority", configure_priority, NULL },
+    { "retry", configure_retry, NULL },
+    { "autotune", configure_autotune, NULL },
+    { "uring", configure_uring, uring_available },
+    { "tcp-uring", configure_uring_tcp, uring_available },
+};
+
+/**
+ * @brief Benchmark options
+ */
+typedef struct {
+    size_t hosts;
+    int sweeps;
+    int thread_counts[BENCH_MAX_THREAD_COUNTS];
+    size_t thread_count_n;
+    int timeout_seconds;
+    double latency_ms;              // Median host latency
+    double error_pct;               // Hosts answering 503
+    double reset_pct;               // Hosts resetting the connection
+    double blackhole_pct;           // Hosts never answering
+    double dying_pct;               // Healthy hosts that stop answering after the warm-up
+    double loss_pct;                // Requests dropped by healthy hosts
+} BenchOptions;
+
+/**
+ * @brief Whether a healthy host goes dark after the warm-up sweeps
+ */
+static bool host_dies(const BenchOptions *opts, size_t host) {
+    return (double)((host * 104729) % 10000) / 100.0 < opts->dying_pct;
+}
+
+/**
+ * @brief Assign behaviors and latency distributions to the virtual hosts
+ *
+ * Hosts get a deterministic mix: medians spread around the configured
+ * latency and a fixed share of errors, resets and blackholes.
+ */
+static void assign_profiles(MockFarm *farm, const BenchOptions *opts) {
+    for (size_t i = 0; i < opts->hosts; i++) {
+        double slot = (double)((i * 7919) % 10000) / 100.0;  // Spread classes over hosts
+        MockHostProfile profile = {
+            .behavior = MOCK_RESPOND,
+            .status_code = 200,
+            .latency_ms = opts->latency_ms * (0.5 + (double)(i % 16) / 10.0),
+            .latency_sigma = 0.5,
+            .loss_pct = opts->loss_pct
+        };
+
+        if (host_dies(opts, i)) {
+            // Stays healthy; its server is pointed at the dead host instead
+        } else if (slot < opts->blackhole_pct) {
+            profile.behavior = MOCK_BLACKHOLE;
+        } else if (slot < opts->blackhole_pct + opts->reset_pct) {
+            profile.behavior = MOCK_RESET;
+        } else if (slot < opts->blackhole_pct + opts->reset_pct + opts->error_pct) {
+            profile.status_code = 503;
+        }
+        mock_farm_set_profile(farm, i, &profile);
+    }
+
+    // Extra virtual host that dying servers switch to
+    const MockHostProfile dead = { .behavior = MOCK_BLACKHOLE };
+    mock_farm_set_profile(farm, opts->hosts, &dead);
+}
+
+/**
+ * @brief Point dying servers at their live host (false) or the dead one (true)
+ */
+static void set_dying(ServerCategory *category, const MockFarm *farm, const BenchOptions *opts,
+                      bool dead) {
+    char dead_url[MAX_URL_LENGTH]; /* flawfinder: ignore - bounds checked in mock_farm_url */
+    mock_farm_url(farm, opts->hosts, dead_url, sizeof(dead_url));
+    for (size_t i = 0; i < category->count; i++) {
+        if (host_dies(opts, i)) {
+            snprintf(category->servers[i].url, sizeof(category->servers[i].url), "%s", // flawfinder: ignore
+                     dead ? dead_url : category->urls[i]);
+        }
+    }
+}
+
+/**
+ * @brief Parse a comma-separated thread count list
+ */
+static int parse_thread_counts(const char *arg, BenchOptions *opts) {
+    opts->thread_count_n = 0;
+    const char *p = arg;
+    while (*p && opts->thread_count_n < BENCH_MAX_THREAD_COUNTS) {
+        char *end;
+        long val = strtol(p, &end, 10);
+        if (end == p || val < MIN_THREADS || val > MAX_THREADS) {
+            return BDIX_ERROR_INVALID_INPUT;
+        }
+        opts->thread_counts[opts->thread_count_n++] = (int)val;
+        p = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != '\0') {
+            return BDIX_ERROR_INVALID_INPUT;
+        }
+    }
+    return opts->thread_count_n > 0 ? BDIX_SUCCESS : BDIX_ERROR_INVALID_INPUT;
+}
+
+/* flawfinder: ignore - all printf calls below use compile-time constant format strings */
+static void print_usage(const char *program) {
+    printf("Usage: %s [OPTIONS]\n\n", program); // flawfinder: ignore
+    printf("  --hosts N          Virtual hosts, at most %d (default: %d)\n", // flawfinder: ignore
+           MAX_SERVERS_PER_CATEGORY, BENCH_DEFAULT_HOSTS);
+    printf("  --sweeps N         Measured sweeps per run (default: %d)\n", BENCH_DEFAULT_SWEEPS); // flawfinder: ignore
+    printf("  --threads LIST     Thread counts, e.g. 8,16,32,64 (default)\n"); // flawfinder: ignore
+    printf("  --timeout SEC      Checker timeout (default: 1)\n"); // flawfinder: ignore
+    printf("  --latency MS       Median host latency (default: 5)\n"); // flawfinder: ignore
+    printf("  --errors PCT       Hosts answering 503 (default: 3)\n"); // flawfinder: ignore
+    printf("  --resets PCT       Hosts resetting connections (default: 1)\n"); // flawfinder: ignore
+    printf("  --blackholes PCT   Hosts never answering (default: 0.5)\n"); // flawfinder: ignore
+    printf("  --dying PCT        Healthy hosts that stop answering after the warm-up (default: 0)\n"); // flawfinder: ignore
+    printf("  --loss PCT         Requests silently dropped by healthy hosts (default: 0)\n"); // flawfinder: ignore
+}
+
+static int parse_options(int argc, char *argv[], BenchOptions *opts) {
+    *opts = (BenchOptions){
+        .hosts = BENCH_DEFAULT_HOSTS,
+        .sweeps = BENCH_DEFAULT_SWEEPS,
+        .thread_counts = { 8, 16, 32, 64 },
+        .thread_count_n = 4,
+        .timeout_seconds = 1,
+        .latency_ms = 5.0,
+        .error_pct = 3.0,
+        .reset_pct = 1.0,
+        .blackhole_pct = 0.5,
+        .dying_pct = 0.0,
+        .loss_pct = 0.0
+    };
+
+    static struct option long_options[] = {
+        {"hosts",      required_argument, 0, 'H'},
+        {"sweeps",     required_argument, 0, 'S'},
+        {"threads",    required_argument, 0, 't'},
+        {"timeout",    required_argument, 0, 'T'},
+        {"latency",    required_argument, 0, 'l'},
+        {"errors",     required_argument, 0, 'e'},
+        {"resets",     required_argument, 0, 'r'},
+        {"blackholes", required_argument, 0, 'b'},
+        {"dying",      required_argument, 0, 'd'},
+        {"loss",       required_argument, 0, 'L'},
+        {"help",       no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1) { /* flawfinder: ignore */
+        switch (opt) {
+            case 'H': opts->hosts = (size_t)strtoul(optarg, NULL, 10); break;
+            case 'S': opts->sweeps = atoi(optarg); break;
+            case 'T': opts->timeout_seconds = atoi(optarg); break;
+            case 'l': opts->latency_ms = strtod(optarg, NULL); break;
+            case 'e': opts->error_pct = strtod(optarg, NULL); break;
+            case 'r': opts->reset_pct = strtod(optarg, NULL); break;
+            case 'b': opts->blackhole_pct = strtod(optarg, NULL); break;
+            case 'd': opts->dying_pct = strtod(optarg, NULL); break;
+            case 'L': opts->loss_pct = strtod(optarg, NULL); break;
+            case 't':
+                if (parse_thread_counts(optarg, opts) != BDIX_SUCCESS) {
+                    fprintf(stderr, "Error: invalid --threads '%s'\n", optarg); /* flawfinder: ignore */
+                    return BDIX_ERROR_INVALID_INPUT;
+                }
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                exit(EXIT_SUCCESS);
+            default:
+                print_usage(argv[0]);
+                return BDIX_ERROR_INVALID_INPUT;
+        }
+    }
+
+    if (opts->hosts == 0 || opts->sweeps <= 0 || opts->timeout_seconds <= 0) {
+        fprintf(stderr, "Error: --hosts, --sweeps and --timeout must be positive\n"); /* flawfinder: ignore */
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+    if (opts->hosts > MAX_SERVERS_PER_CATEGORY) {
+        fprintf(stderr, "Error: --hosts must not exceed %d (servers per category)\n", /* flawfinder: ignore */
+                MAX_SERVERS_PER_CATEGORY);
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+    return BDIX_SUCCESS;
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions opts;
+    if (parse_options(argc, argv, &opts) != BDIX_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    // Results go to the original stdout; checker progress output is discarded
+    FILE *report = bench_capture_stdout();
+    if (!report) {
+        fprintf(stderr, "Error: cannot set up output\n"); /* flawfinder: ignore */
+        return EXIT_FAILURE;
+    }
+
+    if (checker_init() != BDIX_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    MockFarm *farm = mock_farm_start(opts.hosts + 1);
+    if (!farm) {
+        checker_cleanup();
+        return EXIT_FAILURE;
+    }
+    assign_profiles(farm, &opts);
+
+    ServerCategory category;
+    server_category_init(&category, CATEGORY_FTP, "FTP");
+    for (size_t i = 0; i < opts.hosts; i++) {
+        char url[MAX_URL_LENGTH]; /* flawfinder: ignore - bounds checked in mock_farm_url */
+        mock_farm_url(farm, i, url, sizeof(url));
+        server_category_add(&category, url);
+    }
+
+    struct curl_slist *resolve = mock_farm_resolve_list(farm);
+    double *sweep_ms = safe_calloc((size_t)opts.sweeps, sizeof(double));
+
+    fprintf(report, "Checker benchmark: %zu hosts, %d sweeps, median latency %.1f ms, " // flawfinder: ignore
+            "%.1f%% errors, %.1f%% resets, %.1f%% blackholes, %.1f%% dying, %.1f%% loss, timeout %ds\n\n",
+            opts.hosts, opts.sweeps, opts.latency_ms, opts.error_pct, opts.reset_pct,
+            opts.blackhole_pct, opts.dying_pct, opts.loss_pct, opts.timeout_seconds);
+    fprintf(report, "%-10s %8s %12s %12s %12s %8s\n", // flawfinder: ignore
+            "engine", "threads", "checks/sec", "p50 sweep", "p99 sweep", "online");
+
+    for (size_t e = 0; e < sizeof(g_engines) / sizeof(g_engines[0]); e++) {
+        if (g_engines[e].available && !g_engines[e].available()) {
+            fprintf(report, "%-10s skipped: not available on this system\n", g_engines[e].name); // flawfinder: ignore
+            continue;
+        }
+        for (size_t t = 0; t < opts.thread_count_n; t++) {
+            CheckerConfig config = checker_get_default_config();
+            config.verbose = false;
+            config.timeout_seconds = opts.timeout_seconds;
+            config.connect_timeout_seconds = opts.timeout_seconds;
+            config.resolve = resolve;
+            g_engines[e].configure(&config);
+
+            // Unmeasured sweeps warm up the farm's accept queue and curl, and give
+            // every server enough latency history for adaptive timeouts and hedging
+            set_dying(&category, farm, &opts, false);
+            for (size_t i = 0; i < category.count; i++) {
+                category.servers[i].metrics = (ServerMetrics){0};
+            }
+            CheckerStats stats;
+            checker_stats_init(&stats);
+            unsigned warmups = config.adaptive_timeout ? config.adaptive_timeout->min_samples : 1;
+            if (config.retry) {
+                warmups = MAX(warmups, RETRY_HEDGE_MIN_SAMPLES);
+            }
+            if (config.dead_timeout_ms > 0) {
+                warmups = MAX(warmups, CHECKER_DEAD_MIN_SAMPLES);
+            }
+            for (unsigned w = 0; w < warmups; w++) {
+                checker_check_category(&category, &config, opts.thread_counts[t], &stats);
+            }
+            set_dying(&category, farm, &opts, true);
+
+            double total_ms = 0.0;
+            checker_stats_init(&stats);
+            for (int s = 0; s < opts.sweeps; s++) {
+                double start = get_time_ms();
+                checker_check_category(&category, &config, opts.thread_counts[t], &stats);
+                sweep_ms[s] = get_time_ms() - start;
+                total_ms += sweep_ms[s];
+            }
+
+            size_t checks = atomic_load(&stats.total_checked);
+            double p50 = bench_percentile(sweep_ms, (size_t)opts.sweeps, 0.50);
+            double p99 = bench_percentile(sweep_ms, (size_t)opts.sweeps, 0.99);
+            fprintf(report, "%-10s %8d %12.0f %10.1fms %10.1fms %7.1f%%", // flawfinder: ignore
+                    g_engines[e].name, opts.thread_counts[t],
+                    total_ms > 0.0 ? checks * 1000.0 / total_ms : 0.0, p50, p99,
+                    checks > 0 ? atomic_load(&stats.online_count) * 100.0 / checks : 0.0);
+            if (config.autotune_threads) {
+                fprintf(report, "  settled at %zu threads (peak %zu)", // flawfinder: ignore
+                        atomic_load(&stats.settled_threads), atomic_load(&stats.peak_threads));
+            }
+            fprintf(report, "\n"); // flawfinder: ignore
+            fflush(report);
+        }
+    }
+
+    free(sweep_ms);
+    retry_budget_destroy(g_retry_budget);
+    curl_slist_free_all(resolve);
+    server_category_free(&category);
+    mock_farm_stop(farm);
+    checker_cleanup();
+    fclose(report);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,47 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include "../include/common.h"
+#include <fcntl.h>
+
+/**
+ * @brief Nearest-rank percentile (sorts values in place)
+ */
+static inline double bench_percentile(double *values, size_t count, double q) {
+    if (count == 0) {
+        return 0.0;
+    }
+    for (size_t i = 1; i < count; i++) {
+        double v = values[i];
+        size_t j = i;
+        while (j > 0 && values[j - 1] > v) {
+            values[j] = values[j - 1];
+            j--;
+        }
+        values[j] = v;
+    }
+    size_t rank = (size_t)ceil(q * (double)count);
+    return values[rank > 0 ? rank - 1 : 0];
+}
+
+/**
+ * @brief Send stdout to /dev/null and return a stream on the original stdout
+ *
+ * The code under test logs progress to stdout; results go to the
+ * returned stream so they stay machine-readable.
+ */
+static inline FILE* bench_capture_stdout(void) {
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    if (saved < 0 || devnull < 0) {
+        if (saved >= 0) close(saved);
+        if (devnull >= 0) close(devnull);
+        return NULL;
+    }
+    dup2(devnull, STDOUT_FILENO);
+    close(devnull);
+    return fdopen(saved, "w");
+}
+
+#endif // BENCH_COMMON_H
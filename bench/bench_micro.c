@@ -0,0 +1,529 @@
+/**
+ * @file bench_micro.c
+ * @brief Microbenchmarks for the thread pool, statistics, server lists and config loading
+ * @version 1.0.0
+ *
+ * Results are written as JSON so runs of different versions can be
+ * compared; --baseline prints the change against an earlier run.
+ */
+
+#include "bench_common.h"
+#include "../include/checker.h"
+#include "../include/config.h"
+#include "../include/thread_pool.h"
+#include <getopt.h>
+#include <jansson.h>
+#include <pthread.h>
+
+#define BENCH_REPEATS 5
+#define BENCH_POOL_TASKS 200000
+#define BENCH_STATS_OPS 1000000
+#define BENCH_ADD_SERVERS MAX_SERVERS_PER_CATEGORY
+
+/**
+ * @brief Collected results
+ */
+typedef struct {
+    json_t *results;                // Array of result objects
+    int repeats;
+    bool quick;                     // Smaller workloads for smoke runs
+} BenchRun;
+
+/**
+ * @brief Record one result: median and best time per operation over the repeats
+ *
+ * @return The result object, owned by the run
+ */
+static json_t* bench_record(BenchRun *run, const char *name, json_t *params,
+                         size_t ops, double *elapsed_ms, int repeats) {
+    double best = elapsed_ms[0];
+    for (int i = 1; i < repeats; i++) {
+        best = elapsed_ms[i] < best ? elapsed_ms[i] : best;
+    }
+    double median = bench_percentile(elapsed_ms, (size_t)repeats, 0.5);
+
+    json_t *result = json_object();
+    json_object_set_new(result, "name", json_string(name));
+    json_object_set_new(result, "params", params ? params : json_object());
+    json_object_set_new(result, "ops", json_integer((json_int_t)ops));
+    json_object_set_new(result, "repeats", json_integer(repeats));
+    json_object_set_new(result, "median_ms", json_real(median));
+    json_object_set_new(result, "best_ms", json_real(best));
+    json_object_set_new(result, "ns_per_op", json_real(median * 1e6 / (double)ops));
+    json_object_set_new(result, "ops_per_sec", json_real(median > 0.0 ? ops * 1000.0 / median : 0.0));
+
+    char *text = json_dumps(json_object_get(result, "params"), JSON_SORT_KEYS | JSON_COMPACT);
+    fprintf(stderr, "  %-28s %-32s %10.1f ns/op\n", name, text ? text : "", /* flawfinder: ignore */
+            median * 1e6 / (double)ops);
+    free(text);
+    json_array_append_new(run->results, result);
+    return result;
+}
+
+/* ---------- thread_pool_add_work / thread_pool_wait ---------- */
+
+static void* noop_task(void *arg) {
+    atomic_fetch_add((_Atomic size_t*)arg, 1);
+    return NULL;
+}
+
+/**
+ * @brief Scheduling statistics of a pool as JSON
+ */
+static json_t* pool_stats_json(ThreadPool *pool) {
+    ThreadPoolStats stats;
+    if (thread_pool_get_stats(pool, &stats) != BDIX_SUCCESS) {
+        return json_object();
+    }
+
+    double busy_ms = 0.0;
+    double idle_ms = 0.0;
+    uint64_t wakeups = 0;
+    uint64_t empty_wakeups = 0;
+    for (size_t i = 0; i < stats.threads; i++) {
+        busy_ms += stats.workers[i].busy_ms;
+        idle_ms += stats.workers[i].idle_ms;
+        wakeups += stats.workers[i].wakeups;
+        empty_wakeups += stats.workers[i].empty_wakeups;
+    }
+    double contended = stats.lock_acquisitions > 0 ?
+                       (double)stats.lock_contended / (double)stats.lock_acquisitions : 0.0;
+    double busy = busy_ms + idle_ms > 0.0 ? busy_ms / (busy_ms + idle_ms) : 0.0;
+
+    json_t *json = json_object();
+    json_object_set_new(json, "queue_wait_p50_ms", json_real(thread_pool_histogram_quantile(&stats.queue_wait, 0.5)));
+    json_object_set_new(json, "queue_wait_p99_ms", json_real(thread_pool_histogram_quantile(&stats.queue_wait, 0.99)));
+    json_object_set_new(json, "run_p50_ms", json_real(thread_pool_histogram_quantile(&stats.run, 0.5)));
+    json_object_set_new(json, "lock_contended", json_real(contended));
+    json_object_set_new(json, "lock_wait_p99_ms", json_real(thread_pool_histogram_quantile(&stats.lock_wait, 0.99)));
+    json_object_set_new(json, "worker_busy", json_real(busy));
+    json_object_set_new(json, "worker_wakeups", json_integer((json_int_t)wakeups));
+    json_object_set_new(json, "empty_wakeups", json_integer((json_int_t)empty_wakeups));
+    json_object_set_new(json, "done_signals", json_integer((json_int_t)stats.done_signals));
+    json_object_set_new(json, "done_wakeups", json_integer((json_int_t)stats.done_wakeups));
+
+    thread_pool_stats_free(&stats);
+    return json;
+}
+
+/**
+ * @brief Per-task cost of submitting no-op work and waiting for it
+ *
+ * The pool statistics of the last repeat go into the result as "pool".
+ */
+static void bench_thread_pool(BenchRun *run) {
+    static const int thread_counts[] = { 1, 4, 16 };
+    size_t tasks = run->quick ? BENCH_POOL_TASKS / 20 : BENCH_POOL_TASKS;
+    double elapsed[BENCH_REPEATS];
+
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        json_t *pool_stats = NULL;
+        for (int r = 0; r < run->repeats; r++) {
+            ThreadPool *pool = thread_pool_create((size_t)thread_counts[t]);
+            _Atomic size_t done = 0;
+
+            double start = get_time_ms();
+            for (size_t i = 0; i < tasks; i++) {
+                thread_pool_add_work(pool, noop_task, (void*)&done);
+            }
+            thread_pool_wait(pool);
+            elapsed[r] = get_time_ms() - start;
+
+            if (r == run->repeats - 1) {
+                pool_stats = pool_stats_json(pool);
+            }
+            thread_pool_destroy(pool);
+        }
+
+        json_t *params = json_object();
+        json_object_set_new(params, "threads", json_integer(thread_counts[t]));
+        json_object_set_new(params, "tasks", json_integer((json_int_t)tasks));
+        json_t *result = bench_record(run, "thread_pool_add_work_wait", params, tasks, elapsed, run->repeats);
+        json_object_set_new(result, "pool", pool_stats);
+        fprintf(stderr, "  %-28s queue wait p99 %.3f ms, %.1f%% of locks contended, " /* flawfinder: ignore */
+                "workers %.0f%% busy, %lld empty wakeups, %lld done wakeups\n",
+                "", json_real_value(json_object_get(pool_stats, "queue_wait_p99_ms")),
+                json_real_value(json_object_get(pool_stats, "lock_contended")) * 100.0,
+                json_real_value(json_object_get(pool_stats, "worker_busy")) * 100.0,
+                (long long)json_integer_value(json_object_get(pool_stats, "empty_wakeups")),
+                (long long)json_integer_value(json_object_get(pool_stats, "done_wakeups")));
+    }
+}
+
+/**
+ * @brief Per-task cost of the same work submitted to a task group
+ */
+static void bench_thread_pool_group(BenchRun *run) {
+    static const int thread_counts[] = { 1, 4, 16 };
+    size_t tasks = run->quick ? BENCH_POOL_TASKS / 20 : BENCH_POOL_TASKS;
+    double elapsed[BENCH_REPEATS];
+
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        for (int r = 0; r < run->repeats; r++) {
+            ThreadPool *pool = thread_pool_create((size_t)thread_counts[t]);
+            ThreadPoolGroup *group = thread_pool_group_create(pool);
+            _Atomic size_t done = 0;
+
+            double start = get_time_ms();
+            for (size_t i = 0; i < tasks; i++) {
+                thread_pool_group_add_work(group, noop_task, (void*)&done);
+            }
+            thread_pool_group_wait(group);
+            elapsed[r] = get_time_ms() - start;
+
+            thread_pool_group_destroy(group);
+            thread_pool_destroy(pool);
+        }
+
+        json_t *params = json_object();
+        json_object_set_new(params, "threads", json_integer(thread_counts[t]));
+        json_object_set_new(params, "tasks", json_integer((json_int_t)tasks));
+        bench_record(run, "thread_pool_group_wait", params, tasks, elapsed, run->repeats);
+    }
+}
+
+static void noop_index(void *ctx, size_t index) {
+    UNUSED(index);
+    atomic_fetch_add((_Atomic size_t*)ctx, 1);
+}
+
+/**
+ * @brief Per-task cost of the same work handed out lazily as one range
+ */
+static void bench_thread_pool_range(BenchRun *run) {
+    static const int thread_counts[] = { 1, 4, 16 };
+    size_t tasks = run->quick ? BENCH_POOL_TASKS / 20 : BENCH_POOL_TASKS;
+    double elapsed[BENCH_REPEATS];
+
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        for (int r = 0; r < run->repeats; r++) {
+            ThreadPool *pool = thread_pool_create((size_t)thread_counts[t]);
+            _Atomic size_t done = 0;
+
+            double start = get_time_ms();
+            thread_pool_add_range(pool, noop_index, (void*)&done, tasks);
+            thread_pool_wait(pool);
+            elapsed[r] = get_time_ms() - start;
+
+            thread_pool_destroy(pool);
+        }
+
+        json_t *params = json_object();
+        json_object_set_new(params, "threads", json_integer(thread_counts[t]));
+        json_object_set_new(params, "tasks", json_integer((json_int_t)tasks));
+        bench_record(run, "thread_pool_range_wait", params, tasks, elapsed, run->repeats);
+    }
+}
+
+/* ---------- checker_stats_update under contention ---------- */
+
+typedef struct {
+    CheckerStats *stats;
+    size_t ops;
+    pthread_barrier_t *barrier;
+} StatsWorker;
+
+static void* stats_worker(void *arg) {
+    StatsWorker *w = (StatsWorker*)arg;
+    Server server;
+    memset(&server, 0, sizeof(server));
+
+    pthread_barrier_wait(w->barrier);
+    for (size_t i = 0; i < w->ops; i++) {
+        server.status = (i % 8 == 7) ? BDIX_STATUS_TIMEOUT : BDIX_STATUS_ONLINE;
+        server.latency_ms = 5.0 + (double)(i % 100);
+        checker_stats_update(w->stats, &server);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Cost of one statistics update with N threads updating the same counters
+ */
+static void bench_stats_update(BenchRun *run) {
+    static const int thread_counts[] = { 1, 2, 4, 8, 16 };
+    size_t per_thread = (run->quick ? BENCH_STATS_OPS / 20 : BENCH_STATS_OPS);
+    double elapsed[BENCH_REPEATS];
+
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        int n = thread_counts[t];
+        size_t ops = per_thread * (size_t)n;
+
+        for (int r = 0; r < run->repeats; r++) {
+            CheckerStats stats;
+            checker_stats_init(&stats);
+            pthread_barrier_t barrier;
+            pthread_barrier_init(&barrier, NULL, (unsigned)n + 1);
+
+            pthread_t threads[16];
+            StatsWorker workers[16];
+            for (int i = 0; i < n; i++) {
+                workers[i] = (StatsWorker){ &stats, per_thread, &barrier };
+                pthread_create(&threads[i], NULL, stats_worker, &workers[i]);
+            }
+
+            double start = get_time_ms();
+            pthread_barrier_wait(&barrier);
+            for (int i = 0; i < n; i++) {
+                pthread_join(threads[i], NULL);
+            }
+            elapsed[r] = get_time_ms() - start;
+            pthread_barrier_destroy(&barrier);
+
+            if (atomic_load(&stats.total_checked) != ops) {
+                fprintf(stderr, "Warning: lost statistics updates\n"); /* flawfinder: ignore */
+            }
+        }
+
+        json_t *params = json_object();
+        json_object_set_new(params, "threads", json_integer(n));
+        bench_record(run, "checker_stats_update", params, ops, elapsed, run->repeats);
+    }
+}
+
+/* ---------- server_category_add growth ---------- */
+
+/**
+ * @brief Cost of growing a category from empty to the per-category limit
+ */
+static void bench_category_add(BenchRun *run) {
+    size_t count = run->quick ? BENCH_ADD_SERVERS / 4 : BENCH_ADD_SERVERS;
+    double elapsed[BENCH_REPEATS];
+    char url[64]; /* flawfinder: ignore - bounds checked with snprintf */
+
+    for (int r = 0; r < run->repeats; r++) {
+        ServerCategory category;
+        server_category_init(&category, CATEGORY_FTP, "FTP");
+
+        double start = get_time_ms();
+        for (size_t i = 0; i < count; i++) {
+            snprintf(url, sizeof(url), "http://mirror%06zu.example.bd/", i); // flawfinder: ignore
+            server_category_add(&category, url);
+        }
+        elapsed[r] = get_time_ms() - start;
+
+        server_category_free(&category);
+    }
+
+    json_t *params = json_object();
+    json_object_set_new(params, "servers", json_integer((json_int_t)count));
+    bench_record(run, "server_category_add", params, count, elapsed, run->repeats);
+}
+
+/* ---------- config_load_from_file ---------- */
+
+/**
+ * @brief Write a config with urls entries spread over the three categories
+ */
+static int write_config(const char *path, size_t urls) {
+    FILE *f = fopen(path, "w"); /* flawfinder: ignore - temporary file created by mkstemp */
+    if (!f) {
+        return BDIX_ERROR;
+    }
+
+    static const char *const keys[] = { "ftp", "tv", "others" };
+    fputc('{', f);
+    for (size_t k = 0; k < 3; k++) {
+        fprintf(f, "%s\"%s\": [", k ? ", " : "", keys[k]); // flawfinder: ignore
+        for (size_t i = k; i < urls; i += 3) {
+            fprintf(f, "%s\"http://%s%06zu.example.bd/\"", i == k ? "" : ", ", keys[k], i); // flawfinder: ignore
+        }
+        fputc(']', f);
+    }
+    fputs("}\n", f);
+    return fclose(f) == 0 ? BDIX_SUCCESS : BDIX_ERROR;
+}
+
+/**
+ * @brief Cost of loading generated server lists of increasing size
+ *
+ * Lists above 3 * MAX_SERVERS_PER_CATEGORY are parsed in full but only
+ * that many servers are kept; "loaded" records how many were.
+ */
+static void bench_config_load(BenchRun *run) {
+    static const size_t sizes[] = { 1000, 10000, 100000 };
+    double elapsed[BENCH_REPEATS];
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        if (run->quick && sizes[s] > 10000) {
+            continue;
+        }
+
+        char path[] = "/tmp/bdix-bench-XXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0) {
+            continue;
+        }
+        close(fd);
+        if (write_config(path, sizes[s]) != BDIX_SUCCESS) {
+            unlink(path);
+            continue;
+        }
+
+        size_t loaded = 0;
+        for (int r = 0; r < run->repeats; r++) {
+            ServerData data = {0};
+            server_data_init(&data);
+
+            double start = get_time_ms();
+            config_load_from_file(path, &data);
+            elapsed[r] = get_time_ms() - start;
+
+            loaded = data.ftp.count + data.tv.count + data.others.count;
+            server_data_free(&data);
+        }
+        unlink(path);
+
+        json_t *params = json_object();
+        json_object_set_new(params, "urls", json_integer((json_int_t)sizes[s]));
+        json_object_set_new(params, "loaded", json_integer((json_int_t)loaded));
+        bench_record(run, "config_load_from_file", params, sizes[s], elapsed, run->repeats);
+    }
+}
+
+/* ---------- Baseline comparison ---------- */
+
+/**
+ * @brief Find the result with the same name and params in a previous run
+ */
+static json_t* find_baseline(json_t *baseline, json_t *result) {
+    json_t *entries = json_object_get(baseline, "results");
+    const char *name = json_string_value(json_object_get(result, "name"));
+    char *params = json_dumps(json_object_get(result, "params"), JSON_SORT_KEYS | JSON_COMPACT);
+    json_t *match = NULL;
+
+    size_t index;
+    json_t *entry;
+    json_array_foreach(entries, index, entry) {
+        const char *other = json_string_value(json_object_get(entry, "name"));
+        char *other_params = json_dumps(json_object_get(entry, "params"), JSON_SORT_KEYS | JSON_COMPACT);
+        bool same = name && other && params && other_params &&
+                    strcmp(name, other) == 0 && strcmp(params, other_params) == 0;
+        free(other_params);
+        if (same) {
+            match = entry;
+            break;
+        }
+    }
+    free(params);
+    return match;
+}
+
+/**
+ * @brief Print the change in ns/op against a previous run
+ */
+/* flawfinder: ignore - all fprintf calls below use compile-time constant format strings */
+static void compare_baseline(const BenchRun *run, const char *path) {
+    json_error_t error;
+    json_t *baseline = json_load_file(path, 0, &error);
+    if (!baseline) {
+        fprintf(stderr, "Cannot read baseline %s: %s\n", path, error.text); // flawfinder: ignore
+        return;
+    }
+
+    fprintf(stderr, "\nChange against %s (ns/op, negative is faster):\n", path); // flawfinder: ignore
+    size_t index;
+    json_t *result;
+    json_array_foreach(run->results, index, result) {
+        json_t *old = find_baseline(baseline, result);
+        if (!old) {
+            continue;
+        }
+        double now = json_number_value(json_object_get(result, "ns_per_op"));
+        double before = json_number_value(json_object_get(old, "ns_per_op"));
+        char *params = json_dumps(json_object_get(result, "params"), JSON_SORT_KEYS | JSON_COMPACT);
+        fprintf(stderr, "  %-28s %-32s %+7.1f%%\n", // flawfinder: ignore
+                json_string_value(json_object_get(result, "name")), params ? params : "",
+                before > 0.0 ? (now - before) * 100.0 / before : 0.0);
+        free(params);
+    }
+    json_decref(baseline);
+}
+
+/* flawfinder: ignore - all printf calls below use compile-time constant format strings */
+static void print_usage(const char *program) {
+    printf("Usage: %s [OPTIONS]\n\n", program); // flawfinder: ignore
+    printf("  --output FILE      Write JSON results to FILE (default: stdout)\n"); // flawfinder: ignore
+    printf("  --baseline FILE    Compare against the JSON results of an earlier run\n"); // flawfinder: ignore
+    printf("  --repeats N        Repetitions per benchmark, 1-%d (default: %d)\n", // flawfinder: ignore
+           BENCH_REPEATS, BENCH_REPEATS);
+    printf("  --quick            Smaller workloads for a fast smoke run\n"); // flawfinder: ignore
+}
+
+int main(int argc, char *argv[]) {
+    const char *output = NULL;
+    const char *baseline = NULL;
+    BenchRun run = { .repeats = BENCH_REPEATS, .quick = false };
+
+    static struct option long_options[] = {
+        {"output",   required_argument, 0, 'o'},
+        {"baseline", required_argument, 0, 'b'},
+        {"repeats",  required_argument, 0, 'r'},
+        {"quick",    no_argument,       0, 'q'},
+        {"help",     no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "o:b:r:qh", long_options, NULL)) != -1) { /* flawfinder: ignore */
+        switch (opt) {
+            case 'o': output = optarg; break;
+            case 'b': baseline = optarg; break;
+            case 'r': run.repeats = atoi(optarg); break;
+            case 'q': run.quick = true; break;
+            case 'h':
+                print_usage(argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (run.repeats < 1 || run.repeats > BENCH_REPEATS) {
+        fprintf(stderr, "Error: --repeats must be between 1 and %d\n", BENCH_REPEATS); /* flawfinder: ignore */
+        return EXIT_FAILURE;
+    }
+
+    FILE *report = bench_capture_stdout();
+    if (!report) {
+        fprintf(stderr, "Error: cannot set up output\n"); /* flawfinder: ignore */
+        return EXIT_FAILURE;
+    }
+
+    run.results = json_array();
+    fprintf(stderr, "Running microbenchmarks (%d repeats%s)...\n", /* flawfinder: ignore */
+            run.repeats, run.quick ? ", quick" : "");
+    bench_thread_pool(&run);
+    bench_thread_pool_group(&run);
+    bench_thread_pool_range(&run);
+    bench_stats_update(&run);
+    bench_category_add(&run);
+    bench_config_load(&run);
+
+    json_t *root = json_object();
+    json_object_set_new(root, "version", json_string(BDIX_VERSION_STRING));
+    json_object_set_new(root, "timestamp", json_integer((json_int_t)time(NULL)));
+    json_object_set_new(root, "quick", json_boolean(run.quick));
+    json_object_set_new(root, "results", run.results);
+
+    int ret = EXIT_SUCCESS;
+    if (output) {
+        if (json_dump_file(root, output, JSON_INDENT(2)) != 0) {
+            fprintf(stderr, "Error: cannot write %s\n", output); /* flawfinder: ignore */
+            ret = EXIT_FAILURE;
+        } else {
+            fprintf(stderr, "Results written to %s\n", output); /* flawfinder: ignore */
+        }
+    } else {
+        json_dumpf(root, report, JSON_INDENT(2));
+        fputc('\n', report);
+    }
+
+    if (baseline) {
+        compare_baseline(&run, baseline);
+    }
+
+    json_decref(root);
+    fclose(report);
+    return ret;
+}
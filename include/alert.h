@@ -0,0 +1,162 @@
+/**
+ * @file alert.h
+ * @brief State-change detection and batched alert delivery
+ * @version 1.0.0
+ */
+
+#ifndef BDIX_ALERT_H
+#define BDIX_ALERT_H
+
+#include "common.h"
+#include "server.h"
+#include <pthread.h>
+
+// Default alerting parameters
+#define ALERT_DEFAULT_CONFIRM_N 2
+#define ALERT_DEFAULT_WINDOW_M 3
+#define ALERT_MAX_WINDOW 32
+#define ALERT_DEFAULT_QUEUE_CAPACITY 1024
+#define ALERT_DEFAULT_BATCH_SIZE 50
+#define ALERT_DEFAULT_FLUSH_MS 2000
+#define ALERT_DEFAULT_SINK_TIMEOUT 10
+
+/**
+ * @brief Where alert batches are delivered
+ */
+typedef enum {
+    ALERT_SINK_NONE,                // Detect and count only
+    ALERT_SINK_WEBHOOK,             // HTTP POST of a JSON batch
+    ALERT_SINK_COMMAND              // Local executable fed the JSON batch on stdin
+} AlertSinkType;
+
+/**
+ * @brief Alerting configuration
+ */
+typedef struct {
+    unsigned confirm_n;             // Disagreeing observations needed to confirm...
+    unsigned window_m;              // ...out of this many most recent ones
+    AlertSinkType sink;             // Delivery target type
+    char target[MAX_PATH_LENGTH];   /* flawfinder: ignore - bounds checked with safe_strncpy */
+    size_t queue_capacity;          // Event queue slots (rounded up to a power of two)
+    size_t batch_size;              // Maximum events per delivery
+    int flush_interval_ms;          // Longest time an event waits for batching
+    int sink_timeout_seconds;       // Webhook / command timeout
+} AlertConfig;
+
+/**
+ * @brief A confirmed server state change
+ */
+typedef struct {
+    char url[MAX_URL_LENGTH];       /* flawfinder: ignore - bounds checked with safe_strncpy */
+    ServerStatus from;
+    ServerStatus to;
+    double latency_ms;
+    long response_code;
+    time_t timestamp;
+} AlertEvent;
+
+/**
+ * @brief Slot in the lock-free event queue
+ */
+typedef struct {
+    _Atomic size_t sequence;        // Slot turn counter (bounded MPMC queue)
+    AlertEvent event;
+} AlertSlot;
+
+/**
+ * @brief Alert manager owning the event queue and sink thread
+ */
+typedef struct {
+    AlertConfig config;
+
+    AlertSlot *slots;               // Ring of queue_capacity slots
+    size_t mask;                    // queue_capacity - 1
+    _Atomic size_t enqueue_pos;     // Producer cursor (checker workers)
+    _Atomic size_t dequeue_pos;     // Consumer cursor (sink thread)
+
+    pthread_t sink_thread;          // Batching / delivery thread
+    bool sink_running;              // Sink thread not yet joined
+    _Atomic bool shutdown;          // Stop request for the sink thread
+
+    _Atomic size_t detected;        // Confirmed transitions
+    _Atomic size_t dropped;         // Events lost because the queue was full
+    _Atomic size_t delivered;       // Events handed to the sink successfully
+    _Atomic size_t failed;          // Events in batches the sink rejected
+} AlertManager;
+
+/**
+ * @brief Get default alerting configuration
+ *
+ * @return Default configuration structure
+ */
+AlertConfig alert_get_default_config(void);
+
+/**
+ * @brief Feed a check result into a server's N-of-M transition detector
+ *
+ * The first observation only establishes the baseline. Afterwards a
+ * transition between up (ONLINE) and down (any other status) is confirmed
+ * once confirm_n of the last window_m observations disagree with the
+ * confirmed state.
+ *
+ * @param server Pointer to checked server (already updated)
+ * @param confirm_n Disagreeing observations required
+ * @param window_m Observation window size (<= ALERT_MAX_WINDOW)
+ * @param from Receives the previously confirmed status on transition (optional)
+ * @return true if a transition was confirmed
+ */
+bool alert_detect_transition(Server *server, unsigned confirm_n, unsigned window_m,
+                             ServerStatus *from);
+
+/**
+ * @brief Create an alert manager and start its sink thread
+ *
+ * @param config Pointer to configuration
+ * @return Pointer to alert manager or NULL on error
+ */
+AlertManager* alert_manager_create(const AlertConfig *config);
+
+/**
+ * @brief Deliver all queued events and stop the sink thread
+ *
+ * Events observed afterwards are queued but no longer delivered.
+ *
+ * @param manager Pointer to alert manager
+ */
+void alert_manager_flush(AlertManager *manager);
+
+/**
+ * @brief Flush pending events, stop the sink thread and free resources
+ *
+ * @param manager Pointer to alert manager
+ */
+void alert_manager_destroy(AlertManager *manager);
+
+/**
+ * @brief Run the detector for a server and enqueue an event on transition
+ *
+ * Never blocks: if the queue is full the event is counted as dropped.
+ *
+ * @param manager Pointer to alert manager (NULL disables alerting)
+ * @param server Pointer to checked server
+ * @return true if an event was generated
+ */
+bool alert_observe(AlertManager *manager, Server *server);
+
+/**
+ * @brief Enqueue an event without blocking
+ *
+ * @param manager Pointer to alert manager
+ * @param event Pointer to event (copied)
+ * @return BDIX_SUCCESS on success, BDIX_ERROR if the queue is full
+ */
+int alert_enqueue(AlertManager *manager, const AlertEvent *event);
+
+/**
+ * @brief Print alerting counters
+ *
+ * @param manager Pointer to alert manager
+ */
+void alert_manager_print_stats(const AlertManager *manager);
+
+#endif // BDIX_ALERT_H
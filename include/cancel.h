@@ -0,0 +1,127 @@
+/**
+ * @file cancel.h
+ * @brief Cancellation of a running sweep
+ * @version 1.0.0
+ *
+ * A token is cancelled explicitly or when its deadline passes. Engines poll
+ * it between probes and clamp their waits with cancel_token_wait_ms(), and
+ * sockets registered with the token are shut down on cancel so blocked
+ * transfers fail at once instead of running into their own timeouts.
+ *
+ * A token can have a parent (a sweep-wide token over per-set ones): it is
+ * cancelled with its parent and never outlives the parent's deadline.
+ * cancel_token_request() is safe in a signal handler; the cancel takes
+ * effect, sockets included, at the next cancel_token_check().
+ */
+
+#ifndef BDIX_CANCEL_H
+#define BDIX_CANCEL_H
+
+#include "common.h"
+#include <pthread.h>
+
+#define CANCEL_POLL_MS 100          // Wait slice while no deadline is set
+
+/**
+ * @brief Cancellation token shared by the threads of one sweep
+ */
+typedef struct CancelToken {
+    atomic_bool cancelled;
+    atomic_bool requested;          // Cancel asked for by cancel_token_request()
+    _Atomic double deadline_ms;     // get_time_ms() to cancel at, 0 = none
+    struct CancelToken *parent;     // Cancels this token too (optional)
+    pthread_mutex_t lock;           // Protects fds
+    int *fds;                       // Sockets to shut down on cancel
+    size_t fd_count;
+    size_t fd_capacity;
+} CancelToken;
+
+/**
+ * @brief Initialize a token
+ *
+ * @param token Token to initialize
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int cancel_token_init(CancelToken *token);
+
+/**
+ * @brief Initialize a token that is also cancelled with a parent
+ *
+ * @param token Token to initialize
+ * @param parent Parent token (NULL = none); must outlive the token
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int cancel_token_init_child(CancelToken *token, CancelToken *parent);
+
+/**
+ * @brief Release a token's resources
+ *
+ * @param token Token (NULL is ignored)
+ */
+void cancel_token_destroy(CancelToken *token);
+
+/**
+ * @brief Cancel now and shut down every registered socket
+ *
+ * @param token Token (NULL is ignored)
+ */
+void cancel_token_cancel(CancelToken *token);
+
+/**
+ * @brief Ask for a cancel without blocking (async-signal-safe)
+ *
+ * Registered sockets are shut down by the next cancel_token_check() on
+ * this token or a child.
+ *
+ * @param token Token (NULL is ignored)
+ */
+void cancel_token_request(CancelToken *token);
+
+/**
+ * @brief Cancel at a point in time; an earlier deadline already set wins
+ *
+ * @param token Token
+ * @param deadline_ms Monotonic time from get_time_ms()
+ */
+void cancel_token_set_deadline(CancelToken *token, double deadline_ms);
+
+/**
+ * @brief Check whether work should stop, cancelling once the deadline passed
+ *
+ * Also cancels the token when a cancel was requested or its parent is cancelled.
+ *
+ * @param token Token (NULL never cancels)
+ * @return true if cancelled
+ */
+bool cancel_token_check(CancelToken *token);
+
+/**
+ * @brief Clamp a wait so the waiter wakes up at the deadline
+ *
+ * Tokens with a parent also wake up every CANCEL_POLL_MS, since the parent
+ * may be cancelled from a signal handler without waking anyone.
+ *
+ * @param token Token (NULL leaves max_ms unchanged)
+ * @param max_ms Longest wait the caller wants (negative = unbounded)
+ * @return Milliseconds to wait (0 when already due)
+ */
+int cancel_token_wait_ms(const CancelToken *token, int max_ms);
+
+/**
+ * @brief Register a socket to shut down on cancel
+ *
+ * @param token Token
+ * @param fd Socket descriptor
+ * @return false if the token is already cancelled (the socket is not registered)
+ */
+bool cancel_token_add_fd(CancelToken *token, int fd);
+
+/**
+ * @brief Unregister a socket before it is closed
+ *
+ * @param token Token
+ * @param fd Socket descriptor
+ */
+void cancel_token_remove_fd(CancelToken *token, int fd);
+
+#endif // BDIX_CANCEL_H
@@ -9,6 +9,49 @@
 
 #include "common.h"
 #include "server.h"
+#include "rate_limit.h"
+#include "alert.h"
+#include "history.h"
+#include "icmp.h"
+#include "retry.h"
+#include "cancel.h"
+#include "thread_pool.h"
+
+struct curl_slist;
+
+/**
+ * @brief How servers are checked
+ */
+typedef enum {
+    CHECK_ENGINE_CURL,              // HTTP HEAD through libcurl on the thread pool
+    CHECK_ENGINE_TCP                // TCP connect only, swept from one thread (tcp_probe.h)
+} CheckEngine;
+
+#define ADAPTIVE_TIMEOUT_QUANTILE 0.95
+#define ADAPTIVE_TIMEOUT_MULTIPLIER 4.0
+#define ADAPTIVE_TIMEOUT_FLOOR_MS 500
+#define ADAPTIVE_TIMEOUT_MIN_SAMPLES 5
+
+#define TOP_K_GRACE_MS 250          // Default wait for faster results after the K-th online one
+
+#define CHECKER_PRIORITY_UNKNOWN 1e6    // Priority of servers without history (see checker_server_priority)
+#define CHECKER_DEAD_MIN_SAMPLES 3      // Failed samples, and no ONLINE one, before a server counts as dead
+#define CHECKER_QUEUE_PER_THREAD 4      // Deferred checks per pool thread before set ranges pause
+
+/**
+ * @brief Per-server deadlines derived from recent latency
+ *
+ * A server with at least min_samples ONLINE samples gets
+ * quantile(latency) * multiplier as its deadline, clamped to
+ * [floor_ms, ceiling_ms] and never above the global timeouts.
+ */
+typedef struct {
+    double quantile;                // Latency quantile of recent ONLINE checks (0..1)
+    double multiplier;              // Headroom over that quantile
+    int floor_ms;                   // Shortest deadline
+    int ceiling_ms;                 // Longest deadline (0 = the global timeout)
+    unsigned min_samples;           // ONLINE samples needed before adapting
+} AdaptiveTimeoutPolicy;
 
 /**
  * @brief Checker configuration
@@ -20,6 +63,23 @@ typedef struct {
     int max_redirects;              // Maximum number of redirects
     bool verify_ssl;                // Verify SSL certificates
     bool verbose;                   // Verbose output
+    RateLimiter *rate_limiter;      // Per-host limiter shared by workers (optional)
+    AlertManager *alerts;           // State-change alerting (optional)
+    HistoryStore *history;          // Persistent check history (optional)
+    struct curl_slist *resolve;     // CURLOPT_RESOLVE host:port:address pins (optional)
+    const IcmpConfig *icmp;         // Ping each set's hosts before the HTTP checks (optional)
+    CheckEngine engine;             // Probe used for each check
+    bool io_uring;                  // io_uring for TCP sweeps and plain-HTTP checks (see tcp_probe.h)
+    const AdaptiveTimeoutPolicy *adaptive_timeout; // Per-server curl deadlines (optional)
+    size_t top_k;                   // End each set once this many servers are online (0 = check all)
+    int top_k_grace_ms;             // How long after the K-th online result to keep going
+    RetryBudget *retry;             // Retries and hedged requests for curl checks (optional)
+    CancelToken *cancel;            // Sweep-wide deadline and interruption (optional)
+    bool prioritize;                // Check likely-online, fast servers first
+    int dead_timeout_ms;            // Deadline for servers that have been dead throughout (0 = off)
+    bool autotune_threads;          // Tune the curl pool's thread count, starting from thread_count
+    int max_threads;                // Autotuning ceiling (at most MAX_AUTOTUNE_THREADS)
+    ThreadPool *pool;               // Curl pool reused across sets, from checker_create_pool() (NULL = one per set)
 } CheckerConfig;
 
 /**
@@ -29,11 +89,21 @@ typedef struct {
     _Atomic size_t total_checked;
     _Atomic size_t online_count;
     _Atomic size_t offline_count;
-    _Atomic size_t timeout_count;
+    _Atomic size_t timeout_count;   // TIMEOUT and CUTOFF
     _Atomic size_t error_count;
+    _Atomic size_t deferred_count;  // Probes deferred by the rate limiter
+    _Atomic size_t cancelled_count; // Checks dropped because their set ended early
+    _Atomic size_t retried_count;   // Failed checks queued again (retry.h)
+    _Atomic size_t hedged_count;    // Checks that sent a hedged request
+    _Atomic size_t settled_threads; // Thread count the autotuned pool settled on (0 = not tuned)
+    _Atomic size_t peak_threads;    // Highest autotuned thread count
     _Atomic double total_latency_ms;
     _Atomic double min_latency_ms;
     _Atomic double max_latency_ms;
+    _Atomic double total_dns_ms;    // Phase sums over online checks
+    _Atomic double total_connect_ms;
+    _Atomic double total_tls_ms;
+    _Atomic double total_server_ms;
 } CheckerStats;
 
 /**
@@ -55,9 +125,50 @@ void checker_cleanup(void);
  */
 CheckerConfig checker_get_default_config(void);
 
+/**
+ * @brief Get default adaptive timeout policy
+ *
+ * @return Default policy structure
+ */
+AdaptiveTimeoutPolicy checker_get_default_adaptive_timeout(void);
+
+/**
+ * @brief Compute the deadlines for a server's next check
+ *
+ * Uses the global timeouts when no policy is set, when the server has too
+ * few ONLINE samples, or when its last check timed out (so a server that
+ * slowed down is given the full timeout again instead of being cut off on
+ * every check). With config->dead_timeout_ms set, a server with at least
+ * CHECKER_DEAD_MIN_SAMPLES samples and none of them ONLINE gets that
+ * deadline instead.
+ *
+ * @param server Pointer to server
+ * @param config Pointer to checker configuration
+ * @param timeout_ms Receives the whole-transfer deadline
+ * @param connect_timeout_ms Receives the connect deadline
+ * @return true if the deadlines are shorter than the global ones
+ */
+bool checker_server_deadlines(const Server *server, const CheckerConfig *config,
+                              long *timeout_ms, long *connect_timeout_ms);
+
+/**
+ * @brief Scheduling priority of a server from its recent results
+ *
+ * Lower runs first. A server that was ONLINE at its last check ranks by its
+ * smoothed latency; one without results ranks at CHECKER_PRIORITY_UNKNOWN;
+ * one that was down ranks after that, further back the lower its rolling
+ * uptime, so servers that have been dead throughout come last.
+ *
+ * @param server Pointer to server
+ * @return Priority value
+ */
+double checker_server_priority(const Server *server);
+
 /**
  * @brief Check a single server
  *
+ * A check aborted through config->cancel leaves the server unchanged.
+ *
  * @param server Pointer to server to check
  * @param config Pointer to checker configuration
  * @return BDIX_SUCCESS on success, error code otherwise
@@ -67,6 +178,31 @@ int checker_check_server(Server *server, const CheckerConfig *config);
 /**
  * @brief Check all servers in a category
  *
+ * With config->top_k set, the check ends once top_k servers are online and
+ * top_k_grace_ms more have passed: queued checks are dropped, transfers in
+ * flight are aborted, the servers concerned keep their previous status and
+ * are counted in stats->cancelled_count. The fastest top_k servers found
+ * are printed at the end.
+ *
+ * With config->retry set, curl checks that time out or fail are queued
+ * again after a jittered backoff, and slow checks of servers with enough
+ * history send a hedged second request, as far as the retry budget
+ * allows. The TCP and io_uring sweeps make a single attempt.
+ *
+ * Once config->cancel is cancelled (deadline or cancel_token_request()),
+ * the set stops the same way as after top_k: unstarted checks are counted
+ * as cancelled and the results so far are kept.
+ *
+ * With config->autotune_threads set, the curl pool starts at thread_count
+ * (or the count an earlier set with the same stats settled on) and tunes
+ * its concurrency up to config->max_threads; the result is kept in
+ * stats->settled_threads and stats->peak_threads.
+ *
+ * With config->prioritize set, servers are checked in order of
+ * checker_server_priority() rather than config order, and the pool runs
+ * retries and deferred checks by the same priority, so the first results,
+ * and whatever an early stop keeps, are the likely-good servers.
+ *
  * @param category Pointer to server category
  * @param config Pointer to checker configuration
  * @param thread_count Number of threads to use
@@ -76,6 +212,38 @@ int checker_check_server(Server *server, const CheckerConfig *config);
 int checker_check_category(ServerCategory *category, const CheckerConfig *config,
                            int thread_count, CheckerStats *stats);
 
+/**
+ * @brief Check a subset of servers in a category
+ *
+ * @param category Pointer to server category
+ * @param indices Array of server indices within the category
+ * @param count Number of indices
+ * @param config Pointer to checker configuration
+ * @param thread_count Number of threads to use
+ * @param stats Pointer to statistics (optional)
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int checker_check_servers(ServerCategory *category, const size_t *indices, size_t count,
+                          const CheckerConfig *config, int thread_count,
+                          CheckerStats *stats);
+
+/**
+ * @brief Create the curl check pool a configuration asks for
+ *
+ * Sized like the pool each set would otherwise create: thread_count
+ * workers, prioritized with config->prioritize and autotuned with
+ * config->autotune_threads (resuming from stats->settled_threads). Set it
+ * as config->pool to reuse it for many sets, e.g. every round of watch
+ * mode, and destroy it with thread_pool_destroy() afterwards.
+ *
+ * @param config Pointer to checker configuration
+ * @param thread_count Number of threads to use
+ * @param stats Pointer to statistics (optional)
+ * @return Pointer to thread pool or NULL on error
+ */
+ThreadPool* checker_create_pool(const CheckerConfig *config, int thread_count,
+                                const CheckerStats *stats);
+
 /**
  * @brief Check multiple categories
  *
@@ -122,4 +290,12 @@ void checker_stats_print(const CheckerStats *stats);
  */
 double checker_stats_get_avg_latency(const CheckerStats *stats);
 
+/**
+ * @brief Get the average duration of each check phase over online checks
+ *
+ * @param stats Pointer to statistics
+ * @return Average phase durations (total_ms is the average latency)
+ */
+ServerTiming checker_stats_get_avg_timing(const CheckerStats *stats);
+
 #endif // BDIX_CHECKER_H
@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdatomic.h>
 #include <stdarg.h>
 #include <errno.h>
@@ -21,6 +22,8 @@
 #include <ctype.h>
 #include <math.h>
 
+#include "log.h"
+
 // Version information
 #define BDIX_VERSION_MAJOR 1
 #define BDIX_VERSION_MINOR 0
@@ -33,6 +36,8 @@
 #define MIN_THREADS 1
 #define MAX_THREADS 64
 #define DEFAULT_THREADS 15
+#define MAX_AUTOTUNE_THREADS 512        // Ceiling for self-tuning pools (I/O-bound checks)
+#define DEFAULT_AUTOTUNE_MAX_THREADS 256
 #define HTTP_TIMEOUT_SECONDS 10
 #define HTTP_CONNECT_TIMEOUT 5
 #define MAX_INPUT_LENGTH 256
@@ -52,6 +57,8 @@
 #define BDIX_ERROR_JSON_PARSE -5
 #define BDIX_ERROR_NETWORK -6
 #define BDIX_ERROR_THREAD -7
+#define BDIX_ERROR_BUSY -8
+#define BDIX_ERROR_UNSUPPORTED -9
 
 // Utility macros
 #define UNUSED(x) (void)(x)
@@ -69,23 +76,12 @@
          DEFER_VAR(__LINE__); \
          DEFER_VAR(__LINE__) = 0, code)
 
-// Logging macros with levels
+// Logging macros with runtime levels (see log.h)
 /* flawfinder: ignore - all format strings in LOG_* macros are compile-time constants */
-#ifdef DEBUG
-    #define LOG_DEBUG(fmt, ...) \
-        fprintf(stderr, "[DEBUG] %s:%d: " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__) // flawfinder: ignore
-#else
-    #define LOG_DEBUG(fmt, ...) do {} while(0)
-#endif
-
-#define LOG_INFO(fmt, ...) \
-    fprintf(stdout, "[INFO] " fmt "\n", ##__VA_ARGS__) // flawfinder: ignore
-
-#define LOG_WARN(fmt, ...) \
-    fprintf(stderr, "[WARN] " fmt "\n", ##__VA_ARGS__) // flawfinder: ignore
-
-#define LOG_ERROR(fmt, ...) \
-    fprintf(stderr, "[ERROR] %s:%d: " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__) // flawfinder: ignore
+#define LOG_DEBUG(fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...) LOG_AT(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...) LOG_AT(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...) LOG_AT(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
 
 // Memory allocation wrappers with error checking
 static inline void* safe_malloc(size_t size) {
@@ -0,0 +1,249 @@
+/**
+ * @file history.h
+ * @brief Append-only memory-mapped check history store
+ * @version 1.0.0
+ */
+
+#ifndef BDIX_HISTORY_H
+#define BDIX_HISTORY_H
+
+#include "common.h"
+#include "server.h"
+#include <pthread.h>
+
+// On-disk format
+#define HISTORY_MAGIC "BDIXHIST"
+#define HISTORY_FORMAT_VERSION 1
+#define HISTORY_SEGMENT_PREFIX "segment-"
+#define HISTORY_SEGMENT_SUFFIX ".bdh"
+
+// Records per segment file (32 bytes each, 2 MiB per segment)
+#define HISTORY_DEFAULT_SEGMENT_RECORDS 65536
+
+/**
+ * @brief One check result as stored on disk (32 bytes)
+ */
+typedef struct {
+    uint64_t server_id;             // history_server_id() of the server URL
+    int64_t timestamp_ms;           // Wall-clock time of the check (ms since epoch)
+    float latency_ms;               // Measured latency
+    int16_t status;                 // ServerStatus
+    int16_t response_code;          // HTTP response code (0 if none)
+    uint32_t prev;                  // Previous record of this server in the segment + 1 (0 = none)
+    uint32_t reserved;
+} HistoryRecord;
+
+/**
+ * @brief Segment file header (64 bytes, followed by the record array)
+ */
+typedef struct {
+    char magic[8];                  /* flawfinder: ignore - fixed-size binary tag, not a string */
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t capacity;              // Records the segment can hold
+    uint32_t sequence;              // Segment number (matches file name)
+    _Atomic uint32_t count;         // Records written (published after the record)
+    uint32_t reserved0;
+    int64_t first_ms;               // Oldest timestamp in the segment
+    int64_t last_ms;                // Newest timestamp in the segment
+    uint8_t reserved[16];
+} HistorySegmentHeader;
+
+/**
+ * @brief Per-segment index entry mapping a server to its newest record
+ */
+typedef struct {
+    uint64_t server_id;
+    uint32_t head;                  // Newest record + 1 (0 = empty slot)
+    uint32_t count;                 // Records of this server in the segment
+} HistoryIndexEntry;
+
+/**
+ * @brief Mapped segment file with its in-memory index
+ */
+typedef struct {
+    uint32_t sequence;
+    int fd;
+    bool writable;
+    HistorySegmentHeader *header;   // Start of the mapping
+    HistoryRecord *records;         // Record array following the header
+    size_t map_size;
+    HistoryIndexEntry *index;       // Open-addressing table (power of two)
+    size_t index_capacity;
+    size_t index_count;
+} HistorySegment;
+
+/**
+ * @brief History store configuration
+ */
+typedef struct {
+    size_t segment_records;         // Capacity of newly created segments
+    bool read_only;                 // Open existing segments for queries only
+} HistoryConfig;
+
+/**
+ * @brief History store (a directory of segment files)
+ */
+typedef struct {
+    HistoryConfig config;
+    char dir[MAX_PATH_LENGTH];      /* flawfinder: ignore - bounds checked with safe_strncpy */
+    HistorySegment *segments;       // Oldest first
+    size_t segment_count;
+    size_t segment_capacity;
+    uint32_t next_sequence;         // Number for the next created segment
+    pthread_rwlock_t lock;          // Writers: appends, rotation, pruning; readers: queries
+    _Atomic size_t appended;        // Records appended by this process
+    _Atomic size_t failed;          // Appends that could not be stored
+} HistoryStore;
+
+/**
+ * @brief Visitor for history_query(); return false to stop the scan
+ */
+typedef bool (*HistoryVisitFn)(const HistoryRecord *record, void *ctx);
+
+/**
+ * @brief Get default history configuration
+ *
+ * @return Default configuration structure
+ */
+HistoryConfig history_get_default_config(void);
+
+/**
+ * @brief Stable 64-bit identifier of a server URL (FNV-1a)
+ *
+ * @param url Server URL
+ * @return Server identifier
+ */
+uint64_t history_server_id(const char *url);
+
+/**
+ * @brief Current wall-clock time in milliseconds since the epoch
+ *
+ * @return Timestamp in milliseconds
+ */
+int64_t history_now_ms(void);
+
+/**
+ * @brief Open (or create) a history store directory
+ *
+ * Existing segments are mapped and their per-server indexes rebuilt.
+ *
+ * @param dir Directory holding segment files (created if missing, must exist if read-only)
+ * @param config Pointer to configuration
+ * @return Pointer to history store or NULL on error
+ */
+HistoryStore* history_open(const char *dir, const HistoryConfig *config);
+
+/**
+ * @brief Sync and unmap all segments and free the store
+ *
+ * @param store Pointer to history store
+ */
+void history_close(HistoryStore *store);
+
+/**
+ * @brief Append a raw record (prev is filled in by the store)
+ *
+ * Never allocates per record; a new segment is created when the
+ * current one is full.
+ *
+ * @param store Pointer to history store
+ * @param record Pointer to record
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int history_append_record(HistoryStore *store, const HistoryRecord *record);
+
+/**
+ * @brief Append the latest check result of a server
+ *
+ * @param store Pointer to history store (NULL disables recording)
+ * @param server Pointer to checked server
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int history_append(HistoryStore *store, const Server *server);
+
+/**
+ * @brief Visit a server's records within [from_ms, to_ms], newest first
+ *
+ * Uses the per-segment indexes so only the server's own records are
+ * touched. Concurrent queries run in parallel; the visitor runs with
+ * the store read-locked and must not append to it.
+ *
+ * @param store Pointer to history store
+ * @param server_id Server identifier
+ * @param from_ms Oldest timestamp to include
+ * @param to_ms Newest timestamp to include
+ * @param visit Visitor called for every matching record
+ * @param ctx Visitor context
+ * @return Number of records visited
+ */
+size_t history_query(HistoryStore *store, uint64_t server_id, int64_t from_ms, int64_t to_ms,
+                     HistoryVisitFn visit, void *ctx);
+
+/**
+ * @brief Restore a server's recent results from the store
+ *
+ * Replays up to SERVER_SAMPLE_RING of its newest records, oldest first,
+ * into the server's status and metrics, as if those checks had just run
+ * in this process. Call once, before the server is first checked, so a
+ * fresh run starts with the previous runs' latency and uptime.
+ *
+ * @param store Pointer to history store
+ * @param server Pointer to server
+ * @return Number of results restored
+ */
+size_t history_restore(HistoryStore *store, Server *server);
+
+/**
+ * @brief Visit every record with a timestamp in [from_ms, to_ms), in append order
+ *
+ * Used by compaction. The store is only locked while a segment is
+ * picked, so appends continue during the scan; the visitor must not
+ * prune the store.
+ *
+ * @param store Pointer to history store
+ * @param from_ms Oldest timestamp to include
+ * @param to_ms Timestamp bound (exclusive)
+ * @param visit Visitor called for every matching record
+ * @param ctx Visitor context
+ * @return Number of records visited
+ */
+size_t history_scan(HistoryStore *store, int64_t from_ms, int64_t to_ms,
+                    HistoryVisitFn visit, void *ctx);
+
+/**
+ * @brief Oldest timestamp in the store
+ *
+ * @param store Pointer to history store
+ * @param oldest_ms Receives the timestamp
+ * @return true if the store holds any record
+ */
+bool history_oldest(HistoryStore *store, int64_t *oldest_ms);
+
+/**
+ * @brief Delete sealed segments whose newest record is older than before_ms
+ *
+ * The segment receiving appends is never removed.
+ *
+ * @param store Pointer to history store
+ * @param before_ms Retention boundary
+ * @return Number of segments deleted
+ */
+size_t history_prune(HistoryStore *store, int64_t before_ms);
+
+/**
+ * @brief Schedule write-back of the active segment
+ *
+ * @param store Pointer to history store
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int history_sync(HistoryStore *store);
+
+/**
+ * @brief Print history store counters
+ *
+ * @param store Pointer to history store
+ */
+void history_print_stats(HistoryStore *store);
+
+#endif // BDIX_HISTORY_H
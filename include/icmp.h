@@ -0,0 +1,77 @@
+/**
+ * @file icmp.h
+ * @brief Unprivileged ICMP echo probe engine
+ * @version 1.0.0
+ *
+ * Measures raw round-trip time with SOCK_DGRAM ICMP ("ping") sockets,
+ * which need no root as long as the caller's group is within
+ * net.ipv4.ping_group_range. One thread sends every echo request and
+ * collects the replies for all hosts through epoll.
+ */
+
+#ifndef BDIX_ICMP_H
+#define BDIX_ICMP_H
+
+#include "common.h"
+#include "server.h"
+
+#define ICMP_DEFAULT_SAMPLES 3
+#define ICMP_DEFAULT_INTERVAL_MS 100
+#define ICMP_DEFAULT_TIMEOUT_MS 1000
+#define ICMP_MAX_SAMPLES 16
+#define ICMP_MAX_ADDRESSES 4
+
+/**
+ * @brief ICMP probe configuration
+ */
+typedef struct {
+    int samples;                    // Echo requests per host (1..ICMP_MAX_SAMPLES)
+    int interval_ms;                // Gap between rounds of requests
+    int timeout_ms;                 // Wait for replies after the last round
+    int resolver_threads;           // Parallel name lookups before the first round
+} IcmpConfig;
+
+/**
+ * @brief Get default ICMP probe configuration
+ *
+ * @return Default configuration structure
+ */
+IcmpConfig icmp_get_default_config(void);
+
+/**
+ * @brief Check whether unprivileged ICMP sockets can be opened
+ *
+ * @return true if an IPv4 ping socket can be created
+ */
+bool icmp_available(void);
+
+/**
+ * @brief Ping a list of hosts
+ *
+ * Hosts are resolved first, on up to resolver_threads threads; unresolvable
+ * hosts get a result with sent == 0. Requests go to the first of a host's
+ * addresses (up to ICMP_MAX_ADDRESSES) whose family has a socket, moving
+ * to the next one when a send fails.
+ *
+ * @param hosts Host names or numeric addresses
+ * @param count Number of hosts
+ * @param config Probe configuration
+ * @param results Output array of count results
+ * @return BDIX_SUCCESS on success, BDIX_ERROR_NETWORK if ICMP sockets are not permitted
+ */
+int icmp_probe_hosts(const char *const *hosts, size_t count, const IcmpConfig *config,
+                     ServerPing *results);
+
+/**
+ * @brief Ping the hosts of a set of servers and store the RTT in server->ping
+ *
+ * Servers sharing a host are pinged once.
+ *
+ * @param servers Array of server pointers
+ * @param count Number of servers
+ * @param config Probe configuration
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int icmp_probe_servers(Server *const *servers, size_t count, const IcmpConfig *config);
+
+#endif // BDIX_ICMP_H
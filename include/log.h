@@ -0,0 +1,114 @@
+/**
+ * @file log.h
+ * @brief Leveled logging with per-thread ring buffers and a background flusher
+ * @version 1.0.0
+ *
+ * Until log_start() (and after log_stop()) messages are written
+ * synchronously. While started, every other thread formats into its own
+ * lock-free ring and a flusher thread writes them out, so workers never
+ * block on the terminal. The thread that called log_start() keeps writing
+ * directly, after any pending worker messages, so its log lines stay in
+ * order with its other console output. Messages below the runtime level
+ * cost one branch.
+ */
+
+#ifndef BDIX_LOG_H
+#define BDIX_LOG_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define LOG_RING_SLOTS 128          // Messages buffered per thread
+#define LOG_MESSAGE_MAX 384         // Longer messages are truncated
+#define LOG_FLUSH_INTERVAL_MS 20    // Flusher wake-up period
+
+/**
+ * @brief Log levels, in increasing severity
+ */
+typedef enum {
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_OFF
+} LogLevel;
+
+extern _Atomic int g_log_level;
+
+/**
+ * @brief Format and emit one message (use the LOG_* macros)
+ *
+ * @param level Message level
+ * @param file Source file, printed for DEBUG and ERROR
+ * @param line Source line
+ * @param fmt printf-style format
+ */
+void log_write(LogLevel level, const char *file, int line, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+/**
+ * @brief Start the background flusher (other threads' messages become asynchronous)
+ *
+ * @return 0 on success, -1 if the flusher thread could not be started
+ */
+int log_start(void);
+
+/**
+ * @brief Write out all buffered messages and return to synchronous logging
+ */
+void log_stop(void);
+
+/**
+ * @brief Write out all messages buffered so far
+ */
+void log_flush(void);
+
+/**
+ * @brief Set the minimum level that is emitted
+ *
+ * @param level New level
+ */
+void log_set_level(LogLevel level);
+
+/**
+ * @brief Get the minimum level that is emitted
+ *
+ * @return Current level
+ */
+LogLevel log_get_level(void);
+
+/**
+ * @brief Parse a level name (debug, info, warn, error, off)
+ *
+ * @param name Level name, case-insensitive
+ * @param level Output level
+ * @return true if the name is valid
+ */
+bool log_parse_level(const char *name, LogLevel *level);
+
+/**
+ * @brief Redirect output (INFO to out, other levels to err)
+ *
+ * @param out Stream for INFO, or NULL for stdout
+ * @param err Stream for DEBUG/WARN/ERROR, or NULL for stderr
+ */
+void log_set_streams(FILE *out, FILE *err);
+
+/**
+ * @brief Number of messages dropped because a thread's ring was full
+ *
+ * @return Dropped message count
+ */
+size_t log_dropped_count(void);
+
+// Level check first: arguments of disabled levels are never evaluated
+#define LOG_AT(level, fmt, ...) \
+    do { \
+        if ((int)(level) >= atomic_load_explicit(&g_log_level, memory_order_relaxed)) { \
+            log_write((level), __FILE__, __LINE__, fmt, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#endif // BDIX_LOG_H
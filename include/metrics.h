@@ -0,0 +1,148 @@
+/**
+ * @file metrics.h
+ * @brief Process-wide metrics registry served over a Unix domain socket
+ * @version 1.0.0
+ *
+ * Subsystems register counters, gauges and histograms once and update
+ * them with atomic operations. A snapshot is available as JSON or as a
+ * compact binary record, locally or through metrics_server_start().
+ */
+
+#ifndef BDIX_METRICS_H
+#define BDIX_METRICS_H
+
+#include "common.h"
+
+#define METRICS_MAX 128             // Registry capacity
+#define METRICS_NAME_MAX 96         // Including labels, e.g. name{code="28"}
+#define METRICS_BUCKETS 16          // Histogram buckets (last is +Inf)
+#define METRICS_BINARY_MAGIC 0x4D584442u  // "BDXM" little-endian
+#define METRICS_BINARY_VERSION 1u
+#define METRICS_REQUEST_TIMEOUT_MS 200
+
+/**
+ * @brief Metric kinds
+ */
+typedef enum {
+    METRIC_COUNTER,                 // Monotonic count
+    METRIC_GAUGE,                   // Value that goes up and down
+    METRIC_HISTOGRAM                // Distribution of millisecond observations
+} MetricType;
+
+/**
+ * @brief Registered metric (opaque)
+ */
+typedef struct Metric Metric;
+
+/**
+ * @brief Unix socket server (opaque)
+ */
+typedef struct MetricsServer MetricsServer;
+
+/**
+ * @brief Register (or look up) a counter
+ *
+ * @param name Metric name, optionally with labels
+ * @param help Description (string literal)
+ * @return Metric handle, or NULL if the registry is full or the name has another type
+ */
+Metric* metrics_counter(const char *name, const char *help);
+
+/**
+ * @brief Register (or look up) a gauge
+ *
+ * @param name Metric name, optionally with labels
+ * @param help Description (string literal)
+ * @return Metric handle, or NULL on error
+ */
+Metric* metrics_gauge(const char *name, const char *help);
+
+/**
+ * @brief Register (or look up) a histogram of millisecond values
+ *
+ * @param name Metric name, optionally with labels
+ * @param help Description (string literal)
+ * @return Metric handle, or NULL on error
+ */
+Metric* metrics_histogram(const char *name, const char *help);
+
+/**
+ * @brief Add to a counter (no-op for NULL)
+ *
+ * @param metric Counter handle
+ * @param delta Amount to add
+ */
+void metrics_add(Metric *metric, uint64_t delta);
+
+/**
+ * @brief Set a gauge (no-op for NULL)
+ *
+ * @param metric Gauge handle
+ * @param value New value
+ */
+void metrics_gauge_set(Metric *metric, double value);
+
+/**
+ * @brief Add to a gauge, negative to decrease (no-op for NULL)
+ *
+ * @param metric Gauge handle
+ * @param delta Amount to add
+ */
+void metrics_gauge_add(Metric *metric, double delta);
+
+/**
+ * @brief Record an observation in a histogram (no-op for NULL)
+ *
+ * @param metric Histogram handle
+ * @param value_ms Observed value in milliseconds
+ */
+void metrics_observe(Metric *metric, double value_ms);
+
+/**
+ * @brief Current value of a counter or gauge, or observation count of a histogram
+ *
+ * @param metric Metric handle
+ * @return Value (0 for NULL)
+ */
+double metrics_value(const Metric *metric);
+
+/**
+ * @brief Serialize all metrics as JSON
+ *
+ * @return Newly allocated string (caller must free) or NULL on error
+ */
+char* metrics_snapshot_json(void);
+
+/**
+ * @brief Serialize all metrics in the binary format
+ *
+ * Layout (host byte order): u32 magic, u32 version, u64 unix time ms,
+ * u32 metric count, then per metric: u8 type, u16 name length, name
+ * bytes, and either f64 value (counter, gauge) or u64 count, f64 sum,
+ * u16 bucket count and per bucket f64 upper bound + u64 count (histogram).
+ *
+ * @param size Output size in bytes
+ * @return Newly allocated buffer (caller must free) or NULL on error
+ */
+uint8_t* metrics_snapshot_binary(size_t *size);
+
+/**
+ * @brief Serve snapshots on a Unix domain socket
+ *
+ * Each client sends "json" or "binary" (newline optional) and receives
+ * one snapshot before the connection is closed; clients that send
+ * nothing within METRICS_REQUEST_TIMEOUT_MS get JSON.
+ *
+ * @param path Socket path (a stale socket at this path is replaced)
+ * @return Server handle or NULL on error
+ */
+MetricsServer* metrics_server_start(const char *path);
+
+/**
+ * @brief Stop the server and remove its socket
+ *
+ * @param server Server handle (may be NULL)
+ */
+void metrics_server_stop(MetricsServer *server);
+
+#endif // BDIX_METRICS_H
@@ -0,0 +1,135 @@
+/**
+ * @file query.h
+ * @brief Uptime and latency percentile queries over stored history
+ * @version 1.0.0
+ */
+
+#ifndef BDIX_QUERY_H
+#define BDIX_QUERY_H
+
+#include "common.h"
+#include "server.h"
+#include "rollup.h"
+
+// Default query parameters
+#define QUERY_DEFAULT_RANGE_MS (7 * ROLLUP_MS_PER_DAY)
+#define QUERY_DEFAULT_TOP 20
+#define QUERY_SERVERS_PER_TASK 256
+
+/**
+ * @brief Ranking key
+ */
+typedef enum {
+    QUERY_SORT_P50,
+    QUERY_SORT_P90,
+    QUERY_SORT_P99,
+    QUERY_SORT_AVG,
+    QUERY_SORT_UPTIME
+} QuerySortKey;
+
+/**
+ * @brief Output format
+ */
+typedef enum {
+    QUERY_FORMAT_TABLE,
+    QUERY_FORMAT_CSV,
+    QUERY_FORMAT_JSON
+} QueryFormat;
+
+/**
+ * @brief Query options
+ */
+typedef struct {
+    int64_t from_ms;                // Range start
+    int64_t to_ms;                  // Range end (exclusive)
+    QuerySortKey sort;
+    double min_uptime_pct;          // Servers below are dropped
+    size_t top_n;                   // 0 = all
+    QueryFormat format;
+} QueryOptions;
+
+/**
+ * @brief Aggregated history of one server
+ */
+typedef struct {
+    const char *url;                // Points into the server data
+    const char *category;
+    RollupAggregate aggregate;
+    double uptime_pct;
+    double avg_ms;
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double rank;                    // Sort position key (ascending)
+} QueryResult;
+
+/**
+ * @brief Sorted query results
+ */
+typedef struct {
+    QueryResult *rows;
+    size_t count;                   // Rows after filtering and top-N
+    size_t scanned;                 // Servers aggregated
+} QueryResultSet;
+
+/**
+ * @brief Get default query options (last 7 days, top 20 by p90)
+ *
+ * @param now_ms Current wall-clock time in milliseconds
+ * @return Default options
+ */
+QueryOptions query_get_default_options(int64_t now_ms);
+
+/**
+ * @brief Parse a sort key name (p50, p90, p99, avg, uptime)
+ *
+ * @param name Key name
+ * @param key Receives the key
+ * @return BDIX_SUCCESS on success, BDIX_ERROR_INVALID_INPUT otherwise
+ */
+int query_parse_sort(const char *name, QuerySortKey *key);
+
+/**
+ * @brief Parse an output format name (table, csv, json)
+ *
+ * @param name Format name
+ * @param format Receives the format
+ * @return BDIX_SUCCESS on success, BDIX_ERROR_INVALID_INPUT otherwise
+ */
+int query_parse_format(const char *name, QueryFormat *format);
+
+/**
+ * @brief Aggregate, filter and rank the servers of the given categories
+ *
+ * Servers are aggregated in parallel on a thread pool from the rollup
+ * tiers (and raw history at the range edges).
+ *
+ * @param rollups Rollup store (attached to the raw history store)
+ * @param categories Categories to include
+ * @param category_count Number of categories
+ * @param options Pointer to query options
+ * @param thread_count Number of worker threads
+ * @param results Receives the results (free with query_results_free())
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int query_run(RollupStore *rollups, ServerCategory *const *categories, size_t category_count,
+              const QueryOptions *options, int thread_count, QueryResultSet *results);
+
+/**
+ * @brief Write results as a table, CSV or JSON
+ *
+ * @param results Pointer to results
+ * @param options Pointer to query options
+ * @param out Output stream
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int query_write_results(const QueryResultSet *results, const QueryOptions *options, FILE *out);
+
+/**
+ * @brief Free query results
+ *
+ * @param results Pointer to results
+ */
+void query_results_free(QueryResultSet *results);
+
+#endif // BDIX_QUERY_H
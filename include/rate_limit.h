@@ -0,0 +1,133 @@
+/**
+ * @file rate_limit.h
+ * @brief Per-host token-bucket rate limiting and concurrency caps
+ * @version 1.0.0
+ */
+
+#ifndef BDIX_RATE_LIMIT_H
+#define BDIX_RATE_LIMIT_H
+
+#include "common.h"
+#include <pthread.h>
+
+// Default per-host limits
+#define RATE_LIMIT_DEFAULT_RATE 5.0
+#define RATE_LIMIT_DEFAULT_BURST 5.0
+#define RATE_LIMIT_DEFAULT_CONCURRENCY 2
+
+// Shortest suggested retry delay for throttled work
+#define RATE_LIMIT_MIN_RETRY_MS 20.0
+
+// Longest suggested retry delay; later waiters wake and re-queue cheaply
+#define RATE_LIMIT_MAX_RETRY_MS 5000.0
+
+// Slot handed out when no bucket applies (release is a no-op)
+#define RATE_LIMIT_NO_SLOT ((size_t)-1)
+
+/**
+ * @brief Rate limiter configuration
+ */
+typedef struct {
+    double rate_per_sec;            // Token refill rate per bucket
+    double burst;                   // Bucket capacity
+    int max_concurrent;             // In-flight probes per bucket (0 = unlimited)
+    bool per_ip;                    // Share buckets between hosts with the same address
+} RateLimitConfig;
+
+/**
+ * @brief Token bucket for one host or address
+ */
+typedef struct {
+    double tokens;                  // Available tokens
+    double last_refill_ms;          // Monotonic time of last refill
+    int in_flight;                  // Probes currently running
+    int waiting;                    // Deferred probes short of tokens, counted once each
+} RateBucket;
+
+/**
+ * @brief Hash table entry mapping a key to a bucket
+ */
+typedef struct {
+    char *key;                      // Host name, or "ip:" prefixed address
+    size_t bucket;                  // Index into bucket array
+} RateLimitEntry;
+
+/**
+ * @brief Rate limiter shared by all checker workers
+ */
+typedef struct {
+    RateLimitConfig config;
+    RateLimitEntry *entries;        // Open-addressing table
+    size_t entry_capacity;          // Table size (power of two)
+    size_t entry_count;             // Occupied slots
+    RateBucket *buckets;            // Bucket storage (indices are stable)
+    size_t bucket_count;
+    size_t bucket_capacity;
+    pthread_mutex_t mutex;          // Protects table and buckets
+    _Atomic size_t throttled;       // Total deferrals handed out
+} RateLimiter;
+
+/**
+ * @brief Get default rate limiter configuration
+ *
+ * @return Default configuration structure
+ */
+RateLimitConfig rate_limiter_get_default_config(void);
+
+/**
+ * @brief Create a rate limiter
+ *
+ * @param config Pointer to configuration
+ * @return Pointer to rate limiter or NULL on error
+ */
+RateLimiter* rate_limiter_create(const RateLimitConfig *config);
+
+/**
+ * @brief Destroy a rate limiter and free resources
+ *
+ * @param limiter Pointer to rate limiter
+ */
+void rate_limiter_destroy(RateLimiter *limiter);
+
+/**
+ * @brief Try to acquire a probe slot for a URL's host without blocking
+ *
+ * @param limiter Pointer to rate limiter
+ * @param url Server URL
+ * @param slot Receives the bucket to pass to rate_limiter_release()
+ * @param retry_after_ms Receives suggested delay when throttled
+ * @param waiter Per-work-item wait registration, initialized to RATE_LIMIT_NO_SLOT;
+ *               a probe short of tokens is counted as a waiter once until it is
+ *               granted or rate_limiter_cancel_wait() is called (NULL = never counted)
+ * @return true if acquired, false if the probe should be deferred
+ */
+bool rate_limiter_try_acquire(RateLimiter *limiter, const char *url,
+                              size_t *slot, double *retry_after_ms, size_t *waiter);
+
+/**
+ * @brief Drop the wait registration of a deferred probe that will not retry
+ *
+ * @param limiter Pointer to rate limiter
+ * @param waiter Registration from rate_limiter_try_acquire(); reset to RATE_LIMIT_NO_SLOT
+ */
+void rate_limiter_cancel_wait(RateLimiter *limiter, size_t *waiter);
+
+/**
+ * @brief Release a probe slot acquired with rate_limiter_try_acquire()
+ *
+ * @param limiter Pointer to rate limiter
+ * @param slot Bucket returned by rate_limiter_try_acquire()
+ */
+void rate_limiter_release(RateLimiter *limiter, size_t slot);
+
+/**
+ * @brief Extract the lowercase host name from a URL
+ *
+ * @param url Server URL
+ * @param host Output buffer
+ * @param size Output buffer size
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int rate_limiter_extract_host(const char *url, char *host, size_t size);
+
+#endif // BDIX_RATE_LIMIT_H
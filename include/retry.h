@@ -0,0 +1,108 @@
+/**
+ * @file retry.h
+ * @brief Retries with jittered backoff and hedged requests under a shared budget
+ * @version 1.0.0
+ *
+ * All workers share one budget: over the last RETRY_BUDGET_WINDOW_MS, at
+ * most budget_burst plus budget_pct percent of the first attempts may be
+ * retried or hedged. An outage that fails every check therefore adds at
+ * most budget_pct percent of load, and a long healthy stretch does not
+ * save up for a retry storm later.
+ */
+
+#ifndef BDIX_RETRY_H
+#define BDIX_RETRY_H
+
+#include "common.h"
+#include <pthread.h>
+
+#define RETRY_MAX_RETRIES 10
+#define RETRY_DEFAULT_BACKOFF_MS 200.0
+#define RETRY_DEFAULT_MAX_BACKOFF_MS 5000.0
+#define RETRY_DEFAULT_HEDGE_MIN_MS 50.0
+#define RETRY_HEDGE_MIN_SAMPLES 5   // ONLINE samples before a server is hedged
+#define RETRY_DEFAULT_BUDGET_PCT 10.0
+#define RETRY_DEFAULT_BUDGET_BURST 10.0
+#define RETRY_BUDGET_WINDOW_MS 60000.0
+#define RETRY_BUDGET_SLOTS 12       // Window granularity
+
+/**
+ * @brief Retry and hedging configuration
+ */
+typedef struct {
+    int max_retries;                // Extra attempts after a TIMEOUT or ERROR (0 = none)
+    double backoff_ms;              // Delay before the first retry, doubled for each further one
+    double max_backoff_ms;          // Longest delay between attempts
+    double hedge_quantile;          // Hedge once an attempt outlasts this latency quantile (0 = off)
+    double hedge_min_ms;            // Shortest delay before a hedge
+    double budget_pct;              // Retries and hedges allowed per 100 first attempts
+    double budget_burst;            // Extra attempts allowed per window on top of that
+} RetryConfig;
+
+/**
+ * @brief Retry budget shared by all checker workers
+ */
+typedef struct {
+    RetryConfig config;
+    pthread_mutex_t lock;           // Protects the window slots
+    int64_t slot_epoch[RETRY_BUDGET_SLOTS];     // Time slot each entry counts for
+    double deposits[RETRY_BUDGET_SLOTS];        // First attempts per slot
+    double withdrawals[RETRY_BUDGET_SLOTS];     // Retries and hedges per slot
+    _Atomic uint64_t jitter_state;  // Backoff jitter sequence
+    _Atomic size_t retries;         // Retries granted
+    _Atomic size_t hedges;          // Hedges granted
+    _Atomic size_t denied;          // Retries and hedges refused by the budget
+} RetryBudget;
+
+/**
+ * @brief Get default retry configuration (no retries, no hedging)
+ *
+ * @return Default configuration structure
+ */
+RetryConfig retry_get_default_config(void);
+
+/**
+ * @brief Create a retry budget
+ *
+ * @param config Pointer to configuration
+ * @return Pointer to budget or NULL on invalid configuration or error
+ */
+RetryBudget* retry_budget_create(const RetryConfig *config);
+
+/**
+ * @brief Destroy a retry budget
+ *
+ * @param budget Pointer to budget (NULL is ignored)
+ */
+void retry_budget_destroy(RetryBudget *budget);
+
+/**
+ * @brief Count one first attempt towards the budget
+ *
+ * @param budget Pointer to budget (NULL is ignored)
+ */
+void retry_budget_deposit(RetryBudget *budget);
+
+/**
+ * @brief Take out one retry or hedge if the budget allows it
+ *
+ * @param budget Pointer to budget
+ * @param hedge true for a hedge, false for a retry (statistics only)
+ * @return true if the extra attempt may go ahead
+ */
+bool retry_budget_withdraw(RetryBudget *budget, bool hedge);
+
+/**
+ * @brief Jittered delay before a retry
+ *
+ * backoff_ms * 2^(retry - 1), capped at max_backoff_ms, of which a random
+ * half is kept ("equal jitter"), so retries of servers that failed together
+ * do not arrive together.
+ *
+ * @param budget Pointer to budget
+ * @param retry Retry number, starting at 1
+ * @return Delay in milliseconds
+ */
+double retry_backoff_ms(RetryBudget *budget, int retry);
+
+#endif // BDIX_RETRY_H
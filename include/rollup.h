@@ -0,0 +1,382 @@
+/**
+ * @file rollup.h
+ * @brief History rollups (1m/1h/1d aggregates) and background compaction
+ * @version 1.0.0
+ */
+
+#ifndef BDIX_ROLLUP_H
+#define BDIX_ROLLUP_H
+
+#include "common.h"
+#include "history.h"
+#include <pthread.h>
+
+// On-disk format
+#define ROLLUP_MAGIC "BDIXROLL"
+#define ROLLUP_FORMAT_VERSION 1
+#define ROLLUP_CHUNK_PREFIX "chunk-"
+#define ROLLUP_CHUNK_SUFFIX ".bdr"
+
+// Latency sketch: log-spaced buckets between MIN and MAX (about +/-12% relative error)
+#define ROLLUP_SKETCH_BUCKETS 44
+#define ROLLUP_SKETCH_MIN_MS 1.0
+#define ROLLUP_SKETCH_MAX_MS 30000.0
+
+// Compaction defaults
+#define ROLLUP_DEFAULT_GRACE_MS 15000       // Wait before closing a raw minute
+#define ROLLUP_DEFAULT_INTERVAL_MS 60000    // Background compaction period
+#define ROLLUP_MAX_PERIODS_PER_PASS 1440    // Bounds catch-up work per pass and tier
+
+// Default retention per tier
+#define ROLLUP_MS_PER_DAY 86400000LL
+#define ROLLUP_DEFAULT_RAW_RETENTION (2 * ROLLUP_MS_PER_DAY)
+#define ROLLUP_DEFAULT_MINUTE_RETENTION (14 * ROLLUP_MS_PER_DAY)
+#define ROLLUP_DEFAULT_HOUR_RETENTION (180 * ROLLUP_MS_PER_DAY)
+#define ROLLUP_DEFAULT_DAY_RETENTION (1825 * ROLLUP_MS_PER_DAY)
+
+/**
+ * @brief Rollup resolutions, finest first
+ */
+typedef enum {
+    ROLLUP_TIER_MINUTE,
+    ROLLUP_TIER_HOUR,
+    ROLLUP_TIER_DAY,
+    ROLLUP_TIER_COUNT
+} RollupTier;
+
+/**
+ * @brief Mergeable latency histogram with log-spaced buckets
+ */
+typedef struct {
+    uint16_t counts[ROLLUP_SKETCH_BUCKETS];  // Saturating counts
+} LatencySketch;
+
+/**
+ * @brief Latency sketch with wide counts, for merging stored sketches at query time
+ */
+typedef struct {
+    uint64_t counts[ROLLUP_SKETCH_BUCKETS];
+} LatencySketchSum;
+
+/**
+ * @brief Aggregate of one server over one period (128 bytes)
+ */
+typedef struct {
+    uint64_t server_id;             // history_server_id() of the server URL
+    int64_t start_ms;               // Period start
+    uint32_t count;                 // Checks aggregated
+    uint32_t up_count;              // ONLINE checks
+    float min_latency_ms;           // Over ONLINE checks
+    float max_latency_ms;
+    double sum_latency_ms;
+    LatencySketch sketch;
+} RollupRecord;
+
+/**
+ * @brief Aggregate of one server over a queried range
+ *
+ * Same fields as RollupRecord, but its sketch does not saturate however
+ * many stored records are merged into it.
+ */
+typedef struct {
+    uint64_t server_id;
+    int64_t start_ms;               // Range start
+    uint32_t count;
+    uint32_t up_count;
+    float min_latency_ms;
+    float max_latency_ms;
+    double sum_latency_ms;
+    LatencySketchSum sketch;
+} RollupAggregate;
+
+/**
+ * @brief Chunk file header (64 bytes)
+ */
+typedef struct {
+    char magic[8];                  /* flawfinder: ignore - fixed-size binary tag, not a string */
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t tier;
+    uint32_t reserved0;
+    int64_t period_ms;
+    int64_t chunk_start_ms;
+    uint8_t reserved[24];
+} RollupFileHeader;
+
+/**
+ * @brief Header preceding each period's records (sorted by server id)
+ */
+typedef struct {
+    int64_t start_ms;
+    uint32_t count;
+    uint32_t reserved;
+} RollupBlockHeader;
+
+/**
+ * @brief In-memory location of a block
+ */
+typedef struct {
+    int64_t start_ms;
+    size_t offset;                  // Offset of the first record in the chunk mapping
+    uint32_t count;
+} RollupBlock;
+
+/**
+ * @brief Mapped chunk file covering chunk_ms of one tier
+ */
+typedef struct {
+    int64_t start_ms;
+    int fd;
+    uint8_t *map;
+    size_t map_size;
+    RollupBlock *blocks;
+    size_t block_count;
+    size_t block_capacity;
+} RollupChunk;
+
+/**
+ * @brief One resolution tier
+ */
+typedef struct {
+    int64_t period_ms;              // Aggregation period
+    int64_t chunk_ms;               // Time span of one chunk file
+    char dir[MAX_PATH_LENGTH];      /* flawfinder: ignore - bounds checked with snprintf */
+    RollupChunk *chunks;            // Oldest first
+    size_t chunk_count;
+    size_t chunk_capacity;
+    int64_t watermark_ms;           // End of the last compacted period (0 = none)
+} RollupTierStore;
+
+/**
+ * @brief Rollup configuration
+ */
+typedef struct {
+    int64_t raw_retention_ms;       // Raw history kept after compaction
+    int64_t retention_ms[ROLLUP_TIER_COUNT];
+    int64_t grace_ms;               // Delay before a raw minute is considered closed
+    int interval_ms;                // Background compaction period
+    bool read_only;                 // Open for queries only
+} RollupConfig;
+
+/**
+ * @brief Rollup store and compactor
+ */
+typedef struct {
+    RollupConfig config;
+    RollupTierStore tiers[ROLLUP_TIER_COUNT];
+    HistoryStore *history;          // Raw source (not owned)
+    pthread_rwlock_t lock;          // Writers: block appends and pruning; readers: queries
+    pthread_t thread;
+    bool thread_running;
+    _Atomic bool shutdown;
+    _Atomic size_t passes;          // Completed compaction passes
+    _Atomic size_t records_written; // Rollup records written
+} RollupStore;
+
+/**
+ * @brief Add a latency to a sketch
+ *
+ * @param sketch Pointer to sketch
+ * @param latency_ms Latency in milliseconds
+ */
+void latency_sketch_add(LatencySketch *sketch, double latency_ms);
+
+/**
+ * @brief Merge one sketch into another
+ *
+ * @param dst Destination sketch
+ * @param src Source sketch
+ */
+void latency_sketch_merge(LatencySketch *dst, const LatencySketch *src);
+
+/**
+ * @brief Estimate a quantile from a sketch
+ *
+ * @param sketch Pointer to sketch
+ * @param q Quantile in [0, 1]
+ * @return Estimated latency, or -1.0 if the sketch is empty
+ */
+double latency_sketch_quantile(const LatencySketch *sketch, double q);
+
+/**
+ * @brief Merge a stored sketch into a query-time sketch
+ *
+ * @param dst Destination sketch
+ * @param src Source sketch
+ */
+void latency_sketch_sum_merge(LatencySketchSum *dst, const LatencySketch *src);
+
+/**
+ * @brief Estimate a quantile from a query-time sketch
+ *
+ * @param sketch Pointer to sketch
+ * @param q Quantile in [0, 1]
+ * @return Estimated latency, or -1.0 if the sketch is empty
+ */
+double latency_sketch_sum_quantile(const LatencySketchSum *sketch, double q);
+
+/**
+ * @brief Add one check result to an aggregate
+ *
+ * @param record Pointer to aggregate
+ * @param status Check status
+ * @param latency_ms Check latency
+ */
+void rollup_record_add(RollupRecord *record, ServerStatus status, double latency_ms);
+
+/**
+ * @brief Merge one aggregate into another
+ *
+ * @param dst Destination aggregate
+ * @param src Source aggregate
+ */
+void rollup_record_merge(RollupRecord *dst, const RollupRecord *src);
+
+/**
+ * @brief Estimate a latency quantile of an aggregate
+ *
+ * @param record Pointer to aggregate
+ * @param q Quantile in [0, 1]
+ * @return Estimated latency (clamped to min/max), or -1.0 without ONLINE checks
+ */
+double rollup_record_quantile(const RollupRecord *record, double q);
+
+/**
+ * @brief Uptime percentage of an aggregate
+ *
+ * @param record Pointer to aggregate
+ * @return Uptime percentage, or -1.0 without checks
+ */
+double rollup_record_uptime_pct(const RollupRecord *record);
+
+/**
+ * @brief Add one raw check result to a query aggregate
+ *
+ * @param aggregate Pointer to aggregate
+ * @param status Check status
+ * @param latency_ms Check latency
+ */
+void rollup_aggregate_add(RollupAggregate *aggregate, ServerStatus status, double latency_ms);
+
+/**
+ * @brief Merge a stored aggregate into a query aggregate
+ *
+ * @param aggregate Destination aggregate
+ * @param record Stored aggregate
+ */
+void rollup_aggregate_merge(RollupAggregate *aggregate, const RollupRecord *record);
+
+/**
+ * @brief Estimate a latency quantile of a query aggregate
+ *
+ * @param aggregate Pointer to aggregate
+ * @param q Quantile in [0, 1]
+ * @return Estimated latency (clamped to min/max), or -1.0 without ONLINE checks
+ */
+double rollup_aggregate_quantile(const RollupAggregate *aggregate, double q);
+
+/**
+ * @brief Uptime percentage of a query aggregate
+ *
+ * @param aggregate Pointer to aggregate
+ * @return Uptime percentage, or -1.0 without checks
+ */
+double rollup_aggregate_uptime_pct(const RollupAggregate *aggregate);
+
+/**
+ * @brief Get default rollup configuration
+ *
+ * @return Default configuration structure
+ */
+RollupConfig rollup_get_default_config(void);
+
+/**
+ * @brief Parse a duration such as "90s", "14d" or "5y" into milliseconds
+ *
+ * @param text Number followed by one of s, m, h, d, w, y
+ * @param out Receives the duration
+ * @return BDIX_SUCCESS on success, BDIX_ERROR_INVALID_INPUT otherwise
+ */
+int rollup_parse_duration(const char *text, int64_t *out);
+
+/**
+ * @brief Parse a retention spec such as "raw=2d,1m=14d,1h=180d,1d=5y"
+ *
+ * Units: s, m, h, d, w, y. Tiers not mentioned keep their value.
+ *
+ * @param spec Retention specification
+ * @param config Configuration to update
+ * @return BDIX_SUCCESS on success, BDIX_ERROR_INVALID_INPUT otherwise
+ */
+int rollup_parse_retention(const char *spec, RollupConfig *config);
+
+/**
+ * @brief Open (or create) the rollup tiers inside a history directory
+ *
+ * @param dir History directory
+ * @param history Raw history store to compact (may be NULL for queries only)
+ * @param config Pointer to configuration
+ * @return Pointer to rollup store or NULL on error
+ */
+RollupStore* rollup_open(const char *dir, HistoryStore *history, const RollupConfig *config);
+
+/**
+ * @brief Stop compaction, unmap all chunks and free the store
+ *
+ * @param store Pointer to rollup store
+ */
+void rollup_close(RollupStore *store);
+
+/**
+ * @brief Run one compaction and retention pass
+ *
+ * Folds closed raw minutes into the 1m tier, closed hours of 1m
+ * rollups into 1h, closed days of 1h rollups into 1d, then applies
+ * the retention policies. Raw history is never pruned before it has
+ * been compacted.
+ *
+ * @param store Pointer to rollup store
+ * @param now_ms Current wall-clock time in milliseconds
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int rollup_compact(RollupStore *store, int64_t now_ms);
+
+/**
+ * @brief Start background compaction every interval_ms
+ *
+ * @param store Pointer to rollup store
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int rollup_start(RollupStore *store);
+
+/**
+ * @brief Stop background compaction (idempotent)
+ *
+ * @param store Pointer to rollup store
+ */
+void rollup_stop(RollupStore *store);
+
+/**
+ * @brief Aggregate a server's checks over [from_ms, to_ms)
+ *
+ * Covers the range with the coarsest compacted periods that fit and
+ * fills the edges from finer tiers and finally raw history.
+ *
+ * @param store Pointer to rollup store
+ * @param server_id Server identifier
+ * @param from_ms Range start
+ * @param to_ms Range end (exclusive)
+ * @param out Receives the aggregate
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int rollup_aggregate(RollupStore *store, uint64_t server_id, int64_t from_ms, int64_t to_ms,
+                     RollupAggregate *out);
+
+/**
+ * @brief Print rollup counters
+ *
+ * @param store Pointer to rollup store
+ */
+void rollup_print_stats(const RollupStore *store);
+
+#endif // BDIX_ROLLUP_H
@@ -0,0 +1,105 @@
+/**
+ * @file scheduler.h
+ * @brief Adaptive per-server check scheduling for continuous monitoring
+ * @version 1.0.0
+ */
+
+#ifndef BDIX_SCHEDULER_H
+#define BDIX_SCHEDULER_H
+
+#include "common.h"
+#include "server.h"
+#include "checker.h"
+
+// Default scheduling bounds (seconds)
+#define SCHED_DEFAULT_MIN_INTERVAL 10.0
+#define SCHED_DEFAULT_BASE_INTERVAL 30.0
+#define SCHED_DEFAULT_MAX_INTERVAL 600.0
+
+/**
+ * @brief Adaptive scheduler policy configuration
+ */
+typedef struct {
+    double min_interval_s;          // Interval right after a state change
+    double base_interval_s;         // Interval for servers without history
+    double max_interval_s;          // Ceiling for long-stable servers
+    double growth_factor;           // Interval multiplier per stable check
+    double shrink_factor;           // Interval divisor after a latency excursion
+    double latency_tolerance;       // Relative latency change still considered stable
+    double min_excursion_ms;        // Absolute latency change ignored below this
+    unsigned stable_threshold;      // Stable checks required before stretching
+} SchedulerConfig;
+
+/**
+ * @brief Get default scheduler configuration
+ *
+ * @return Default configuration structure
+ */
+SchedulerConfig scheduler_get_default_config(void);
+
+/**
+ * @brief Validate scheduler configuration bounds
+ *
+ * @param config Pointer to scheduler configuration
+ * @return true if valid, false otherwise
+ */
+bool scheduler_config_validate(const SchedulerConfig *config);
+
+/**
+ * @brief Reset a server's schedule so it is due immediately
+ *
+ * @param server Pointer to server
+ * @param config Pointer to scheduler configuration
+ */
+void scheduler_reset_server(Server *server, const SchedulerConfig *config);
+
+/**
+ * @brief Adapt a server's interval after a check completed
+ *
+ * Going from online to any other status, or back, resets the interval to
+ * the minimum; one failure status turning into another does not. A latency
+ * excursion shrinks it by shrink_factor, and a run of stable checks
+ * stretches it by growth_factor up to the maximum.
+ *
+ * @param server Pointer to checked server (already updated)
+ * @param prev_status Status before the check
+ * @param prev_latency_ms Latency before the check
+ * @param config Pointer to scheduler configuration
+ * @param now_ms Current monotonic time in milliseconds
+ */
+void scheduler_on_result(Server *server, ServerStatus prev_status, double prev_latency_ms,
+                         const SchedulerConfig *config, double now_ms);
+
+/**
+ * @brief Check whether a server is due for a check
+ *
+ * @param server Pointer to server
+ * @param now_ms Current monotonic time in milliseconds
+ * @return true if due
+ */
+bool scheduler_is_due(const Server *server, double now_ms);
+
+/**
+ * @brief Run continuous monitoring until scheduler_stop() is called
+ *
+ * @param data Pointer to server data
+ * @param checker_config Pointer to checker configuration
+ * @param config Pointer to scheduler configuration
+ * @param thread_count Number of threads to use
+ * @param check_ftp Monitor FTP category
+ * @param check_tv Monitor TV category
+ * @param check_others Monitor others category
+ * @param stats Pointer to cumulative statistics (optional)
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int scheduler_run(ServerData *data, const CheckerConfig *checker_config,
+                  const SchedulerConfig *config, int thread_count,
+                  bool check_ftp, bool check_tv, bool check_others,
+                  CheckerStats *stats);
+
+/**
+ * @brief Request the monitoring loop to stop (async-signal-safe)
+ */
+void scheduler_stop(void);
+
+#endif // BDIX_SCHEDULER_H
@@ -9,6 +9,12 @@
 
 #include "common.h"
 
+// Recent-sample tracking
+#define SERVER_SAMPLE_RING 32           // Samples kept per server
+#define SERVER_EWMA_ALPHA 0.2           // Weight of the newest latency in the EWMA
+#define SERVER_JITTER_GAIN (1.0 / 16.0) // RFC 3550 interarrival jitter gain
+#define SERVER_STABLE_UPTIME_PCT 99.0   // Uptime needed to count as stable
+
 /**
  * @brief Server category types
  */
@@ -27,9 +33,74 @@ typedef enum {
     BDIX_STATUS_ONLINE,
     BDIX_STATUS_OFFLINE,
     BDIX_STATUS_TIMEOUT,
-    BDIX_STATUS_ERROR
+    BDIX_STATUS_ERROR,
+    BDIX_STATUS_CUTOFF              // Timed out at its adaptive deadline, before the full timeout
 } ServerStatus;
 
+/**
+ * @brief Per-server adaptive scheduling state (continuous monitoring)
+ */
+typedef struct {
+    double interval_s;              // Current check interval in seconds
+    double next_check_ms;           // Monotonic time of next due check (0 = due now)
+    unsigned stable_checks;         // Consecutive checks without a change
+} ServerSchedule;
+
+/**
+ * @brief Debounced up/down tracking used for state-change alerts
+ */
+typedef struct {
+    ServerStatus confirmed;         // Last confirmed status (UNKNOWN until first check)
+    uint32_t window;                // Recent observations, newest in bit 0 (1 = online)
+    unsigned window_len;            // Valid observations in window
+} ServerTransition;
+
+/**
+ * @brief One recent check result
+ */
+typedef struct {
+    float latency_ms;
+    ServerStatus status;
+} ServerSample;
+
+/**
+ * @brief Recent samples and incrementally maintained latency/uptime metrics
+ */
+typedef struct {
+    ServerSample samples[SERVER_SAMPLE_RING];  // Ring of recent results
+    unsigned head;                  // Next write position
+    unsigned count;                 // Valid samples (<= SERVER_SAMPLE_RING)
+    unsigned up_count;              // ONLINE samples currently in the ring
+    bool has_latency;               // At least one ONLINE check seen
+    double ewma_latency_ms;         // Smoothed latency of ONLINE checks
+    double jitter_ms;               // Smoothed variation between consecutive ONLINE latencies
+    double last_up_latency_ms;      // Latency of the previous ONLINE check
+} ServerMetrics;
+
+/**
+ * @brief Duration of each phase of the last check (from curl timing info)
+ *
+ * Phases that were not reached (e.g. TLS for plain HTTP, or everything
+ * after a failed connect) are 0.
+ */
+typedef struct {
+    double dns_ms;                  // Name resolution
+    double connect_ms;              // TCP handshake
+    double tls_ms;                  // TLS handshake
+    double server_ms;               // Request sent until first response byte
+    double total_ms;                // Whole transfer
+} ServerTiming;
+
+/**
+ * @brief Raw round-trip time from the last ICMP echo probe
+ */
+typedef struct {
+    double min_ms;                  // Fastest reply
+    double avg_ms;                  // Mean over received replies
+    unsigned sent;                  // Echo requests sent (0 = not probed)
+    unsigned received;              // Replies received
+} ServerPing;
+
 /**
  * @brief Individual server information
  */
@@ -39,6 +110,11 @@ typedef struct {
     double latency_ms;
     long response_code;
     time_t last_checked;
+    ServerTiming timing;            // Phase breakdown of latency_ms
+    ServerPing ping;                // ICMP RTT (when probed)
+    ServerSchedule schedule;
+    ServerTransition transition;
+    ServerMetrics metrics;
 } Server;
 
 /**
@@ -109,6 +185,45 @@ Server* server_category_get(ServerCategory *category, size_t index);
 void server_update_status(Server *server, ServerStatus status,
                          double latency_ms, long response_code);
 
+/**
+ * @brief Record the server's current status and latency as a new sample
+ *
+ * Updates the ring, EWMA latency, jitter and rolling uptime in O(1).
+ * Called by server_update_status().
+ *
+ * @param server Pointer to server
+ */
+void server_metrics_record(Server *server);
+
+/**
+ * @brief Rolling uptime over the samples in the ring
+ *
+ * @param server Pointer to server
+ * @return Uptime percentage, or -1.0 if the server has no samples
+ */
+double server_uptime_pct(const Server *server);
+
+/**
+ * @brief Latency quantile over the ONLINE samples in the ring
+ *
+ * Nearest-rank quantile of at most SERVER_SAMPLE_RING values, so cheap
+ * enough to compute before every check.
+ *
+ * @param server Pointer to server
+ * @param q Quantile in [0, 1] (0.5 = median)
+ * @return Latency in milliseconds, or -1.0 if there are no ONLINE samples
+ */
+double server_latency_quantile(const Server *server, double q);
+
+/**
+ * @brief Find the online server with the lowest EWMA latency among stable ones
+ *
+ * @param data Pointer to server data
+ * @param min_uptime_pct Minimum rolling uptime to qualify
+ * @return Pointer to server or NULL if none qualifies
+ */
+const Server* server_data_fastest_stable(const ServerData *data, double min_uptime_pct);
+
 /**
  * @brief Initialize server data structure
  *
@@ -0,0 +1,119 @@
+/**
+ * @file tcp_probe.h
+ * @brief TCP connect reachability sweep from a single thread
+ * @version 1.0.0
+ *
+ * Each distinct host:port is resolved once (in parallel), then one thread
+ * starts non-blocking connect() calls and waits for them with epoll, each
+ * with its own deadline. A connection counts as online as soon as the
+ * handshake completes and is closed right away with a reset, so neither
+ * side keeps it in TIME_WAIT.
+ *
+ * With io_uring enabled the same sweep is driven by one ring instead:
+ * connect (and, in HTTP HEAD mode, a minimal request/response exchange
+ * through registered buffers) is submitted as one linked chain per probe,
+ * with linked timeouts as deadlines, so a whole batch costs one syscall.
+ */
+
+#ifndef BDIX_TCP_PROBE_H
+#define BDIX_TCP_PROBE_H
+
+#include "common.h"
+#include "server.h"
+#include "cancel.h"
+
+struct curl_slist;
+
+#define TCP_PROBE_FD_RESERVE 64     // Descriptors left for the rest of the process
+#define TCP_PROBE_MAX_EVENTS 256    // Events handled per epoll_wait
+#define TCP_PROBE_URING_ENTRIES 4096 // io_uring submission queue size
+#define TCP_PROBE_REQUEST_MAX 896   // Registered buffer bytes for a HEAD request
+#define TCP_PROBE_RESPONSE_MAX 128  // Registered buffer bytes for the status line
+
+/**
+ * @brief Called for every server once its host:port has a result
+ *
+ * @param server Server whose status was just updated
+ * @param ctx Caller context
+ */
+typedef void (*TcpProbeCallback)(Server *server, void *ctx);
+
+/**
+ * @brief What a probe checks once connected
+ */
+typedef enum {
+    TCP_PROBE_CONNECT,              // Handshake only, one probe per host:port
+    TCP_PROBE_HTTP_HEAD             // HEAD request per server over plain HTTP (io_uring only)
+} TcpProbeMode;
+
+/**
+ * @brief TCP sweep configuration
+ */
+typedef struct {
+    int timeout_ms;                 // Deadline per connection
+    int response_timeout_ms;        // Deadline for the HTTP response after connecting
+    size_t max_in_flight;           // Concurrent connects, 0 = derive from RLIMIT_NOFILE
+    int resolver_threads;           // Parallel name lookups before the sweep
+    const struct curl_slist *resolve; // host:port:address pins, as for CURLOPT_RESOLVE (optional)
+    TcpProbeMode mode;
+    bool io_uring;                  // Drive the sweep with io_uring instead of epoll
+    CancelToken *cancel;            // Ends the sweep early (optional)
+} TcpProbeConfig;
+
+/**
+ * @brief Get default TCP sweep configuration
+ *
+ * @return Default configuration structure
+ */
+TcpProbeConfig tcp_probe_get_default_config(void);
+
+/**
+ * @brief Parse the port of a URL, defaulting by scheme
+ *
+ * @param url Server URL
+ * @return Port number (80 for unknown schemes without a port)
+ */
+int tcp_probe_url_port(const char *url);
+
+/**
+ * @brief Check whether a URL can be probed in TCP_PROBE_HTTP_HEAD mode
+ *
+ * @param url Server URL
+ * @return true for http:// URLs
+ */
+bool tcp_probe_supports_http(const char *url);
+
+/**
+ * @brief Connect to every server's host:port and record the result
+ *
+ * In TCP_PROBE_CONNECT mode status is ONLINE when the handshake completes,
+ * OFFLINE when refused, TIMEOUT after the deadline and ERROR otherwise;
+ * latency is the time to the SYN-ACK (timing.connect_ms) and timing.dns_ms
+ * the lookup time. Servers sharing a host:port share one connection attempt.
+ *
+ * In TCP_PROBE_HTTP_HEAD mode every server gets its own HEAD request and is
+ * classified like the curl checker: ONLINE for 2xx/3xx, OFFLINE for other
+ * status codes, TIMEOUT past either deadline and ERROR when the connection
+ * fails. A status line that arrives in pieces is read until it ends or
+ * fills TCP_PROBE_RESPONSE_MAX. This mode needs io_uring;
+ * BDIX_ERROR_UNSUPPORTED is returned before any server is touched when the
+ * ring cannot be set up, so the caller can fall back. If the ring fails
+ * later, the servers not finished yet are reported as ERROR and
+ * BDIX_ERROR_NETWORK is returned. In connect mode the sweep falls back to
+ * epoll by itself.
+ *
+ * Once config->cancel is cancelled no further probes start, the ones in
+ * flight are dropped and their servers, like those never probed, are left
+ * untouched and not reported.
+ *
+ * @param servers Array of server pointers
+ * @param count Number of servers
+ * @param config Sweep configuration
+ * @param on_result Called from the sweep thread per server (optional)
+ * @param ctx Passed to on_result
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int tcp_probe_servers(Server *const *servers, size_t count, const TcpProbeConfig *config,
+                      TcpProbeCallback on_result, void *ctx);
+
+#endif // BDIX_TCP_PROBE_H
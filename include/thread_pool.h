@@ -10,34 +10,231 @@
 #include "common.h"
 #include <pthread.h>
 
+#define THREAD_POOL_TUNE_INTERVAL_MS 100.0 // Autotuning control period
+#define THREAD_POOL_TUNE_CPU_HIGH 0.85      // CPU share of all cores above which the pool shrinks
+#define THREAD_POOL_TUNE_STEP 4             // Additive increase after slow start
+#define THREAD_POOL_TUNE_DROP 0.10          // Throughput loss after a raise that signals overload
+#define THREAD_POOL_TUNE_INFLATION 1.5      // Run time growth after a raise that signals overload
+#define THREAD_POOL_HIST_BUCKETS 28         // Power-of-two microsecond buckets (last is +Inf)
+
 /**
  * @brief Work item function signature
  * @param arg Work item argument
- * @return Result pointer (unused, should return NULL)
+ * @return Result pointer (the task result for thread_pool_submit(), ignored otherwise)
  */
 typedef void* (*thread_pool_func_t)(void *arg);
 
+/**
+ * @brief Continuation function signature
+ * @param result Result of the task the continuation was attached to
+ * @param arg Continuation argument
+ * @return Result of the continuation
+ */
+typedef void* (*thread_pool_then_t)(void *result, void *arg);
+
+/**
+ * @brief Function run for each index of a range
+ * @param ctx Range context
+ * @param index Position in the range, from 0
+ */
+typedef void (*thread_pool_range_func_t)(void *ctx, size_t index);
+
+/**
+ * @brief Handle of submitted work with a result (opaque)
+ */
+typedef struct ThreadPoolTask ThreadPoolTask;
+
+/**
+ * @brief Set of tasks in one pool that can be waited on together (opaque)
+ */
+typedef struct ThreadPoolGroup ThreadPoolGroup;
+
 /**
  * @brief Thread pool work item
  */
 typedef struct work_item {
     thread_pool_func_t function;    // Function to execute
-    void *arg;                      // Function argument
+    void *arg;                      // Function argument (range context for range items)
+    thread_pool_range_func_t range; // Set instead of function for an index claimed from a range
+    size_t index;                   // That index
+    double ready_ms;                // Monotonic time the item may run (delayed items)
+    uint64_t trace_us;              // Submission time when tracing (0 otherwise)
+    double queued_ms;               // Monotonic time the item entered the run queue
+    double priority;                // Lower runs first (prioritized pools only)
+    uint64_t seq;                   // Submission order, breaks priority ties
     struct work_item *next;         // Next item in queue
 } WorkItem;
 
 /**
- * @brief Thread pool structure
+ * @brief Distribution of durations in power-of-two microsecond buckets
+ *
+ * Bucket 0 counts durations below 1 us, bucket b those from 2^(b-1) to
+ * 2^b us, and the last one everything longer (about 67 s and up).
+ */
+typedef struct {
+    uint64_t counts[THREAD_POOL_HIST_BUCKETS];
+    uint64_t count;                 // Observations
+    double sum_ms;                  // Their total
+    double max_ms;                  // The longest
+} ThreadPoolHistogram;
+
+/**
+ * @brief Time accounting of one worker thread
+ */
+typedef struct {
+    double busy_ms;                 // Running work items (counted as each one finishes)
+    double idle_ms;                 // Parked on work_cond
+    uint64_t tasks;                 // Work items run
+    uint64_t wakeups;               // Returns from waiting on work_cond
+    uint64_t empty_wakeups;         // Wakeups that went back to waiting without work
+} ThreadPoolWorkerStats;
+
+/**
+ * @brief Worker thread slot
+ */
+typedef struct {
+    struct thread_pool *pool;
+    ThreadPoolWorkerStats stats;    // Protected by queue_mutex
+} ThreadPoolWorker;
+
+/**
+ * @brief Snapshot of a pool's scheduling statistics
+ *
+ * Shows where a sweep's time goes between the run queue and the workers:
+ * a queue wait that grows with the thread count while workers sit idle,
+ * many contended queue_mutex acquisitions, or far more done_cond wakeups
+ * than thread_pool_wait() needs all point at the pool rather than the
+ * network. Release with thread_pool_stats_free().
  */
 typedef struct {
+    double elapsed_ms;              // Since the pool was created
+    size_t threads;                 // Worker threads started
+    size_t pending;                 // Items queued or deferred
+    size_t working;                 // Items running
+    ThreadPoolHistogram queue_wait; // Enqueue to start of run
+    ThreadPoolHistogram run;        // Run time
+    ThreadPoolHistogram lock_wait;  // queue_mutex acquisitions that had to block
+    uint64_t lock_acquisitions;     // Every queue_mutex acquisition, stats readers included
+    uint64_t lock_contended;        // Of those, the ones that had to block
+    uint64_t work_signals;          // work_cond signals and broadcasts
+    uint64_t done_signals;          // done_cond signals
+    uint64_t done_wakeups;          // Returns from waiting on done_cond
+    uint64_t producer_waits;        // Submissions that blocked on a full queue
+    double producer_wait_ms;        // Time they spent blocked
+    ThreadPoolWorkerStats *workers; // One entry per started thread
+} ThreadPoolStats;
+
+/**
+ * @brief Lazily generated work: one function applied to indices 0..count-1
+ */
+typedef struct thread_pool_range {
+    thread_pool_range_func_t function;
+    void *ctx;
+    size_t count;
+    size_t next;                    // Next index to hand out
+    double added_ms;                // Monotonic time the range was added
+    struct thread_pool_range *next_range;
+} ThreadPoolRange;
+
+/**
+ * @brief Thread pool configuration
+ */
+typedef struct {
+    size_t threads;                 // Workers at creation, and the concurrency without autotuning
+    size_t max_threads;             // Autotuning ceiling (at most MAX_AUTOTUNE_THREADS)
+    bool prioritized;               // Run queue ordered by priority (see thread_pool_create_prioritized)
+    bool autotune;                  // Adjust the concurrency to the observed load
+    double tune_interval_ms;        // Autotuning control period
+    size_t queue_capacity;          // Most items queued or deferred before submitters block (0 = unbounded)
+} ThreadPoolConfig;
+
+/**
+ * @brief Autotuning state (protected by queue_mutex)
+ *
+ * Every interval, a pool whose workers are all busy while work waits
+ * grows its concurrency limit, doubling at first ("slow start") and then
+ * by THREAD_POOL_TUNE_STEP, as long as the process has CPU to spare and
+ * a raise did not cost throughput while inflating run times; otherwise
+ * the limit drops by a quarter. Once nothing waits, the limit shrinks
+ * towards what Little's law says the observed load needs:
+ * throughput x mean run time.
+ */
+typedef struct {
+    bool enabled;
+    double interval_ms;
+    double cpus;                    // Online CPUs, for the process CPU share
+    double epoch_start_ms;          // Start of the current measurement interval
+    double epoch_cpu_ms;            // Process CPU time at that start
+    size_t completed;               // Items finished in this interval
+    double run_ms;                  // Their total run time
+    size_t dequeued;                // Items taken from the run queue in this interval
+    double wait_ms;                 // Their total queueing delay
+    double last_throughput;         // Items per second in the previous interval
+    double last_run_ms;             // Mean run time in the previous interval
+    bool raised;                    // The previous interval raised the limit
+    bool slow_start;                // Still doubling
+    size_t settled;                 // Limit at the last interval with work waiting
+    size_t peak;                    // Highest limit reached
+    unsigned adjustments;           // Limit changes
+} ThreadPoolTuner;
+
+/**
+ * @brief Concurrency of a pool
+ */
+typedef struct {
+    size_t limit;                   // Workers currently allowed to run work
+    size_t settled;                 // Limit the autotuner settled on under load
+    size_t peak;                    // Highest limit reached
+    size_t threads;                 // Worker threads started
+    unsigned adjustments;           // Autotuning changes of the limit
+} ThreadPoolConcurrency;
+
+/**
+ * @brief Thread pool structure
+ */
+typedef struct thread_pool {
     pthread_t *threads;             // Array of worker threads
-    size_t thread_count;            // Number of threads
+    ThreadPoolWorker *workers;      // Per-thread slots, same size as threads
+    size_t thread_count;            // Number of threads started
+    size_t thread_capacity;         // Size of the threads array
+    _Atomic size_t concurrency;     // Workers allowed to run work at once
+    ThreadPoolTuner tuner;
 
     WorkItem *work_queue_head;      // Queue head
     WorkItem *work_queue_tail;      // Queue tail
+    bool prioritized;               // Run queue is heap instead of the FIFO list
+    WorkItem **heap;                // Min-heap on (priority, seq) for prioritized pools
+    size_t heap_count;
+    size_t heap_capacity;
+    uint64_t next_seq;
+    size_t run_count;               // Items in the run queue
+    WorkItem *delayed_head;         // Deferred items sorted by ready time
+    ThreadPoolRange *ranges_head;   // Ranges with indices left, in the order added
+    ThreadPoolRange *ranges_tail;
+    size_t range_remaining;         // Indices not yet handed out, over all ranges
+    size_t queue_capacity;          // Bound on queued and deferred items (0 = none)
+    size_t space_waiters;           // Submitters blocked on a full queue
     pthread_mutex_t queue_mutex;    // Queue protection mutex
     pthread_cond_t work_cond;       // Work available condition
     pthread_cond_t done_cond;       // All work done condition
+    pthread_cond_t space_cond;      // Room in a bounded queue
+    pthread_mutex_t task_mutex;     // Protects task and group completion state
+    pthread_cond_t task_cond;       // A task finished
+    size_t task_waiters;            // Threads in task and group waits (protected by task_mutex)
+    ThreadPoolGroup *groups;        // Groups not yet destroyed (protected by task_mutex)
+
+    // Scheduling statistics (protected by queue_mutex)
+    double created_ms;
+    ThreadPoolHistogram queue_wait_hist;
+    ThreadPoolHistogram run_hist;
+    ThreadPoolHistogram lock_wait_hist;
+    uint64_t lock_acquisitions;
+    uint64_t lock_contended;
+    uint64_t work_signals;
+    uint64_t done_signals;
+    uint64_t done_wakeups;
+    uint64_t producer_waits;
+    double producer_wait_ms;
 
     _Atomic size_t working_count;   // Number of threads currently working
     _Atomic size_t pending_count;   // Number of pending work items
@@ -52,9 +249,89 @@ typedef struct {
  */
 ThreadPool* thread_pool_create(size_t thread_count);
 
+/**
+ * @brief Create a thread pool that runs queued work by priority
+ *
+ * The run queue is a min-heap: the item with the lowest priority value
+ * runs first, items of equal priority in submission order. Work added
+ * without a priority gets 0.
+ *
+ * @param thread_count Number of worker threads to create
+ * @return Pointer to thread pool or NULL on error
+ */
+ThreadPool* thread_pool_create_prioritized(size_t thread_count);
+
+/**
+ * @brief Get default pool configuration (DEFAULT_THREADS, FIFO, fixed size)
+ *
+ * @return Default configuration structure
+ */
+ThreadPoolConfig thread_pool_get_default_config(void);
+
+/**
+ * @brief Create a thread pool from a configuration
+ *
+ * Without autotuning, config->threads must be at most MAX_THREADS. With
+ * it, the pool starts config->threads workers and starts more, up to
+ * config->max_threads, as the autotuner raises its concurrency limit.
+ * Tuning runs on workers finishing work and on threads waiting in
+ * thread_pool_wait(), thread_pool_wait_timeout() or on tasks and groups.
+ *
+ * @param config Pointer to configuration
+ * @return Pointer to thread pool or NULL on error
+ */
+ThreadPool* thread_pool_create_with_config(const ThreadPoolConfig *config);
+
+/**
+ * @brief Get the concurrency of a pool
+ *
+ * @param pool Pointer to thread pool
+ * @return Current limit, settled and peak limit, and threads started
+ */
+ThreadPoolConcurrency thread_pool_get_concurrency(ThreadPool *pool);
+
+/**
+ * @brief Take a snapshot of a pool's scheduling statistics
+ *
+ * @param pool Pointer to thread pool
+ * @param stats Filled in; release with thread_pool_stats_free()
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int thread_pool_get_stats(ThreadPool *pool, ThreadPoolStats *stats);
+
+/**
+ * @brief Release the per-worker array of a snapshot
+ *
+ * @param stats Snapshot (NULL is ignored)
+ */
+void thread_pool_stats_free(ThreadPoolStats *stats);
+
+/**
+ * @brief Record a duration in a histogram
+ *
+ * @param hist Histogram
+ * @param ms Duration in milliseconds
+ */
+void thread_pool_histogram_add(ThreadPoolHistogram *hist, double ms);
+
+/**
+ * @brief Estimate a quantile from a histogram
+ *
+ * Interpolates within the bucket, so the error is below a factor of two.
+ *
+ * @param hist Histogram
+ * @param q Quantile (0..1)
+ * @return Duration in milliseconds (0 without observations)
+ */
+double thread_pool_histogram_quantile(const ThreadPoolHistogram *hist, double q);
+
 /**
  * @brief Add work to the thread pool
  *
+ * On a pool with a queue_capacity, blocks while the queue is full, unless
+ * called from one of the pool's own workers (retries, deferrals and
+ * continuations must not wait for the workers that would drain the queue).
+ *
  * @param pool Pointer to thread pool
  * @param function Function to execute
  * @param arg Argument to pass to function
@@ -62,6 +339,79 @@ ThreadPool* thread_pool_create(size_t thread_count);
  */
 int thread_pool_add_work(ThreadPool *pool, thread_pool_func_t function, void *arg);
 
+/**
+ * @brief Add work unless a bounded queue is full
+ *
+ * Lets a producer do something else (or yield) instead of blocking.
+ *
+ * @param pool Pointer to thread pool
+ * @param function Function to execute
+ * @param arg Argument to pass to function
+ * @return BDIX_SUCCESS on success, BDIX_ERROR_BUSY if the queue is full, error code otherwise
+ */
+int thread_pool_try_add_work(ThreadPool *pool, thread_pool_func_t function, void *arg);
+
+/**
+ * @brief Add work for indices 0..count-1 without queuing an item per index
+ *
+ * Workers take the next index themselves when the run queue is empty, so
+ * memory stays constant however long the range is. Indices are handed
+ * out in order; queued items (e.g. retries) go first. The range counts
+ * as count pending items, but not against the queue_capacity; on a
+ * bounded pool, indices are only handed out while the queue is not full.
+ *
+ * @param pool Pointer to thread pool
+ * @param function Function called with ctx and each index
+ * @param ctx Context passed to function; must stay valid until the range is done
+ * @param count Number of indices
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int thread_pool_add_range(ThreadPool *pool, thread_pool_range_func_t function, void *ctx,
+                          size_t count);
+
+/**
+ * @brief Add work that must not start before a delay has elapsed
+ *
+ * Deferred items are held in a separate time-ordered list and do not
+ * occupy a worker thread while waiting. They count as pending work.
+ *
+ * @param pool Pointer to thread pool
+ * @param function Function to execute
+ * @param arg Argument to pass to function
+ * @param delay_ms Minimum delay before execution in milliseconds
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int thread_pool_add_work_delayed(ThreadPool *pool, thread_pool_func_t function,
+                                 void *arg, double delay_ms);
+
+/**
+ * @brief Add work with a priority, optionally after a delay
+ *
+ * On a pool from thread_pool_create() the priority is ignored and work
+ * runs in FIFO order. Deferred work keeps its priority once it is due.
+ * Blocks on a full bounded queue like thread_pool_add_work().
+ *
+ * @param pool Pointer to thread pool
+ * @param function Function to execute
+ * @param arg Argument to pass to function
+ * @param priority Lower values run first
+ * @param delay_ms Minimum delay before execution in milliseconds (0 = none)
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int thread_pool_add_work_priority(ThreadPool *pool, thread_pool_func_t function, void *arg,
+                                  double priority, double delay_ms);
+
+/**
+ * @brief Make all deferred work runnable now
+ *
+ * Used when a sweep is cancelled, so deferred items run (and drop out)
+ * at once instead of holding thread_pool_wait() until their delay ends.
+ *
+ * @param pool Pointer to thread pool
+ * @return Number of items released
+ */
+size_t thread_pool_release_delayed(ThreadPool *pool);
+
 /**
  * @brief Wait for all work to complete
  *
@@ -70,9 +420,145 @@ int thread_pool_add_work(ThreadPool *pool, thread_pool_func_t function, void *ar
  */
 int thread_pool_wait(ThreadPool *pool);
 
+/**
+ * @brief Wait for all work to complete, giving up after a timeout
+ *
+ * Lets the caller act while work is still running, e.g. cancel it.
+ *
+ * @param pool Pointer to thread pool
+ * @param timeout_ms Longest wait in milliseconds
+ * @return BDIX_SUCCESS once idle, BDIX_ERROR if work is still running
+ */
+int thread_pool_wait_timeout(ThreadPool *pool, int timeout_ms);
+
+/**
+ * @brief Submit work and get a handle to its result
+ *
+ * Tasks run as ordinary work items, so they share the workers, the queue
+ * order and thread_pool_wait() with everything else in the pool. The
+ * handle must be released with thread_pool_task_release(). Do not wait on
+ * a task from inside the pool; chain it with thread_pool_task_then().
+ *
+ * @param pool Pointer to thread pool
+ * @param group Group the task belongs to (NULL = none); must be of the same pool
+ * @param function Function to execute; its return value is the task result
+ * @param arg Argument to pass to function
+ * @return Task handle, or NULL on error
+ */
+ThreadPoolTask* thread_pool_submit(ThreadPool *pool, ThreadPoolGroup *group,
+                                   thread_pool_func_t function, void *arg);
+
+/**
+ * @brief Run a continuation on the result of a task once it finishes
+ *
+ * The continuation is queued on the task's pool and joins the task's
+ * group; if the task already finished, it is queued at once. Should the
+ * pool be shutting down, the continuation finishes with a NULL result
+ * without running.
+ *
+ * @param task Task to continue
+ * @param function Continuation, called with the task's result
+ * @param arg Argument to pass to function
+ * @return Handle of the continuation, or NULL on error
+ */
+ThreadPoolTask* thread_pool_task_then(ThreadPoolTask *task, thread_pool_then_t function, void *arg);
+
+/**
+ * @brief Wait for a task and get its result
+ *
+ * @param task Task handle
+ * @return Result returned by the task function (NULL for a NULL task)
+ */
+void* thread_pool_task_wait(ThreadPoolTask *task);
+
+/**
+ * @brief Wait until any of several tasks has finished
+ *
+ * @param tasks Task handles, all of the same pool
+ * @param count Number of handles
+ * @return Index of a finished task (the lowest one), or count on invalid input
+ */
+size_t thread_pool_task_wait_any(ThreadPoolTask *const *tasks, size_t count);
+
+/**
+ * @brief Check whether a task has finished
+ *
+ * @param task Task handle
+ * @return true once the result is available
+ */
+bool thread_pool_task_done(ThreadPoolTask *task);
+
+/**
+ * @brief Release a task handle
+ *
+ * The task still runs if it has not yet; only the handle goes away.
+ *
+ * @param task Task handle (NULL is ignored)
+ */
+void thread_pool_task_release(ThreadPoolTask *task);
+
+/**
+ * @brief Create a task group in a pool
+ *
+ * @param pool Pointer to thread pool
+ * @return Group, or NULL on error
+ */
+ThreadPoolGroup* thread_pool_group_create(ThreadPool *pool);
+
+/**
+ * @brief Add work to a group without keeping a handle
+ *
+ * @param group Group
+ * @param function Function to execute (its result is discarded)
+ * @param arg Argument to pass to function
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int thread_pool_group_add_work(ThreadPoolGroup *group, thread_pool_func_t function, void *arg);
+
+/**
+ * @brief Wait until every task of a group, continuations included, has finished
+ *
+ * Other work in the pool may keep running.
+ *
+ * @param group Group
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int thread_pool_group_wait(ThreadPoolGroup *group);
+
+/**
+ * @brief Wait for a group, giving up after a timeout
+ *
+ * @param group Group
+ * @param timeout_ms Longest wait in milliseconds
+ * @return BDIX_SUCCESS once the group is idle, BDIX_ERROR if tasks are still outstanding
+ */
+int thread_pool_group_wait_timeout(ThreadPoolGroup *group, int timeout_ms);
+
+/**
+ * @brief Get the number of unfinished tasks in a group
+ *
+ * @param group Group
+ * @return Tasks submitted or chained to the group that have not finished
+ */
+size_t thread_pool_group_pending(ThreadPoolGroup *group);
+
+/**
+ * @brief Wait for a group and free it
+ *
+ * Only needed before the pool is destroyed, which frees the groups left.
+ *
+ * @param group Group (NULL is ignored)
+ */
+void thread_pool_group_destroy(ThreadPoolGroup *group);
+
 /**
  * @brief Destroy thread pool and free resources
  *
+ * Queued work is dropped. Tasks that never ran, and their continuations,
+ * finish with a NULL result so pending waits return. Their handles can
+ * still be released once the pool is gone. Groups not yet destroyed are
+ * freed with the pool and must not be used afterwards.
+ *
  * @param pool Pointer to thread pool
  */
 void thread_pool_destroy(ThreadPool *pool);
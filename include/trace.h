@@ -0,0 +1,95 @@
+/**
+ * @file trace.h
+ * @brief Span tracer writing Chrome trace-event JSON
+ * @version 1.0.0
+ *
+ * Spans are appended to per-thread buffers without locks and written out
+ * by trace_stop(). Open the file in chrome://tracing or ui.perfetto.dev.
+ * When tracing is off, trace_begin() and trace_end() cost one relaxed
+ * atomic load.
+ */
+
+#ifndef BDIX_TRACE_H
+#define BDIX_TRACE_H
+
+#include "common.h"
+
+#define TRACE_CHUNK_EVENTS 1024     // Events per buffer chunk
+#define TRACE_MAX_EVENTS 1000000    // Further events are dropped (~40 MB)
+
+// Span categories
+#define TRACE_CAT_POOL "pool"
+#define TRACE_CAT_CHECK "check"
+#define TRACE_CAT_UI "ui"
+
+extern _Atomic bool g_trace_enabled;
+
+/**
+ * @brief Start recording spans
+ *
+ * @param path File the trace is written to by trace_stop()
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int trace_start(const char *path);
+
+/**
+ * @brief Stop recording, write the trace file and free all buffers
+ *
+ * Call once every thread that recorded spans has finished (pools
+ * destroyed, background threads joined).
+ *
+ * @return BDIX_SUCCESS on success (or if tracing was off), error code otherwise
+ */
+int trace_stop(void);
+
+/**
+ * @brief Monotonic clock in microseconds
+ *
+ * @return Current time
+ */
+uint64_t trace_clock_us(void);
+
+/**
+ * @brief Record a complete span on the calling thread's buffer
+ *
+ * @param category Span category (string literal)
+ * @param name Span name (string literal)
+ * @param start_us Start time from trace_clock_us()
+ * @param end_us End time from trace_clock_us()
+ * @param detail Optional argument shown with the span; must stay valid until trace_stop()
+ */
+void trace_record(const char *category, const char *name, uint64_t start_us,
+                  uint64_t end_us, const char *detail);
+
+/**
+ * @brief Number of spans dropped because TRACE_MAX_EVENTS was reached
+ *
+ * @return Dropped span count
+ */
+size_t trace_dropped_count(void);
+
+/**
+ * @brief Begin a span
+ *
+ * @return Start time, or 0 when tracing is off
+ */
+static inline uint64_t trace_begin(void) {
+    return atomic_load_explicit(&g_trace_enabled, memory_order_relaxed) ? trace_clock_us() : 0;
+}
+
+/**
+ * @brief End a span started with trace_begin()
+ *
+ * @param category Span category (string literal)
+ * @param name Span name (string literal)
+ * @param start Value returned by trace_begin()
+ * @param detail Optional argument (see trace_record())
+ */
+static inline void trace_end(const char *category, const char *name, uint64_t start,
+                             const char *detail) {
+    if (start != 0) {
+        trace_record(category, name, start, trace_clock_us(), detail);
+    }
+}
+
+#endif // BDIX_TRACE_H
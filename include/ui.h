@@ -20,6 +20,7 @@ typedef struct {
     bool show_only_ok;              // Show only successful checks
     bool show_progress;             // Show progress indicators
     bool show_latency;              // Show latency information
+    bool show_timing;               // Show DNS/connect/TLS/server breakdown
     bool use_colors;                // Use colored output
     bool verbose;                   // Verbose output mode
 } UIConfig;
@@ -94,6 +95,15 @@ int ui_export_results_md(const ServerData *data, const char *filename);
 void ui_print_check_result(const Server *server, const char *category,
                            size_t current, size_t total, bool show_only_ok);
 
+/**
+ * @brief Print the fastest online servers of a set, fastest first
+ *
+ * @param category Category name
+ * @param servers Servers sorted by latency
+ * @param count Number of servers (nothing is printed for 0)
+ */
+void ui_print_fastest_servers(const char *category, const Server *const *servers, size_t count);
+
 /**
  * @brief Print progress bar
  *
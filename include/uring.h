@@ -0,0 +1,116 @@
+/**
+ * @file uring.h
+ * @brief Minimal io_uring ring on top of the raw system calls
+ * @version 1.0.0
+ *
+ * Just enough of io_uring for the probe engines: map the submission and
+ * completion rings, hand out SQEs, submit/wait in one call and register
+ * fixed buffers. No liburing dependency; callers fill SQEs with the
+ * opcodes from <linux/io_uring.h> directly.
+ */
+
+#ifndef BDIX_URING_H
+#define BDIX_URING_H
+
+#include "common.h"
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+/**
+ * @brief Opaque ring handle
+ */
+typedef struct UringRing UringRing;
+
+/**
+ * @brief Check whether io_uring can be used for socket probes
+ *
+ * True when a ring can be created and the kernel supports connect, linked
+ * timeouts, fixed-buffer reads/writes and close. The result is cached.
+ *
+ * @return true if the io_uring probe backend is usable
+ */
+bool uring_available(void);
+
+/**
+ * @brief Create a ring
+ *
+ * @param entries Submission queue size (the completion queue is twice that)
+ * @return Ring or NULL on failure (errno is set)
+ */
+UringRing* uring_create(unsigned entries);
+
+/**
+ * @brief Unmap and close a ring
+ *
+ * @param ring Ring to destroy (NULL is ignored)
+ */
+void uring_destroy(UringRing *ring);
+
+/**
+ * @brief Completion queue size of a ring
+ *
+ * @param ring Ring
+ * @return Number of CQ entries
+ */
+unsigned uring_cq_entries(const UringRing *ring);
+
+/**
+ * @brief Free submission queue slots
+ *
+ * @param ring Ring
+ * @return SQEs that uring_get_sqe() can still hand out before a submit
+ */
+unsigned uring_sq_space(const UringRing *ring);
+
+/**
+ * @brief Get a zeroed submission queue entry
+ *
+ * The entry is queued by the next uring_submit().
+ *
+ * @param ring Ring
+ * @return SQE or NULL when the submission queue is full
+ */
+struct io_uring_sqe* uring_get_sqe(UringRing *ring);
+
+/**
+ * @brief Submit queued SQEs and optionally wait for completions
+ *
+ * @param ring Ring
+ * @param wait_nr Completions to wait for (0 = do not block)
+ * @return Number of SQEs submitted, or -errno
+ */
+int uring_submit(UringRing *ring, unsigned wait_nr);
+
+/**
+ * @brief Submit queued SQEs and wait for completions, at most timeout_ms
+ *
+ * Kernels without IORING_FEAT_EXT_ARG (before 5.11) ignore the timeout and
+ * wait like uring_submit().
+ *
+ * @param ring Ring
+ * @param wait_nr Completions to wait for (0 = do not block)
+ * @param timeout_ms Longest wait (negative = unbounded)
+ * @return Number of SQEs submitted, -ETIME on timeout, or -errno
+ */
+int uring_submit_timeout(UringRing *ring, unsigned wait_nr, int timeout_ms);
+
+/**
+ * @brief Pop the next completion if there is one
+ *
+ * @param ring Ring
+ * @param cqe Receives a copy of the completion
+ * @return true if a completion was returned
+ */
+bool uring_peek_cqe(UringRing *ring, struct io_uring_cqe *cqe);
+
+/**
+ * @brief Register fixed buffers for IORING_OP_READ_FIXED/WRITE_FIXED
+ *
+ * @param ring Ring
+ * @param iovecs Buffers; SQEs refer to them by index (buf_index)
+ * @param count Number of buffers
+ * @return BDIX_SUCCESS on success, error code otherwise
+ */
+int uring_register_buffers(UringRing *ring, const struct iovec *iovecs, unsigned count);
+
+#endif // BDIX_URING_H
@@ -0,0 +1,459 @@
+/**
+ * @file alert.c
+ * @brief State-change detection and batched alert delivery implementation
+ * @version 1.0.0
+ */
+
+#include "alert.h"
+#include <curl/curl.h>
+#include <jansson.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+// Sink thread polling interval while the queue is empty
+#define ALERT_POLL_MS 50
+
+/**
+ * @brief Get default alerting configuration
+ */
+AlertConfig alert_get_default_config(void) {
+    AlertConfig config = {
+        .confirm_n = ALERT_DEFAULT_CONFIRM_N,
+        .window_m = ALERT_DEFAULT_WINDOW_M,
+        .sink = ALERT_SINK_NONE,
+        .queue_capacity = ALERT_DEFAULT_QUEUE_CAPACITY,
+        .batch_size = ALERT_DEFAULT_BATCH_SIZE,
+        .flush_interval_ms = ALERT_DEFAULT_FLUSH_MS,
+        .sink_timeout_seconds = ALERT_DEFAULT_SINK_TIMEOUT
+    };
+    config.target[0] = '\0';
+    return config;
+}
+
+/**
+ * @brief Feed a check result into a server's N-of-M transition detector
+ */
+bool alert_detect_transition(Server *server, unsigned confirm_n, unsigned window_m,
+                             ServerStatus *from) {
+    if (!server || confirm_n == 0 || window_m == 0 ||
+        window_m > ALERT_MAX_WINDOW || confirm_n > window_m) {
+        return false;
+    }
+
+    ServerTransition *t = &server->transition;
+    bool up = server->status == BDIX_STATUS_ONLINE;
+    uint32_t mask = window_m == 32 ? UINT32_MAX : ((1u << window_m) - 1u);
+
+    t->window = ((t->window << 1) | (up ? 1u : 0u)) & mask;
+    if (t->window_len < window_m) {
+        t->window_len++;
+    }
+
+    // First observation establishes the baseline without alerting
+    if (t->confirmed == BDIX_STATUS_UNKNOWN) {
+        t->confirmed = server->status;
+        return false;
+    }
+
+    bool confirmed_up = t->confirmed == BDIX_STATUS_ONLINE;
+    if (up == confirmed_up) {
+        // Track the latest flavour of the confirmed state (e.g. OFFLINE -> TIMEOUT)
+        t->confirmed = server->status;
+        return false;
+    }
+
+    unsigned up_count = (unsigned)__builtin_popcount(t->window);
+    unsigned disagree = confirmed_up ? t->window_len - up_count : up_count;
+    if (disagree < confirm_n) {
+        return false;
+    }
+
+    if (from) {
+        *from = t->confirmed;
+    }
+    t->confirmed = server->status;
+
+    // Start the new state with a clean, full window so one reversal cannot re-trigger
+    t->window = up ? mask : 0u;
+    t->window_len = window_m;
+    return true;
+}
+
+/**
+ * @brief Enqueue an event without blocking (bounded MPMC queue)
+ */
+int alert_enqueue(AlertManager *manager, const AlertEvent *event) {
+    if (!manager || !event) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    size_t pos = atomic_load_explicit(&manager->enqueue_pos, memory_order_relaxed);
+    AlertSlot *slot;
+
+    while (true) {
+        slot = &manager->slots[pos & manager->mask];
+        size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&manager->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return BDIX_ERROR;  // Queue full
+        } else {
+            pos = atomic_load_explicit(&manager->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    slot->event = *event;
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Dequeue one event (sink thread only)
+ */
+static bool alert_dequeue(AlertManager *manager, AlertEvent *event) {
+    size_t pos = atomic_load_explicit(&manager->dequeue_pos, memory_order_relaxed);
+    AlertSlot *slot = &manager->slots[pos & manager->mask];
+    size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+
+    if ((intptr_t)seq - (intptr_t)(pos + 1) < 0) {
+        return false;  // Empty
+    }
+
+    *event = slot->event;
+    atomic_store_explicit(&manager->dequeue_pos, pos + 1, memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, pos + manager->mask + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Serialize a batch of events to a JSON string (caller frees)
+ */
+static char* batch_to_json(const AlertEvent *events, size_t count) {
+    json_t *root = json_object();
+    json_t *array = json_array();
+
+    for (size_t i = 0; i < count; i++) {
+        json_t *item = json_object();
+        json_object_set_new(item, "url", json_string(events[i].url));
+        json_object_set_new(item, "from", json_string(server_status_name(events[i].from)));
+        json_object_set_new(item, "to", json_string(server_status_name(events[i].to)));
+        json_object_set_new(item, "latency_ms", json_real(events[i].latency_ms));
+        json_object_set_new(item, "response_code", json_integer(events[i].response_code));
+        json_object_set_new(item, "timestamp", json_integer((json_int_t)events[i].timestamp));
+        json_array_append_new(array, item);
+    }
+
+    json_object_set_new(root, "source", json_string("bdix-monitor"));
+    json_object_set_new(root, "events", array);
+
+    char *body = json_dumps(root, JSON_COMPACT);
+    json_decref(root);
+    return body;
+}
+
+/**
+ * @brief CURL write callback that discards the webhook response
+ */
+static size_t alert_discard_callback(void *contents, size_t size, size_t nmemb, void *userp) {
+    UNUSED(contents);
+    UNUSED(userp);
+    return size * nmemb;
+}
+
+/**
+ * @brief POST a JSON batch to the configured webhook
+ */
+static int deliver_webhook(const AlertConfig *config, const char *body) {
+    CURL *curl = curl_easy_init();
+    if (!curl) {
+        LOG_ERROR("Failed to initialize CURL handle for alert webhook");
+        return BDIX_ERROR;
+    }
+
+    struct curl_slist *headers = curl_slist_append(NULL, "Content-Type: application/json");
+
+    curl_easy_setopt(curl, CURLOPT_URL, config->target);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, (long)config->sink_timeout_seconds);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, alert_discard_callback);
+
+    CURLcode res = curl_easy_perform(curl);
+    long response_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
+
+    if (res != CURLE_OK || response_code < 200 || response_code >= 300) {
+        LOG_WARN("Alert webhook failed: %s (HTTP %ld)",
+                 res != CURLE_OK ? curl_easy_strerror(res) : "bad status", response_code);
+        return BDIX_ERROR_NETWORK;
+    }
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Run the configured command with the JSON batch on its stdin
+ */
+static int deliver_command(const AlertConfig *config, const char *body) {
+    int sv[2];
+
+    // A socket pair lets us write with MSG_NOSIGNAL if the command exits early
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        LOG_ERROR("Failed to create alert command channel (errno: %d)", errno);
+        return BDIX_ERROR;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        LOG_ERROR("Failed to fork alert command (errno: %d)", errno);
+        close(sv[0]);
+        close(sv[1]);
+        return BDIX_ERROR;
+    }
+
+    if (pid == 0) {
+        close(sv[0]);
+        dup2(sv[1], STDIN_FILENO);
+        close(sv[1]);
+        execl(config->target, config->target, (char*)NULL); // flawfinder: ignore - fixed path, no shell
+        _exit(127);
+    }
+
+    close(sv[1]);
+
+    size_t len = strlen(body); /* flawfinder: ignore - json_dumps output is null-terminated */
+    size_t sent = 0;
+    while (sent < len) {
+        ssize_t n = send(sv[0], body + sent, len - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        sent += (size_t)n;
+    }
+    close(sv[0]);
+
+    // Wait for the command with a deadline so a hung hook cannot stall the sink
+    double deadline = get_time_ms() + config->sink_timeout_seconds * 1000.0;
+    int status = 0;
+    pid_t done;
+    while ((done = waitpid(pid, &status, WNOHANG)) == 0 && get_time_ms() < deadline) {
+        sleep_ms(10);
+    }
+
+    if (done == 0) {
+        LOG_WARN("Alert command timed out, killing pid %ld", (long)pid);
+        kill(pid, SIGKILL);
+        waitpid(pid, &status, 0);
+        return BDIX_ERROR;
+    }
+
+    if (done < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        LOG_WARN("Alert command failed (status: %d)", status);
+        return BDIX_ERROR;
+    }
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Deliver one batch of events to the configured sink
+ */
+static void deliver_batch(AlertManager *manager, const AlertEvent *events, size_t count) {
+    int ret = BDIX_SUCCESS;
+
+    if (manager->config.sink == ALERT_SINK_NONE) {
+        for (size_t i = 0; i < count; i++) {
+            LOG_WARN("State change: %s %s -> %s", events[i].url,
+                     server_status_name(events[i].from), server_status_name(events[i].to));
+        }
+    } else {
+        char *body = batch_to_json(events, count);
+        if (!body) {
+            LOG_ERROR("Failed to serialize alert batch");
+            ret = BDIX_ERROR;
+        } else {
+            ret = manager->config.sink == ALERT_SINK_WEBHOOK
+                      ? deliver_webhook(&manager->config, body)
+                      : deliver_command(&manager->config, body);
+            free(body);
+        }
+    }
+
+    if (ret == BDIX_SUCCESS) {
+        atomic_fetch_add(&manager->delivered, count);
+    } else {
+        atomic_fetch_add(&manager->failed, count);
+    }
+}
+
+/**
+ * @brief Sink thread: drain the queue and deliver batches
+ */
+static void* sink_thread(void *arg) {
+    AlertManager *manager = (AlertManager*)arg;
+    AlertEvent *batch = safe_calloc(manager->config.batch_size, sizeof(AlertEvent));
+    size_t count = 0;
+    double first_ms = 0.0;
+
+    while (true) {
+        bool stopping = atomic_load(&manager->shutdown);
+
+        while (count < manager->config.batch_size && alert_dequeue(manager, &batch[count])) {
+            if (count == 0) {
+                first_ms = get_time_ms();
+            }
+            count++;
+        }
+
+        bool due = count > 0 &&
+                   (stopping || count >= manager->config.batch_size ||
+                    get_time_ms() - first_ms >= manager->config.flush_interval_ms);
+        if (due) {
+            deliver_batch(manager, batch, count);
+            count = 0;
+            continue;
+        }
+
+        if (stopping && count == 0) {
+            break;
+        }
+
+        sleep_ms(ALERT_POLL_MS);
+    }
+
+    free(batch);
+    return NULL;
+}
+
+/**
+ * @brief Create an alert manager and start its sink thread
+ */
+AlertManager* alert_manager_create(const AlertConfig *config) {
+    if (!config || config->confirm_n == 0 || config->window_m == 0 ||
+        config->window_m > ALERT_MAX_WINDOW || config->confirm_n > config->window_m ||
+        config->batch_size == 0 || config->queue_capacity == 0) {
+        LOG_ERROR("Invalid alert configuration");
+        return NULL;
+    }
+
+    if (config->sink == ALERT_SINK_WEBHOOK && !is_valid_url(config->target)) {
+        LOG_ERROR("Invalid alert webhook URL: %s", config->target);
+        return NULL;
+    }
+
+    if (config->sink == ALERT_SINK_COMMAND && access(config->target, X_OK) != 0) { // flawfinder: ignore
+        LOG_ERROR("Alert command is not executable: %s", config->target);
+        return NULL;
+    }
+
+    AlertManager *manager = safe_calloc(1, sizeof(AlertManager));
+    manager->config = *config;
+
+    size_t capacity = 1;
+    while (capacity < config->queue_capacity) {
+        capacity <<= 1;
+    }
+    manager->mask = capacity - 1;
+    manager->slots = safe_calloc(capacity, sizeof(AlertSlot));
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_store(&manager->slots[i].sequence, i);
+    }
+
+    atomic_store(&manager->enqueue_pos, 0);
+    atomic_store(&manager->dequeue_pos, 0);
+    atomic_store(&manager->shutdown, false);
+
+    if (pthread_create(&manager->sink_thread, NULL, sink_thread, manager) != 0) {
+        LOG_ERROR("Failed to create alert sink thread");
+        free(manager->slots);
+        free(manager);
+        return NULL;
+    }
+    manager->sink_running = true;
+
+    LOG_DEBUG("Alert manager created (%u-of-%u confirmation)", config->confirm_n, config->window_m);
+    return manager;
+}
+
+/**
+ * @brief Deliver all queued events and stop the sink thread
+ */
+void alert_manager_flush(AlertManager *manager) {
+    if (!manager || !manager->sink_running) {
+        return;
+    }
+
+    atomic_store(&manager->shutdown, true);
+    pthread_join(manager->sink_thread, NULL);
+    manager->sink_running = false;
+}
+
+/**
+ * @brief Flush pending events, stop the sink thread and free resources
+ */
+void alert_manager_destroy(AlertManager *manager) {
+    if (!manager) {
+        return;
+    }
+
+    alert_manager_flush(manager);
+
+    free(manager->slots);
+    free(manager);
+}
+
+/**
+ * @brief Run the detector for a server and enqueue an event on transition
+ */
+bool alert_observe(AlertManager *manager, Server *server) {
+    if (!manager || !server) {
+        return false;
+    }
+
+    ServerStatus from = BDIX_STATUS_UNKNOWN;
+    if (!alert_detect_transition(server, manager->config.confirm_n,
+                                 manager->config.window_m, &from)) {
+        return false;
+    }
+
+    atomic_fetch_add(&manager->detected, 1);
+
+    AlertEvent event = {
+        .from = from,
+        .to = server->status,
+        .latency_ms = server->latency_ms,
+        .response_code = server->response_code,
+        .timestamp = server->last_checked
+    };
+    // Both buffers are MAX_URL_LENGTH and server URLs are always terminated
+    memcpy(event.url, server->url, sizeof(event.url));
+
+    if (alert_enqueue(manager, &event) != BDIX_SUCCESS) {
+        atomic_fetch_add(&manager->dropped, 1);
+        LOG_WARN("Alert queue full, dropping event for %s", server->url);
+    }
+    return true;
+}
+
+/**
+ * @brief Print alerting counters
+ */
+/* flawfinder: ignore - all printf calls below use compile-time constant format strings */
+void alert_manager_print_stats(const AlertManager *manager) {
+    if (!manager) {
+        return;
+    }
+
+    printf("Alerts: %zu detected, %zu delivered, %zu failed, %zu dropped\n", // flawfinder: ignore
+           atomic_load(&manager->detected), atomic_load(&manager->delivered),
+           atomic_load(&manager->failed), atomic_load(&manager->dropped));
+}
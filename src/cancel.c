@@ -0,0 +1,167 @@
+/**
+ * @file cancel.c
+ * @brief Cancellation of a running sweep
+ * @version 1.0.0
+ */
+
+#include "cancel.h"
+#include <sys/socket.h>
+
+#define CANCEL_INITIAL_FDS 16
+
+/**
+ * @brief Initialize a token
+ */
+int cancel_token_init(CancelToken *token) {
+    return cancel_token_init_child(token, NULL);
+}
+
+/**
+ * @brief Initialize a token that is also cancelled with a parent
+ */
+int cancel_token_init_child(CancelToken *token, CancelToken *parent) {
+    if (!token) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+    memset(token, 0, sizeof(*token));
+    atomic_store(&token->cancelled, false);
+    atomic_store(&token->requested, false);
+    atomic_store(&token->deadline_ms, 0.0);
+    token->parent = parent;
+    if (pthread_mutex_init(&token->lock, NULL) != 0) {
+        LOG_ERROR("Failed to initialize cancel token mutex");
+        return BDIX_ERROR_THREAD;
+    }
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Release a token's resources
+ */
+void cancel_token_destroy(CancelToken *token) {
+    if (!token) {
+        return;
+    }
+    pthread_mutex_destroy(&token->lock);
+    free(token->fds);
+    token->fds = NULL;
+    token->fd_count = 0;
+    token->fd_capacity = 0;
+}
+
+/**
+ * @brief Cancel now and shut down every registered socket
+ */
+void cancel_token_cancel(CancelToken *token) {
+    if (!token || atomic_exchange(&token->cancelled, true)) {
+        return;
+    }
+
+    // Registered sockets are only closed after being removed under the lock
+    pthread_mutex_lock(&token->lock);
+    for (size_t i = 0; i < token->fd_count; i++) {
+        shutdown(token->fds[i], SHUT_RDWR);
+    }
+    pthread_mutex_unlock(&token->lock);
+}
+
+/**
+ * @brief Ask for a cancel without blocking (async-signal-safe)
+ */
+void cancel_token_request(CancelToken *token) {
+    if (token) {
+        atomic_store(&token->requested, true);
+    }
+}
+
+/**
+ * @brief Cancel at a point in time; an earlier deadline already set wins
+ */
+void cancel_token_set_deadline(CancelToken *token, double deadline_ms) {
+    if (!token) {
+        return;
+    }
+    double current = atomic_load(&token->deadline_ms);
+    while (current == 0.0 || deadline_ms < current) {
+        if (atomic_compare_exchange_weak(&token->deadline_ms, &current, deadline_ms)) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Check whether work should stop, cancelling once the deadline passed
+ */
+bool cancel_token_check(CancelToken *token) {
+    if (!token) {
+        return false;
+    }
+    if (atomic_load(&token->cancelled)) {
+        return true;
+    }
+    double deadline = atomic_load(&token->deadline_ms);
+    if (atomic_load(&token->requested) || (deadline > 0.0 && get_time_ms() >= deadline) ||
+        cancel_token_check(token->parent)) {
+        cancel_token_cancel(token);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Clamp a wait so the waiter wakes up at the deadline
+ */
+int cancel_token_wait_ms(const CancelToken *token, int max_ms) {
+    if (!token) {
+        return max_ms;
+    }
+    if (atomic_load(&token->cancelled) || atomic_load(&token->requested)) {
+        return 0;
+    }
+    if (token->parent) {
+        int parent_ms = cancel_token_wait_ms(token->parent, CANCEL_POLL_MS);
+        max_ms = max_ms >= 0 && max_ms < parent_ms ? max_ms : parent_ms;
+    }
+    double deadline = atomic_load(&token->deadline_ms);
+    if (deadline <= 0.0) {
+        return max_ms;
+    }
+    double remaining = deadline - get_time_ms();
+    if (remaining <= 0.0) {
+        return 0;
+    }
+    int wait_ms = (int)ceil(remaining);
+    return max_ms >= 0 && max_ms < wait_ms ? max_ms : wait_ms;
+}
+
+/**
+ * @brief Register a socket to shut down on cancel
+ */
+bool cancel_token_add_fd(CancelToken *token, int fd) {
+    pthread_mutex_lock(&token->lock);
+    if (atomic_load(&token->cancelled)) {
+        pthread_mutex_unlock(&token->lock);
+        return false;
+    }
+    if (token->fd_count == token->fd_capacity) {
+        token->fd_capacity = token->fd_capacity ? token->fd_capacity * 2 : CANCEL_INITIAL_FDS;
+        token->fds = safe_realloc(token->fds, token->fd_capacity * sizeof(int));
+    }
+    token->fds[token->fd_count++] = fd;
+    pthread_mutex_unlock(&token->lock);
+    return true;
+}
+
+/**
+ * @brief Unregister a socket before it is closed
+ */
+void cancel_token_remove_fd(CancelToken *token, int fd) {
+    pthread_mutex_lock(&token->lock);
+    for (size_t i = 0; i < token->fd_count; i++) {
+        if (token->fds[i] == fd) {
+            token->fds[i] = token->fds[--token->fd_count];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&token->lock);
+}
@@ -5,9 +5,14 @@
  */
 
 #include "checker.h"
+#include "tcp_probe.h"
 #include "thread_pool.h"
+#include "trace.h"
+#include "metrics.h"
 #include "ui.h"
 #include <curl/curl.h>
+#include <pthread.h>
+#include <inttypes.h>
 
 /**
  * @brief CURL write callback that discards data
@@ -18,6 +23,145 @@ static size_t curl_discard_callback(void *contents, size_t size, size_t nmemb, v
     return size * nmemb;
 }
 
+#define CHECKER_CURL_CODES 128      // Cached error counters (covers all CURLcode values)
+
+/**
+ * @brief Checker metrics, registered on first use
+ */
+static struct {
+    Metric *status[BDIX_STATUS_CUTOFF + 1];
+    Metric *duration;
+    Metric *sweep_duration;
+    Metric *bytes_sent;
+    Metric *bytes_received;
+    Metric *adaptive_timeouts;
+    Metric *retries;
+    Metric *hedges;
+    Metric *hedge_wins;
+    Metric *_Atomic curl_errors[CHECKER_CURL_CODES];
+} g_checker_metrics;
+static pthread_once_t g_checker_metrics_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Register the checker metrics (once, via g_checker_metrics_once)
+ */
+static void register_metrics(void) {
+    static const char *const names[] = {
+        [BDIX_STATUS_ONLINE] = "bdix_checks_total{status=\"online\"}",
+        [BDIX_STATUS_OFFLINE] = "bdix_checks_total{status=\"offline\"}",
+        [BDIX_STATUS_TIMEOUT] = "bdix_checks_total{status=\"timeout\"}",
+        [BDIX_STATUS_ERROR] = "bdix_checks_total{status=\"error\"}",
+        [BDIX_STATUS_CUTOFF] = "bdix_checks_total{status=\"cutoff\"}"
+    };
+    for (size_t i = BDIX_STATUS_ONLINE; i < ARRAY_SIZE(names); i++) {
+        g_checker_metrics.status[i] = metrics_counter(names[i], "Completed checks by result");
+    }
+    g_checker_metrics.duration = metrics_histogram("bdix_check_duration_ms", "Time per check (curl total time or TCP connect time)");
+    g_checker_metrics.sweep_duration = metrics_histogram("bdix_sweep_duration_ms", "Time to check one server set");
+    g_checker_metrics.bytes_sent = metrics_counter("bdix_check_bytes_sent_total", "Request bytes sent");
+    g_checker_metrics.bytes_received = metrics_counter("bdix_check_bytes_received_total",
+                                                       "Header and body bytes received");
+    g_checker_metrics.adaptive_timeouts = metrics_counter("bdix_adaptive_timeouts_total",
+                                                          "Checks cut off by a shortened per-server deadline");
+    g_checker_metrics.retries = metrics_counter("bdix_retries_total", "Checks retried after a timeout or error");
+    g_checker_metrics.hedges = metrics_counter("bdix_hedges_total", "Hedged requests sent for slow checks");
+    g_checker_metrics.hedge_wins = metrics_counter("bdix_hedge_wins_total",
+                                                   "Hedged requests that answered first");
+}
+
+/**
+ * @brief Count a curl error by code, registering its counter on first use
+ */
+static void count_curl_error(CURLcode code) {
+    bool cached = (size_t)code < CHECKER_CURL_CODES;
+    Metric *metric = cached ?
+        atomic_load_explicit(&g_checker_metrics.curl_errors[code], memory_order_acquire) : NULL;
+
+    if (!metric) {
+        char name[METRICS_NAME_MAX]; /* flawfinder: ignore - bounds checked with snprintf */
+        snprintf(name, sizeof(name), "bdix_curl_errors_total{code=\"%d\"}", (int)code); // flawfinder: ignore
+        metric = metrics_counter(name, "Failed checks by curl error code");
+        if (cached) {
+            atomic_store_explicit(&g_checker_metrics.curl_errors[code], metric, memory_order_release);
+        }
+    }
+    metrics_add(metric, 1);
+}
+
+/**
+ * @brief Record a check's status and duration in the metrics registry
+ */
+static void record_result_metrics(const Server *server) {
+    pthread_once(&g_checker_metrics_once, register_metrics);
+
+    if (server->status >= BDIX_STATUS_ONLINE && server->status <= BDIX_STATUS_CUTOFF) {
+        metrics_add(g_checker_metrics.status[server->status], 1);
+    }
+    metrics_observe(g_checker_metrics.duration, server->latency_ms);
+}
+
+/**
+ * @brief Record one curl transfer (attempt or hedge) in the metrics registry
+ */
+static void record_transfer_metrics(CURL *curl, CURLcode res) {
+    pthread_once(&g_checker_metrics_once, register_metrics);
+
+    if (res != CURLE_OK) {
+        count_curl_error(res);
+    }
+
+    long request_size = 0;
+    long header_size = 0;
+    curl_off_t body_size = 0;
+    curl_easy_getinfo(curl, CURLINFO_REQUEST_SIZE, &request_size);
+    curl_easy_getinfo(curl, CURLINFO_HEADER_SIZE, &header_size);
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &body_size);
+    metrics_add(g_checker_metrics.bytes_sent, request_size > 0 ? (uint64_t)request_size : 0);
+    metrics_add(g_checker_metrics.bytes_received,
+                (header_size > 0 ? (uint64_t)header_size : 0) + (body_size > 0 ? (uint64_t)body_size : 0));
+}
+
+/**
+ * @brief Read a curl timing value in milliseconds (0 if unavailable)
+ */
+static double curl_time_ms(CURL *curl, CURLINFO info) {
+    curl_off_t us = 0;
+    if (curl_easy_getinfo(curl, info, &us) != CURLE_OK || us < 0) {
+        return 0.0;
+    }
+    return (double)us / 1000.0;
+}
+
+/**
+ * @brief Split curl's cumulative timestamps into per-phase durations
+ */
+static ServerTiming read_timing(CURL *curl) {
+    double lookup = curl_time_ms(curl, CURLINFO_NAMELOOKUP_TIME_T);
+    double connect = curl_time_ms(curl, CURLINFO_CONNECT_TIME_T);
+    double appconnect = curl_time_ms(curl, CURLINFO_APPCONNECT_TIME_T);
+    double start_transfer = curl_time_ms(curl, CURLINFO_STARTTRANSFER_TIME_T);
+
+    // Unreached phases report 0; the request goes out after the last handshake
+    double request_sent = appconnect > 0.0 ? appconnect : connect;
+    return (ServerTiming){
+        .dns_ms = lookup,
+        .connect_ms = connect > 0.0 ? MAX(connect - lookup, 0.0) : 0.0,
+        .tls_ms = appconnect > 0.0 ? MAX(appconnect - connect, 0.0) : 0.0,
+        .server_ms = start_transfer > 0.0 ? MAX(start_transfer - request_sent, 0.0) : 0.0,
+        .total_ms = curl_time_ms(curl, CURLINFO_TOTAL_TIME_T)
+    };
+}
+
+/**
+ * @brief Add to an atomic double
+ */
+static void atomic_add_double(_Atomic double *target, double value) {
+    double current = atomic_load(target);
+    while (!atomic_compare_exchange_weak(target, &current, current + value)) {
+        // Retry on failure
+    }
+}
+
 /**
  * @brief Initialize checker subsystem
  */
@@ -50,75 +194,528 @@ CheckerConfig checker_get_default_config(void) {
         .follow_redirects = false,
         .max_redirects = 0,
         .verify_ssl = true,
-        .verbose = true
+        .verbose = true,
+        .rate_limiter = NULL,
+        .alerts = NULL,
+        .history = NULL,
+        .resolve = NULL,
+        .icmp = NULL,
+        .engine = CHECK_ENGINE_CURL,
+        .io_uring = false,
+        .adaptive_timeout = NULL,
+        .top_k = 0,
+        .top_k_grace_ms = TOP_K_GRACE_MS,
+        .retry = NULL,
+        .cancel = NULL,
+        .prioritize = false,
+        .dead_timeout_ms = 0,
+        .autotune_threads = false,
+        .max_threads = DEFAULT_AUTOTUNE_MAX_THREADS,
+        .pool = NULL
     };
 }
 
 /**
- * @brief Check a single server
+ * @brief Get default adaptive timeout policy
  */
-int checker_check_server(Server *server, const CheckerConfig *config) {
-    if (!server || !config) {
-        LOG_ERROR("Invalid parameters for server check");
-        return BDIX_ERROR_INVALID_INPUT;
+AdaptiveTimeoutPolicy checker_get_default_adaptive_timeout(void) {
+    return (AdaptiveTimeoutPolicy){
+        .quantile = ADAPTIVE_TIMEOUT_QUANTILE,
+        .multiplier = ADAPTIVE_TIMEOUT_MULTIPLIER,
+        .floor_ms = ADAPTIVE_TIMEOUT_FLOOR_MS,
+        .ceiling_ms = 0,
+        .min_samples = ADAPTIVE_TIMEOUT_MIN_SAMPLES
+    };
+}
+
+/**
+ * @brief Status of the n-th most recent sample (0 = newest), UNKNOWN if absent
+ */
+static ServerStatus recent_status(const Server *server, unsigned n) {
+    const ServerMetrics *m = &server->metrics;
+    if (n >= m->count) {
+        return BDIX_STATUS_UNKNOWN;
+    }
+    return m->samples[(m->head + SERVER_SAMPLE_RING - 1 - n) % SERVER_SAMPLE_RING].status;
+}
+
+/**
+ * @brief Compute the deadlines for a server's next check
+ */
+bool checker_server_deadlines(const Server *server, const CheckerConfig *config,
+                              long *timeout_ms, long *connect_timeout_ms) {
+    *timeout_ms = (long)config->timeout_seconds * 1000;
+    *connect_timeout_ms = (long)config->connect_timeout_seconds * 1000;
+
+    // Servers that never answered lately get a short look, not the full timeout
+    if (config->dead_timeout_ms > 0 && server && server->metrics.up_count == 0 &&
+        server->metrics.count >= CHECKER_DEAD_MIN_SAMPLES &&
+        config->dead_timeout_ms < *timeout_ms) {
+        *timeout_ms = config->dead_timeout_ms;
+        if (*connect_timeout_ms > *timeout_ms) {
+            *connect_timeout_ms = *timeout_ms;
+        }
+        return true;
+    }
+
+    const AdaptiveTimeoutPolicy *policy = config->adaptive_timeout;
+    if (!policy || !server || server->metrics.up_count < policy->min_samples) {
+        return false;
+    }
+    // After the first timeout under a shortened deadline, allow the full one once
+    ServerStatus last = recent_status(server, 0);
+    if ((last == BDIX_STATUS_CUTOFF || last == BDIX_STATUS_TIMEOUT) &&
+        recent_status(server, 1) == BDIX_STATUS_ONLINE) {
+        return false;
     }
 
+    double deadline = server_latency_quantile(server, policy->quantile) * policy->multiplier;
+    if (policy->ceiling_ms > 0 && deadline > policy->ceiling_ms) {
+        deadline = policy->ceiling_ms;
+    }
+    if (deadline < policy->floor_ms) {
+        deadline = policy->floor_ms;
+    }
+    if (deadline >= *timeout_ms) {
+        return false;
+    }
+
+    *timeout_ms = (long)ceil(deadline);
+    if (*connect_timeout_ms > *timeout_ms) {
+        *connect_timeout_ms = *timeout_ms;
+    }
+    return true;
+}
+
+/**
+ * @brief Scheduling priority of a server from its recent results
+ */
+double checker_server_priority(const Server *server) {
+    const ServerMetrics *m = &server->metrics;
+    if (m->count == 0) {
+        return CHECKER_PRIORITY_UNKNOWN;
+    }
+    if (recent_status(server, 0) == BDIX_STATUS_ONLINE) {
+        return m->has_latency ? m->ewma_latency_ms : server->latency_ms;
+    }
+    return CHECKER_PRIORITY_UNKNOWN * (2.0 - (double)m->up_count / (double)m->count);
+}
+
+/**
+ * @brief CURL socket callback: register each connection with the cancel token
+ */
+static curl_socket_t open_socket_callback(void *clientp, curlsocktype purpose,
+                                          struct curl_sockaddr *address) {
+    UNUSED(purpose);
+    curl_socket_t fd = socket(address->family, address->socktype, address->protocol);
+    if (fd != CURL_SOCKET_BAD && !cancel_token_add_fd((CancelToken*)clientp, fd)) {
+        close(fd);
+        return CURL_SOCKET_BAD;
+    }
+    return fd;
+}
+
+static int close_socket_callback(void *clientp, curl_socket_t fd) {
+    cancel_token_remove_fd((CancelToken*)clientp, fd);
+    return close(fd);
+}
+
+/**
+ * @brief CURL progress callback: abort the transfer once cancelled
+ */
+static int cancel_progress_callback(void *clientp, curl_off_t dltotal, curl_off_t dlnow,
+                                    curl_off_t ultotal, curl_off_t ulnow) {
+    UNUSED(dltotal);
+    UNUSED(dlnow);
+    UNUSED(ultotal);
+    UNUSED(ulnow);
+    return cancel_token_check((CancelToken*)clientp) ? 1 : 0;
+}
+
+/**
+ * @brief Outcome of one check, before it is recorded on the server
+ */
+typedef struct {
+    ServerStatus status;
+    double latency_ms;
+    long response_code;
+    ServerTiming timing;
+    bool hedged;                    // A hedge was sent
+} CheckAttempt;
+
+/**
+ * @brief Create a configured HEAD request handle for a server
+ */
+static CURL* create_check_handle(const Server *server, const CheckerConfig *config,
+                                 CancelToken *cancel, long *timeout_ms, bool *adapted) {
     CURL *curl = curl_easy_init();
     if (!curl) {
         LOG_ERROR("Failed to initialize CURL handle");
-        return BDIX_ERROR;
+        return NULL;
     }
 
     // Configure CURL for secure operation
     curl_easy_setopt(curl, CURLOPT_URL, server->url);
     curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);  // HEAD request
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, (long)config->timeout_seconds);
-    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, (long)config->connect_timeout_seconds);
+    long connect_timeout_ms;
+    *adapted = checker_server_deadlines(server, config, timeout_ms, &connect_timeout_ms);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, *timeout_ms);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, connect_timeout_ms);
     curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, config->follow_redirects ? 1L : 0L);
     curl_easy_setopt(curl, CURLOPT_MAXREDIRS, (long)config->max_redirects);
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, config->verify_ssl ? 1L : 0L);
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, config->verify_ssl ? 2L : 0L);
     curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);  // Thread safety
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_discard_callback);
+    if (config->resolve) {
+        curl_easy_setopt(curl, CURLOPT_RESOLVE, config->resolve);
+    }
+    if (cancel) {
+        curl_easy_setopt(curl, CURLOPT_OPENSOCKETFUNCTION, open_socket_callback);
+        curl_easy_setopt(curl, CURLOPT_OPENSOCKETDATA, cancel);
+        curl_easy_setopt(curl, CURLOPT_CLOSESOCKETFUNCTION, close_socket_callback);
+        curl_easy_setopt(curl, CURLOPT_CLOSESOCKETDATA, cancel);
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, cancel_progress_callback);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, cancel);
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    }
 
     // Disable verbose output
     curl_easy_setopt(curl, CURLOPT_VERBOSE, 0L);
+    return curl;
+}
 
-    // Measure latency
-    double start_time = get_time_ms();
-    CURLcode res = curl_easy_perform(curl);
-    double latency_ms = get_time_ms() - start_time;
+/**
+ * @brief Classify a finished transfer
+ *
+ * elapsed_ms is used when curl reports no total time.
+ */
+static void read_attempt(CURL *curl, CURLcode res, double elapsed_ms, const Server *server,
+                         long timeout_ms, bool adapted, CheckAttempt *attempt) {
+    // curl's own timers exclude handle setup and split the latency by phase
+    attempt->timing = read_timing(curl);
+    attempt->latency_ms = attempt->timing.total_ms > 0.0 ? attempt->timing.total_ms : elapsed_ms;
 
     // Get response code
-    long response_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+    attempt->response_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &attempt->response_code);
 
     // Determine status
-    ServerStatus status;
     if (res == CURLE_OK) {
-        if (response_code >= 200 && response_code < 400) {
-            status = BDIX_STATUS_ONLINE;
+        if (attempt->response_code >= 200 && attempt->response_code < 400) {
+            attempt->status = BDIX_STATUS_ONLINE;
         } else {
-            status = BDIX_STATUS_OFFLINE;
+            attempt->status = BDIX_STATUS_OFFLINE;
         }
     } else if (res == CURLE_OPERATION_TIMEDOUT) {
-        status = BDIX_STATUS_TIMEOUT;
+        // Hitting the adaptive deadline says a server got slow, which uptime,
+        // alerts and history keep apart from a full timeout; a server without
+        // ONLINE samples was given the dead-server deadline and just timed out
+        attempt->status = adapted && server->metrics.up_count > 0 ? BDIX_STATUS_CUTOFF :
+                          BDIX_STATUS_TIMEOUT;
+        if (adapted) {
+            pthread_once(&g_checker_metrics_once, register_metrics);
+            metrics_add(g_checker_metrics.adaptive_timeouts, 1);
+            LOG_DEBUG("%s timed out after its adaptive deadline of %ld ms", server->url, timeout_ms);
+        }
     } else {
-        status = BDIX_STATUS_ERROR;
+        attempt->status = BDIX_STATUS_ERROR;
         LOG_DEBUG("CURL error for %s: %s", server->url, curl_easy_strerror(res));
     }
 
-    // Update server status
-    server_update_status(server, status, latency_ms, response_code);
+    record_transfer_metrics(curl, res);
+}
+
+/**
+ * @brief Delay after which a check of this server is hedged, or -1 for none
+ *
+ * The configured quantile of the server's recent ONLINE latencies, so only
+ * servers with some history are hedged, and only when that comes well
+ * before the deadline.
+ */
+static double hedge_delay_ms(const Server *server, const CheckerConfig *config, long timeout_ms) {
+    const RetryBudget *budget = config->retry;
+    if (!budget || budget->config.hedge_quantile <= 0.0 ||
+        server->metrics.up_count < RETRY_HEDGE_MIN_SAMPLES) {
+        return -1.0;
+    }
+    double delay = MAX(server_latency_quantile(server, budget->config.hedge_quantile),
+                       budget->config.hedge_min_ms);
+    return delay < timeout_ms / 2.0 ? delay : -1.0;
+}
+
+/**
+ * @brief Run a check that sends a second, hedged request if the first is slow
+ *
+ * Both requests run on one multi handle from the calling worker. The first
+ * to get an HTTP response wins and the other is aborted; a failed request
+ * waits for the other one. Returns the winning handle (the other is
+ * cleaned up) with its result in *res. The hedge takes its own rate
+ * limiter slot and is skipped when none is free.
+ */
+static CURL* perform_hedged(CURL *primary, const Server *server, const CheckerConfig *config,
+                            CancelToken *cancel, double hedge_ms, CURLcode *res,
+                            double *elapsed_ms, bool *hedged) {
+    CURLM *multi = curl_multi_init();
+    if (!multi) {
+        double start = get_time_ms();
+        *res = curl_easy_perform(primary);
+        *elapsed_ms = get_time_ms() - start;
+        return primary;
+    }
+
+    CURL *handles[2] = { primary, NULL };
+    double starts[2] = { get_time_ms(), 0.0 };
+    bool running[2] = { true, false };
+    bool hedge_considered = false;
+    int winner = -1;
+    int last_done = 0;
+    CURLcode results[2] = { CURLE_OK, CURLE_OK };
+    size_t hedge_slot = RATE_LIMIT_NO_SLOT;
+    curl_multi_add_handle(multi, primary);
+
+    while (winner < 0) {
+        int still_running = 0;
+        curl_multi_perform(multi, &still_running);
+
+        CURLMsg *msg;
+        int queued;
+        while ((msg = curl_multi_info_read(multi, &queued))) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            int which = msg->easy_handle == handles[0] ? 0 : 1;
+            running[which] = false;
+            results[which] = msg->data.result;
+            last_done = which;
+            if (winner < 0 && results[which] == CURLE_OK) {
+                winner = which;
+            }
+        }
+        if (winner >= 0) {
+            break;
+        }
+        if (!running[0] && !running[1]) {
+            winner = last_done;
+            break;
+        }
+
+        // Hedge once, while the first request is still waiting
+        double waited = get_time_ms() - starts[0];
+        if (!hedge_considered && running[0] && waited >= hedge_ms) {
+            hedge_considered = true;
+            long timeout_ms;
+            bool adapted;
+            double retry_ms;
+
+            // The hedge is a probe of its own: skip it if the host is at its limits
+            if (rate_limiter_try_acquire(config->rate_limiter, server->url, &hedge_slot,
+                                         &retry_ms, NULL) &&
+                retry_budget_withdraw(config->retry, true) &&
+                (handles[1] = create_check_handle(server, config, cancel, &timeout_ms, &adapted))) {
+                starts[1] = get_time_ms();
+                running[1] = true;
+                *hedged = true;
+                curl_multi_add_handle(multi, handles[1]);
+                pthread_once(&g_checker_metrics_once, register_metrics);
+                metrics_add(g_checker_metrics.hedges, 1);
+                LOG_DEBUG("Hedging check of %s after %.0f ms", server->url, waited);
+                continue;
+            }
+            rate_limiter_release(config->rate_limiter, hedge_slot);
+            hedge_slot = RATE_LIMIT_NO_SLOT;
+        }
+
+        int wait_ms = hedge_considered ? 1000 : (int)MAX(hedge_ms - waited, 1.0);
+        curl_multi_poll(multi, NULL, 0, wait_ms, NULL);
+    }
 
+    for (int i = 0; i < 2; i++) {
+        if (handles[i]) {
+            curl_multi_remove_handle(multi, handles[i]);
+            if (i != winner) {
+                curl_easy_cleanup(handles[i]);
+            }
+        }
+    }
+    curl_multi_cleanup(multi);
+    rate_limiter_release(config->rate_limiter, hedge_slot);
+
+    if (winner == 1) {
+        pthread_once(&g_checker_metrics_once, register_metrics);
+        metrics_add(g_checker_metrics.hedge_wins, 1);
+    }
+    *res = results[winner];
+    *elapsed_ms = get_time_ms() - starts[winner];
+    return handles[winner];
+}
+
+/**
+ * @brief Check a single server without recording the result
+ *
+ * A check cut short by cancel sets *cancelled and leaves attempt unset.
+ */
+static int check_server(const Server *server, const CheckerConfig *config, CancelToken *cancel,
+                        CheckAttempt *attempt, bool *cancelled) {
+    *cancelled = false;
+    attempt->hedged = false;
+
+    long timeout_ms;
+    bool adapted;
+    CURL *curl = create_check_handle(server, config, cancel, &timeout_ms, &adapted);
+    if (!curl) {
+        return BDIX_ERROR;
+    }
+
+    uint64_t perform_start = trace_begin();
+    CURLcode res;
+    double elapsed_ms;
+    double hedge_ms = hedge_delay_ms(server, config, timeout_ms);
+    if (hedge_ms >= 0.0) {
+        curl = perform_hedged(curl, server, config, cancel, hedge_ms, &res, &elapsed_ms,
+                              &attempt->hedged);
+    } else {
+        double start_time = get_time_ms();
+        res = curl_easy_perform(curl);
+        elapsed_ms = get_time_ms() - start_time;
+    }
+    trace_end(TRACE_CAT_CHECK, "curl_perform", perform_start, server->url);
+
+    if (res != CURLE_OK && cancel_token_check(cancel)) {
+        LOG_DEBUG("Check of %s cancelled", server->url);
+        *cancelled = true;
+        curl_easy_cleanup(curl);
+        return BDIX_SUCCESS;
+    }
+
+    read_attempt(curl, res, elapsed_ms, server, timeout_ms, adapted, attempt);
     curl_easy_cleanup(curl);
     return BDIX_SUCCESS;
 }
 
+/**
+ * @brief Record a check's result on the server
+ */
+static void record_attempt(Server *server, const CheckAttempt *attempt) {
+    server->timing = attempt->timing;
+    server_update_status(server, attempt->status, attempt->latency_ms, attempt->response_code);
+    record_result_metrics(server);
+}
+
+/**
+ * @brief Check a single server
+ */
+int checker_check_server(Server *server, const CheckerConfig *config) {
+    if (!server || !config) {
+        LOG_ERROR("Invalid parameters for server check");
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    CheckAttempt attempt;
+    bool cancelled;
+    int ret = check_server(server, config, config->cancel, &attempt, &cancelled);
+    if (ret == BDIX_SUCCESS && !cancelled) {
+        record_attempt(server, &attempt);
+    }
+    return ret;
+}
+
+/**
+ * @brief Early termination state of one server set (config->top_k, config->cancel)
+ */
+typedef struct {
+    CancelToken cancel;
+    pthread_mutex_t lock;           // Protects best and count
+    const Server **best;            // Max-heap on latency: the slowest kept result first
+    size_t count;
+    size_t k;                       // 0 = only the sweep-wide cancel
+    int grace_ms;
+} SetControl;
+
+static int set_control_init(SetControl *control, const CheckerConfig *config) {
+    if (cancel_token_init_child(&control->cancel, config->cancel) != BDIX_SUCCESS) {
+        return BDIX_ERROR_THREAD;
+    }
+    if (pthread_mutex_init(&control->lock, NULL) != 0) {
+        cancel_token_destroy(&control->cancel);
+        return BDIX_ERROR_THREAD;
+    }
+    control->k = config->top_k;
+    control->best = control->k > 0 ? safe_malloc(control->k * sizeof(Server*)) : NULL;
+    control->count = 0;
+    control->grace_ms = config->top_k_grace_ms > 0 ? config->top_k_grace_ms : 0;
+    return BDIX_SUCCESS;
+}
+
+static void set_control_destroy(SetControl *control) {
+    cancel_token_destroy(&control->cancel);
+    pthread_mutex_destroy(&control->lock);
+    free(control->best);
+}
+
+/**
+ * @brief Keep an online result if it is among the k fastest so far
+ *
+ * The k-th online result starts the grace period, after which the set is cancelled.
+ */
+static void top_k_offer(SetControl *control, const Server *server) {
+    if (!control || control->k == 0 || server->status != BDIX_STATUS_ONLINE) {
+        return;
+    }
+
+    pthread_mutex_lock(&control->lock);
+    const Server **heap = control->best;
+    if (control->count < control->k) {
+        size_t i = control->count++;
+        while (i > 0 && heap[(i - 1) / 2]->latency_ms < server->latency_ms) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = server;
+        if (control->count == control->k) {
+            cancel_token_set_deadline(&control->cancel, get_time_ms() + control->grace_ms);
+        }
+    } else if (server->latency_ms < heap[0]->latency_ms) {
+        size_t i = 0;
+        for (;;) {
+            size_t child = 2 * i + 1;
+            if (child >= control->count) {
+                break;
+            }
+            if (child + 1 < control->count && heap[child + 1]->latency_ms > heap[child]->latency_ms) {
+                child++;
+            }
+            if (heap[child]->latency_ms <= server->latency_ms) {
+                break;
+            }
+            heap[i] = heap[child];
+            i = child;
+        }
+        heap[i] = server;
+    }
+    pthread_mutex_unlock(&control->lock);
+}
+
+static int compare_latency(const void *a, const void *b) {
+    double x = (*(const Server *const *)a)->latency_ms;
+    double y = (*(const Server *const *)b)->latency_ms;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Count checks dropped by an early end
+ */
+static void count_cancelled(CheckerStats *stats, size_t count) {
+    if (stats && count > 0) {
+        atomic_fetch_add(&stats->cancelled_count, count);
+    }
+}
+
 /**
  * @brief Work item for thread pool
  */
 typedef struct {
+    ThreadPool *pool;
     Server *server;
     const CheckerConfig *config;
     CheckerStats *stats;
@@ -126,8 +723,69 @@ typedef struct {
     size_t index;
     size_t total;
     bool show_only_ok;
+    SetControl *control;            // Early termination (NULL = check everything)
+    int attempt;                    // Retries made so far
+    double priority;                // Pool priority (prioritized sets)
+    size_t rate_waiter;             // Rate limiter wait registration (RATE_LIMIT_NO_SLOT = none)
 } CheckWorkItem;
 
+/**
+ * @brief Record a finished check: statistics, alerts, history and output
+ */
+static void finish_check(Server *server, const CheckerConfig *config, CheckerStats *stats,
+                         const char *category_name, size_t position, size_t total,
+                         bool show_only_ok) {
+    // Update statistics
+    uint64_t stats_start = trace_begin();
+    if (stats) {
+        checker_stats_update(stats, server);
+    }
+    trace_end(TRACE_CAT_CHECK, "stats_update", stats_start, NULL);
+
+    // Detect confirmed state changes (never blocks)
+    alert_observe(config->alerts, server);
+
+    // Persist the result (no allocation, short critical section)
+    if (config->history) {
+        history_append(config->history, server);
+    }
+
+    // Print result
+    uint64_t print_start = trace_begin();
+    ui_print_check_result(server, category_name, position, total, show_only_ok);
+    trace_end(TRACE_CAT_UI, "print", print_start, NULL);
+}
+
+static void* check_worker(void *arg);
+
+/**
+ * @brief Re-queue a failed check after a backoff if retries and the budget allow
+ */
+static bool should_retry(CheckWorkItem *work, const CheckAttempt *attempt) {
+    RetryBudget *budget = work->config->retry;
+    if (!budget || work->attempt >= budget->config.max_retries ||
+        (attempt->status != BDIX_STATUS_TIMEOUT && attempt->status != BDIX_STATUS_CUTOFF &&
+         attempt->status != BDIX_STATUS_ERROR) ||
+        !retry_budget_withdraw(budget, false)) {
+        return false;
+    }
+
+    double delay_ms = retry_backoff_ms(budget, ++work->attempt);
+    if (thread_pool_add_work_priority(work->pool, check_worker, work, work->priority,
+                                      delay_ms) != BDIX_SUCCESS) {
+        LOG_WARN("Failed to queue retry of %s", work->server->url);
+        return false;
+    }
+    if (work->stats) {
+        atomic_fetch_add(&work->stats->retried_count, 1);
+    }
+    pthread_once(&g_checker_metrics_once, register_metrics);
+    metrics_add(g_checker_metrics.retries, 1);
+    LOG_DEBUG("Retrying %s in %.0f ms (%s, retry %d)", work->server->url, delay_ms,
+              server_status_name(attempt->status), work->attempt);
+    return true;
+}
+
 /**
  * @brief Thread worker function for checking servers
  */
@@ -138,17 +796,54 @@ static void* check_worker(void *arg) {
         return NULL;
     }
 
-    // Check the server
-    checker_check_server(work->server, work->config);
+    CancelToken *cancel = work->control ? &work->control->cancel : NULL;
+    if (cancel_token_check(cancel)) {
+        rate_limiter_cancel_wait(work->config->rate_limiter, &work->rate_waiter);
+        count_cancelled(work->stats, 1);
+        free(work);
+        return NULL;
+    }
 
-    // Update statistics
-    if (work->stats) {
-        checker_stats_update(work->stats, work->server);
+    // Defer rather than block a worker while the host is over its limits
+    size_t slot = 0;
+    double retry_ms = 0.0;
+    if (!rate_limiter_try_acquire(work->config->rate_limiter, work->server->url,
+                                  &slot, &retry_ms, &work->rate_waiter)) {
+        if (work->stats) {
+            atomic_fetch_add(&work->stats->deferred_count, 1);
+        }
+        if (thread_pool_add_work_priority(work->pool, check_worker, work, work->priority,
+                                          retry_ms) == BDIX_SUCCESS) {
+            return NULL;
+        }
+        LOG_WARN("Failed to defer throttled check of %s, checking now", work->server->url);
+        rate_limiter_cancel_wait(work->config->rate_limiter, &work->rate_waiter);
+        slot = RATE_LIMIT_NO_SLOT;
     }
 
-    // Print result
-    ui_print_check_result(work->server, work->category_name,
-                         work->index + 1, work->total, work->show_only_ok);
+    // Check the server
+    CheckAttempt attempt;
+    bool cancelled;
+    int ret = check_server(work->server, work->config, cancel, &attempt, &cancelled);
+    rate_limiter_release(work->config->rate_limiter, slot);
+    if (ret != BDIX_SUCCESS) {
+        free(work);
+        return NULL;
+    }
+    if (attempt.hedged && work->stats) {
+        atomic_fetch_add(&work->stats->hedged_count, 1);
+    }
+
+    if (cancelled) {
+        count_cancelled(work->stats, 1);
+    } else if (should_retry(work, &attempt)) {
+        return NULL;
+    } else {
+        record_attempt(work->server, &attempt);
+        finish_check(work->server, work->config, work->stats, work->category_name,
+                     work->index + 1, work->total, work->show_only_ok);
+        top_k_offer(work->control, work->server);
+    }
 
     // Free work item
     free(work);
@@ -157,58 +852,496 @@ static void* check_worker(void *arg) {
 }
 
 /**
- * @brief Check all servers in a category
+ * @brief Collect pointers to a set of servers, skipping invalid indices
  */
-int checker_check_category(ServerCategory *category, const CheckerConfig *config,
-                           int thread_count, CheckerStats *stats) {
-    if (!category || !config) {
-        LOG_ERROR("Invalid parameters for category check");
-        return BDIX_ERROR_INVALID_INPUT;
+static Server** collect_servers(ServerCategory *category, const size_t *indices, size_t count,
+                                size_t *n) {
+    Server **servers = safe_malloc((count > 0 ? count : 1) * sizeof(Server*));
+    *n = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t index = indices ? indices[i] : i;
+        if (index < category->count) {
+            servers[(*n)++] = &category->servers[index];
+        }
     }
+    return servers;
+}
 
-    if (category->count == 0) {
-        LOG_INFO("No servers to check in category '%s'", category->name);
-        return BDIX_SUCCESS;
+/**
+ * @brief Ping the hosts of a set of servers from one thread
+ *
+ * Names are looked up on thread_count threads first.
+ */
+static void ping_server_set(ServerCategory *category, const size_t *indices, size_t count,
+                            const IcmpConfig *icmp, int thread_count) {
+    IcmpConfig icmp_config = *icmp;
+    icmp_config.resolver_threads = thread_count;
+
+    size_t n;
+    Server **servers = collect_servers(category, indices, count, &n);
+    if (icmp_probe_servers(servers, n, &icmp_config) != BDIX_SUCCESS) {
+        LOG_WARN("ICMP probe of '%s' failed", category->name);
+    }
+    free(servers);
+}
+
+/**
+ * @brief Context for results of a TCP connect sweep
+ */
+typedef struct {
+    const CheckerConfig *config;
+    CheckerStats *stats;
+    const char *category_name;
+    size_t done;
+    size_t total;
+    SetControl *control;
+} TcpSweepContext;
+
+static void tcp_sweep_result(Server *server, void *arg) {
+    TcpSweepContext *ctx = (TcpSweepContext*)arg;
+    record_result_metrics(server);
+    finish_check(server, ctx->config, ctx->stats, ctx->category_name,
+                 ++ctx->done, ctx->total, !ctx->config->verbose);
+    top_k_offer(ctx->control, server);
+}
+
+/**
+ * @brief Probe servers from the calling thread and report each result
+ *
+ * Results are numbered from position + 1 out of total. Servers left
+ * unchecked by an early end are counted as cancelled.
+ */
+static int probe_servers(Server *const *servers, size_t n, TcpProbeMode mode,
+                         const CheckerConfig *config, int thread_count, CheckerStats *stats,
+                         SetControl *control, const char *category_name, size_t position,
+                         size_t total) {
+    TcpProbeConfig tcp_config = tcp_probe_get_default_config();
+    tcp_config.timeout_ms = config->connect_timeout_seconds * 1000;
+    tcp_config.response_timeout_ms = config->timeout_seconds * 1000;
+    tcp_config.resolver_threads = thread_count;
+    tcp_config.resolve = config->resolve;
+    tcp_config.mode = mode;
+    tcp_config.io_uring = config->io_uring;
+    tcp_config.cancel = control ? &control->cancel : NULL;
+
+    TcpSweepContext ctx = {
+        .config = config,
+        .stats = stats,
+        .category_name = category_name,
+        .done = position,
+        .total = total,
+        .control = control
+    };
+    int ret = tcp_probe_servers(servers, n, &tcp_config, tcp_sweep_result, &ctx);
+    if (control && cancel_token_check(&control->cancel)) {
+        count_cancelled(stats, n - (ctx.done - position));
+    }
+    return ret;
+}
+
+/**
+ * @brief Check a set of servers with a single-threaded TCP connect sweep
+ *
+ * Names are looked up on thread_count threads first; the rate limiter is
+ * not consulted since each host:port gets one connection per sweep.
+ */
+static int sweep_server_set(ServerCategory *category, const size_t *indices, size_t count,
+                            const CheckerConfig *config, int thread_count,
+                            CheckerStats *stats, SetControl *control) {
+    LOG_INFO("Checking %zu servers in '%s' category with a TCP connect sweep%s",
+             count, category->name, config->io_uring ? " (io_uring)" : "");
+    double sweep_start = get_time_ms();
+
+    if (config->icmp) {
+        ping_server_set(category, indices, count, config->icmp, thread_count);
+    }
+
+    size_t n;
+    Server **servers = collect_servers(category, indices, count, &n);
+    if (n < count) {
+        LOG_WARN("Skipping %zu invalid server indices in '%s'", count - n, category->name);
+    }
+
+    int ret = probe_servers(servers, n, TCP_PROBE_CONNECT, config, thread_count, stats,
+                            control, category->name, 0, n);
+    free(servers);
+
+    pthread_once(&g_checker_metrics_once, register_metrics);
+    metrics_observe(g_checker_metrics.sweep_duration, get_time_ms() - sweep_start);
+
+    return ret;
+}
+
+/**
+ * @brief Servers of a set, handed to pool workers one index at a time
+ *
+ * Server i is servers[i] if given, else the category's server at
+ * indices[i] (or i). Its result is numbered offset + i + 1 out of total.
+ */
+typedef struct {
+    ThreadPool *pool;
+    ServerCategory *category;
+    Server **servers;
+    const size_t *indices;
+    size_t offset;
+    size_t total;
+    const CheckerConfig *config;
+    CheckerStats *stats;
+    SetControl *control;
+} CheckRange;
+
+/**
+ * @brief Check the next server of a set on the worker that claimed it
+ *
+ * The work item exists only while the check runs or waits for a retry,
+ * so a set of any size needs memory for as many checks as are in flight.
+ */
+static void check_range_worker(void *ctx, size_t i) {
+    CheckRange *range = (CheckRange*)ctx;
+    Server *server;
+    if (range->servers) {
+        server = range->servers[i];
+    } else {
+        size_t index = range->indices ? range->indices[i] : i;
+        if (index >= range->category->count) {
+            LOG_WARN("Skipping invalid server index %zu in '%s'", index, range->category->name);
+            return;
+        }
+        server = &range->category->servers[index];
+    }
+
+    CheckWorkItem *work = safe_malloc(sizeof(CheckWorkItem));
+    work->pool = range->pool;
+    work->server = server;
+    work->config = range->config;
+    work->stats = range->stats;
+    work->category_name = range->category->name;
+    work->index = range->offset + i;
+    work->total = range->total;
+    work->show_only_ok = !range->config->verbose;
+    work->control = range->control;
+    work->attempt = 0;
+    work->priority = range->config->prioritize ? checker_server_priority(server) : 0.0;
+    work->rate_waiter = RATE_LIMIT_NO_SLOT;
+    retry_budget_deposit(range->config->retry);
+
+    check_worker(work);
+}
+
+/**
+ * @brief Wait for the pool, cancelling the set once its deadline passes
+ */
+static void wait_server_set(ThreadPool *pool, SetControl *control) {
+    if (control) {
+        while (!cancel_token_check(&control->cancel)) {
+            int wait_ms = cancel_token_wait_ms(&control->cancel, CANCEL_POLL_MS);
+            if (thread_pool_wait_timeout(pool, wait_ms) == BDIX_SUCCESS) {
+                return;
+            }
+        }
+    }
+    // Cancelled checks drop out quickly: queued and deferred ones never start,
+    // transfers are aborted
+    if (control && cancel_token_check(&control->cancel)) {
+        thread_pool_release_delayed(pool);
+    }
+    thread_pool_wait(pool);
+}
+
+/**
+ * @brief Create the curl check pool a configuration asks for
+ */
+ThreadPool* checker_create_pool(const CheckerConfig *config, int thread_count,
+                                const CheckerStats *stats) {
+    if (!config || thread_count <= 0) {
+        LOG_ERROR("Invalid parameters for checker pool creation");
+        return NULL;
+    }
+
+    // An autotuned pool resumes where the last set settled
+    ThreadPoolConfig pool_config = thread_pool_get_default_config();
+    pool_config.threads = (size_t)thread_count;
+    pool_config.prioritized = config->prioritize;
+    pool_config.autotune = config->autotune_threads;
+    pool_config.max_threads = (size_t)config->max_threads;
+    if (config->autotune_threads) {
+        size_t settled = stats ? atomic_load(&stats->settled_threads) : 0;
+        if (settled > 0) {
+            pool_config.threads = settled;
+        }
+        pool_config.threads = MIN(pool_config.threads, pool_config.max_threads);
     }
 
-    // Create thread pool
-    ThreadPool *pool = thread_pool_create(thread_count);
+    // Set ranges pause while throttled or retried checks wait, instead of
+    // deferring one item per server of a slow host
+    size_t ceiling = config->autotune_threads ? pool_config.max_threads : pool_config.threads;
+    pool_config.queue_capacity = ceiling * CHECKER_QUEUE_PER_THREAD;
+    return thread_pool_create_with_config(&pool_config);
+}
+
+/**
+ * @brief Check a set of servers in a category using a thread pool
+ *
+ * With io_uring enabled, plain HTTP servers are checked by one io_uring
+ * sweep on the calling thread while the pool handles the rest; if the ring
+ * cannot be set up they go to the pool as well.
+ */
+static int pool_server_set(ServerCategory *category, const size_t *indices, size_t count,
+                           const CheckerConfig *config, int thread_count,
+                           CheckerStats *stats, SetControl *control) {
+    // Use the caller's pool or create one for this set
+    ThreadPool *pool = config->pool ? config->pool : checker_create_pool(config, thread_count, stats);
     if (!pool) {
         LOG_ERROR("Failed to create thread pool");
         return BDIX_ERROR_THREAD;
     }
 
-    LOG_INFO("Checking %zu servers in '%s' category with %d threads",
-             category->count, category->name, thread_count);
+    LOG_INFO("Checking %zu servers in '%s' category with %zu threads%s%s",
+             count, category->name, thread_pool_get_concurrency(pool).limit,
+             config->autotune_threads ? " (autotuned)" : "",
+             config->io_uring ? " and io_uring for plain HTTP" : "");
+    double sweep_start = get_time_ms();
 
-    // Submit all work items
-    for (size_t i = 0; i < category->count; i++) {
-        CheckWorkItem *work = safe_malloc(sizeof(CheckWorkItem));
+    // Raw RTT first, so HTTP traffic does not skew it and results print together
+    if (config->icmp) {
+        ping_server_set(category, indices, count, config->icmp, thread_count);
+    }
 
-        work->server = &category->servers[i];
-        work->config = config;
-        work->stats = stats;
-        work->category_name = category->name;
-        work->index = i;
-        work->total = category->count;
-        work->show_only_ok = !config->verbose;
+    // Workers pull servers from the set themselves; with io_uring, plain
+    // HTTP servers are split off first
+    CheckRange curl_range = {
+        .pool = pool,
+        .category = category,
+        .indices = indices,
+        .total = count,
+        .config = config,
+        .stats = stats,
+        .control = control
+    };
+    size_t curl_count = count;
+    Server **uring_servers = NULL;
+    size_t uring_count = 0;
+    if (config->io_uring) {
+        size_t n;
+        Server **servers = collect_servers(category, indices, count, &n);
+        if (n < count) {
+            LOG_WARN("Skipping %zu invalid server indices in '%s'", count - n, category->name);
+        }
+        uring_servers = safe_malloc((n > 0 ? n : 1) * sizeof(Server*));
+        curl_count = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (tcp_probe_supports_http(servers[i]->url)) {
+                uring_servers[uring_count++] = servers[i];
+            } else {
+                servers[curl_count++] = servers[i];
+            }
+        }
+        curl_range.servers = servers;
+    }
 
-        if (thread_pool_add_work(pool, check_worker, work) != BDIX_SUCCESS) {
-            LOG_ERROR("Failed to add work to thread pool");
-            free(work);
+    int ret = thread_pool_add_range(pool, check_range_worker, &curl_range, curl_count);
+    CheckRange uring_range = curl_range;
+    if (ret == BDIX_SUCCESS && uring_count > 0) {
+        int probe_ret = probe_servers(uring_servers, uring_count, TCP_PROBE_HTTP_HEAD, config,
+                                      thread_count, stats, control, category->name, curl_count,
+                                      count);
+        bool cancelled = control && cancel_token_check(&control->cancel);
+        if (!cancelled && (probe_ret == BDIX_ERROR_UNSUPPORTED || probe_ret == BDIX_ERROR_INVALID_INPUT)) {
+            // Refused before any server was touched
+            LOG_WARN("io_uring unavailable, checking %zu plain HTTP servers with curl", uring_count);
+            uring_range.servers = uring_servers;
+            uring_range.offset = curl_count;
+            ret = thread_pool_add_range(pool, check_range_worker, &uring_range, uring_count);
+        } else if (!cancelled && probe_ret != BDIX_SUCCESS) {
+            // The sweep reported the servers it could not finish as ERROR
+            LOG_WARN("io_uring sweep of '%s' failed, unfinished plain HTTP servers are marked ERROR",
+                     category->name);
+        }
+    }
+    if (ret != BDIX_SUCCESS) {
+        LOG_ERROR("Failed to add work to thread pool");
+        if (!config->pool) {
             thread_pool_destroy(pool);
-            return BDIX_ERROR_THREAD;
         }
+        free(curl_range.servers);
+        free(uring_servers);
+        return BDIX_ERROR_THREAD;
     }
 
     // Wait for all work to complete
-    thread_pool_wait(pool);
-    thread_pool_destroy(pool);
+    wait_server_set(pool, control);
+    free(curl_range.servers);
+    free(uring_servers);
+    ThreadPoolStats pool_stats;
+    if (log_get_level() <= LOG_LEVEL_DEBUG && thread_pool_get_stats(pool, &pool_stats) == BDIX_SUCCESS) {
+        LOG_DEBUG("'%s' pool: queue wait p50 %.2f / p99 %.2f ms, run p50 %.1f ms, "
+                  "%" PRIu64 "/%" PRIu64 " lock acquisitions contended, %" PRIu64 " done wakeups",
+                  category->name, thread_pool_histogram_quantile(&pool_stats.queue_wait, 0.5),
+                  thread_pool_histogram_quantile(&pool_stats.queue_wait, 0.99),
+                  thread_pool_histogram_quantile(&pool_stats.run, 0.5), pool_stats.lock_contended,
+                  pool_stats.lock_acquisitions, pool_stats.done_wakeups);
+        thread_pool_stats_free(&pool_stats);
+    }
+    if (config->autotune_threads) {
+        ThreadPoolConcurrency concurrency = thread_pool_get_concurrency(pool);
+        LOG_INFO("'%s' settled at %zu threads (peak %zu, %u adjustments)", category->name,
+                 concurrency.settled, concurrency.peak, concurrency.adjustments);
+        if (stats) {
+            atomic_store(&stats->settled_threads, concurrency.settled);
+            size_t peak = atomic_load(&stats->peak_threads);
+            while (concurrency.peak > peak &&
+                   !atomic_compare_exchange_weak(&stats->peak_threads, &peak, concurrency.peak)) {
+            }
+        }
+    }
+    if (!config->pool) {
+        thread_pool_destroy(pool);
+    }
+
+    pthread_once(&g_checker_metrics_once, register_metrics);
+    metrics_observe(g_checker_metrics.sweep_duration, get_time_ms() - sweep_start);
+
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Server index with its scheduling priority
+ */
+typedef struct {
+    double priority;
+    size_t index;
+} RankedIndex;
+
+static int compare_ranked(const void *a, const void *b) {
+    const RankedIndex *ra = (const RankedIndex*)a;
+    const RankedIndex *rb = (const RankedIndex*)b;
+    if (ra->priority != rb->priority) {
+        return ra->priority < rb->priority ? -1 : 1;
+    }
+    return (ra->index > rb->index) - (ra->index < rb->index);
+}
+
+/**
+ * @brief Order a set of servers by checker_server_priority(), best first
+ *
+ * Invalid indices are kept (at the end) so the engines still report them.
+ *
+ * @return Newly allocated index array of count entries
+ */
+static size_t* rank_server_set(const ServerCategory *category, const size_t *indices, size_t count) {
+    RankedIndex *ranked = safe_malloc((count > 0 ? count : 1) * sizeof(RankedIndex));
+    for (size_t i = 0; i < count; i++) {
+        ranked[i].index = indices ? indices[i] : i;
+        ranked[i].priority = ranked[i].index < category->count
+                                 ? checker_server_priority(&category->servers[ranked[i].index])
+                                 : INFINITY;
+    }
+    qsort(ranked, count, sizeof(RankedIndex), compare_ranked);
+
+    size_t *order = safe_malloc((count > 0 ? count : 1) * sizeof(size_t));
+    for (size_t i = 0; i < count; i++) {
+        order[i] = ranked[i].index;
+    }
+    free(ranked);
+    return order;
+}
+
+/**
+ * @brief Check a set of servers in a category with the configured engine
+ *
+ * When indices is NULL, the first count servers of the category are checked.
+ * With config->top_k set, the set ends early once enough servers are online
+ * and the fastest of them are printed. A set started after config->cancel
+ * was cancelled is skipped and counted as cancelled.
+ */
+static int check_server_set(ServerCategory *category, const size_t *indices, size_t count,
+                            const CheckerConfig *config, int thread_count,
+                            CheckerStats *stats) {
+    if (cancel_token_check(config->cancel)) {
+        LOG_INFO("Skipping %zu servers in '%s': the sweep was stopped", count, category->name);
+        count_cancelled(stats, count);
+        return BDIX_SUCCESS;
+    }
+
+    SetControl control;
+    SetControl *top = NULL;
+    if (config->top_k > 0 || config->cancel) {
+        if (set_control_init(&control, config) == BDIX_SUCCESS) {
+            top = &control;
+        } else {
+            LOG_WARN("Cannot stop '%s' early, checking all of it", category->name);
+        }
+    }
+
+    size_t *order = config->prioritize ? rank_server_set(category, indices, count) : NULL;
+    if (order) {
+        indices = order;
+    }
+
+    int ret;
+    if (config->engine == CHECK_ENGINE_TCP) {
+        ret = sweep_server_set(category, indices, count, config, thread_count, stats, top);
+    } else {
+        ret = pool_server_set(category, indices, count, config, thread_count, stats, top);
+    }
+    free(order);
+
+    if (top) {
+        if (cancel_token_check(&top->cancel)) {
+            LOG_INFO("'%s' ended early", category->name);
+        }
+        if (top->k > 0) {
+            qsort(top->best, top->count, sizeof(Server*), compare_latency);
+            ui_print_fastest_servers(category->name, top->best, top->count);
+        }
+        set_control_destroy(top);
+    }
+    return ret;
+}
+
+/**
+ * @brief Check all servers in a category
+ */
+int checker_check_category(ServerCategory *category, const CheckerConfig *config,
+                           int thread_count, CheckerStats *stats) {
+    if (!category || !config) {
+        LOG_ERROR("Invalid parameters for category check");
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    if (category->count == 0) {
+        LOG_INFO("No servers to check in category '%s'", category->name);
+        return BDIX_SUCCESS;
+    }
+
+    int ret = check_server_set(category, NULL, category->count, config,
+                               thread_count, stats);
+    if (ret != BDIX_SUCCESS) {
+        return ret;
+    }
 
     LOG_INFO("Completed checking '%s' category", category->name);
     return BDIX_SUCCESS;
 }
 
+/**
+ * @brief Check a subset of servers in a category
+ */
+int checker_check_servers(ServerCategory *category, const size_t *indices, size_t count,
+                          const CheckerConfig *config, int thread_count,
+                          CheckerStats *stats) {
+    if (!category || !indices || !config) {
+        LOG_ERROR("Invalid parameters for server subset check");
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    if (count == 0) {
+        return BDIX_SUCCESS;
+    }
+
+    return check_server_set(category, indices, count, config, thread_count, stats);
+}
+
 /**
  * @brief Check multiple categories
  */
@@ -263,7 +1396,11 @@ int checker_check_multiple(ServerData *data, const CheckerConfig *config,
     }
 
     printf("\n"); /* flawfinder: ignore */
-    LOG_INFO("All checks completed");
+    if (cancel_token_check(config->cancel)) {
+        LOG_INFO("Checks stopped early");
+    } else {
+        LOG_INFO("All checks completed");
+    }
 
     return BDIX_SUCCESS;
 }
@@ -281,9 +1418,19 @@ void checker_stats_init(CheckerStats *stats) {
     atomic_store(&stats->offline_count, 0);
     atomic_store(&stats->timeout_count, 0);
     atomic_store(&stats->error_count, 0);
+    atomic_store(&stats->deferred_count, 0);
+    atomic_store(&stats->cancelled_count, 0);
+    atomic_store(&stats->retried_count, 0);
+    atomic_store(&stats->hedged_count, 0);
+    atomic_store(&stats->settled_threads, 0);
+    atomic_store(&stats->peak_threads, 0);
     atomic_store(&stats->total_latency_ms, 0.0);
     atomic_store(&stats->min_latency_ms, INFINITY);
     atomic_store(&stats->max_latency_ms, 0.0);
+    atomic_store(&stats->total_dns_ms, 0.0);
+    atomic_store(&stats->total_connect_ms, 0.0);
+    atomic_store(&stats->total_tls_ms, 0.0);
+    atomic_store(&stats->total_server_ms, 0.0);
 
     LOG_DEBUG("Statistics initialized");
 }
@@ -308,6 +1455,7 @@ void checker_stats_update(CheckerStats *stats, const Server *server) {
             atomic_fetch_add(&stats->offline_count, 1);
             break;
         case BDIX_STATUS_TIMEOUT:
+        case BDIX_STATUS_CUTOFF:
             atomic_fetch_add(&stats->timeout_count, 1);
             break;
         case BDIX_STATUS_ERROR:
@@ -319,11 +1467,11 @@ void checker_stats_update(CheckerStats *stats, const Server *server) {
 
     // Update latency statistics (only for successful checks)
     if (server->status == BDIX_STATUS_ONLINE && server->latency_ms >= 0) {
-        double current_total = atomic_load(&stats->total_latency_ms);
-        while (!atomic_compare_exchange_weak(&stats->total_latency_ms, &current_total,
-                                             current_total + server->latency_ms)) {
-            // Retry on failure
-        }
+        atomic_add_double(&stats->total_latency_ms, server->latency_ms);
+        atomic_add_double(&stats->total_dns_ms, server->timing.dns_ms);
+        atomic_add_double(&stats->total_connect_ms, server->timing.connect_ms);
+        atomic_add_double(&stats->total_tls_ms, server->timing.tls_ms);
+        atomic_add_double(&stats->total_server_ms, server->timing.server_ms);
 
         // Update min latency
         double current_min = atomic_load(&stats->min_latency_ms);
@@ -362,6 +1510,28 @@ double checker_stats_get_avg_latency(const CheckerStats *stats) {
     return total / online;
 }
 
+/**
+ * @brief Get average phase durations from statistics
+ */
+ServerTiming checker_stats_get_avg_timing(const CheckerStats *stats) {
+    ServerTiming avg = {0};
+    if (!stats) {
+        return avg;
+    }
+
+    size_t online = atomic_load(&stats->online_count);
+    if (online == 0) {
+        return avg;
+    }
+
+    avg.dns_ms = atomic_load(&stats->total_dns_ms) / online;
+    avg.connect_ms = atomic_load(&stats->total_connect_ms) / online;
+    avg.tls_ms = atomic_load(&stats->total_tls_ms) / online;
+    avg.server_ms = atomic_load(&stats->total_server_ms) / online;
+    avg.total_ms = atomic_load(&stats->total_latency_ms) / online;
+    return avg;
+}
+
 /**
  * @brief Print statistics summary
  */
@@ -376,6 +1546,11 @@ void checker_stats_print(const CheckerStats *stats) {
     size_t offline = atomic_load(&stats->offline_count);
     size_t timeout = atomic_load(&stats->timeout_count);
     size_t error = atomic_load(&stats->error_count);
+    size_t deferred = atomic_load(&stats->deferred_count);
+    size_t cancelled = atomic_load(&stats->cancelled_count);
+    size_t retried = atomic_load(&stats->retried_count);
+    size_t hedged = atomic_load(&stats->hedged_count);
+    size_t settled_threads = atomic_load(&stats->settled_threads);
 
     double min_latency = atomic_load(&stats->min_latency_ms);
     double max_latency = atomic_load(&stats->max_latency_ms);
@@ -396,11 +1571,34 @@ void checker_stats_print(const CheckerStats *stats) {
     printf("Error:           %5zu  (%.1f%%)\n", error, // flawfinder: ignore
            total > 0 ? (error * 100.0 / total) : 0.0);
 
+    if (deferred > 0) {
+        printf("Rate Deferred:   %5zu\n", deferred); // flawfinder: ignore
+    }
+    if (cancelled > 0) {
+        printf("Cancelled:       %5zu\n", cancelled); // flawfinder: ignore
+    }
+    if (retried > 0) {
+        printf("Retried:         %5zu\n", retried); // flawfinder: ignore
+    }
+    if (hedged > 0) {
+        printf("Hedged:          %5zu\n", hedged); // flawfinder: ignore
+    }
+    if (settled_threads > 0) {
+        printf("Threads:         %5zu  (autotuned, peak %zu)\n", settled_threads, // flawfinder: ignore
+               atomic_load(&stats->peak_threads));
+    }
+
     if (online > 0) {
         printf("───────────────────────────────────────────\n"); // flawfinder: ignore
         printf("Min Latency:     %.2f ms\n", min_latency); // flawfinder: ignore
         printf("Max Latency:     %.2f ms\n", max_latency); // flawfinder: ignore
         printf("Avg Latency:     %.2f ms\n", avg_latency); // flawfinder: ignore
+
+        ServerTiming avg = checker_stats_get_avg_timing(stats);
+        printf("  DNS:           %.2f ms\n", avg.dns_ms); // flawfinder: ignore
+        printf("  Connect:       %.2f ms\n", avg.connect_ms); // flawfinder: ignore
+        printf("  TLS:           %.2f ms\n", avg.tls_ms); // flawfinder: ignore
+        printf("  Server:        %.2f ms\n", avg.server_ms); // flawfinder: ignore
     }
 
     printf("═══════════════════════════════════════════\n"); // flawfinder: ignore
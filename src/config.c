@@ -31,6 +31,13 @@ static int parse_server_array(json_t *array, ServerCategory *category) {
             continue;
         }
 
+        // One warning instead of one per URL for oversized lists
+        if (category->count >= MAX_SERVERS_PER_CATEGORY) {
+            LOG_WARN("Category '%s' is full (%d servers), skipping %zu remaining URLs",
+                     category->name, MAX_SERVERS_PER_CATEGORY, json_array_size(array) - index);
+            break;
+        }
+
         // Add server to category
         if (server_category_add(category, url) != BDIX_SUCCESS) {
             LOG_WARN("Failed to add server: %s", url);
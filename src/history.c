@@ -0,0 +1,682 @@
+/**
+ * @file history.c
+ * @brief Append-only memory-mapped check history store implementation
+ * @version 1.0.0
+ */
+
+#include "history.h"
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define HISTORY_INITIAL_INDEX 256
+#define HISTORY_INITIAL_SEGMENTS 8
+
+_Static_assert(sizeof(HistoryRecord) == 32, "HistoryRecord must stay 32 bytes");
+_Static_assert(sizeof(HistorySegmentHeader) == 64, "HistorySegmentHeader must stay 64 bytes");
+
+/**
+ * @brief Get default history configuration
+ */
+HistoryConfig history_get_default_config(void) {
+    return (HistoryConfig){
+        .segment_records = HISTORY_DEFAULT_SEGMENT_RECORDS,
+        .read_only = false
+    };
+}
+
+/**
+ * @brief Stable 64-bit identifier of a server URL (FNV-1a)
+ */
+uint64_t history_server_id(const char *url) {
+    uint64_t hash = 14695981039346656037ULL;
+    if (!url) {
+        return hash;
+    }
+    for (const unsigned char *p = (const unsigned char*)url; *p; p++) {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Current wall-clock time in milliseconds since the epoch
+ */
+int64_t history_now_ms(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_REALTIME, &ts) != 0) {
+        return (int64_t)time(NULL) * 1000;
+    }
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Locate a server's slot in a segment index
+ *
+ * @return Matching or empty slot
+ */
+static HistoryIndexEntry* index_slot(HistoryIndexEntry *index, size_t capacity, uint64_t id) {
+    size_t mask = capacity - 1;
+    size_t i = (size_t)(id ^ (id >> 32)) & mask;
+
+    while (index[i].head != 0 && index[i].server_id != id) {
+        i = (i + 1) & mask;
+    }
+    return &index[i];
+}
+
+/**
+ * @brief Record a server's newest record in a segment index
+ */
+static void index_update(HistorySegment *seg, uint64_t id, uint32_t head) {
+    if ((seg->index_count + 1) * 2 > seg->index_capacity) {
+        size_t new_capacity = seg->index_capacity * 2;
+        HistoryIndexEntry *new_index = safe_calloc(new_capacity, sizeof(HistoryIndexEntry));
+
+        for (size_t i = 0; i < seg->index_capacity; i++) {
+            if (seg->index[i].head != 0) {
+                *index_slot(new_index, new_capacity, seg->index[i].server_id) = seg->index[i];
+            }
+        }
+
+        free(seg->index);
+        seg->index = new_index;
+        seg->index_capacity = new_capacity;
+    }
+
+    HistoryIndexEntry *entry = index_slot(seg->index, seg->index_capacity, id);
+    if (entry->head == 0) {
+        entry->server_id = id;
+        seg->index_count++;
+    }
+    entry->head = head;
+    entry->count++;
+}
+
+/**
+ * @brief Build a segment file path
+ */
+static void segment_path(const HistoryStore *store, uint32_t sequence, char *path, size_t size) {
+    snprintf(path, size, "%s/" HISTORY_SEGMENT_PREFIX "%08u" HISTORY_SEGMENT_SUFFIX, // flawfinder: ignore
+             store->dir, sequence);
+}
+
+/**
+ * @brief Unmap a segment and free its index
+ */
+static void segment_unmap(HistorySegment *seg) {
+    if (seg->header) {
+        if (seg->writable) {
+            msync(seg->header, seg->map_size, MS_SYNC);
+        }
+        munmap(seg->header, seg->map_size);
+    }
+    if (seg->fd >= 0) {
+        close(seg->fd);
+    }
+    free(seg->index);
+    memset(seg, 0, sizeof(*seg));
+    seg->fd = -1;
+}
+
+/**
+ * @brief Map an open segment file and rebuild its index
+ */
+static int segment_map(HistorySegment *seg, size_t file_size) {
+    int prot = seg->writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void *base = mmap(NULL, file_size, prot, MAP_SHARED, seg->fd, 0);
+    if (base == MAP_FAILED) {
+        LOG_ERROR("Failed to map history segment %u: %s", seg->sequence, strerror(errno));
+        return BDIX_ERROR;
+    }
+
+    seg->header = base;
+    seg->records = (HistoryRecord*)(seg->header + 1);
+    seg->map_size = file_size;
+
+    const HistorySegmentHeader *h = seg->header;
+    size_t fit = (file_size - sizeof(HistorySegmentHeader)) / sizeof(HistoryRecord);
+    if (memcmp(h->magic, HISTORY_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != HISTORY_FORMAT_VERSION ||
+        h->record_size != sizeof(HistoryRecord) ||
+        h->capacity > fit || atomic_load(&seg->header->count) > h->capacity) {
+        LOG_WARN("Ignoring invalid history segment %u", seg->sequence);
+        return BDIX_ERROR;
+    }
+
+    seg->index_capacity = HISTORY_INITIAL_INDEX;
+    seg->index = safe_calloc(seg->index_capacity, sizeof(HistoryIndexEntry));
+    seg->index_count = 0;
+
+    uint32_t count = atomic_load_explicit(&seg->header->count, memory_order_acquire);
+    for (uint32_t i = 0; i < count; i++) {
+        index_update(seg, seg->records[i].server_id, i + 1);
+    }
+
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Open and map an existing segment file
+ */
+static int segment_open(const HistoryStore *store, uint32_t sequence, bool writable,
+                        HistorySegment *seg) {
+    char path[MAX_PATH_LENGTH + SMALL_BUFFER]; /* flawfinder: ignore - bounds checked with snprintf */
+    segment_path(store, sequence, path, sizeof(path));
+
+    memset(seg, 0, sizeof(*seg));
+    seg->sequence = sequence;
+    seg->writable = writable;
+    seg->fd = open(path, writable ? O_RDWR : O_RDONLY); // flawfinder: ignore
+    if (seg->fd < 0) {
+        LOG_ERROR("Failed to open history segment %s: %s", path, strerror(errno));
+        return BDIX_ERROR_FILE_NOT_FOUND;
+    }
+
+    struct stat st;
+    if (fstat(seg->fd, &st) != 0 ||
+        (size_t)st.st_size < sizeof(HistorySegmentHeader) + sizeof(HistoryRecord)) {
+        LOG_WARN("Ignoring truncated history segment %s", path);
+        segment_unmap(seg);
+        return BDIX_ERROR;
+    }
+
+    if (segment_map(seg, (size_t)st.st_size) != BDIX_SUCCESS) {
+        segment_unmap(seg);
+        return BDIX_ERROR;
+    }
+
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Create, size and map a new empty segment file
+ */
+static int segment_create(const HistoryStore *store, uint32_t sequence, HistorySegment *seg) {
+    char path[MAX_PATH_LENGTH + SMALL_BUFFER]; /* flawfinder: ignore - bounds checked with snprintf */
+    segment_path(store, sequence, path, sizeof(path));
+
+    memset(seg, 0, sizeof(*seg));
+    seg->sequence = sequence;
+    seg->writable = true;
+    seg->fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644); // flawfinder: ignore
+    if (seg->fd < 0) {
+        LOG_ERROR("Failed to create history segment %s: %s", path, strerror(errno));
+        return BDIX_ERROR;
+    }
+
+    size_t size = sizeof(HistorySegmentHeader) +
+                  store->config.segment_records * sizeof(HistoryRecord);
+    if (ftruncate(seg->fd, (off_t)size) != 0) {
+        LOG_ERROR("Failed to size history segment %s: %s", path, strerror(errno));
+        segment_unmap(seg);
+        unlink(path);
+        return BDIX_ERROR;
+    }
+
+    // Write the header through the file so the mapping validates it like any other
+    HistorySegmentHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, HISTORY_MAGIC, sizeof(header.magic));
+    header.version = HISTORY_FORMAT_VERSION;
+    header.record_size = sizeof(HistoryRecord);
+    header.capacity = (uint32_t)store->config.segment_records;
+    header.sequence = sequence;
+
+    if (pwrite(seg->fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        segment_map(seg, size) != BDIX_SUCCESS) {
+        LOG_ERROR("Failed to initialize history segment %s", path);
+        segment_unmap(seg);
+        unlink(path);
+        return BDIX_ERROR;
+    }
+
+    LOG_DEBUG("Created history segment %s", path);
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Append a mapped segment to the store (write lock held or store private)
+ */
+static void store_push_segment(HistoryStore *store, const HistorySegment *seg) {
+    if (store->segment_count >= store->segment_capacity) {
+        store->segment_capacity = store->segment_capacity ? store->segment_capacity * 2
+                                                          : HISTORY_INITIAL_SEGMENTS;
+        store->segments = safe_realloc(store->segments,
+                                       store->segment_capacity * sizeof(HistorySegment));
+    }
+    store->segments[store->segment_count++] = *seg;
+}
+
+/**
+ * @brief qsort comparator for segment sequence numbers
+ */
+static int compare_sequence(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief List segment sequence numbers in a directory, ascending
+ *
+ * @return Number of sequences (caller frees *out)
+ */
+static size_t list_segments(const char *dir, uint32_t **out) {
+    *out = NULL;
+    DIR *d = opendir(dir);
+    if (!d) {
+        return 0;
+    }
+
+    size_t count = 0;
+    size_t capacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        unsigned sequence;
+        char suffix[8]; /* flawfinder: ignore - width limited in sscanf */
+        if (sscanf(entry->d_name, HISTORY_SEGMENT_PREFIX "%8u%7s", &sequence, suffix) != 2 || // flawfinder: ignore
+            strcmp(suffix, HISTORY_SEGMENT_SUFFIX) != 0) {
+            continue;
+        }
+        if (count >= capacity) {
+            capacity = capacity ? capacity * 2 : HISTORY_INITIAL_SEGMENTS;
+            *out = safe_realloc(*out, capacity * sizeof(uint32_t));
+        }
+        (*out)[count++] = sequence;
+    }
+    closedir(d);
+
+    if (count > 1) {
+        qsort(*out, count, sizeof(uint32_t), compare_sequence);
+    }
+    return count;
+}
+
+/**
+ * @brief Open (or create) a history store directory
+ */
+HistoryStore* history_open(const char *dir, const HistoryConfig *config) {
+    /* flawfinder: ignore - dir is null checked and null-terminated */
+    if (!dir || !config || strlen(dir) == 0 || strlen(dir) >= MAX_PATH_LENGTH - 32 ||
+        config->segment_records == 0 || config->segment_records > UINT32_MAX - 1) {
+        LOG_ERROR("Invalid history store configuration");
+        return NULL;
+    }
+
+    if (!config->read_only && mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        LOG_ERROR("Failed to create history directory %s: %s", dir, strerror(errno));
+        return NULL;
+    }
+    if (config->read_only && access(dir, R_OK | X_OK) != 0) {
+        LOG_ERROR("Cannot read history directory %s: %s", dir, strerror(errno));
+        return NULL;
+    }
+
+    HistoryStore *store = safe_calloc(1, sizeof(HistoryStore));
+    store->config = *config;
+    safe_strncpy(store->dir, dir, sizeof(store->dir));
+    atomic_store(&store->appended, 0);
+    atomic_store(&store->failed, 0);
+
+    if (pthread_rwlock_init(&store->lock, NULL) != 0) {
+        LOG_ERROR("Failed to initialize history lock");
+        free(store);
+        return NULL;
+    }
+
+    uint32_t *sequences = NULL;
+    size_t count = list_segments(dir, &sequences);
+    store->next_sequence = count > 0 ? sequences[count - 1] + 1 : 0;
+    for (size_t i = 0; i < count; i++) {
+        // Only the newest segment can still receive appends
+        bool writable = !config->read_only && i == count - 1;
+        HistorySegment seg;
+        if (segment_open(store, sequences[i], writable, &seg) == BDIX_SUCCESS) {
+            store_push_segment(store, &seg);
+        }
+    }
+    free(sequences);
+
+    LOG_DEBUG("Opened history store %s with %zu segments", dir, store->segment_count);
+    return store;
+}
+
+/**
+ * @brief Sync and unmap all segments and free the store
+ */
+void history_close(HistoryStore *store) {
+    if (!store) {
+        return;
+    }
+
+    for (size_t i = 0; i < store->segment_count; i++) {
+        segment_unmap(&store->segments[i]);
+    }
+
+    pthread_rwlock_destroy(&store->lock);
+    free(store->segments);
+    free(store);
+}
+
+/**
+ * @brief Get the segment to append to, rotating when full (write lock held)
+ */
+static HistorySegment* active_segment(HistoryStore *store) {
+    HistorySegment *last = store->segment_count > 0
+                         ? &store->segments[store->segment_count - 1] : NULL;
+
+    if (last && last->writable && atomic_load(&last->header->count) < last->header->capacity) {
+        return last;
+    }
+
+    // Seal the full segment; it stays mapped for queries
+    if (last && last->writable) {
+        msync(last->header, last->map_size, MS_ASYNC);
+    }
+
+    HistorySegment seg;
+    if (segment_create(store, store->next_sequence, &seg) != BDIX_SUCCESS) {
+        return NULL;
+    }
+    store->next_sequence++;
+    store_push_segment(store, &seg);
+    return &store->segments[store->segment_count - 1];
+}
+
+/**
+ * @brief Append a raw record (prev is filled in by the store)
+ */
+int history_append_record(HistoryStore *store, const HistoryRecord *record) {
+    if (!store || !record) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    if (store->config.read_only) {
+        return BDIX_ERROR;
+    }
+
+    pthread_rwlock_wrlock(&store->lock);
+
+    HistorySegment *seg = active_segment(store);
+    if (!seg) {
+        pthread_rwlock_unlock(&store->lock);
+        atomic_fetch_add(&store->failed, 1);
+        return BDIX_ERROR;
+    }
+
+    HistorySegmentHeader *header = seg->header;
+    uint32_t slot = atomic_load_explicit(&header->count, memory_order_relaxed);
+    HistoryIndexEntry *entry = index_slot(seg->index, seg->index_capacity, record->server_id);
+
+    HistoryRecord *dst = &seg->records[slot];
+    *dst = *record;
+    dst->prev = entry->head;
+    dst->reserved = 0;
+
+    if (slot == 0 || record->timestamp_ms < header->first_ms) {
+        header->first_ms = record->timestamp_ms;
+    }
+    if (slot == 0 || record->timestamp_ms > header->last_ms) {
+        header->last_ms = record->timestamp_ms;
+    }
+
+    index_update(seg, record->server_id, slot + 1);
+
+    // Publish only after the record is complete so concurrent readers never see a torn one
+    atomic_store_explicit(&header->count, slot + 1, memory_order_release);
+
+    pthread_rwlock_unlock(&store->lock);
+
+    atomic_fetch_add(&store->appended, 1);
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Append the latest check result of a server
+ */
+int history_append(HistoryStore *store, const Server *server) {
+    if (!store || !server) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    HistoryRecord record = {
+        .server_id = history_server_id(server->url),
+        .timestamp_ms = history_now_ms(),
+        .latency_ms = (float)server->latency_ms,
+        .status = (int16_t)server->status,
+        .response_code = (int16_t)MAX(MIN(server->response_code, INT16_MAX), 0)
+    };
+
+    return history_append_record(store, &record);
+}
+
+/**
+ * @brief Visit a server's records within [from_ms, to_ms], newest first
+ */
+size_t history_query(HistoryStore *store, uint64_t server_id, int64_t from_ms, int64_t to_ms,
+                     HistoryVisitFn visit, void *ctx) {
+    if (!store || !visit || from_ms > to_ms) {
+        return 0;
+    }
+
+    size_t visited = 0;
+    bool stop = false;
+
+    pthread_rwlock_rdlock(&store->lock);
+
+    for (size_t s = store->segment_count; s-- > 0 && !stop;) {
+        HistorySegment *seg = &store->segments[s];
+        const HistorySegmentHeader *header = seg->header;
+
+        if (atomic_load(&seg->header->count) == 0 || header->first_ms > to_ms) {
+            continue;
+        }
+        if (header->last_ms < from_ms) {
+            break;  // Older segments are entirely out of range too
+        }
+
+        const HistoryIndexEntry *entry = index_slot(seg->index, seg->index_capacity, server_id);
+        for (uint32_t r = entry->head; r != 0 && !stop; r = seg->records[r - 1].prev) {
+            const HistoryRecord *record = &seg->records[r - 1];
+            if (record->timestamp_ms > to_ms) {
+                continue;
+            }
+            if (record->timestamp_ms < from_ms) {
+                break;
+            }
+            visited++;
+            stop = !visit(record, ctx);
+        }
+    }
+
+    pthread_rwlock_unlock(&store->lock);
+    return visited;
+}
+
+/**
+ * @brief Newest records of one server, collected newest first
+ */
+typedef struct {
+    HistoryRecord records[SERVER_SAMPLE_RING];
+    size_t count;
+} RestoreContext;
+
+static bool collect_recent(const HistoryRecord *record, void *ctx) {
+    RestoreContext *restore = (RestoreContext*)ctx;
+    if (record->status > BDIX_STATUS_UNKNOWN && record->status <= BDIX_STATUS_CUTOFF) {
+        restore->records[restore->count++] = *record;
+    }
+    return restore->count < SERVER_SAMPLE_RING;
+}
+
+/**
+ * @brief Restore a server's recent results from the store
+ */
+size_t history_restore(HistoryStore *store, Server *server) {
+    if (!store || !server) {
+        return 0;
+    }
+
+    RestoreContext ctx = { .count = 0 };
+    history_query(store, history_server_id(server->url), 0, INT64_MAX, collect_recent, &ctx);
+
+    for (size_t i = ctx.count; i-- > 0;) {
+        const HistoryRecord *record = &ctx.records[i];
+        server->status = (ServerStatus)record->status;
+        server->latency_ms = record->latency_ms;
+        server->response_code = record->response_code;
+        server->last_checked = (time_t)(record->timestamp_ms / 1000);
+        server_metrics_record(server);
+    }
+    return ctx.count;
+}
+
+/**
+ * @brief Visit every record with a timestamp in [from_ms, to_ms), in append order
+ */
+size_t history_scan(HistoryStore *store, int64_t from_ms, int64_t to_ms,
+                    HistoryVisitFn visit, void *ctx) {
+    if (!store || !visit || from_ms >= to_ms) {
+        return 0;
+    }
+
+    size_t visited = 0;
+
+    for (size_t s = 0;; s++) {
+        // Snapshot one segment; mappings stay valid until pruned
+        pthread_rwlock_rdlock(&store->lock);
+        if (s >= store->segment_count) {
+            pthread_rwlock_unlock(&store->lock);
+            break;
+        }
+        const HistorySegment *seg = &store->segments[s];
+        const HistoryRecord *records = seg->records;
+        uint32_t count = atomic_load_explicit(&seg->header->count, memory_order_acquire);
+        int64_t first_ms = seg->header->first_ms;
+        int64_t last_ms = seg->header->last_ms;
+        pthread_rwlock_unlock(&store->lock);
+
+        if (count == 0 || last_ms < from_ms) {
+            continue;
+        }
+        if (first_ms >= to_ms) {
+            break;
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            if (records[i].timestamp_ms >= from_ms && records[i].timestamp_ms < to_ms) {
+                visited++;
+                if (!visit(&records[i], ctx)) {
+                    return visited;
+                }
+            }
+        }
+    }
+
+    return visited;
+}
+
+/**
+ * @brief Oldest timestamp in the store
+ */
+bool history_oldest(HistoryStore *store, int64_t *oldest_ms) {
+    if (!store || !oldest_ms) {
+        return false;
+    }
+
+    bool found = false;
+    pthread_rwlock_rdlock(&store->lock);
+    for (size_t s = 0; s < store->segment_count; s++) {
+        const HistorySegmentHeader *header = store->segments[s].header;
+        if (atomic_load(&store->segments[s].header->count) > 0 &&
+            (!found || header->first_ms < *oldest_ms)) {
+            *oldest_ms = header->first_ms;
+            found = true;
+        }
+    }
+    pthread_rwlock_unlock(&store->lock);
+    return found;
+}
+
+/**
+ * @brief Delete sealed segments whose newest record is older than before_ms
+ */
+size_t history_prune(HistoryStore *store, int64_t before_ms) {
+    if (!store || store->config.read_only) {
+        return 0;
+    }
+
+    size_t removed = 0;
+    pthread_rwlock_wrlock(&store->lock);
+
+    // Segments are time ordered, so expired ones form a prefix
+    while (removed + 1 < store->segment_count) {
+        HistorySegment *seg = &store->segments[removed];
+        if (atomic_load(&seg->header->count) > 0 && seg->header->last_ms >= before_ms) {
+            break;
+        }
+
+        char path[MAX_PATH_LENGTH + SMALL_BUFFER]; /* flawfinder: ignore - bounds checked with snprintf */
+        segment_path(store, seg->sequence, path, sizeof(path));
+        segment_unmap(seg);
+        if (unlink(path) != 0) {
+            LOG_WARN("Failed to delete history segment %s: %s", path, strerror(errno));
+        }
+        removed++;
+    }
+
+    if (removed > 0) {
+        memmove(store->segments, store->segments + removed,
+                (store->segment_count - removed) * sizeof(HistorySegment));
+        store->segment_count -= removed;
+        LOG_DEBUG("Pruned %zu history segments", removed);
+    }
+
+    pthread_rwlock_unlock(&store->lock);
+    return removed;
+}
+
+/**
+ * @brief Schedule write-back of the active segment
+ */
+int history_sync(HistoryStore *store) {
+    if (!store) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    int ret = BDIX_SUCCESS;
+    pthread_rwlock_rdlock(&store->lock);
+    if (store->segment_count > 0) {
+        HistorySegment *seg = &store->segments[store->segment_count - 1];
+        if (seg->writable && msync(seg->header, seg->map_size, MS_ASYNC) != 0) {
+            LOG_WARN("Failed to sync history segment %u: %s", seg->sequence, strerror(errno));
+            ret = BDIX_ERROR;
+        }
+    }
+    pthread_rwlock_unlock(&store->lock);
+    return ret;
+}
+
+/**
+ * @brief Print history store counters
+ */
+/* flawfinder: ignore - all printf calls below use compile-time constant format strings */
+void history_print_stats(HistoryStore *store) {
+    if (!store) {
+        return;
+    }
+
+    pthread_rwlock_rdlock(&store->lock);
+    size_t segments = store->segment_count;
+    size_t stored = 0;
+    for (size_t i = 0; i < segments; i++) {
+        stored += atomic_load(&store->segments[i].header->count);
+    }
+    pthread_rwlock_unlock(&store->lock);
+
+    printf("History: %zu records appended, %zu failed (%zu stored in %zu segments)\n", // flawfinder: ignore
+           atomic_load(&store->appended), atomic_load(&store->failed), stored, segments);
+}
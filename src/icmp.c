@@ -0,0 +1,583 @@
+/**
+ * @file icmp.c
+ * @brief Unprivileged ICMP echo probe engine
+ * @version 1.0.0
+ */
+
+#include "common.h"
+#include "icmp.h"
+#include "metrics.h"
+#include "rate_limit.h"
+#include "thread_pool.h"
+#include "trace.h"
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#define ICMP_ECHO_REQUEST 8
+#define ICMP_ECHO_REPLY 0
+#define ICMP6_ECHO_REQUEST_TYPE 128
+#define ICMP6_ECHO_REPLY_TYPE 129
+#define ICMP_RECV_BUFFER 512
+
+/**
+ * @brief Echo request/reply header (same layout for ICMP and ICMPv6)
+ *
+ * Ping sockets fill in the checksum and replace the identifier with the
+ * socket's local port, so replies are matched on the payload instead.
+ */
+typedef struct {
+    uint8_t type;
+    uint8_t code;
+    uint16_t checksum;
+    uint16_t id;
+    uint16_t sequence;
+} IcmpEchoHeader;
+
+/**
+ * @brief Echo packet: header plus the payload the peer echoes back
+ */
+typedef struct {
+    IcmpEchoHeader header;
+    uint64_t token;                 // Identifies this probe run
+    uint32_t target;                // Index into the target array
+    uint32_t sample;                // Round the request was sent in
+} IcmpEchoPacket;
+
+/**
+ * @brief One resolved address of a host
+ */
+typedef struct {
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    int family;                     // AF_INET or AF_INET6
+} IcmpAddress;
+
+/**
+ * @brief Per-host probe state
+ */
+typedef struct {
+    IcmpAddress addresses[ICMP_MAX_ADDRESSES];
+    size_t address_count;
+    size_t current;                 // Address echo requests go to
+    int family;                     // Family of the current address, 0 if none is usable
+    double sent_ms[ICMP_MAX_SAMPLES];
+    uint8_t sent_to[ICMP_MAX_SAMPLES]; // Address each round's request went to
+    uint32_t replied;               // Bit per sample that got a reply
+    double sum_ms;
+    ServerPing *result;
+} IcmpTarget;
+
+/**
+ * @brief Name lookup for one target, run on the resolver pool
+ */
+typedef struct {
+    const char *host;
+    IcmpTarget *target;
+} IcmpResolveJob;
+
+/**
+ * @brief One probe run over all targets
+ */
+typedef struct {
+    IcmpTarget *targets;
+    size_t count;
+    const IcmpConfig *config;
+    uint64_t token;
+    uint16_t sequence;
+    int sockets[2];                 // IPv4, IPv6 (-1 if not needed)
+    int epoll_fd;
+    int blocked;                    // Socket index waiting for EPOLLOUT, or -1
+    size_t expected;                // Requests that may still be answered
+    size_t replies;
+} IcmpRun;
+
+static struct {
+    Metric *requests;
+    Metric *replies;
+    Metric *rtt;
+} g_icmp_metrics;
+static pthread_once_t g_icmp_metrics_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Register the ICMP probe metrics
+ */
+static void register_metrics(void) {
+    g_icmp_metrics.requests = metrics_counter("bdix_icmp_requests_total", "ICMP echo requests sent");
+    g_icmp_metrics.replies = metrics_counter("bdix_icmp_replies_total", "ICMP echo replies received");
+    g_icmp_metrics.rtt = metrics_histogram("bdix_icmp_rtt_ms", "ICMP echo round-trip time");
+}
+
+/**
+ * @brief Open a non-blocking ping socket
+ */
+static int open_ping_socket(int family) {
+    int protocol = family == AF_INET ? IPPROTO_ICMP : IPPROTO_ICMPV6;
+    return socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, protocol);
+}
+
+static int family_index(int family) {
+    return family == AF_INET ? 0 : 1;
+}
+
+/**
+ * @brief Get default ICMP probe configuration
+ */
+IcmpConfig icmp_get_default_config(void) {
+    return (IcmpConfig){
+        .samples = ICMP_DEFAULT_SAMPLES,
+        .interval_ms = ICMP_DEFAULT_INTERVAL_MS,
+        .timeout_ms = ICMP_DEFAULT_TIMEOUT_MS,
+        .resolver_threads = DEFAULT_THREADS
+    };
+}
+
+/**
+ * @brief Check whether unprivileged ICMP sockets can be opened
+ */
+bool icmp_available(void) {
+    int fd = open_ping_socket(AF_INET);
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+    return true;
+}
+
+/**
+ * @brief Thread pool worker: resolve every address of one target
+ */
+static void* resolve_worker(void *arg) {
+    IcmpResolveJob *job = (IcmpResolveJob*)arg;
+    IcmpTarget *target = job->target;
+
+    struct addrinfo hints;
+    struct addrinfo *result = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    if (!job->host || getaddrinfo(job->host, NULL, &hints, &result) != 0 || !result) {
+        LOG_DEBUG("ICMP probe could not resolve %s", job->host ? job->host : "(null)");
+        return NULL;
+    }
+
+    for (const struct addrinfo *ai = result; ai && target->address_count < ICMP_MAX_ADDRESSES;
+         ai = ai->ai_next) {
+        if ((ai->ai_family != AF_INET && ai->ai_family != AF_INET6) ||
+            ai->ai_addrlen > sizeof(target->addresses[0].addr)) {
+            continue;
+        }
+        IcmpAddress *address = &target->addresses[target->address_count++];
+        memcpy(&address->addr, ai->ai_addr, ai->ai_addrlen);
+        address->addr_len = ai->ai_addrlen;
+        address->family = ai->ai_family;
+    }
+    freeaddrinfo(result);
+    return NULL;
+}
+
+/**
+ * @brief Resolve every host, in parallel when more than one thread is allowed
+ */
+static void resolve_targets(IcmpRun *run, const char *const *hosts) {
+    IcmpResolveJob *jobs = safe_malloc(run->count * sizeof(IcmpResolveJob));
+    for (size_t i = 0; i < run->count; i++) {
+        jobs[i] = (IcmpResolveJob){ .host = hosts[i], .target = &run->targets[i] };
+    }
+
+    int threads = run->config->resolver_threads;
+    ThreadPool *pool = NULL;
+    if (threads > 1 && run->count > 1) {
+        pool = thread_pool_create((size_t)threads < run->count ? (size_t)threads : run->count);
+    }
+    for (size_t i = 0; i < run->count; i++) {
+        if (!pool || thread_pool_add_work(pool, resolve_worker, &jobs[i]) != BDIX_SUCCESS) {
+            resolve_worker(&jobs[i]);
+        }
+    }
+    if (pool) {
+        thread_pool_wait(pool);
+        thread_pool_destroy(pool);
+    }
+    free(jobs);
+}
+
+/**
+ * @brief Move a target to its first address, from start on, that has an open socket
+ *
+ * @return false if no address is left to try
+ */
+static bool select_address(IcmpRun *run, IcmpTarget *target, size_t start) {
+    for (size_t i = start; i < target->address_count; i++) {
+        if (run->sockets[family_index(target->addresses[i].family)] >= 0) {
+            target->current = i;
+            target->family = target->addresses[i].family;
+            return true;
+        }
+    }
+    target->family = 0;
+    return false;
+}
+
+/**
+ * @brief Send one echo request
+ *
+ * @return false if the socket buffer is full and the request must be retried
+ */
+static bool send_echo(IcmpRun *run, size_t index, unsigned sample) {
+    IcmpTarget *target = &run->targets[index];
+
+    IcmpEchoPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.token = run->token;
+    packet.target = (uint32_t)index;
+    packet.sample = sample;
+
+    for (;;) {
+        const IcmpAddress *address = &target->addresses[target->current];
+        int slot = family_index(address->family);
+        packet.header.type = address->family == AF_INET ? ICMP_ECHO_REQUEST : ICMP6_ECHO_REQUEST_TYPE;
+        packet.header.sequence = htons(run->sequence);
+
+        target->sent_ms[sample] = get_time_ms();
+        target->sent_to[sample] = (uint8_t)target->current;
+        if (sendto(run->sockets[slot], &packet, sizeof(packet), 0,
+                   (const struct sockaddr*)&address->addr, address->addr_len) >= 0) {
+            break;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            struct epoll_event event = { .events = EPOLLIN | EPOLLOUT, .data.u32 = (uint32_t)slot };
+            epoll_ctl(run->epoll_fd, EPOLL_CTL_MOD, run->sockets[slot], &event);
+            run->blocked = slot;
+            return false;
+        }
+        // Unreachable network and the like: try the host's next address,
+        // else the request counts as lost
+        LOG_DEBUG("ICMP echo to target %zu failed: %s", index, strerror(errno));
+        run->sequence++;
+        if (!select_address(run, target, target->current + 1)) {
+            target->result->sent++;
+            return true;
+        }
+    }
+
+    target->result->sent++;
+    run->sequence++;
+    run->expected++;
+    metrics_add(g_icmp_metrics.requests, 1);
+    return true;
+}
+
+/**
+ * @brief Check whether a reply came from the address a request went to
+ */
+static bool reply_from(const IcmpAddress *address, const struct sockaddr_storage *from) {
+    if (address->family != from->ss_family) {
+        return false;
+    }
+    if (address->family == AF_INET) {
+        return memcmp(&((const struct sockaddr_in*)&address->addr)->sin_addr,
+                      &((const struct sockaddr_in*)from)->sin_addr, sizeof(struct in_addr)) == 0;
+    }
+    return memcmp(&((const struct sockaddr_in6*)&address->addr)->sin6_addr,
+                  &((const struct sockaddr_in6*)from)->sin6_addr, sizeof(struct in6_addr)) == 0;
+}
+
+/**
+ * @brief Read every pending reply from a socket
+ */
+static void receive_replies(IcmpRun *run, int slot) {
+    uint8_t buffer[ICMP_RECV_BUFFER];
+    uint8_t reply_type = slot == 0 ? ICMP_ECHO_REPLY : ICMP6_ECHO_REPLY_TYPE;
+
+    for (;;) {
+        struct sockaddr_storage from;
+        socklen_t from_len = sizeof(from);
+        ssize_t n = recvfrom(run->sockets[slot], buffer, sizeof(buffer), 0, /* flawfinder: ignore - bounded by sizeof(buffer) */
+                             (struct sockaddr*)&from, &from_len);
+        if (n < 0) {
+            return;  // EAGAIN: drained
+        }
+        double now = get_time_ms();
+
+        IcmpEchoPacket packet;
+        if ((size_t)n < sizeof(packet)) {
+            continue;
+        }
+        memcpy(&packet, buffer, sizeof(packet));
+        if (packet.header.type != reply_type || packet.token != run->token ||
+            packet.target >= run->count || packet.sample >= (uint32_t)run->config->samples) {
+            continue;
+        }
+
+        IcmpTarget *target = &run->targets[packet.target];
+        uint32_t bit = 1u << packet.sample;
+        // Match on the address that round went to: the target may have moved on since
+        if (!reply_from(&target->addresses[target->sent_to[packet.sample]], &from) ||
+            (target->replied & bit)) {
+            continue;  // Duplicate or stray reply
+        }
+        target->replied |= bit;
+
+        double rtt_ms = now - target->sent_ms[packet.sample];
+        ServerPing *result = target->result;
+        if (result->received == 0 || rtt_ms < result->min_ms) {
+            result->min_ms = rtt_ms;
+        }
+        result->received++;
+        target->sum_ms += rtt_ms;
+        run->replies++;
+        metrics_add(g_icmp_metrics.replies, 1);
+        metrics_observe(g_icmp_metrics.rtt, rtt_ms);
+    }
+}
+
+/**
+ * @brief Send all rounds and collect replies until done or timed out
+ */
+static void run_probe(IcmpRun *run) {
+    const IcmpConfig *config = run->config;
+    double start = get_time_ms();
+    double sends_done_ms = 0.0;
+    unsigned round = 0;
+    size_t next = 0;
+
+    for (;;) {
+        double now = get_time_ms();
+
+        // Send every request that is due, unless a socket buffer is full
+        while (run->blocked < 0 && round < (unsigned)config->samples &&
+               now >= start + (double)round * config->interval_ms) {
+            if (next == run->count) {
+                round++;
+                next = 0;
+                continue;
+            }
+            IcmpTarget *target = &run->targets[next];
+            if (target->family == 0 || run->sockets[family_index(target->family)] < 0) {
+                next++;
+                continue;
+            }
+            if (!send_echo(run, next, round)) {
+                break;
+            }
+            next++;
+        }
+
+        bool sending = round < (unsigned)config->samples;
+        if (!sending && sends_done_ms == 0.0) {
+            sends_done_ms = get_time_ms();
+        }
+        if (!sending && (run->replies == run->expected ||
+                         now >= sends_done_ms + config->timeout_ms)) {
+            break;
+        }
+
+        double wake_ms;
+        if (!sending) {
+            wake_ms = sends_done_ms + config->timeout_ms;
+        } else if (run->blocked >= 0) {
+            wake_ms = now + config->timeout_ms;
+        } else {
+            wake_ms = start + (double)round * config->interval_ms;
+        }
+        int wait_ms = wake_ms > now ? (int)(wake_ms - now) + 1 : 0;
+
+        struct epoll_event events[2];
+        int ready = epoll_wait(run->epoll_fd, events, 2, wait_ms);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("ICMP epoll_wait failed: %s", strerror(errno));
+            return;
+        }
+        if (ready == 0 && run->blocked >= 0) {
+            // Still no buffer space: give up on the remaining requests
+            LOG_WARN("ICMP send buffer stayed full, %u of %d rounds sent",
+                     round, config->samples);
+            return;
+        }
+
+        for (int i = 0; i < ready; i++) {
+            int slot = (int)events[i].data.u32;
+            if (events[i].events & EPOLLOUT) {
+                struct epoll_event event = { .events = EPOLLIN, .data.u32 = (uint32_t)slot };
+                epoll_ctl(run->epoll_fd, EPOLL_CTL_MOD, run->sockets[slot], &event);
+                run->blocked = -1;
+            }
+            if (events[i].events & EPOLLIN) {
+                receive_replies(run, slot);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Ping a list of hosts
+ */
+int icmp_probe_hosts(const char *const *hosts, size_t count, const IcmpConfig *config,
+                     ServerPing *results) {
+    if (!hosts || !config || !results || config->samples < 1 ||
+        config->samples > ICMP_MAX_SAMPLES || config->interval_ms < 0 ||
+        config->timeout_ms <= 0) {
+        LOG_ERROR("Invalid parameters for ICMP probe");
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    memset(results, 0, count * sizeof(ServerPing));
+    if (count == 0) {
+        return BDIX_SUCCESS;
+    }
+
+    pthread_once(&g_icmp_metrics_once, register_metrics);
+    uint64_t probe_start = trace_begin();
+
+    IcmpRun run = {
+        .targets = safe_calloc(count, sizeof(IcmpTarget)),
+        .count = count,
+        .config = config,
+        .token = ((uint64_t)getpid() << 32) ^ (uint64_t)(get_time_ms() * 1000.0),
+        .sockets = { -1, -1 },
+        .epoll_fd = -1,
+        .blocked = -1
+    };
+
+    for (size_t i = 0; i < count; i++) {
+        run.targets[i].result = &results[i];
+    }
+    resolve_targets(&run, hosts);
+
+    bool need[2] = { false, false };
+    for (size_t i = 0; i < count; i++) {
+        for (size_t a = 0; a < run.targets[i].address_count; a++) {
+            need[family_index(run.targets[i].addresses[a].family)] = true;
+        }
+    }
+
+    int ret = BDIX_SUCCESS;
+    run.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (run.epoll_fd < 0) {
+        LOG_ERROR("Failed to create epoll instance: %s", strerror(errno));
+        ret = BDIX_ERROR_NETWORK;
+        goto cleanup;
+    }
+
+    bool opened = false;
+    for (int slot = 0; slot < 2; slot++) {
+        if (!need[slot]) {
+            continue;
+        }
+        int family = slot == 0 ? AF_INET : AF_INET6;
+        run.sockets[slot] = open_ping_socket(family);
+        if (run.sockets[slot] < 0) {
+            if (errno == EACCES || errno == EPERM) {
+                LOG_WARN("ICMP%s echo sockets not permitted for group %u (see net.ipv4.ping_group_range)",
+                         slot == 0 ? "" : "v6", (unsigned)getgid());
+            } else {
+                LOG_WARN("Failed to open ICMP%s socket: %s", slot == 0 ? "" : "v6", strerror(errno));
+            }
+            continue;
+        }
+        struct epoll_event event = { .events = EPOLLIN, .data.u32 = (uint32_t)slot };
+        epoll_ctl(run.epoll_fd, EPOLL_CTL_ADD, run.sockets[slot], &event);
+        opened = true;
+    }
+    if (!opened) {
+        ret = need[0] || need[1] ? BDIX_ERROR_NETWORK : BDIX_SUCCESS;
+        goto cleanup;
+    }
+    for (size_t i = 0; i < count; i++) {
+        select_address(&run, &run.targets[i], 0);
+    }
+
+    run_probe(&run);
+
+    for (size_t i = 0; i < count; i++) {
+        if (results[i].received > 0) {
+            results[i].avg_ms = run.targets[i].sum_ms / results[i].received;
+        }
+    }
+    LOG_DEBUG("ICMP probe: %zu hosts, %zu replies to %zu requests",
+              count, run.replies, run.expected);
+
+cleanup:
+    for (int slot = 0; slot < 2; slot++) {
+        if (run.sockets[slot] >= 0) {
+            close(run.sockets[slot]);
+        }
+    }
+    if (run.epoll_fd >= 0) {
+        close(run.epoll_fd);
+    }
+    free(run.targets);
+    trace_end(TRACE_CAT_CHECK, "icmp_probe", probe_start, NULL);
+    return ret;
+}
+
+/**
+ * @brief Host of a server, for sorting
+ */
+typedef struct {
+    char host[MEDIUM_BUFFER]; /* flawfinder: ignore - bounds checked in rate_limiter_extract_host */
+    size_t server;
+} IcmpHostEntry;
+
+static int compare_host_entries(const void *a, const void *b) {
+    return strcmp(((const IcmpHostEntry*)a)->host, ((const IcmpHostEntry*)b)->host);
+}
+
+/**
+ * @brief Ping the hosts of a set of servers
+ */
+int icmp_probe_servers(Server *const *servers, size_t count, const IcmpConfig *config) {
+    if (!servers || !config) {
+        LOG_ERROR("Invalid parameters for ICMP server probe");
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+    if (count == 0) {
+        return BDIX_SUCCESS;
+    }
+
+    // Sort by host so servers sharing a host are pinged once
+    IcmpHostEntry *entries = safe_malloc(count * sizeof(IcmpHostEntry));
+    size_t valid = 0;
+    for (size_t i = 0; i < count; i++) {
+        memset(&servers[i]->ping, 0, sizeof(servers[i]->ping));
+        if (rate_limiter_extract_host(servers[i]->url, entries[valid].host,
+                                      sizeof(entries[valid].host)) == BDIX_SUCCESS) {
+            entries[valid].server = i;
+            valid++;
+        }
+    }
+    qsort(entries, valid, sizeof(IcmpHostEntry), compare_host_entries);
+
+    const char **hosts = safe_malloc((valid > 0 ? valid : 1) * sizeof(char*));
+    size_t unique = 0;
+    for (size_t i = 0; i < valid; i++) {
+        if (unique == 0 || strcmp(hosts[unique - 1], entries[i].host) != 0) {
+            hosts[unique++] = entries[i].host;
+        }
+    }
+
+    ServerPing *results = safe_malloc((unique > 0 ? unique : 1) * sizeof(ServerPing));
+    int ret = icmp_probe_hosts(hosts, unique, config, results);
+    if (ret == BDIX_SUCCESS) {
+        size_t host = 0;
+        for (size_t i = 0; i < valid; i++) {
+            if (strcmp(hosts[host], entries[i].host) != 0) {
+                host++;
+            }
+            servers[entries[i].server]->ping = results[host];
+        }
+    }
+
+    free(results);
+    free(hosts);
+    free(entries);
+    return ret;
+}
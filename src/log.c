@@ -0,0 +1,379 @@
+/**
+ * @file log.c
+ * @brief Leveled logging with per-thread ring buffers and a background flusher
+ * @version 1.0.0
+ */
+
+#include "common.h"
+#include <pthread.h>
+#include <strings.h>
+
+/**
+ * @brief One buffered message
+ */
+typedef struct {
+    LogLevel level;
+    char text[LOG_MESSAGE_MAX]; /* flawfinder: ignore - bounds checked with vsnprintf */
+} LogSlot;
+
+/**
+ * @brief Single-producer/single-consumer ring owned by one thread
+ *
+ * The owning thread advances head; the flusher (holding g_log_mutex)
+ * advances tail. Rings of exited threads are freed once drained.
+ */
+typedef struct LogRing {
+    struct LogRing *next;           // Registration list link
+    _Atomic size_t head;            // Next slot to write
+    _Atomic size_t tail;            // Next slot to flush
+    _Atomic bool orphaned;          // Owning thread has exited
+    LogSlot slots[LOG_RING_SLOTS];
+} LogRing;
+
+#ifdef DEBUG
+_Atomic int g_log_level = LOG_LEVEL_DEBUG;
+#else
+_Atomic int g_log_level = LOG_LEVEL_INFO;
+#endif
+
+static const char *const g_level_names[] = { "debug", "info", "warn", "error", "off" };
+static const char *const g_level_tags[] = { "DEBUG", "INFO", "WARN", "ERROR", "" };
+
+static _Atomic bool g_log_async = false;
+static LogRing *_Atomic g_log_rings = NULL;
+static _Atomic size_t g_log_dropped = 0;
+static _Atomic size_t g_log_pending = 0;    // Buffered, not yet written
+static FILE *_Atomic g_log_out = NULL;
+static FILE *_Atomic g_log_err = NULL;
+
+static pthread_mutex_t g_log_mutex = PTHREAD_MUTEX_INITIALIZER;  // Serializes flushing
+static pthread_cond_t g_log_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t g_log_thread;
+static pthread_t g_log_owner;                // Thread that writes synchronously
+static bool g_log_running = false;
+static bool g_log_atexit = false;
+
+static pthread_key_t g_log_key;
+static pthread_once_t g_log_key_once = PTHREAD_ONCE_INIT;
+static _Thread_local LogRing *t_log_ring = NULL;
+
+/**
+ * @brief Stream a level is written to
+ */
+static FILE* level_stream(LogLevel level) {
+    FILE *out = atomic_load(&g_log_out);
+    FILE *err = atomic_load(&g_log_err);
+    if (level == LOG_LEVEL_INFO) {
+        return out ? out : stdout;
+    }
+    return err ? err : stderr;
+}
+
+/**
+ * @brief Mark the exiting thread's ring for reclamation by the flusher
+ */
+static void release_ring(void *arg) {
+    LogRing *ring = (LogRing*)arg;
+    if (ring) {
+        atomic_store_explicit(&ring->orphaned, true, memory_order_release);
+    }
+}
+
+static void create_key(void) {
+    pthread_key_create(&g_log_key, release_ring);
+}
+
+/**
+ * @brief Get (or create and register) the calling thread's ring
+ */
+static LogRing* thread_ring(void) {
+    if (t_log_ring) {
+        return t_log_ring;
+    }
+
+    pthread_once(&g_log_key_once, create_key);
+
+    LogRing *ring = calloc(1, sizeof(LogRing));
+    if (!ring) {
+        return NULL;
+    }
+
+    // Lock-free push onto the registration list
+    LogRing *head = atomic_load(&g_log_rings);
+    do {
+        ring->next = head;
+    } while (!atomic_compare_exchange_weak(&g_log_rings, &head, ring));
+
+    pthread_setspecific(g_log_key, ring);
+    t_log_ring = ring;
+    return ring;
+}
+
+/**
+ * @brief Format a message with its level tag into buf
+ */
+static void format_message(char *buf, size_t size, LogLevel level, const char *file,
+                           int line, const char *fmt, va_list args) {
+    int offset;
+    if (level == LOG_LEVEL_DEBUG || level == LOG_LEVEL_ERROR) {
+        offset = snprintf(buf, size, "[%s] %s:%d: ", g_level_tags[level], file, line); // flawfinder: ignore
+    } else {
+        offset = snprintf(buf, size, "[%s] ", g_level_tags[level]); // flawfinder: ignore
+    }
+    if (offset < 0 || (size_t)offset >= size) {
+        return;
+    }
+    vsnprintf(buf + offset, size - (size_t)offset, fmt, args); // flawfinder: ignore - fmt comes from LOG_* call sites
+}
+
+/**
+ * @brief Format and emit one message
+ */
+void log_write(LogLevel level, const char *file, int line, const char *fmt, ...) {
+    if (level < LOG_LEVEL_DEBUG || level >= LOG_LEVEL_OFF || !fmt) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+
+    LogRing *ring = NULL;
+    if (atomic_load_explicit(&g_log_async, memory_order_acquire)) {
+        if (!pthread_equal(pthread_self(), g_log_owner)) {
+            ring = thread_ring();
+        } else if (atomic_load_explicit(&g_log_pending, memory_order_relaxed) > 0) {
+            log_flush();
+        }
+    }
+    if (!ring) {
+        char text[LOG_MESSAGE_MAX]; /* flawfinder: ignore - bounds checked with vsnprintf */
+        format_message(text, sizeof(text), level, file, line, fmt, args);
+        va_end(args);
+        fprintf(level_stream(level), "%s\n", text); // flawfinder: ignore
+        return;
+    }
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= LOG_RING_SLOTS) {
+        va_end(args);
+        atomic_fetch_add_explicit(&g_log_dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    LogSlot *slot = &ring->slots[head % LOG_RING_SLOTS];
+    slot->level = level;
+    format_message(slot->text, sizeof(slot->text), level, file, line, fmt, args);
+    va_end(args);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    atomic_fetch_add_explicit(&g_log_pending, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Write out every ring and free drained rings of exited threads
+ *
+ * Must be called with g_log_mutex held.
+ */
+static void drain_locked(void) {
+    LogRing *prev = NULL;
+    LogRing *ring = atomic_load(&g_log_rings);
+    FILE *out = level_stream(LOG_LEVEL_INFO);
+    FILE *err = level_stream(LOG_LEVEL_ERROR);
+    bool wrote_out = false;
+    bool wrote_err = false;
+
+    while (ring) {
+        bool orphaned = atomic_load_explicit(&ring->orphaned, memory_order_acquire);
+        size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+        if (head != tail) {
+            atomic_fetch_sub_explicit(&g_log_pending, head - tail, memory_order_relaxed);
+        }
+        for (; tail != head; tail++) {
+            const LogSlot *slot = &ring->slots[tail % LOG_RING_SLOTS];
+            bool to_out = slot->level == LOG_LEVEL_INFO;
+            fprintf(to_out ? out : err, "%s\n", slot->text); // flawfinder: ignore
+            wrote_out |= to_out;
+            wrote_err |= !to_out;
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+        LogRing *next = ring->next;
+        if (orphaned) {
+            // Unlink; producers only ever push at the list head
+            bool unlinked = false;
+            if (prev) {
+                prev->next = next;
+                unlinked = true;
+            } else {
+                LogRing *expected = ring;
+                unlinked = atomic_compare_exchange_strong(&g_log_rings, &expected, next);
+                if (!unlinked) {
+                    // New rings were pushed in front; find the predecessor
+                    LogRing *p = atomic_load(&g_log_rings);
+                    while (p && p->next != ring) {
+                        p = p->next;
+                    }
+                    if (p) {
+                        p->next = next;
+                        unlinked = true;
+                    }
+                }
+            }
+            if (unlinked) {
+                free(ring);
+                ring = next;
+                continue;
+            }
+        }
+
+        prev = ring;
+        ring = next;
+    }
+
+    if (wrote_out) {
+        fflush(out);
+    }
+    if (wrote_err) {
+        fflush(err);
+    }
+}
+
+/**
+ * @brief Flusher thread: drain all rings every LOG_FLUSH_INTERVAL_MS
+ */
+static void* flusher_thread(void *arg) {
+    UNUSED(arg);
+
+    pthread_mutex_lock(&g_log_mutex);
+    while (g_log_running) {
+        drain_locked();
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += LOG_FLUSH_INTERVAL_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&g_log_cond, &g_log_mutex, &deadline);
+    }
+    drain_locked();
+    pthread_mutex_unlock(&g_log_mutex);
+    return NULL;
+}
+
+/**
+ * @brief Write out buffered messages
+ */
+void log_flush(void) {
+    pthread_mutex_lock(&g_log_mutex);
+    drain_locked();
+    pthread_mutex_unlock(&g_log_mutex);
+}
+
+/**
+ * @brief Start the background flusher
+ */
+int log_start(void) {
+    pthread_mutex_lock(&g_log_mutex);
+    if (g_log_running) {
+        pthread_mutex_unlock(&g_log_mutex);
+        return BDIX_SUCCESS;
+    }
+
+    g_log_running = true;
+    g_log_owner = pthread_self();
+    if (pthread_create(&g_log_thread, NULL, flusher_thread, NULL) != 0) {
+        g_log_running = false;
+        pthread_mutex_unlock(&g_log_mutex);
+        return BDIX_ERROR;
+    }
+
+    // Messages logged right before exit() must not be lost
+    if (!g_log_atexit) {
+        g_log_atexit = atexit(log_stop) == 0;
+    }
+    pthread_mutex_unlock(&g_log_mutex);
+
+    atomic_store_explicit(&g_log_async, true, memory_order_release);
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Flush and return to synchronous logging
+ */
+void log_stop(void) {
+    atomic_store_explicit(&g_log_async, false, memory_order_release);
+
+    pthread_mutex_lock(&g_log_mutex);
+    if (!g_log_running) {
+        drain_locked();
+        pthread_mutex_unlock(&g_log_mutex);
+        return;
+    }
+    g_log_running = false;
+    pthread_cond_signal(&g_log_cond);
+    pthread_mutex_unlock(&g_log_mutex);
+
+    pthread_join(g_log_thread, NULL);
+
+    size_t dropped = atomic_exchange(&g_log_dropped, 0);
+    if (dropped > 0) {
+        fprintf(level_stream(LOG_LEVEL_WARN), // flawfinder: ignore
+                "[WARN] %zu log messages dropped (buffer full)\n", dropped);
+    }
+}
+
+/**
+ * @brief Set the runtime level
+ */
+void log_set_level(LogLevel level) {
+    if (level >= LOG_LEVEL_DEBUG && level <= LOG_LEVEL_OFF) {
+        atomic_store(&g_log_level, (int)level);
+    }
+}
+
+/**
+ * @brief Get the runtime level
+ */
+LogLevel log_get_level(void) {
+    return (LogLevel)atomic_load(&g_log_level);
+}
+
+/**
+ * @brief Parse a level name
+ */
+bool log_parse_level(const char *name, LogLevel *level) {
+    if (!name || !level) {
+        return false;
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(g_level_names); i++) {
+        if (strcasecmp(name, g_level_names[i]) == 0) {
+            *level = (LogLevel)i;
+            return true;
+        }
+    }
+    if (strcasecmp(name, "warning") == 0) {
+        *level = LOG_LEVEL_WARN;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Redirect log output
+ */
+void log_set_streams(FILE *out, FILE *err) {
+    log_flush();
+    atomic_store(&g_log_out, out);
+    atomic_store(&g_log_err, err);
+}
+
+/**
+ * @brief Get number of dropped messages
+ */
+size_t log_dropped_count(void) {
+    return atomic_load(&g_log_dropped);
+}
@@ -10,16 +10,69 @@
 #include "checker.h"
 #include "config.h"
 #include "ui.h"
+#include "scheduler.h"
+#include "rollup.h"
+#include "query.h"
+#include "trace.h"
+#include "metrics.h"
+#include "icmp.h"
+#include "uring.h"
 #include <getopt.h>
+#include <limits.h>
+#include <signal.h>
+#include <sys/resource.h>
 
 
 
+// Long-only option identifiers
+enum {
+    OPT_MIN_INTERVAL = 1000,
+    OPT_MAX_INTERVAL,
+    OPT_HOST_RATE,
+    OPT_HOST_BURST,
+    OPT_HOST_CONCURRENCY,
+    OPT_PER_IP,
+    OPT_NO_RATE_LIMIT,
+    OPT_ALERT_WEBHOOK,
+    OPT_ALERT_COMMAND,
+    OPT_ALERT_CONFIRM,
+    OPT_HISTORY,
+    OPT_HISTORY_RETENTION,
+    OPT_SINCE,
+    OPT_TOP,
+    OPT_SORT,
+    OPT_MIN_UPTIME,
+    OPT_FORMAT,
+    OPT_OUTPUT,
+    OPT_TIMING,
+    OPT_TRACE,
+    OPT_LOG_LEVEL,
+    OPT_METRICS_SOCKET,
+    OPT_ICMP,
+    OPT_ICMP_SAMPLES,
+    OPT_TCP_ONLY,
+    OPT_IO_URING,
+    OPT_ADAPTIVE_TIMEOUT,
+    OPT_FASTEST,
+    OPT_FASTEST_GRACE,
+    OPT_RETRIES,
+    OPT_RETRY_BACKOFF,
+    OPT_HEDGE,
+    OPT_RETRY_BUDGET,
+    OPT_DEADLINE,
+    OPT_PRIORITIZE,
+    OPT_DEAD_TIMEOUT,
+    OPT_MAX_THREADS
+};
+
 /**
  * @brief Program options structure
  */
 typedef struct {
     char config_file[MAX_PATH_LENGTH]; /* flawfinder: ignore - bounds checked with safe_strncpy */
     int thread_count;
+    bool autotune_threads;          // --threads auto
+    int max_threads;                // Autotuning ceiling
     bool check_ftp;
     bool check_tv;
     bool check_others;
@@ -28,6 +81,33 @@ typedef struct {
     bool no_color;
     bool interactive;
     bool show_stats;
+    bool show_timing;
+    char trace_file[MAX_PATH_LENGTH]; /* flawfinder: ignore - bounds checked with safe_strncpy */
+    char metrics_socket[MAX_PATH_LENGTH]; /* flawfinder: ignore - bounds checked with safe_strncpy */
+    bool icmp;
+    IcmpConfig icmp_config;
+    bool tcp_only;
+    bool io_uring;
+    bool adaptive_timeout;
+    AdaptiveTimeoutPolicy adaptive_policy;
+    size_t fastest;                 // Stop each category once this many are online (0 = off)
+    int fastest_grace_ms;
+    RetryConfig retry;              // Retries and hedging (off unless --retries or --hedge)
+    double deadline_s;              // Stop a one-shot sweep after this long (0 = none)
+    bool prioritize;                // Check likely-online, fast servers first
+    int dead_timeout_ms;            // Deadline for servers dead throughout their history (0 = off)
+    bool watch;
+    double min_interval_s;
+    double max_interval_s;
+    RateLimitConfig rate_limit;
+    bool rate_limit_enabled;
+    AlertConfig alert;
+    char history_dir[MAX_PATH_LENGTH]; /* flawfinder: ignore - bounds checked with safe_strncpy */
+    RollupConfig rollup;
+    bool query;                     // "query" subcommand
+    int64_t query_since_ms;
+    QueryOptions query_options;
+    char query_output[MAX_PATH_LENGTH]; /* flawfinder: ignore - bounds checked with safe_strncpy */
 } ProgramOptions;
 
 /**
@@ -35,12 +115,15 @@ typedef struct {
  */
 /* flawfinder: ignore - all printf calls below use compile-time constant format strings */
 static void print_usage(const char *program_name) {
-    printf("Usage: %s [OPTIONS]\n\n", program_name); // flawfinder: ignore
+    printf("Usage: %s [OPTIONS]\n", program_name); // flawfinder: ignore
+    printf("       %s query --history DIR [QUERY OPTIONS]\n\n", program_name); // flawfinder: ignore
     printf("BDIX Server Monitor - Check FTP, TV, and other BDIX servers\n\n"); // flawfinder: ignore
     printf("Options:\n"); // flawfinder: ignore
     printf("  -c, --config FILE      Configuration file (default: data/server.json)\n"); // flawfinder: ignore
-    printf("  -t, --threads NUM      Number of threads (default: %d, range: %d-%d)\n", // flawfinder: ignore
+    printf("  -t, --threads NUM      Number of threads (default: %d, range: %d-%d), or auto\n", // flawfinder: ignore
            DEFAULT_THREADS, MIN_THREADS, MAX_THREADS);
+    printf("      --max-threads NUM  Ceiling for --threads auto (default: %d, at most %d)\n", // flawfinder: ignore
+           DEFAULT_AUTOTUNE_MAX_THREADS, MAX_AUTOTUNE_THREADS);
     printf("  -f, --ftp              Check only FTP servers\n"); // flawfinder: ignore
     printf("  -v, --tv               Check only TV servers\n"); // flawfinder: ignore
     printf("  -o, --others           Check only other servers\n"); // flawfinder: ignore
@@ -49,12 +132,66 @@ static void print_usage(const char *program_name) {
     printf("  -n, --no-color         Disable colored output\n"); // flawfinder: ignore
     printf("  -i, --interactive      Start in interactive mode (default)\n"); // flawfinder: ignore
     printf("  -s, --stats            Show statistics only\n"); // flawfinder: ignore
+    printf("      --timing           Show DNS/connect/TLS/server time per check\n"); // flawfinder: ignore
+    printf("      --trace FILE       Record pool and check spans as Chrome trace JSON in FILE\n"); // flawfinder: ignore
+    printf("      --metrics-socket PATH  Serve JSON/binary metrics snapshots on a Unix socket\n"); // flawfinder: ignore
+    printf("      --icmp             Also measure raw RTT with unprivileged ICMP echo\n"); // flawfinder: ignore
+    printf("      --icmp-samples NUM Echo requests per host (default: %d, max: %d)\n", // flawfinder: ignore
+           ICMP_DEFAULT_SAMPLES, ICMP_MAX_SAMPLES);
+    printf("      --tcp-only         Only test TCP reachability (connect sweep, no HTTP)\n"); // flawfinder: ignore
+    printf("      --io-uring         Drive TCP sweeps and plain-HTTP checks with io_uring\n"); // flawfinder: ignore
+    printf("      --adaptive-timeout Per-server deadlines from recent latency (p%.0f x %.0f, min %d ms)\n", // flawfinder: ignore
+           ADAPTIVE_TIMEOUT_QUANTILE * 100, ADAPTIVE_TIMEOUT_MULTIPLIER, ADAPTIVE_TIMEOUT_FLOOR_MS);
+    printf("      --fastest K        Stop each category once K servers are online, list the fastest\n"); // flawfinder: ignore
+    printf("      --fastest-grace MS Keep checking this long after the K-th result (default: %d)\n", // flawfinder: ignore
+           TOP_K_GRACE_MS);
+    printf("      --retries N        Retry timed-out or failed checks up to N times (max: %d)\n", // flawfinder: ignore
+           RETRY_MAX_RETRIES);
+    printf("      --retry-backoff MS Delay before the first retry, doubled per retry (default: %.0f)\n", // flawfinder: ignore
+           RETRY_DEFAULT_BACKOFF_MS);
+    printf("      --hedge PCT        Send a second request once a check outlasts this latency percentile\n"); // flawfinder: ignore
+    printf("      --retry-budget PCT Retries and hedges per 100 checks (default: %.0f)\n", // flawfinder: ignore
+           RETRY_DEFAULT_BUDGET_PCT);
+    printf("      --deadline SEC     Stop the sweep after SEC seconds and report what was checked\n"); // flawfinder: ignore
+    printf("      --prioritize       Check servers that were online and fast first, dead ones last\n"); // flawfinder: ignore
+    printf("      --dead-timeout MS  Timeout for servers that failed every recent check\n"); // flawfinder: ignore
+    printf("      --log-level LEVEL  debug, info, warn, error or off (default: info, or $BDIX_LOG_LEVEL)\n"); // flawfinder: ignore
+    printf("  -w, --watch            Monitor continuously with adaptive intervals\n"); // flawfinder: ignore
+    printf("      --min-interval SEC Shortest watch interval (default: %.0f)\n", // flawfinder: ignore
+           SCHED_DEFAULT_MIN_INTERVAL);
+    printf("      --max-interval SEC Longest watch interval (default: %.0f)\n", // flawfinder: ignore
+           SCHED_DEFAULT_MAX_INTERVAL);
+    printf("      --host-rate NUM    Probes per second per host (default: %.0f)\n", // flawfinder: ignore
+           RATE_LIMIT_DEFAULT_RATE);
+    printf("      --host-burst NUM   Burst size per host (default: %.0f)\n", // flawfinder: ignore
+           RATE_LIMIT_DEFAULT_BURST);
+    printf("      --host-concurrency NUM  Concurrent probes per host, 0 = unlimited (default: %d)\n", // flawfinder: ignore
+           RATE_LIMIT_DEFAULT_CONCURRENCY);
+    printf("      --per-ip           Apply host limits per resolved IP address\n"); // flawfinder: ignore
+    printf("      --no-rate-limit    Disable per-host rate limiting\n"); // flawfinder: ignore
+    printf("      --alert-webhook URL  POST watch-mode state changes as JSON to URL\n"); // flawfinder: ignore
+    printf("      --alert-command PATH Run PATH with state changes as JSON on stdin\n"); // flawfinder: ignore
+    printf("      --alert-confirm N/M  Confirm a change after N of M checks (default: %d/%d)\n", // flawfinder: ignore
+           ALERT_DEFAULT_CONFIRM_N, ALERT_DEFAULT_WINDOW_M);
+    printf("      --history DIR      Append every check result to the history store in DIR\n"); // flawfinder: ignore
+    printf("      --history-retention SPEC  Retention per tier (default: raw=2d,1m=14d,1h=180d,1d=5y)\n"); // flawfinder: ignore
     printf("  -h, --help             Show this help message\n"); // flawfinder: ignore
     printf("  -V, --version          Show version information\n"); // flawfinder: ignore
+    printf("\nQuery options (with -c, -f, -v, -o, -t):\n"); // flawfinder: ignore
+    printf("      --since DUR        Range ending now, e.g. 24h, 7d, 4w (default: 7d)\n"); // flawfinder: ignore
+    printf("      --top N            Show the best N servers, 0 = all (default: %d)\n", // flawfinder: ignore
+           QUERY_DEFAULT_TOP);
+    printf("      --sort KEY         p50, p90, p99, avg or uptime (default: p90)\n"); // flawfinder: ignore
+    printf("      --min-uptime PCT   Drop servers below PCT uptime\n"); // flawfinder: ignore
+    printf("      --format FMT       table, csv or json (default: table)\n"); // flawfinder: ignore
+    printf("      --output FILE      Write results to FILE instead of stdout\n"); // flawfinder: ignore
     printf("\nExamples:\n"); // flawfinder: ignore
     printf("  %s                           # Interactive mode\n", program_name); // flawfinder: ignore
     printf("  %s --all --threads 32        # Check all with 32 threads\n", program_name); // flawfinder: ignore
     printf("  %s --ftp --quiet             # Check FTP, show only OK\n", program_name); // flawfinder: ignore
+    printf("  %s --watch --max-interval 300 # Monitor continuously\n", program_name); // flawfinder: ignore
+    printf("  %s query --history hist --ftp --min-uptime 99  # Fastest stable FTP mirrors\n", // flawfinder: ignore
+           program_name);
     printf("\n"); // flawfinder: ignore
 }
 
@@ -69,6 +206,20 @@ static void print_version(void) {
     printf("\n"); // flawfinder: ignore
 }
 
+/**
+ * @brief Parse a positive number (interval in seconds or rate)
+ */
+static int parse_positive(const char *arg, double *out) {
+    char *endptr;
+    double val = strtod(arg, &endptr);
+    if (*endptr != '\0' || !(val > 0.0)) {
+        fprintf(stderr, "Error: '%s' must be a positive number\n", arg); /* flawfinder: ignore */
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+    *out = val;
+    return BDIX_SUCCESS;
+}
+
 /**
  * @brief Parse command line arguments
  */
@@ -77,6 +228,8 @@ static int parse_arguments(int argc, char *argv[], ProgramOptions *opts) {
     // Config file will be determined later if not specified
     memset(opts->config_file, 0, sizeof(opts->config_file));
     opts->thread_count = DEFAULT_THREADS;
+    opts->autotune_threads = false;
+    opts->max_threads = DEFAULT_AUTOTUNE_MAX_THREADS;
     opts->check_ftp = false;
     opts->check_tv = false;
     opts->check_others = false;
@@ -85,6 +238,33 @@ static int parse_arguments(int argc, char *argv[], ProgramOptions *opts) {
     opts->no_color = false;
     opts->interactive = true;
     opts->show_stats = false;
+    opts->show_timing = false;
+    memset(opts->trace_file, 0, sizeof(opts->trace_file));
+    memset(opts->metrics_socket, 0, sizeof(opts->metrics_socket));
+    opts->icmp = false;
+    opts->icmp_config = icmp_get_default_config();
+    opts->tcp_only = false;
+    opts->io_uring = false;
+    opts->adaptive_timeout = false;
+    opts->adaptive_policy = checker_get_default_adaptive_timeout();
+    opts->fastest = 0;
+    opts->fastest_grace_ms = TOP_K_GRACE_MS;
+    opts->retry = retry_get_default_config();
+    opts->deadline_s = 0.0;
+    opts->prioritize = false;
+    opts->dead_timeout_ms = 0;
+    opts->watch = false;
+    opts->min_interval_s = SCHED_DEFAULT_MIN_INTERVAL;
+    opts->max_interval_s = SCHED_DEFAULT_MAX_INTERVAL;
+    opts->rate_limit = rate_limiter_get_default_config();
+    opts->rate_limit_enabled = true;
+    opts->alert = alert_get_default_config();
+    memset(opts->history_dir, 0, sizeof(opts->history_dir));
+    opts->rollup = rollup_get_default_config();
+    opts->query = false;
+    opts->query_since_ms = QUERY_DEFAULT_RANGE_MS;
+    opts->query_options = query_get_default_options(0);
+    memset(opts->query_output, 0, sizeof(opts->query_output));
 
     static struct option long_options[] = {
         {"config",      required_argument, 0, 'c'},
@@ -97,6 +277,44 @@ static int parse_arguments(int argc, char *argv[], ProgramOptions *opts) {
         {"no-color",    no_argument,       0, 'n'},
         {"interactive", no_argument,       0, 'i'},
         {"stats",       no_argument,       0, 's'},
+        {"watch",       no_argument,       0, 'w'},
+        {"min-interval", required_argument, 0, OPT_MIN_INTERVAL},
+        {"max-interval", required_argument, 0, OPT_MAX_INTERVAL},
+        {"host-rate",   required_argument, 0, OPT_HOST_RATE},
+        {"host-burst",  required_argument, 0, OPT_HOST_BURST},
+        {"host-concurrency", required_argument, 0, OPT_HOST_CONCURRENCY},
+        {"per-ip",      no_argument,       0, OPT_PER_IP},
+        {"no-rate-limit", no_argument,     0, OPT_NO_RATE_LIMIT},
+        {"alert-webhook", required_argument, 0, OPT_ALERT_WEBHOOK},
+        {"alert-command", required_argument, 0, OPT_ALERT_COMMAND},
+        {"alert-confirm", required_argument, 0, OPT_ALERT_CONFIRM},
+        {"history",     required_argument, 0, OPT_HISTORY},
+        {"history-retention", required_argument, 0, OPT_HISTORY_RETENTION},
+        {"since",       required_argument, 0, OPT_SINCE},
+        {"top",         required_argument, 0, OPT_TOP},
+        {"sort",        required_argument, 0, OPT_SORT},
+        {"min-uptime",  required_argument, 0, OPT_MIN_UPTIME},
+        {"format",      required_argument, 0, OPT_FORMAT},
+        {"output",      required_argument, 0, OPT_OUTPUT},
+        {"timing",      no_argument,       0, OPT_TIMING},
+        {"trace",       required_argument, 0, OPT_TRACE},
+        {"log-level",   required_argument, 0, OPT_LOG_LEVEL},
+        {"metrics-socket", required_argument, 0, OPT_METRICS_SOCKET},
+        {"icmp",        no_argument,       0, OPT_ICMP},
+        {"icmp-samples", required_argument, 0, OPT_ICMP_SAMPLES},
+        {"tcp-only",    no_argument,       0, OPT_TCP_ONLY},
+        {"io-uring",    no_argument,       0, OPT_IO_URING},
+        {"adaptive-timeout", no_argument,  0, OPT_ADAPTIVE_TIMEOUT},
+        {"fastest",     required_argument, 0, OPT_FASTEST},
+        {"fastest-grace", required_argument, 0, OPT_FASTEST_GRACE},
+        {"retries",     required_argument, 0, OPT_RETRIES},
+        {"retry-backoff", required_argument, 0, OPT_RETRY_BACKOFF},
+        {"hedge",       required_argument, 0, OPT_HEDGE},
+        {"retry-budget", required_argument, 0, OPT_RETRY_BUDGET},
+        {"deadline",    required_argument, 0, OPT_DEADLINE},
+        {"prioritize",  no_argument,       0, OPT_PRIORITIZE},
+        {"dead-timeout", required_argument, 0, OPT_DEAD_TIMEOUT},
+        {"max-threads", required_argument, 0, OPT_MAX_THREADS},
         {"help",        no_argument,       0, 'h'},
         {"version",     no_argument,       0, 'V'},
         {0, 0, 0, 0}
@@ -105,14 +323,27 @@ static int parse_arguments(int argc, char *argv[], ProgramOptions *opts) {
     int opt;
     int option_index = 0;
 
-    while ((opt = getopt_long(argc, argv, "c:t:fvoaqnishV", /* flawfinder: ignore */
+    // Subcommand: bdix query [OPTIONS]
+    if (argc > 1 && strcmp(argv[1], "query") == 0) {
+        opts->query = true;
+        opts->interactive = false;
+        optind = 2;
+    }
+
+    while ((opt = getopt_long(argc, argv, "c:t:fvoaqniswhV", /* flawfinder: ignore */
                               long_options, &option_index)) != -1) {
         switch (opt) {
             case 'c':
                 safe_strncpy(opts->config_file, optarg, sizeof(opts->config_file));
                 break;
             case 't':
+                if (strcmp(optarg, "auto") == 0) {
+                    opts->autotune_threads = true;
+                    opts->thread_count = DEFAULT_THREADS;
+                    break;
+                }
                 {
+                    opts->autotune_threads = false;
                     char *endptr;
                     long val = strtol(optarg, &endptr, 10);
                     if (*endptr != '\0' || val < MIN_THREADS || val > MAX_THREADS) {
@@ -152,6 +383,260 @@ static int parse_arguments(int argc, char *argv[], ProgramOptions *opts) {
                 opts->show_stats = true;
                 opts->interactive = false;
                 break;
+            case 'w':
+                opts->watch = true;
+                opts->interactive = false;
+                break;
+            case OPT_MIN_INTERVAL:
+                if (parse_positive(optarg, &opts->min_interval_s) != BDIX_SUCCESS) {
+                    return BDIX_ERROR_INVALID_INPUT;
+                }
+                break;
+            case OPT_MAX_INTERVAL:
+                if (parse_positive(optarg, &opts->max_interval_s) != BDIX_SUCCESS) {
+                    return BDIX_ERROR_INVALID_INPUT;
+                }
+                break;
+            case OPT_HOST_RATE:
+                if (parse_positive(optarg, &opts->rate_limit.rate_per_sec) != BDIX_SUCCESS) {
+                    return BDIX_ERROR_INVALID_INPUT;
+                }
+                break;
+            case OPT_HOST_BURST:
+                if (parse_positive(optarg, &opts->rate_limit.burst) != BDIX_SUCCESS ||
+                    opts->rate_limit.burst < 1.0) {
+                    fprintf(stderr, "Error: Host burst must be at least 1\n"); /* flawfinder: ignore */
+                    return BDIX_ERROR_INVALID_INPUT;
+                }
+                break;
+            case OPT_HOST_CONCURRENCY:
+                {
+                    char *endptr;
+                    long val = strtol(optarg, &endptr, 10);
+                    if (*endptr != '\0' || val < 0 || val > MAX_THREADS) {
+                        fprintf(stderr, "Error: Host concurrency must be between 0 and %d\n", /* flawfinder: ignore */
+                                MAX_THREADS);
+                        return BDIX_ERROR_INVALID_INPUT;
+                    }
+                    opts->rate_limit.max_concurrent = (int)val;
+                }
+                break;
+            case OPT_PER_IP:
+                opts->rate_limit.per_ip = true;
+                break;
+            case OPT_NO_RATE_LIMIT:
+                opts->rate_limit_enabled = false;
+                break;
+            case OPT_ALERT_WEBHOOK:
+                opts->alert.sink = ALERT_SINK_WEBHOOK;
+                safe_strncpy(opts->alert.target, optarg, sizeof(opts->alert.target));
+                break;
+            case OPT_ALERT_COMMAND:
+                opts->alert.sink = ALERT_SINK_COMMAND;
+                safe_strncpy(opts->alert.target, optarg, sizeof(opts->alert.target));
+                break;
+            case OPT_ALERT_CONFIRM:
+                {
+                    unsigned n = 0, m = 0;
+                    char extra;
+                    if (sscanf(optarg, "%u/%u%c", &n, &m, &extra) != 2 || // flawfinder: ignore
+                        n == 0 || n > m || m > ALERT_MAX_WINDOW) {
+                        fprintf(stderr, "Error: --alert-confirm expects N/M with 1 <= N <= M <= %d\n", /* flawfinder: ignore */
+                                ALERT_MAX_WINDOW);
+                        return BDIX_ERROR_INVALID_INPUT;
+                    }
+                    opts->alert.confirm_n = n;
+                    opts->alert.window_m = m;
+                }
+                break;
+            case OPT_HISTORY:
+                safe_strncpy(opts->history_dir, optarg, sizeof(opts->history_dir));
+                break;
+            case OPT_HISTORY_RETENTION:
+                if (rollup_parse_retention(optarg, &opts->rollup) != BDIX_SUCCESS) {
+                    fprintf(stderr, "Error: invalid --history-retention '%s' (e.g. raw=2d,1m=14d,1h=180d,1d=5y)\n", /* flawfinder: ignore */
+                            optarg);
+                    return BDIX_ERROR_INVALID_INPUT;
+                }
+                break;
+            case OPT_SINCE:
+                if (rollup_parse_duration(optarg, &opts->query_since_ms) != BDIX_SUCCESS) {
+                    fprintf(stderr, "Error: invalid --since '%s' (e.g. 24h, 7d, 4w)\n", optarg); /* flawfinder: ignore */
+                    return BDIX_ERROR_INVALID_INPUT;
+                }
+                break;
+            case OPT_TOP:
+                {
+                    char *endptr;
+                    long val = strtol(optarg, &endptr, 10);
+                    if (*endptr != '\0' || val < 0) {
+                        fprintf(stderr, "Error: --top must be a non-negative integer\n"); /* flawfinder: ignore */
+                        return BDIX_ERROR_INVALID_INPUT;
+                    }
+                    opts->query_options.top_n = (size_t)val;
+                }
+                break;
+            case OPT_SORT:
+                if (query_parse_sort(optarg, &opts->query_options.sort) != BDIX_SUCCESS) {
+                    fprintf(stderr, "Error: --sort must be p50, p90, p99, avg or uptime\n"); /* flawfinder: ignore */
+                    return BDIX_ERROR_INVALID_INPUT;
+                }
+                break;
+            case OPT_MIN_UPTIME:
+                {
+                    char *endptr;
+                    double val = strtod(optarg, &endptr);
+                    if (*endptr != '\0' || val < 0.0 || val > 100.0) {
+                        fprintf(stderr, "Error: --min-uptime must be between 0 and 100\n"); /* flawfinder: ignore */
+                        return BDIX_ERROR_INVALID_INPUT;
+                    }
+                    opts->query_options.min_uptime_pct = val;
+                }
+                break;
+            case OPT_FORMAT:
+                if (query_parse_format(optarg, &opts->query_options.format) != BDIX_SUCCESS) {
+                    fprintf(stderr, "Error: --format must be table, csv or json\n"); /* flawfinder: ignore */
+                    return BDIX_ERROR_INVALID_INPUT;
+                }
+                break;
+            case OPT_OUTPUT:
+                safe_strncpy(opts->query_output, optarg, sizeof(opts->query_output));
+                break;
+            case OPT_TIMING:
+                opts->show_timing = true;
+                break;
+            case OPT_TRACE:
+                safe_strncpy(opts->trace_file, optarg, sizeof(opts->trace_file));
+                break;
+            case OPT_METRICS_SOCKET:
+                safe_strncpy(opts->metrics_socket, optarg, sizeof(opts->metrics_socket));
+                break;
+            case OPT_ICMP:
+                opts->icmp = true;
+                break;
+            case OPT_ICMP_SAMPLES:
+                {
+                    char *endptr;
+                    long val = strtol(optarg, &endptr, 10);
+                    if (*endptr != '\0' || val < 1 || val > ICMP_MAX_SAMPLES) {
+                        fprintf(stderr, "Error: --icmp-samples must be between 1 and %d\n", /* flawfinder: ignore */
+                                ICMP_MAX_SAMPLES);
+                        return BDIX_ERROR_INVALID_INPUT;
+                    }
+                    opts->icmp_config.samples = (int)val;
+                    opts->icmp = true;
+                }
+                break;
+            case OPT_TCP_ONLY:
+                opts->tcp_only = true;
+                break;
+            case OPT_IO_URING:
+                opts->io_uring = true;
+                break;
+            case OPT_ADAPTIVE_TIMEOUT:
+                opts->adaptive_timeout = true;
+                break;
+            case OPT_FASTEST:
+                {
+                    char *endptr;
+                    long val = strtol(optarg, &endptr, 10);
+                    if (*endptr != '\0' || val < 1) {
+                        fprintf(stderr, "Error: --fastest must be a positive integer\n"); /* flawfinder: ignore */
+                        return BDIX_ERROR_INVALID_INPUT;
+                    }
+                    opts->fastest = (size_t)val;
+                }
+                break;
+            case OPT_FASTEST_GRACE:
+                {
+                    char *endptr;
+                    long val = strtol(optarg, &endptr, 10);
+                    if (*endptr != '\0' || val < 0 || val > INT_MAX) {
+                        fprintf(stderr, "Error: --fastest-grace must be a non-negative number of milliseconds\n"); /* flawfinder: ignore */
+                        return BDIX_ERROR_INVALID_INPUT;
+                    }
+                    opts->fastest_grace_ms = (int)val;
+                }
+                break;
+            case OPT_RETRIES:
+                {
+                    char *endptr;
+                    long val = strtol(optarg, &endptr, 10);
+                    if (*endptr != '\0' || val < 0 || val > RETRY_MAX_RETRIES) {
+                        fprintf(stderr, "Error: --retries must be between 0 and %d\n", /* flawfinder: ignore */
+                                RETRY_MAX_RETRIES);
+                        return BDIX_ERROR_INVALID_INPUT;
+                    }
+                    opts->retry.max_retries = (int)val;
+                }
+                break;
+            case OPT_RETRY_BACKOFF:
+                if (parse_positive(optarg, &opts->retry.backoff_ms) != BDIX_SUCCESS) {
+                    return BDIX_ERROR_INVALID_INPUT;
+                }
+                break;
+            case OPT_HEDGE:
+                {
+                    char *endptr;
+                    double val = strtod(optarg, &endptr);
+                    if (*endptr != '\0' || !(val > 0.0 && val < 100.0)) {
+                        fprintf(stderr, "Error: --hedge must be a percentile between 0 and 100\n"); /* flawfinder: ignore */
+                        return BDIX_ERROR_INVALID_INPUT;
+                    }
+                    opts->retry.hedge_quantile = val / 100.0;
+                }
+                break;
+            case OPT_RETRY_BUDGET:
+                {
+                    char *endptr;
+                    double val = strtod(optarg, &endptr);
+                    if (*endptr != '\0' || !(val >= 0.0 && val <= 100.0)) {
+                        fprintf(stderr, "Error: --retry-budget must be a percentage between 0 and 100\n"); /* flawfinder: ignore */
+                        return BDIX_ERROR_INVALID_INPUT;
+                    }
+                    opts->retry.budget_pct = val;
+                }
+                break;
+            case OPT_DEADLINE:
+                if (parse_positive(optarg, &opts->deadline_s) != BDIX_SUCCESS) {
+                    return BDIX_ERROR_INVALID_INPUT;
+                }
+                break;
+            case OPT_PRIORITIZE:
+                opts->prioritize = true;
+                break;
+            case OPT_MAX_THREADS:
+                {
+                    char *endptr;
+                    long val = strtol(optarg, &endptr, 10);
+                    if (*endptr != '\0' || val < MIN_THREADS || val > MAX_AUTOTUNE_THREADS) {
+                        fprintf(stderr, "Error: --max-threads must be between %d and %d\n", /* flawfinder: ignore */
+                                MIN_THREADS, MAX_AUTOTUNE_THREADS);
+                        return BDIX_ERROR_INVALID_INPUT;
+                    }
+                    opts->max_threads = (int)val;
+                }
+                break;
+            case OPT_DEAD_TIMEOUT:
+                {
+                    char *endptr;
+                    long val = strtol(optarg, &endptr, 10);
+                    if (*endptr != '\0' || val < 1 || val > 600000) {
+                        fprintf(stderr, "Error: --dead-timeout must be between 1 and 600000 ms\n"); /* flawfinder: ignore */
+                        return BDIX_ERROR_INVALID_INPUT;
+                    }
+                    opts->dead_timeout_ms = (int)val;
+                }
+                break;
+            case OPT_LOG_LEVEL: {
+                LogLevel level;
+                if (!log_parse_level(optarg, &level)) {
+                    fprintf(stderr, "Error: --log-level must be debug, info, warn, error or off\n"); /* flawfinder: ignore */
+                    return BDIX_ERROR_INVALID_INPUT;
+                }
+                log_set_level(level);
+                break;
+            }
             case 'h':
                 print_usage(argv[0]);
                 exit(EXIT_SUCCESS);
@@ -164,15 +649,43 @@ static int parse_arguments(int argc, char *argv[], ProgramOptions *opts) {
         }
     }
 
+    if (opts->query) {
+        if (opts->history_dir[0] == '\0') {
+            fprintf(stderr, "Error: query requires --history DIR\n"); /* flawfinder: ignore */
+            return BDIX_ERROR_INVALID_INPUT;
+        }
+        if (!opts->check_ftp && !opts->check_tv && !opts->check_others) {
+            opts->check_all = true;
+        }
+        return BDIX_SUCCESS;
+    }
+
     // If no specific check selected, default to all
     if (!opts->check_ftp && !opts->check_tv && !opts->check_others &&
         !opts->show_stats && !opts->interactive) {
         opts->check_all = true;
     }
 
+    if (opts->min_interval_s > opts->max_interval_s) {
+        fprintf(stderr, "Error: --min-interval must not exceed --max-interval\n"); /* flawfinder: ignore */
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
     return BDIX_SUCCESS;
 }
 
+// Cancels the running sweep on SIGINT/SIGTERM or at --deadline
+static CancelToken g_sweep_cancel;
+
+/**
+ * @brief Signal handler that stops the running sweep and continuous monitoring
+ */
+static void handle_stop_signal(int signum) {
+    UNUSED(signum);
+    cancel_token_request(&g_sweep_cancel);
+    scheduler_stop();
+}
+
 /**
  * @brief Interactive menu mode
  */
@@ -283,6 +796,145 @@ static void interactive_mode(ServerData *data, CheckerConfig *config) {
     }
 }
 
+/**
+ * @brief Fit the autotuning ceiling to the open file limit, raising it if allowed
+ *
+ * Each check may hold two sockets (hedging), plus a reserve for the rest.
+ */
+static int fit_thread_ceiling(int max_threads) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return max_threads;
+    }
+    rlim_t needed = (rlim_t)max_threads * 2 + 64;
+    if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < needed) {
+        limit.rlim_cur = limit.rlim_max == RLIM_INFINITY ? needed : MIN(needed, limit.rlim_max);
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+    }
+    if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < needed) {
+        int fitted = limit.rlim_cur > 64 + 2 * MIN_THREADS ? (int)((limit.rlim_cur - 64) / 2) : MIN_THREADS;
+        ui_print_warning("Open file limit %lu allows at most %d threads\n",
+                         (unsigned long)limit.rlim_cur, fitted);
+        return fitted;
+    }
+    return max_threads;
+}
+
+/**
+ * @brief Restore every server's recent results from the history store
+ */
+static size_t restore_history(HistoryStore *history, ServerData *data) {
+    size_t restored = 0;
+    for (int type = 0; type < CATEGORY_COUNT; type++) {
+        ServerCategory *category = server_data_get_category(data, (ServerCategoryType)type);
+        for (size_t i = 0; category && i < category->count; i++) {
+            restored += history_restore(history, &category->servers[i]);
+        }
+    }
+    return restored;
+}
+
+/**
+ * @brief Run the "query" subcommand over the history store
+ *
+ * Progress messages go to stderr so CSV and JSON on stdout stay clean.
+ */
+static int run_query(ProgramOptions *opts) {
+    ServerData data = {0};
+    HistoryStore *history = NULL;
+    RollupStore *rollups = NULL;
+    QueryResultSet results = {0};
+    FILE *out = stdout;
+    int ret = EXIT_FAILURE;
+
+    // Diagnostics go to stderr so stdout carries only the results
+    log_set_streams(stderr, NULL);
+
+    if (server_data_init(&data) != BDIX_SUCCESS) {
+        ui_print_error("Failed to initialize server data\n");
+        goto cleanup;
+    }
+
+    if (opts->config_file[0] == '\0') {
+        bool parent = !config_validate_file("data/server.json") &&
+                      config_validate_file("../data/server.json");
+        safe_strncpy(opts->config_file, parent ? "../data/server.json" : "data/server.json",
+                     sizeof(opts->config_file));
+    }
+    if (config_load_from_file(opts->config_file, &data) != BDIX_SUCCESS) {
+        ui_print_error("Failed to load configuration from %s\n", opts->config_file);
+        goto cleanup;
+    }
+
+    HistoryConfig history_config = history_get_default_config();
+    history_config.read_only = true;
+    history = history_open(opts->history_dir, &history_config);
+    if (!history) {
+        ui_print_error("Failed to open history store %s\n", opts->history_dir);
+        goto cleanup;
+    }
+
+    RollupConfig rollup_config = opts->rollup;
+    rollup_config.read_only = true;
+    rollups = rollup_open(opts->history_dir, history, &rollup_config);
+    if (!rollups) {
+        ui_print_error("Failed to open history rollups in %s\n", opts->history_dir);
+        goto cleanup;
+    }
+
+    ServerCategory *categories[3];
+    size_t category_count = 0;
+    if (opts->check_ftp || opts->check_all) {
+        categories[category_count++] = &data.ftp;
+    }
+    if (opts->check_tv || opts->check_all) {
+        categories[category_count++] = &data.tv;
+    }
+    if (opts->check_others || opts->check_all) {
+        categories[category_count++] = &data.others;
+    }
+
+    QueryOptions *query = &opts->query_options;
+    query->to_ms = history_now_ms();
+    query->from_ms = query->to_ms - opts->query_since_ms;
+
+    if (query_run(rollups, categories, category_count, query, opts->thread_count,
+                  &results) != BDIX_SUCCESS) {
+        ui_print_error("History query failed\n");
+        goto cleanup;
+    }
+
+    if (opts->query_output[0] != '\0') {
+        out = fopen(opts->query_output, "w"); /* flawfinder: ignore - user-selected output path */
+        if (!out) {
+            ui_print_error("Cannot open %s: %s\n", opts->query_output, strerror(errno));
+            goto cleanup;
+        }
+    }
+
+    if (query_write_results(&results, query, out) == BDIX_SUCCESS) {
+        ret = EXIT_SUCCESS;
+    } else {
+        ui_print_error("Failed to write query results\n");
+    }
+
+    if (out != stdout) {
+        fclose(out);
+        if (ret == EXIT_SUCCESS) {
+            fprintf(stderr, "Wrote %zu results to %s\n", results.count, opts->query_output); /* flawfinder: ignore */
+        }
+    }
+
+cleanup:
+    query_results_free(&results);
+    rollup_close(rollups);
+    history_close(history);
+    server_data_free(&data);
+    log_set_streams(NULL, NULL);
+    return ret;
+}
+
 /**
  * @brief Main entry point
  */
@@ -291,13 +943,31 @@ int main(int argc, char *argv[]) {
     CheckerConfig config;
     CheckerStats stats;
     ProgramOptions opts;
+    RateLimiter *rate_limiter = NULL;
+    RetryBudget *retry_budget = NULL;
+    AlertManager *alerts = NULL;
+    HistoryStore *history = NULL;
+    RollupStore *rollups = NULL;
+    MetricsServer *metrics_server = NULL;
     int ret = EXIT_SUCCESS;
 
+    // Environment sets the default log level, --log-level overrides it
+    const char *env_level = getenv("BDIX_LOG_LEVEL"); /* flawfinder: ignore - only compared against level names */
+    LogLevel level;
+    if (env_level && log_parse_level(env_level, &level)) {
+        log_set_level(level);
+    }
+
     // Parse arguments
     if (parse_arguments(argc, argv, &opts) != BDIX_SUCCESS) {
         return EXIT_FAILURE;
     }
 
+    // Workers hand log messages to a background flusher from here on
+    if (log_start() != BDIX_SUCCESS) {
+        fprintf(stderr, "Warning: asynchronous logging unavailable\n"); /* flawfinder: ignore */
+    }
+
     // Setup colors
     if (opts.no_color) {
         colors_disable();
@@ -310,11 +980,16 @@ int main(int argc, char *argv[]) {
         .show_only_ok = opts.only_ok,
         .show_progress = true,
         .show_latency = true,
+        .show_timing = opts.show_timing,
         .use_colors = !opts.no_color,
         .verbose = !opts.only_ok
     };
     ui_init(&ui_config);
 
+    if (opts.query) {
+        return run_query(&opts);
+    }
+
     // Initialize checker
     if (checker_init() != BDIX_SUCCESS) {
         ui_print_error("Failed to initialize checker\n");
@@ -322,6 +997,18 @@ int main(int argc, char *argv[]) {
     }
 
     // Resources initialized, ensure cleanup via goto
+    cancel_token_init(&g_sweep_cancel);
+
+    if (opts.trace_file[0] != '\0' && trace_start(opts.trace_file) != BDIX_SUCCESS) {
+        ui_print_warning("Tracing disabled\n");
+    }
+
+    if (opts.metrics_socket[0] != '\0') {
+        metrics_server = metrics_server_start(opts.metrics_socket);
+        if (!metrics_server) {
+            ui_print_warning("Metrics socket disabled\n");
+        }
+    }
 
     // Print header
     if (!opts.show_stats) {
@@ -381,6 +1068,103 @@ int main(int argc, char *argv[]) {
     // Get default checker config
     config = checker_get_default_config();
     config.verbose = !opts.only_ok;
+    if (opts.tcp_only) {
+        config.engine = CHECK_ENGINE_TCP;
+    }
+    if (opts.adaptive_timeout) {
+        config.adaptive_timeout = &opts.adaptive_policy;
+    }
+    if (opts.deadline_s > 0.0 && opts.watch) {
+        ui_print_warning("--deadline is ignored in watch mode, press Ctrl-C to stop\n");
+    }
+    config.prioritize = opts.prioritize;
+    config.dead_timeout_ms = opts.dead_timeout_ms;
+    if (opts.autotune_threads) {
+        config.autotune_threads = true;
+        config.max_threads = fit_thread_ceiling(opts.max_threads);
+        opts.thread_count = MIN(opts.thread_count, config.max_threads);
+        if (opts.tcp_only) {
+            ui_print_warning("--threads auto tunes HTTP checks only, name lookups use %d threads\n",
+                             opts.thread_count);
+        }
+    }
+    if (opts.alert.sink != ALERT_SINK_NONE && !opts.watch) {
+        ui_print_warning("--alert-webhook and --alert-command need --watch, no alerts are sent\n");
+    }
+    if (opts.fastest > 0 && opts.watch) {
+        ui_print_warning("--fastest is ignored in watch mode, every server is checked each cycle\n");
+    } else {
+        config.top_k = opts.fastest;
+        config.top_k_grace_ms = opts.fastest_grace_ms;
+    }
+    if (opts.io_uring) {
+        if (uring_available()) {
+            config.io_uring = true;
+        } else {
+            ui_print_warning("io_uring unavailable (kernel support or io_uring_disabled), "
+                             "using %s\n", opts.tcp_only ? "epoll" : "curl");
+        }
+    }
+
+    if (opts.icmp) {
+        if (icmp_available()) {
+            config.icmp = &opts.icmp_config;
+        } else {
+            ui_print_warning("ICMP probes disabled: ping sockets are not permitted for group %u "
+                             "(see net.ipv4.ping_group_range)\n", (unsigned)getgid());
+        }
+    }
+
+    if (opts.rate_limit_enabled) {
+        rate_limiter = rate_limiter_create(&opts.rate_limit);
+        if (!rate_limiter) {
+            ui_print_error("Failed to create rate limiter\n");
+            ret = EXIT_FAILURE;
+            goto cleanup;
+        }
+        config.rate_limiter = rate_limiter;
+    }
+
+    if (opts.retry.max_retries > 0 || opts.retry.hedge_quantile > 0.0) {
+        if (opts.tcp_only) {
+            ui_print_warning("--retries and --hedge apply to HTTP checks only\n");
+        }
+        retry_budget = retry_budget_create(&opts.retry);
+        if (!retry_budget) {
+            ui_print_error("Failed to create retry budget\n");
+            ret = EXIT_FAILURE;
+            goto cleanup;
+        }
+        config.retry = retry_budget;
+    }
+
+    if (opts.history_dir[0] != '\0') {
+        HistoryConfig history_config = history_get_default_config();
+        history = history_open(opts.history_dir, &history_config);
+        if (!history) {
+            ui_print_error("Failed to open history store %s\n", opts.history_dir);
+            ret = EXIT_FAILURE;
+            goto cleanup;
+        }
+        config.history = history;
+
+        rollups = rollup_open(opts.history_dir, history, &opts.rollup);
+        if (!rollups) {
+            ui_print_error("Failed to open history rollups in %s\n", opts.history_dir);
+            ret = EXIT_FAILURE;
+            goto cleanup;
+        }
+
+        // Ranking, dead-server timeouts and hedge delays start from earlier runs' results
+        if (opts.prioritize || opts.dead_timeout_ms > 0 || opts.retry.hedge_quantile > 0.0) {
+            size_t restored = restore_history(history, &data);
+            ui_print_info("Restored %zu earlier results from %s\n", restored, opts.history_dir);
+        }
+    } else if ((opts.prioritize || opts.dead_timeout_ms > 0 || opts.retry.hedge_quantile > 0.0) &&
+               !opts.watch) {
+        ui_print_warning("--prioritize, --dead-timeout and --hedge need --history DIR to know "
+                         "earlier results\n");
+    }
 
     // Initialize statistics
     checker_stats_init(&stats);
@@ -403,21 +1187,89 @@ int main(int argc, char *argv[]) {
     bool check_tv = opts.check_tv || opts.check_all;
     bool check_others = opts.check_others || opts.check_all;
 
-    if (checker_check_multiple(&data, &config, opts.thread_count,
-                               check_ftp, check_tv, check_others,
-                               &stats) != BDIX_SUCCESS) {
-        ui_print_error("Server checking failed\n");
-        ret = EXIT_FAILURE;
+    // Ctrl-C stops the sweep but keeps its results; a second one exits at once
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_stop_signal;
+    sa.sa_flags = SA_RESETHAND;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    config.cancel = &g_sweep_cancel;
+
+    double sweep_start = get_time_ms();
+    if (opts.watch) {
+        SchedulerConfig sched_config = scheduler_get_default_config();
+        sched_config.min_interval_s = opts.min_interval_s;
+        sched_config.max_interval_s = opts.max_interval_s;
+
+        alerts = alert_manager_create(&opts.alert);
+        if (!alerts) {
+            ui_print_error("Failed to start alerting\n");
+            ret = EXIT_FAILURE;
+            goto cleanup;
+        }
+        config.alerts = alerts;
+
+        if (rollups && rollup_start(rollups) != BDIX_SUCCESS) {
+            ui_print_warning("History compaction disabled\n");
+        }
+
+        ui_print_info("Monitoring continuously, press Ctrl-C to stop\n");
+        if (scheduler_run(&data, &config, &sched_config, opts.thread_count,
+                          check_ftp, check_tv, check_others,
+                          &stats) != BDIX_SUCCESS) {
+            ui_print_error("Continuous monitoring failed\n");
+            ret = EXIT_FAILURE;
+        }
+    } else {
+        if (opts.deadline_s > 0.0) {
+            cancel_token_set_deadline(&g_sweep_cancel, sweep_start + opts.deadline_s * 1000.0);
+        }
+        if (checker_check_multiple(&data, &config, opts.thread_count,
+                                   check_ftp, check_tv, check_others,
+                                   &stats) != BDIX_SUCCESS) {
+            ui_print_error("Server checking failed\n");
+            ret = EXIT_FAILURE;
+        } else if (cancel_token_check(&g_sweep_cancel)) {
+            ui_print_warning("Sweep %s after %.1f s, showing partial results\n",
+                             atomic_load(&g_sweep_cancel.requested) ? "interrupted" : "hit its deadline",
+                             (get_time_ms() - sweep_start) / 1000.0);
+        }
+    }
+
+    // Flush pending alerts before reporting
+    alert_manager_flush(alerts);
+
+    // Fold closed periods into rollups (also covers one-shot runs)
+    if (rollups) {
+        rollup_stop(rollups);
+        rollup_compact(rollups, history_now_ms());
     }
 
     // Print final statistics
     printf("\n"); /* flawfinder: ignore */
+    if (opts.watch) {
+        ui_print_server_stats(&data);
+    }
     checker_stats_print(&stats);
+    alert_manager_print_stats(alerts);
+    history_print_stats(history);
+    rollup_print_stats(rollups);
 
 cleanup:
+    alert_manager_destroy(alerts);
+    rollup_close(rollups);
+    history_close(history);
+    rate_limiter_destroy(rate_limiter);
+    retry_budget_destroy(retry_budget);
+    metrics_server_stop(metrics_server);
+    trace_stop();  // Every pool and background thread has been joined
     checker_cleanup();
+    cancel_token_destroy(&g_sweep_cancel);
     ui_cleanup();
     server_data_free(&data);
+    log_stop();
 
     return ret;
 }
@@ -0,0 +1,459 @@
+/**
+ * @file metrics.c
+ * @brief Process-wide metrics registry served over a Unix domain socket
+ * @version 1.0.0
+ */
+
+#include "metrics.h"
+#include <jansson.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/**
+ * @brief Registered metric
+ */
+struct Metric {
+    char name[METRICS_NAME_MAX]; /* flawfinder: ignore - bounds checked with safe_strncpy */
+    const char *help;
+    MetricType type;
+    _Atomic uint64_t count;         // Counter value / histogram observations
+    _Atomic double value;           // Gauge value / histogram sum
+    _Atomic uint64_t buckets[METRICS_BUCKETS];
+};
+
+/**
+ * @brief Unix socket server
+ */
+struct MetricsServer {
+    int listen_fd;
+    int wake_pipe[2];               // Written by metrics_server_stop()
+    pthread_t thread;
+    char path[MAX_PATH_LENGTH]; /* flawfinder: ignore - bounds checked with safe_strncpy */
+};
+
+// Histogram upper bounds in milliseconds; the last bucket is +Inf
+static const double g_bucket_bounds[METRICS_BUCKETS - 1] = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 30000, 60000
+};
+
+static const char *const g_type_names[] = { "counter", "gauge", "histogram" };
+
+static Metric g_metrics[METRICS_MAX];
+static _Atomic size_t g_metric_count = 0;
+static pthread_mutex_t g_register_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Find or create a metric
+ *
+ * Slots are filled before the count is published, so readers can walk
+ * the registry without locking.
+ */
+static Metric* metrics_register(const char *name, const char *help, MetricType type) {
+    if (!name || name[0] == '\0') {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&g_register_mutex);
+
+    size_t count = atomic_load(&g_metric_count);
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(g_metrics[i].name, name) == 0) {
+            pthread_mutex_unlock(&g_register_mutex);
+            if (g_metrics[i].type != type) {
+                LOG_WARN("Metric %s already registered as a %s", name, g_type_names[g_metrics[i].type]);
+                return NULL;
+            }
+            return &g_metrics[i];
+        }
+    }
+
+    if (count >= METRICS_MAX) {
+        pthread_mutex_unlock(&g_register_mutex);
+        LOG_WARN("Metrics registry full, dropping %s", name);
+        return NULL;
+    }
+
+    Metric *metric = &g_metrics[count];
+    safe_strncpy(metric->name, name, sizeof(metric->name));
+    metric->help = help ? help : "";
+    metric->type = type;
+    atomic_store(&metric->count, 0);
+    atomic_store(&metric->value, 0.0);
+    for (size_t b = 0; b < METRICS_BUCKETS; b++) {
+        atomic_store(&metric->buckets[b], 0);
+    }
+    atomic_store_explicit(&g_metric_count, count + 1, memory_order_release);
+
+    pthread_mutex_unlock(&g_register_mutex);
+    return metric;
+}
+
+/**
+ * @brief Register a counter, or look up the one with this name
+ */
+Metric* metrics_counter(const char *name, const char *help) {
+    return metrics_register(name, help, METRIC_COUNTER);
+}
+
+/**
+ * @brief Register a gauge, or look up the one with this name
+ */
+Metric* metrics_gauge(const char *name, const char *help) {
+    return metrics_register(name, help, METRIC_GAUGE);
+}
+
+/**
+ * @brief Register a histogram, or look up the one with this name
+ */
+Metric* metrics_histogram(const char *name, const char *help) {
+    return metrics_register(name, help, METRIC_HISTOGRAM);
+}
+
+/**
+ * @brief Add to an atomic double
+ */
+static void add_double(_Atomic double *target, double delta) {
+    double current = atomic_load_explicit(target, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(target, &current, current + delta,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+        // Retry on contention
+    }
+}
+
+/**
+ * @brief Add to a counter
+ */
+void metrics_add(Metric *metric, uint64_t delta) {
+    if (metric) {
+        atomic_fetch_add_explicit(&metric->count, delta, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Set a gauge
+ */
+void metrics_gauge_set(Metric *metric, double value) {
+    if (metric) {
+        atomic_store_explicit(&metric->value, value, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Add to a gauge
+ */
+void metrics_gauge_add(Metric *metric, double delta) {
+    if (metric) {
+        add_double(&metric->value, delta);
+    }
+}
+
+/**
+ * @brief Record a histogram observation
+ */
+void metrics_observe(Metric *metric, double value_ms) {
+    if (!metric) {
+        return;
+    }
+
+    size_t bucket = 0;
+    while (bucket < METRICS_BUCKETS - 1 && value_ms > g_bucket_bounds[bucket]) {
+        bucket++;
+    }
+    atomic_fetch_add_explicit(&metric->buckets[bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&metric->count, 1, memory_order_relaxed);
+    add_double(&metric->value, value_ms);
+}
+
+/**
+ * @brief Read a metric's primary value
+ */
+double metrics_value(const Metric *metric) {
+    if (!metric) {
+        return 0.0;
+    }
+    if (metric->type == METRIC_GAUGE) {
+        return atomic_load(&metric->value);
+    }
+    return (double)atomic_load(&metric->count);
+}
+
+/**
+ * @brief Wall-clock time in milliseconds
+ */
+static uint64_t wall_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+/**
+ * @brief Serialize as JSON
+ */
+char* metrics_snapshot_json(void) {
+    json_t *root = json_object();
+    json_t *list = json_array();
+    json_object_set_new(root, "timestamp_ms", json_integer((json_int_t)wall_time_ms()));
+    json_object_set_new(root, "metrics", list);
+
+    size_t count = atomic_load_explicit(&g_metric_count, memory_order_acquire);
+    for (size_t i = 0; i < count; i++) {
+        const Metric *m = &g_metrics[i];
+        json_t *entry = json_object();
+        json_object_set_new(entry, "name", json_string(m->name));
+        json_object_set_new(entry, "type", json_string(g_type_names[m->type]));
+        json_object_set_new(entry, "help", json_string(m->help));
+
+        if (m->type == METRIC_COUNTER) {
+            json_object_set_new(entry, "value", json_integer((json_int_t)atomic_load(&m->count)));
+        } else if (m->type == METRIC_GAUGE) {
+            json_object_set_new(entry, "value", json_real(atomic_load(&m->value)));
+        } else {
+            json_t *buckets = json_array();
+            for (size_t b = 0; b < METRICS_BUCKETS; b++) {
+                json_t *bucket = json_object();
+                json_object_set_new(bucket, "le", b < METRICS_BUCKETS - 1 ?
+                                    json_real(g_bucket_bounds[b]) : json_string("+Inf"));
+                json_object_set_new(bucket, "count", json_integer((json_int_t)atomic_load(&m->buckets[b])));
+                json_array_append_new(buckets, bucket);
+            }
+            json_object_set_new(entry, "count", json_integer((json_int_t)atomic_load(&m->count)));
+            json_object_set_new(entry, "sum", json_real(atomic_load(&m->value)));
+            json_object_set_new(entry, "buckets", buckets);
+        }
+        json_array_append_new(list, entry);
+    }
+
+    char *text = json_dumps(root, JSON_COMPACT);
+    json_decref(root);
+    return text;
+}
+
+/**
+ * @brief Append raw bytes to a growing buffer
+ */
+static void put_bytes(uint8_t **buf, size_t *size, size_t *capacity, const void *data, size_t len) {
+    if (*size + len > *capacity) {
+        *capacity = MAX(*capacity * 2, *size + len);
+        *buf = safe_realloc(*buf, *capacity);
+    }
+    memcpy(*buf + *size, data, len);
+    *size += len;
+}
+
+/**
+ * @brief Serialize in the binary format
+ */
+uint8_t* metrics_snapshot_binary(size_t *size) {
+    if (!size) {
+        return NULL;
+    }
+
+    size_t capacity = 4096;
+    uint8_t *buf = safe_malloc(capacity);
+    *size = 0;
+
+    size_t count = atomic_load_explicit(&g_metric_count, memory_order_acquire);
+    uint32_t magic = METRICS_BINARY_MAGIC;
+    uint32_t version = METRICS_BINARY_VERSION;
+    uint64_t now = wall_time_ms();
+    uint32_t n = (uint32_t)count;
+    put_bytes(&buf, size, &capacity, &magic, sizeof(magic));
+    put_bytes(&buf, size, &capacity, &version, sizeof(version));
+    put_bytes(&buf, size, &capacity, &now, sizeof(now));
+    put_bytes(&buf, size, &capacity, &n, sizeof(n));
+
+    for (size_t i = 0; i < count; i++) {
+        const Metric *m = &g_metrics[i];
+        uint8_t type = (uint8_t)m->type;
+        uint16_t name_len = (uint16_t)strnlen(m->name, sizeof(m->name));
+        put_bytes(&buf, size, &capacity, &type, sizeof(type));
+        put_bytes(&buf, size, &capacity, &name_len, sizeof(name_len));
+        put_bytes(&buf, size, &capacity, m->name, name_len);
+
+        if (m->type != METRIC_HISTOGRAM) {
+            double value = metrics_value(m);
+            put_bytes(&buf, size, &capacity, &value, sizeof(value));
+            continue;
+        }
+
+        uint64_t observations = atomic_load(&m->count);
+        double sum = atomic_load(&m->value);
+        uint16_t buckets = METRICS_BUCKETS;
+        put_bytes(&buf, size, &capacity, &observations, sizeof(observations));
+        put_bytes(&buf, size, &capacity, &sum, sizeof(sum));
+        put_bytes(&buf, size, &capacity, &buckets, sizeof(buckets));
+        for (size_t b = 0; b < METRICS_BUCKETS; b++) {
+            double bound = b < METRICS_BUCKETS - 1 ? g_bucket_bounds[b] : INFINITY;
+            uint64_t bucket_count = atomic_load(&m->buckets[b]);
+            put_bytes(&buf, size, &capacity, &bound, sizeof(bound));
+            put_bytes(&buf, size, &capacity, &bucket_count, sizeof(bucket_count));
+        }
+    }
+
+    return buf;
+}
+
+/**
+ * @brief Write a whole buffer to a socket
+ */
+static void send_all(int fd, const void *data, size_t len) {
+    const uint8_t *p = data;
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+}
+
+/**
+ * @brief Read the request and reply with one snapshot
+ */
+static void serve_client(int fd) {
+    char request[32] = {0}; /* flawfinder: ignore - reads bounded by sizeof */
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    if (poll(&pfd, 1, METRICS_REQUEST_TIMEOUT_MS) > 0) {
+        ssize_t n = recv(fd, request, sizeof(request) - 1, 0); /* flawfinder: ignore */
+        if (n > 0) {
+            request[n] = '\0';
+        }
+    }
+
+    if (strncmp(request, "binary", 6) == 0) {
+        size_t size = 0;
+        uint8_t *data = metrics_snapshot_binary(&size);
+        send_all(fd, data, size);
+        free(data);
+    } else {
+        char *text = metrics_snapshot_json();
+        if (text) {
+            send_all(fd, text, strlen(text)); /* flawfinder: ignore - json_dumps output is terminated */
+            send_all(fd, "\n", 1);
+            free(text);
+        }
+    }
+}
+
+/**
+ * @brief Accept loop
+ */
+static void* server_thread(void *arg) {
+    MetricsServer *server = (MetricsServer*)arg;
+    struct pollfd fds[2] = {
+        { .fd = server->listen_fd, .events = POLLIN },
+        { .fd = server->wake_pipe[0], .events = POLLIN }
+    };
+
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Metrics socket poll failed: %s", strerror(errno));
+            break;
+        }
+        if (fds[1].revents) {
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            int client = accept(server->listen_fd, NULL, NULL);
+            if (client >= 0) {
+                serve_client(client);
+                close(client);
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Start serving snapshots
+ */
+MetricsServer* metrics_server_start(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (!path || path[0] == '\0' || strlen(path) >= sizeof(addr.sun_path)) { /* flawfinder: ignore - path is NUL-terminated */
+        LOG_ERROR("Invalid metrics socket path");
+        return NULL;
+    }
+    safe_strncpy(addr.sun_path, path, sizeof(addr.sun_path));
+
+    // Replace a socket left behind by a previous run, never a regular file
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            LOG_ERROR("%s exists and is not a socket", path);
+            return NULL;
+        }
+        unlink(path);
+    }
+
+    MetricsServer *server = safe_calloc(1, sizeof(MetricsServer));
+    safe_strncpy(server->path, path, sizeof(server->path));
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server->listen_fd < 0) {
+        LOG_ERROR("Failed to create metrics socket: %s", strerror(errno));
+        free(server);
+        return NULL;
+    }
+
+    if (bind(server->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(server->listen_fd, 8) != 0) {
+        LOG_ERROR("Failed to listen on %s: %s", path, strerror(errno));
+        close(server->listen_fd);
+        free(server);
+        return NULL;
+    }
+
+    if (pipe(server->wake_pipe) != 0) {
+        LOG_ERROR("Failed to create metrics wake pipe: %s", strerror(errno));
+        close(server->listen_fd);
+        unlink(path);
+        free(server);
+        return NULL;
+    }
+
+    if (pthread_create(&server->thread, NULL, server_thread, server) != 0) {
+        LOG_ERROR("Failed to start metrics thread");
+        close(server->wake_pipe[0]);
+        close(server->wake_pipe[1]);
+        close(server->listen_fd);
+        unlink(path);
+        free(server);
+        return NULL;
+    }
+
+    LOG_INFO("Serving metrics on %s", path);
+    return server;
+}
+
+/**
+ * @brief Stop the server
+ */
+void metrics_server_stop(MetricsServer *server) {
+    if (!server) {
+        return;
+    }
+
+    ssize_t n;
+    do {
+        n = write(server->wake_pipe[1], "x", 1);
+    } while (n < 0 && errno == EINTR);
+    pthread_join(server->thread, NULL);
+
+    close(server->wake_pipe[0]);
+    close(server->wake_pipe[1]);
+    close(server->listen_fd);
+    unlink(server->path);
+    free(server);
+}
@@ -0,0 +1,346 @@
+/**
+ * @file query.c
+ * @brief Uptime and latency percentile queries over stored history
+ * @version 1.0.0
+ */
+
+#include "query.h"
+#include "thread_pool.h"
+#include <jansson.h>
+
+/**
+ * @brief Slice of the result array aggregated by one pool task
+ */
+typedef struct {
+    RollupStore *rollups;
+    const QueryOptions *options;
+    QueryResult *rows;
+    size_t count;
+} QueryTask;
+
+static const char *const g_sort_names[] = { "p50", "p90", "p99", "avg", "uptime" };
+static const char *const g_format_names[] = { "table", "csv", "json" };
+
+/**
+ * @brief Get default query options
+ */
+QueryOptions query_get_default_options(int64_t now_ms) {
+    QueryOptions options = {
+        .from_ms = now_ms - QUERY_DEFAULT_RANGE_MS,
+        .to_ms = now_ms,
+        .sort = QUERY_SORT_P90,
+        .min_uptime_pct = 0.0,
+        .top_n = QUERY_DEFAULT_TOP,
+        .format = QUERY_FORMAT_TABLE
+    };
+    return options;
+}
+
+/**
+ * @brief Parse a sort key name
+ */
+int query_parse_sort(const char *name, QuerySortKey *key) {
+    if (!name || !key) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    for (size_t i = 0; i < sizeof(g_sort_names) / sizeof(g_sort_names[0]); i++) {
+        if (strcmp(name, g_sort_names[i]) == 0) {
+            *key = (QuerySortKey)i;
+            return BDIX_SUCCESS;
+        }
+    }
+    return BDIX_ERROR_INVALID_INPUT;
+}
+
+/**
+ * @brief Parse an output format name
+ */
+int query_parse_format(const char *name, QueryFormat *format) {
+    if (!name || !format) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    for (size_t i = 0; i < sizeof(g_format_names) / sizeof(g_format_names[0]); i++) {
+        if (strcmp(name, g_format_names[i]) == 0) {
+            *format = (QueryFormat)i;
+            return BDIX_SUCCESS;
+        }
+    }
+    return BDIX_ERROR_INVALID_INPUT;
+}
+
+/**
+ * @brief Aggregate one slice of servers (runs on the thread pool)
+ *
+ * Every task owns a disjoint slice of the result array, so no locking
+ * is needed beyond the store's read lock.
+ */
+static void* query_task(void *arg) {
+    QueryTask *task = (QueryTask*)arg;
+
+    for (size_t i = 0; i < task->count; i++) {
+        QueryResult *row = &task->rows[i];
+        rollup_aggregate(task->rollups, history_server_id(row->url),
+                         task->options->from_ms, task->options->to_ms, &row->aggregate);
+
+        row->uptime_pct = rollup_aggregate_uptime_pct(&row->aggregate);
+        row->avg_ms = row->aggregate.up_count > 0
+            ? row->aggregate.sum_latency_ms / row->aggregate.up_count : -1.0;
+        row->p50_ms = rollup_aggregate_quantile(&row->aggregate, 0.50);
+        row->p90_ms = rollup_aggregate_quantile(&row->aggregate, 0.90);
+        row->p99_ms = rollup_aggregate_quantile(&row->aggregate, 0.99);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Value a row is ranked by
+ */
+static double query_sort_value(const QueryResult *row, QuerySortKey key) {
+    switch (key) {
+        case QUERY_SORT_P50: return row->p50_ms;
+        case QUERY_SORT_P90: return row->p90_ms;
+        case QUERY_SORT_P99: return row->p99_ms;
+        case QUERY_SORT_AVG: return row->avg_ms;
+        case QUERY_SORT_UPTIME: return row->uptime_pct;
+    }
+    return 0.0;
+}
+
+/**
+ * @brief Order rows by rank, then uptime (descending), then URL so output is stable
+ */
+static int compare_rows(const void *a, const void *b) {
+    const QueryResult *ra = (const QueryResult*)a;
+    const QueryResult *rb = (const QueryResult*)b;
+
+    if (ra->rank != rb->rank) {
+        return ra->rank < rb->rank ? -1 : 1;
+    }
+    if (ra->uptime_pct != rb->uptime_pct) {
+        return ra->uptime_pct > rb->uptime_pct ? -1 : 1;
+    }
+    return strcmp(ra->url, rb->url);
+}
+
+/**
+ * @brief Aggregate, filter and rank the servers of the given categories
+ */
+int query_run(RollupStore *rollups, ServerCategory *const *categories, size_t category_count,
+              const QueryOptions *options, int thread_count, QueryResultSet *results) {
+    if (!rollups || !categories || !options || !results || options->from_ms > options->to_ms) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    memset(results, 0, sizeof(*results));
+
+    size_t total = 0;
+    for (size_t c = 0; c < category_count; c++) {
+        if (categories[c]) {
+            total += categories[c]->count;
+        }
+    }
+    if (total == 0) {
+        return BDIX_SUCCESS;
+    }
+
+    results->rows = (QueryResult*)safe_calloc(total, sizeof(QueryResult));
+    size_t n = 0;
+    for (size_t c = 0; c < category_count; c++) {
+        if (!categories[c]) {
+            continue;
+        }
+        for (size_t i = 0; i < categories[c]->count; i++) {
+            results->rows[n].url = categories[c]->servers[i].url;
+            results->rows[n].category = categories[c]->name;
+            n++;
+        }
+    }
+
+    size_t task_count = (total + QUERY_SERVERS_PER_TASK - 1) / QUERY_SERVERS_PER_TASK;
+    QueryTask *tasks = (QueryTask*)safe_calloc(task_count, sizeof(QueryTask));
+    for (size_t t = 0; t < task_count; t++) {
+        size_t first = t * QUERY_SERVERS_PER_TASK;
+        tasks[t].rollups = rollups;
+        tasks[t].options = options;
+        tasks[t].rows = &results->rows[first];
+        tasks[t].count = total - first < QUERY_SERVERS_PER_TASK ? total - first : QUERY_SERVERS_PER_TASK;
+    }
+
+    // A single slice is not worth the pool start-up
+    ThreadPool *pool = NULL;
+    if (task_count > 1 && thread_count > 1) {
+        int workers = (size_t)thread_count < task_count ? thread_count : (int)task_count;
+        pool = thread_pool_create(workers);
+    }
+
+    for (size_t t = 0; t < task_count; t++) {
+        if (!pool || thread_pool_add_work(pool, query_task, &tasks[t]) != BDIX_SUCCESS) {
+            query_task(&tasks[t]);
+        }
+    }
+    if (pool) {
+        thread_pool_wait(pool);
+        thread_pool_destroy(pool);
+    }
+    free(tasks);
+
+    results->scanned = total;
+
+    // Drop servers without data in range, below the uptime floor or never up
+    n = 0;
+    for (size_t i = 0; i < total; i++) {
+        const QueryResult *row = &results->rows[i];
+        if (row->aggregate.count == 0 || row->uptime_pct < options->min_uptime_pct) {
+            continue;
+        }
+        if (options->sort != QUERY_SORT_UPTIME && row->aggregate.up_count == 0) {
+            continue;
+        }
+        results->rows[n] = *row;
+        // Lowest latency first, or highest uptime first
+        double value = query_sort_value(row, options->sort);
+        results->rows[n].rank = options->sort == QUERY_SORT_UPTIME ? -value : value;
+        n++;
+    }
+
+    qsort(results->rows, n, sizeof(QueryResult), compare_rows);
+
+    results->count = options->top_n > 0 && options->top_n < n ? options->top_n : n;
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Write a CSV field, quoting it when needed
+ */
+static void write_csv_field(FILE *out, const char *value) {
+    if (!strpbrk(value, ",\"\n")) {
+        fputs(value, out);
+        return;
+    }
+
+    fputc('"', out);
+    for (const char *p = value; *p; p++) {
+        if (*p == '"') {
+            fputc('"', out);
+        }
+        fputc(*p, out);
+    }
+    fputc('"', out);
+}
+
+/**
+ * @brief Write results as JSON
+ */
+static int write_json(const QueryResultSet *results, const QueryOptions *options, FILE *out) {
+    json_t *root = json_object();
+    json_t *servers = json_array();
+    if (!root || !servers) {
+        json_decref(root);
+        json_decref(servers);
+        return BDIX_ERROR_MEMORY;
+    }
+
+    json_object_set_new(root, "from_ms", json_integer(options->from_ms));
+    json_object_set_new(root, "to_ms", json_integer(options->to_ms));
+    json_object_set_new(root, "sort", json_string(g_sort_names[options->sort]));
+    json_object_set_new(root, "min_uptime_pct", json_real(options->min_uptime_pct));
+    json_object_set_new(root, "scanned", json_integer((json_int_t)results->scanned));
+
+    for (size_t i = 0; i < results->count; i++) {
+        const QueryResult *row = &results->rows[i];
+        json_t *entry = json_object();
+        if (!entry) {
+            continue;
+        }
+        json_object_set_new(entry, "url", json_string(row->url));
+        json_object_set_new(entry, "category", json_string(row->category ? row->category : ""));
+        json_object_set_new(entry, "checks", json_integer(row->aggregate.count));
+        json_object_set_new(entry, "up", json_integer(row->aggregate.up_count));
+        json_object_set_new(entry, "uptime_pct", json_real(row->uptime_pct));
+        if (row->aggregate.up_count > 0) {
+            json_object_set_new(entry, "avg_ms", json_real(row->avg_ms));
+            json_object_set_new(entry, "p50_ms", json_real(row->p50_ms));
+            json_object_set_new(entry, "p90_ms", json_real(row->p90_ms));
+            json_object_set_new(entry, "p99_ms", json_real(row->p99_ms));
+            json_object_set_new(entry, "min_ms", json_real(row->aggregate.min_latency_ms));
+            json_object_set_new(entry, "max_ms", json_real(row->aggregate.max_latency_ms));
+        }
+        json_array_append_new(servers, entry);
+    }
+    json_object_set_new(root, "servers", servers);
+
+    int rc = json_dumpf(root, out, JSON_INDENT(2)) == 0 ? BDIX_SUCCESS : BDIX_ERROR;
+    fputc('\n', out);
+    json_decref(root);
+    return rc;
+}
+
+/**
+ * @brief Write results as a table, CSV or JSON
+ */
+/* flawfinder: ignore - all fprintf calls below use compile-time constant format strings */
+int query_write_results(const QueryResultSet *results, const QueryOptions *options, FILE *out) {
+    if (!results || !options || !out) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    if (options->format == QUERY_FORMAT_JSON) {
+        return write_json(results, options, out);
+    }
+
+    if (options->format == QUERY_FORMAT_CSV) {
+        fprintf(out, "rank,url,category,checks,uptime_pct,avg_ms,p50_ms,p90_ms,p99_ms\n"); // flawfinder: ignore
+        for (size_t i = 0; i < results->count; i++) {
+            const QueryResult *row = &results->rows[i];
+            fprintf(out, "%zu,", i + 1); // flawfinder: ignore
+            write_csv_field(out, row->url);
+            fputc(',', out);
+            write_csv_field(out, row->category ? row->category : "");
+            fprintf(out, ",%u,%.3f,%.2f,%.2f,%.2f,%.2f\n", // flawfinder: ignore
+                    row->aggregate.count, row->uptime_pct,
+                    row->avg_ms, row->p50_ms, row->p90_ms, row->p99_ms);
+        }
+        return ferror(out) ? BDIX_ERROR : BDIX_SUCCESS;
+    }
+
+    fprintf(out, "Top %zu of %zu servers by %s", // flawfinder: ignore
+            results->count, results->scanned, g_sort_names[options->sort]);
+    if (options->min_uptime_pct > 0.0) {
+        fprintf(out, " (uptime >= %.2f%%)", options->min_uptime_pct); // flawfinder: ignore
+    }
+    fprintf(out, "\n\n"); // flawfinder: ignore
+
+    fprintf(out, "%4s  %-48s %7s %8s %9s %9s %9s %9s\n", // flawfinder: ignore
+            "#", "Server URL", "Checks", "Uptime", "Avg", "p50", "p90", "p99");
+    for (size_t i = 0; i < results->count; i++) {
+        const QueryResult *row = &results->rows[i];
+        fprintf(out, "%4zu  %-48s %7u %7.2f%%", // flawfinder: ignore
+                i + 1, row->url, row->aggregate.count, row->uptime_pct);
+        if (row->aggregate.up_count > 0) {
+            fprintf(out, " %7.1fms %7.1fms %7.1fms %7.1fms\n", // flawfinder: ignore
+                    row->avg_ms, row->p50_ms, row->p90_ms, row->p99_ms);
+        } else {
+            fprintf(out, " %9s %9s %9s %9s\n", "-", "-", "-", "-"); // flawfinder: ignore
+        }
+    }
+    if (results->count == 0) {
+        fprintf(out, "No servers with history in the selected range\n"); // flawfinder: ignore
+    }
+
+    return ferror(out) ? BDIX_ERROR : BDIX_SUCCESS;
+}
+
+/**
+ * @brief Free query results
+ */
+void query_results_free(QueryResultSet *results) {
+    if (!results) {
+        return;
+    }
+    free(results->rows);
+    results->rows = NULL;
+    results->count = 0;
+    results->scanned = 0;
+}
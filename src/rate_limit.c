@@ -0,0 +1,386 @@
+/**
+ * @file rate_limit.c
+ * @brief Per-host token-bucket rate limiting implementation
+ * @version 1.0.0
+ */
+
+#include "rate_limit.h"
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+
+#define RATE_LIMIT_INITIAL_ENTRIES 64
+#define RATE_LIMIT_INITIAL_BUCKETS 32
+
+/**
+ * @brief FNV-1a hash of a string key
+ */
+static size_t hash_key(const char *key) {
+    size_t hash = (size_t)14695981039346656037ULL;
+    for (const unsigned char *p = (const unsigned char*)key; *p; p++) {
+        hash ^= *p;
+        hash *= (size_t)1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Find a key in the table (mutex must be held)
+ *
+ * @return Pointer to entry, or NULL if absent
+ */
+static RateLimitEntry* table_find(RateLimiter *limiter, const char *key) {
+    size_t mask = limiter->entry_capacity - 1;
+    size_t i = hash_key(key) & mask;
+
+    while (limiter->entries[i].key) {
+        if (strcmp(limiter->entries[i].key, key) == 0) {
+            return &limiter->entries[i];
+        }
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Insert a new key without checking for duplicates (mutex must be held)
+ */
+static void table_insert_raw(RateLimitEntry *entries, size_t capacity, char *key, size_t bucket) {
+    size_t mask = capacity - 1;
+    size_t i = hash_key(key) & mask;
+
+    while (entries[i].key) {
+        i = (i + 1) & mask;
+    }
+    entries[i].key = key;
+    entries[i].bucket = bucket;
+}
+
+/**
+ * @brief Insert a key, growing the table as needed (mutex must be held)
+ */
+static void table_insert(RateLimiter *limiter, const char *key, size_t bucket) {
+    if ((limiter->entry_count + 1) * 2 > limiter->entry_capacity) {
+        size_t new_capacity = limiter->entry_capacity * 2;
+        RateLimitEntry *new_entries = safe_calloc(new_capacity, sizeof(RateLimitEntry));
+
+        for (size_t i = 0; i < limiter->entry_capacity; i++) {
+            if (limiter->entries[i].key) {
+                table_insert_raw(new_entries, new_capacity, limiter->entries[i].key,
+                                 limiter->entries[i].bucket);
+            }
+        }
+
+        free(limiter->entries);
+        limiter->entries = new_entries;
+        limiter->entry_capacity = new_capacity;
+    }
+
+    table_insert_raw(limiter->entries, limiter->entry_capacity, safe_strdup(key), bucket);
+    limiter->entry_count++;
+}
+
+/**
+ * @brief Allocate a full bucket (mutex must be held)
+ */
+static size_t bucket_new(RateLimiter *limiter) {
+    if (limiter->bucket_count >= limiter->bucket_capacity) {
+        limiter->bucket_capacity *= 2;
+        limiter->buckets = safe_realloc(limiter->buckets,
+                                        limiter->bucket_capacity * sizeof(RateBucket));
+    }
+
+    limiter->buckets[limiter->bucket_count] = (RateBucket){
+        .tokens = limiter->config.burst,
+        .last_refill_ms = get_time_ms(),
+        .in_flight = 0,
+        .waiting = 0
+    };
+    return limiter->bucket_count++;
+}
+
+/**
+ * @brief Resolve a host to a textual address key ("ip:<addr>")
+ */
+static bool resolve_address_key(const char *host, char *key, size_t size) {
+    struct addrinfo hints;
+    struct addrinfo *result = NULL;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (getaddrinfo(host, NULL, &hints, &result) != 0 || !result) {
+        LOG_DEBUG("Rate limiter could not resolve %s, keying on host name", host);
+        return false;
+    }
+
+    char addr[INET6_ADDRSTRLEN]; /* flawfinder: ignore - bounds checked with inet_ntop */
+    const void *src = NULL;
+    if (result->ai_family == AF_INET) {
+        src = &((struct sockaddr_in*)result->ai_addr)->sin_addr;
+    } else if (result->ai_family == AF_INET6) {
+        src = &((struct sockaddr_in6*)result->ai_addr)->sin6_addr;
+    }
+
+    bool ok = src && inet_ntop(result->ai_family, src, addr, sizeof(addr));
+    freeaddrinfo(result);
+
+    if (ok) {
+        snprintf(key, size, "ip:%s", addr); // flawfinder: ignore
+    }
+    return ok;
+}
+
+/**
+ * @brief Find or create the bucket for a host
+ */
+static size_t lookup_bucket(RateLimiter *limiter, const char *host) {
+    pthread_mutex_lock(&limiter->mutex);
+    RateLimitEntry *entry = table_find(limiter, host);
+    if (entry) {
+        size_t bucket = entry->bucket;
+        pthread_mutex_unlock(&limiter->mutex);
+        return bucket;
+    }
+    pthread_mutex_unlock(&limiter->mutex);
+
+    // Resolve outside the lock so a slow DNS lookup never stalls other workers
+    char ip_key[MEDIUM_BUFFER]; /* flawfinder: ignore - bounds checked with snprintf */
+    bool have_ip = limiter->config.per_ip &&
+                   resolve_address_key(host, ip_key, sizeof(ip_key));
+
+    pthread_mutex_lock(&limiter->mutex);
+
+    // Another worker may have inserted the host meanwhile
+    entry = table_find(limiter, host);
+    if (entry) {
+        size_t bucket = entry->bucket;
+        pthread_mutex_unlock(&limiter->mutex);
+        return bucket;
+    }
+
+    size_t bucket;
+    RateLimitEntry *ip_entry = have_ip ? table_find(limiter, ip_key) : NULL;
+    if (ip_entry) {
+        bucket = ip_entry->bucket;
+    } else {
+        bucket = bucket_new(limiter);
+        if (have_ip) {
+            table_insert(limiter, ip_key, bucket);
+        }
+    }
+    table_insert(limiter, host, bucket);
+
+    pthread_mutex_unlock(&limiter->mutex);
+    return bucket;
+}
+
+/**
+ * @brief Get default rate limiter configuration
+ */
+RateLimitConfig rate_limiter_get_default_config(void) {
+    return (RateLimitConfig){
+        .rate_per_sec = RATE_LIMIT_DEFAULT_RATE,
+        .burst = RATE_LIMIT_DEFAULT_BURST,
+        .max_concurrent = RATE_LIMIT_DEFAULT_CONCURRENCY,
+        .per_ip = false
+    };
+}
+
+/**
+ * @brief Create a rate limiter
+ */
+RateLimiter* rate_limiter_create(const RateLimitConfig *config) {
+    if (!config || config->rate_per_sec <= 0.0 || config->burst < 1.0 ||
+        config->max_concurrent < 0) {
+        LOG_ERROR("Invalid rate limiter configuration");
+        return NULL;
+    }
+
+    RateLimiter *limiter = safe_calloc(1, sizeof(RateLimiter));
+    limiter->config = *config;
+    limiter->entry_capacity = RATE_LIMIT_INITIAL_ENTRIES;
+    limiter->entries = safe_calloc(limiter->entry_capacity, sizeof(RateLimitEntry));
+    limiter->bucket_capacity = RATE_LIMIT_INITIAL_BUCKETS;
+    limiter->buckets = safe_calloc(limiter->bucket_capacity, sizeof(RateBucket));
+    atomic_store(&limiter->throttled, 0);
+
+    if (pthread_mutex_init(&limiter->mutex, NULL) != 0) {
+        LOG_ERROR("Failed to initialize rate limiter mutex");
+        free(limiter->buckets);
+        free(limiter->entries);
+        free(limiter);
+        return NULL;
+    }
+
+    LOG_DEBUG("Rate limiter created (%.1f/s, burst %.0f, concurrency %d, per-ip %d)",
+              config->rate_per_sec, config->burst, config->max_concurrent, config->per_ip);
+    return limiter;
+}
+
+/**
+ * @brief Destroy a rate limiter and free resources
+ */
+void rate_limiter_destroy(RateLimiter *limiter) {
+    if (!limiter) {
+        return;
+    }
+
+    for (size_t i = 0; i < limiter->entry_capacity; i++) {
+        free(limiter->entries[i].key);
+    }
+
+    pthread_mutex_destroy(&limiter->mutex);
+    free(limiter->entries);
+    free(limiter->buckets);
+    free(limiter);
+}
+
+/**
+ * @brief Drop a wait registration (mutex must be held)
+ */
+static void drop_waiter_locked(RateLimiter *limiter, size_t *waiter) {
+    if (*waiter < limiter->bucket_count && limiter->buckets[*waiter].waiting > 0) {
+        limiter->buckets[*waiter].waiting--;
+    }
+    *waiter = RATE_LIMIT_NO_SLOT;
+}
+
+/**
+ * @brief Try to acquire a probe slot for a URL's host without blocking
+ */
+bool rate_limiter_try_acquire(RateLimiter *limiter, const char *url,
+                              size_t *slot, double *retry_after_ms, size_t *waiter) {
+    if (slot) *slot = RATE_LIMIT_NO_SLOT;
+    if (retry_after_ms) *retry_after_ms = 0.0;
+
+    char host[MEDIUM_BUFFER]; /* flawfinder: ignore - bounds checked in rate_limiter_extract_host */
+    if (!limiter || !url || !slot ||
+        rate_limiter_extract_host(url, host, sizeof(host)) != BDIX_SUCCESS) {
+        return true;
+    }
+
+    size_t index = lookup_bucket(limiter, host);
+    double now = get_time_ms();
+
+    pthread_mutex_lock(&limiter->mutex);
+
+    RateBucket *bucket = &limiter->buckets[index];
+    double elapsed = now - bucket->last_refill_ms;
+    if (elapsed > 0.0) {
+        bucket->tokens = MIN(limiter->config.burst,
+                             bucket->tokens + elapsed * limiter->config.rate_per_sec / 1000.0);
+        bucket->last_refill_ms = now;
+    }
+
+    bool capped = limiter->config.max_concurrent > 0 &&
+                  bucket->in_flight >= limiter->config.max_concurrent;
+
+    if (!capped && bucket->tokens >= 1.0) {
+        bucket->tokens -= 1.0;
+        bucket->in_flight++;
+        if (waiter) {
+            drop_waiter_locked(limiter, waiter);
+        }
+        pthread_mutex_unlock(&limiter->mutex);
+        *slot = index;
+        return true;
+    }
+
+    double delay;
+    if (bucket->tokens >= 1.0) {
+        // Only the concurrency cap is in the way; a slot frees up when a probe finishes
+        delay = 1000.0 / limiter->config.rate_per_sec;
+    } else {
+        // Spread deferred retries over the refill schedule instead of waking them together
+        if (waiter && *waiter != index) {
+            drop_waiter_locked(limiter, waiter);
+            bucket->waiting++;
+            *waiter = index;
+        }
+        int ahead = bucket->waiting + (waiter ? 0 : 1);
+        double deficit = (double)ahead - bucket->tokens;
+        delay = deficit * 1000.0 / limiter->config.rate_per_sec;
+    }
+    pthread_mutex_unlock(&limiter->mutex);
+
+    atomic_fetch_add(&limiter->throttled, 1);
+
+    if (retry_after_ms) {
+        *retry_after_ms = MIN(MAX(delay, RATE_LIMIT_MIN_RETRY_MS), RATE_LIMIT_MAX_RETRY_MS);
+    }
+    return false;
+}
+
+/**
+ * @brief Drop the wait registration of a deferred probe that will not retry
+ */
+void rate_limiter_cancel_wait(RateLimiter *limiter, size_t *waiter) {
+    if (!limiter || !waiter || *waiter == RATE_LIMIT_NO_SLOT) {
+        return;
+    }
+
+    pthread_mutex_lock(&limiter->mutex);
+    drop_waiter_locked(limiter, waiter);
+    pthread_mutex_unlock(&limiter->mutex);
+}
+
+/**
+ * @brief Release a probe slot
+ */
+void rate_limiter_release(RateLimiter *limiter, size_t slot) {
+    if (!limiter || slot == RATE_LIMIT_NO_SLOT) {
+        return;
+    }
+
+    pthread_mutex_lock(&limiter->mutex);
+    if (slot < limiter->bucket_count && limiter->buckets[slot].in_flight > 0) {
+        limiter->buckets[slot].in_flight--;
+    }
+    pthread_mutex_unlock(&limiter->mutex);
+}
+
+/**
+ * @brief Extract the lowercase host name from a URL
+ */
+int rate_limiter_extract_host(const char *url, char *host, size_t size) {
+    if (!url || !host || size == 0) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    const char *start = strstr(url, "://");
+    start = start ? start + 3 : url;
+
+    // Skip userinfo ("user:pass@") within the authority
+    const char *authority_end = start + strcspn(start, "/?#");
+    const char *at = memchr(start, '@', (size_t)(authority_end - start));
+    if (at) {
+        start = at + 1;
+    }
+
+    const char *end;
+    if (*start == '[') {
+        // IPv6 literal
+        start++;
+        end = memchr(start, ']', (size_t)(authority_end - start));
+        if (!end) {
+            return BDIX_ERROR_INVALID_INPUT;
+        }
+    } else {
+        end = start + strcspn(start, ":/?#");
+    }
+
+    size_t len = (size_t)(end - start);
+    if (len == 0 || len >= size) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        host[i] = (char)tolower((unsigned char)start[i]);
+    }
+    host[len] = '\0';
+
+    return BDIX_SUCCESS;
+}
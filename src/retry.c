@@ -0,0 +1,141 @@
+/**
+ * @file retry.c
+ * @brief Retries with jittered backoff and hedged requests under a shared budget
+ * @version 1.0.0
+ */
+
+#include "retry.h"
+
+/**
+ * @brief Get default retry configuration
+ */
+RetryConfig retry_get_default_config(void) {
+    return (RetryConfig){
+        .max_retries = 0,
+        .backoff_ms = RETRY_DEFAULT_BACKOFF_MS,
+        .max_backoff_ms = RETRY_DEFAULT_MAX_BACKOFF_MS,
+        .hedge_quantile = 0.0,
+        .hedge_min_ms = RETRY_DEFAULT_HEDGE_MIN_MS,
+        .budget_pct = RETRY_DEFAULT_BUDGET_PCT,
+        .budget_burst = RETRY_DEFAULT_BUDGET_BURST
+    };
+}
+
+/**
+ * @brief Create a retry budget
+ */
+RetryBudget* retry_budget_create(const RetryConfig *config) {
+    if (!config || config->max_retries < 0 || config->max_retries > RETRY_MAX_RETRIES ||
+        config->backoff_ms < 0.0 || config->hedge_quantile < 0.0 || config->hedge_quantile >= 1.0 ||
+        config->budget_pct < 0.0 || config->budget_burst < 0.0) {
+        LOG_ERROR("Invalid retry configuration");
+        return NULL;
+    }
+
+    RetryBudget *budget = safe_calloc(1, sizeof(RetryBudget));
+    if (pthread_mutex_init(&budget->lock, NULL) != 0) {
+        LOG_ERROR("Failed to initialize retry budget mutex");
+        free(budget);
+        return NULL;
+    }
+    budget->config = *config;
+    atomic_store(&budget->jitter_state, (uint64_t)(get_time_ms() * 1000.0));
+    atomic_store(&budget->retries, 0);
+    atomic_store(&budget->hedges, 0);
+    atomic_store(&budget->denied, 0);
+
+    LOG_DEBUG("Retry budget: %d retries, %.0f%% of probes + %.0f per minute, hedging at p%.0f",
+              config->max_retries, config->budget_pct, config->budget_burst,
+              config->hedge_quantile * 100.0);
+    return budget;
+}
+
+/**
+ * @brief Destroy a retry budget
+ */
+void retry_budget_destroy(RetryBudget *budget) {
+    if (!budget) {
+        return;
+    }
+    pthread_mutex_destroy(&budget->lock);
+    free(budget);
+}
+
+/**
+ * @brief Current window slot, cleared if it last counted for an older one
+ *
+ * Called with the lock held. Returns the slot index and its epoch in *epoch.
+ */
+static size_t current_slot(RetryBudget *budget, int64_t *epoch) {
+    *epoch = (int64_t)(get_time_ms() / (RETRY_BUDGET_WINDOW_MS / RETRY_BUDGET_SLOTS));
+    size_t slot = (size_t)(*epoch % RETRY_BUDGET_SLOTS);
+    if (budget->slot_epoch[slot] != *epoch) {
+        budget->slot_epoch[slot] = *epoch;
+        budget->deposits[slot] = 0.0;
+        budget->withdrawals[slot] = 0.0;
+    }
+    return slot;
+}
+
+/**
+ * @brief Count one first attempt towards the budget
+ */
+void retry_budget_deposit(RetryBudget *budget) {
+    if (!budget) {
+        return;
+    }
+    int64_t epoch;
+    pthread_mutex_lock(&budget->lock);
+    budget->deposits[current_slot(budget, &epoch)] += 1.0;
+    pthread_mutex_unlock(&budget->lock);
+}
+
+/**
+ * @brief Take out one retry or hedge if the budget allows it
+ */
+bool retry_budget_withdraw(RetryBudget *budget, bool hedge) {
+    if (!budget) {
+        return false;
+    }
+
+    pthread_mutex_lock(&budget->lock);
+    int64_t epoch;
+    size_t slot = current_slot(budget, &epoch);
+    double deposits = 0.0;
+    double withdrawals = 0.0;
+    for (size_t i = 0; i < RETRY_BUDGET_SLOTS; i++) {
+        if (budget->slot_epoch[i] > epoch - RETRY_BUDGET_SLOTS) {
+            deposits += budget->deposits[i];
+            withdrawals += budget->withdrawals[i];
+        }
+    }
+    bool granted = withdrawals + 1.0 <=
+                   budget->config.budget_burst + deposits * budget->config.budget_pct / 100.0;
+    if (granted) {
+        budget->withdrawals[slot] += 1.0;
+    }
+    pthread_mutex_unlock(&budget->lock);
+
+    atomic_fetch_add(granted ? (hedge ? &budget->hedges : &budget->retries) : &budget->denied, 1);
+    return granted;
+}
+
+/**
+ * @brief Jittered delay before a retry
+ */
+double retry_backoff_ms(RetryBudget *budget, int retry) {
+    double delay = budget->config.backoff_ms;
+    for (int i = 1; i < retry && delay < budget->config.max_backoff_ms; i++) {
+        delay *= 2.0;
+    }
+    delay = MIN(delay, budget->config.max_backoff_ms);
+
+    // splitmix64 over a shared counter: lock-free and well mixed
+    uint64_t z = atomic_fetch_add(&budget->jitter_state, 0x9E3779B97F4A7C15ULL) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    double uniform = (double)(z >> 11) / 9007199254740992.0;
+
+    return delay / 2.0 + uniform * delay / 2.0;
+}
@@ -0,0 +1,1153 @@
+/**
+ * @file rollup.c
+ * @brief History rollups (1m/1h/1d aggregates) and background compaction
+ * @version 1.0.0
+ */
+
+#include "rollup.h"
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define ROLLUP_INITIAL_AGG 1024
+#define ROLLUP_INITIAL_BLOCKS 64
+#define ROLLUP_INITIAL_CHUNKS 8
+
+// Longest single sleep of the compactor so stop requests are noticed promptly
+#define ROLLUP_POLL_INTERVAL_MS 250
+
+_Static_assert(sizeof(RollupRecord) == 128, "RollupRecord must stay 128 bytes");
+_Static_assert(sizeof(RollupFileHeader) == 64, "RollupFileHeader must stay 64 bytes");
+_Static_assert(sizeof(RollupBlockHeader) == 16, "RollupBlockHeader must stay 16 bytes");
+
+static const char *const g_tier_names[ROLLUP_TIER_COUNT] = { "1m", "1h", "1d" };
+static const int64_t g_tier_period_ms[ROLLUP_TIER_COUNT] = {
+    60000LL, 3600000LL, ROLLUP_MS_PER_DAY
+};
+static const int64_t g_tier_chunk_ms[ROLLUP_TIER_COUNT] = {
+    ROLLUP_MS_PER_DAY, 30 * ROLLUP_MS_PER_DAY, 365 * ROLLUP_MS_PER_DAY
+};
+
+/**
+ * @brief Round a timestamp down to a multiple of period
+ */
+static int64_t floor_to(int64_t ts, int64_t period) {
+    int64_t rem = ts % period;
+    return rem < 0 ? ts - rem - period : ts - rem;
+}
+
+/**
+ * @brief Round a timestamp up to a multiple of period
+ */
+static int64_t ceil_to(int64_t ts, int64_t period) {
+    int64_t down = floor_to(ts, period);
+    return down == ts ? ts : down + period;
+}
+
+/* ---------- Latency sketch ---------- */
+
+/**
+ * @brief Natural log of the bucket growth factor
+ */
+static double sketch_log_gamma(void) {
+    return log(ROLLUP_SKETCH_MAX_MS / ROLLUP_SKETCH_MIN_MS) / (ROLLUP_SKETCH_BUCKETS - 1);
+}
+
+/**
+ * @brief Bucket index of a latency
+ */
+static size_t sketch_bucket(double latency_ms) {
+    if (!(latency_ms > ROLLUP_SKETCH_MIN_MS)) {
+        return 0;
+    }
+    double pos = log(latency_ms / ROLLUP_SKETCH_MIN_MS) / sketch_log_gamma();
+    size_t index = 1 + (size_t)pos;
+    return MIN(index, (size_t)ROLLUP_SKETCH_BUCKETS - 1);
+}
+
+/**
+ * @brief Add a latency to a sketch
+ */
+void latency_sketch_add(LatencySketch *sketch, double latency_ms) {
+    if (!sketch) {
+        return;
+    }
+    uint16_t *count = &sketch->counts[sketch_bucket(latency_ms)];
+    if (*count < UINT16_MAX) {
+        (*count)++;
+    }
+}
+
+/**
+ * @brief Merge one sketch into another
+ */
+void latency_sketch_merge(LatencySketch *dst, const LatencySketch *src) {
+    if (!dst || !src) {
+        return;
+    }
+    for (size_t i = 0; i < ROLLUP_SKETCH_BUCKETS; i++) {
+        uint32_t sum = (uint32_t)dst->counts[i] + src->counts[i];
+        dst->counts[i] = (uint16_t)MIN(sum, (uint32_t)UINT16_MAX);
+    }
+}
+
+/**
+ * @brief Estimate a quantile from bucket counts
+ */
+static double sketch_quantile(const uint64_t *counts, double q) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < ROLLUP_SKETCH_BUCKETS; i++) {
+        total += counts[i];
+    }
+    if (total == 0) {
+        return -1.0;
+    }
+
+    q = MAX(0.0, MIN(q, 1.0));
+    double rank = q * (double)(total - 1);
+    uint64_t cumulative = 0;
+    size_t bucket = ROLLUP_SKETCH_BUCKETS - 1;
+    for (size_t i = 0; i < ROLLUP_SKETCH_BUCKETS; i++) {
+        cumulative += counts[i];
+        if ((double)cumulative > rank) {
+            bucket = i;
+            break;
+        }
+    }
+
+    // Geometric midpoint of the bucket
+    if (bucket == 0) {
+        return ROLLUP_SKETCH_MIN_MS;
+    }
+    return ROLLUP_SKETCH_MIN_MS * exp(((double)bucket - 0.5) * sketch_log_gamma());
+}
+
+/**
+ * @brief Estimate a quantile from a sketch
+ */
+double latency_sketch_quantile(const LatencySketch *sketch, double q) {
+    if (!sketch) {
+        return -1.0;
+    }
+
+    uint64_t counts[ROLLUP_SKETCH_BUCKETS];
+    for (size_t i = 0; i < ROLLUP_SKETCH_BUCKETS; i++) {
+        counts[i] = sketch->counts[i];
+    }
+    return sketch_quantile(counts, q);
+}
+
+/**
+ * @brief Merge a stored sketch into a query-time sketch
+ */
+void latency_sketch_sum_merge(LatencySketchSum *dst, const LatencySketch *src) {
+    if (!dst || !src) {
+        return;
+    }
+    for (size_t i = 0; i < ROLLUP_SKETCH_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+}
+
+/**
+ * @brief Estimate a quantile from a query-time sketch
+ */
+double latency_sketch_sum_quantile(const LatencySketchSum *sketch, double q) {
+    return sketch ? sketch_quantile(sketch->counts, q) : -1.0;
+}
+
+/* ---------- Aggregates ---------- */
+
+/**
+ * @brief Add one check result to an aggregate
+ */
+void rollup_record_add(RollupRecord *record, ServerStatus status, double latency_ms) {
+    if (!record) {
+        return;
+    }
+
+    record->count++;
+    if (status != BDIX_STATUS_ONLINE) {
+        return;
+    }
+
+    float latency = (float)latency_ms;
+    if (record->up_count == 0 || latency < record->min_latency_ms) {
+        record->min_latency_ms = latency;
+    }
+    if (record->up_count == 0 || latency > record->max_latency_ms) {
+        record->max_latency_ms = latency;
+    }
+    record->up_count++;
+    record->sum_latency_ms += latency_ms;
+    latency_sketch_add(&record->sketch, latency_ms);
+}
+
+/**
+ * @brief Merge one aggregate into another
+ */
+void rollup_record_merge(RollupRecord *dst, const RollupRecord *src) {
+    if (!dst || !src || src->count == 0) {
+        return;
+    }
+
+    if (src->up_count > 0) {
+        if (dst->up_count == 0 || src->min_latency_ms < dst->min_latency_ms) {
+            dst->min_latency_ms = src->min_latency_ms;
+        }
+        if (dst->up_count == 0 || src->max_latency_ms > dst->max_latency_ms) {
+            dst->max_latency_ms = src->max_latency_ms;
+        }
+    }
+    dst->count += src->count;
+    dst->up_count += src->up_count;
+    dst->sum_latency_ms += src->sum_latency_ms;
+    latency_sketch_merge(&dst->sketch, &src->sketch);
+}
+
+/**
+ * @brief Estimate a latency quantile of an aggregate
+ */
+double rollup_record_quantile(const RollupRecord *record, double q) {
+    if (!record || record->up_count == 0) {
+        return -1.0;
+    }
+
+    double value = latency_sketch_quantile(&record->sketch, q);
+    value = MAX(value, (double)record->min_latency_ms);
+    return MIN(value, (double)record->max_latency_ms);
+}
+
+/**
+ * @brief Uptime percentage of an aggregate
+ */
+double rollup_record_uptime_pct(const RollupRecord *record) {
+    if (!record || record->count == 0) {
+        return -1.0;
+    }
+    return 100.0 * record->up_count / record->count;
+}
+
+/**
+ * @brief Add one raw check result to a query aggregate
+ */
+void rollup_aggregate_add(RollupAggregate *aggregate, ServerStatus status, double latency_ms) {
+    if (!aggregate) {
+        return;
+    }
+
+    // A one-check record has a single sketch count, which never saturates
+    RollupRecord check = {0};
+    rollup_record_add(&check, status, latency_ms);
+    rollup_aggregate_merge(aggregate, &check);
+}
+
+/**
+ * @brief Merge a stored aggregate into a query aggregate
+ */
+void rollup_aggregate_merge(RollupAggregate *aggregate, const RollupRecord *record) {
+    if (!aggregate || !record || record->count == 0) {
+        return;
+    }
+
+    if (record->up_count > 0) {
+        if (aggregate->up_count == 0 || record->min_latency_ms < aggregate->min_latency_ms) {
+            aggregate->min_latency_ms = record->min_latency_ms;
+        }
+        if (aggregate->up_count == 0 || record->max_latency_ms > aggregate->max_latency_ms) {
+            aggregate->max_latency_ms = record->max_latency_ms;
+        }
+    }
+    aggregate->count += record->count;
+    aggregate->up_count += record->up_count;
+    aggregate->sum_latency_ms += record->sum_latency_ms;
+    latency_sketch_sum_merge(&aggregate->sketch, &record->sketch);
+}
+
+/**
+ * @brief Estimate a latency quantile of a query aggregate
+ */
+double rollup_aggregate_quantile(const RollupAggregate *aggregate, double q) {
+    if (!aggregate || aggregate->up_count == 0) {
+        return -1.0;
+    }
+
+    double value = latency_sketch_sum_quantile(&aggregate->sketch, q);
+    value = MAX(value, (double)aggregate->min_latency_ms);
+    return MIN(value, (double)aggregate->max_latency_ms);
+}
+
+/**
+ * @brief Uptime percentage of a query aggregate
+ */
+double rollup_aggregate_uptime_pct(const RollupAggregate *aggregate) {
+    if (!aggregate || aggregate->count == 0) {
+        return -1.0;
+    }
+    return 100.0 * aggregate->up_count / aggregate->count;
+}
+
+/* ---------- Configuration ---------- */
+
+/**
+ * @brief Get default rollup configuration
+ */
+RollupConfig rollup_get_default_config(void) {
+    return (RollupConfig){
+        .raw_retention_ms = ROLLUP_DEFAULT_RAW_RETENTION,
+        .retention_ms = {
+            ROLLUP_DEFAULT_MINUTE_RETENTION,
+            ROLLUP_DEFAULT_HOUR_RETENTION,
+            ROLLUP_DEFAULT_DAY_RETENTION
+        },
+        .grace_ms = ROLLUP_DEFAULT_GRACE_MS,
+        .interval_ms = ROLLUP_DEFAULT_INTERVAL_MS,
+        .read_only = false
+    };
+}
+
+/**
+ * @brief Parse a duration such as "90s", "14d" or "5y" into milliseconds
+ */
+int rollup_parse_duration(const char *text, int64_t *out) {
+    if (!text || !out) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    char *end;
+    double value = strtod(text, &end);
+    if (end == text || !(value > 0.0)) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    double unit;
+    switch (*end) {
+        case 's': unit = 1000.0; break;
+        case 'm': unit = 60000.0; break;
+        case 'h': unit = 3600000.0; break;
+        case 'd': unit = (double)ROLLUP_MS_PER_DAY; break;
+        case 'w': unit = 7.0 * ROLLUP_MS_PER_DAY; break;
+        case 'y': unit = 365.0 * ROLLUP_MS_PER_DAY; break;
+        default: return BDIX_ERROR_INVALID_INPUT;
+    }
+    if (end[1] != '\0') {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    *out = (int64_t)(value * unit);
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Parse a retention spec such as "raw=2d,1m=14d,1h=180d,1d=5y"
+ */
+int rollup_parse_retention(const char *spec, RollupConfig *config) {
+    if (!spec || !config) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    RollupConfig parsed = *config;
+    char *copy = safe_strdup(spec);
+    char *saveptr = NULL;
+    int ret = BDIX_SUCCESS;
+
+    for (char *token = strtok_r(copy, ",", &saveptr); token && ret == BDIX_SUCCESS;
+         token = strtok_r(NULL, ",", &saveptr)) {
+        char *eq = strchr(token, '=');
+        int64_t value = 0;
+        if (!eq || rollup_parse_duration(eq + 1, &value) != BDIX_SUCCESS) {
+            ret = BDIX_ERROR_INVALID_INPUT;
+            break;
+        }
+        *eq = '\0';
+
+        if (strcmp(token, "raw") == 0) {
+            parsed.raw_retention_ms = value;
+            continue;
+        }
+
+        ret = BDIX_ERROR_INVALID_INPUT;
+        for (int t = 0; t < ROLLUP_TIER_COUNT; t++) {
+            if (strcmp(token, g_tier_names[t]) == 0) {
+                parsed.retention_ms[t] = value;
+                ret = BDIX_SUCCESS;
+            }
+        }
+    }
+
+    free(copy);
+    if (ret == BDIX_SUCCESS) {
+        *config = parsed;
+    }
+    return ret;
+}
+
+/* ---------- Chunk files ---------- */
+
+/**
+ * @brief Build a chunk file path
+ */
+static void chunk_path(const RollupTierStore *tier, int64_t start_ms, char *path, size_t size) {
+    snprintf(path, size, "%s/" ROLLUP_CHUNK_PREFIX "%lld" ROLLUP_CHUNK_SUFFIX, // flawfinder: ignore
+             tier->dir, (long long)start_ms);
+}
+
+/**
+ * @brief Unmap and close a chunk
+ */
+static void chunk_release(RollupChunk *chunk) {
+    if (chunk->map) {
+        munmap(chunk->map, chunk->map_size);
+    }
+    if (chunk->fd >= 0) {
+        close(chunk->fd);
+    }
+    free(chunk->blocks);
+    memset(chunk, 0, sizeof(*chunk));
+    chunk->fd = -1;
+}
+
+/**
+ * @brief (Re)map a chunk file at its current size
+ */
+static int chunk_remap(RollupChunk *chunk, size_t size) {
+    if (chunk->map) {
+        munmap(chunk->map, chunk->map_size);
+        chunk->map = NULL;
+    }
+
+    void *map = mmap(NULL, size, PROT_READ, MAP_SHARED, chunk->fd, 0);
+    if (map == MAP_FAILED) {
+        LOG_ERROR("Failed to map rollup chunk: %s", strerror(errno));
+        return BDIX_ERROR;
+    }
+
+    chunk->map = map;
+    chunk->map_size = size;
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Record a block location in a chunk
+ */
+static void chunk_push_block(RollupChunk *chunk, int64_t start_ms, size_t offset, uint32_t count) {
+    if (chunk->block_count >= chunk->block_capacity) {
+        chunk->block_capacity = chunk->block_capacity ? chunk->block_capacity * 2
+                                                      : ROLLUP_INITIAL_BLOCKS;
+        chunk->blocks = safe_realloc(chunk->blocks, chunk->block_capacity * sizeof(RollupBlock));
+    }
+    chunk->blocks[chunk->block_count++] = (RollupBlock){
+        .start_ms = start_ms,
+        .offset = offset,
+        .count = count
+    };
+}
+
+/**
+ * @brief Open a chunk file, map it and index its blocks
+ *
+ * A trailing partially written block (interrupted append) is ignored,
+ * and truncated away when the chunk is writable.
+ */
+static int chunk_open(const RollupTierStore *tier, RollupTier t, int64_t start_ms, bool writable,
+                      RollupChunk *chunk) {
+    char path[MAX_PATH_LENGTH + SMALL_BUFFER]; /* flawfinder: ignore - bounds checked with snprintf */
+    chunk_path(tier, start_ms, path, sizeof(path));
+
+    memset(chunk, 0, sizeof(*chunk));
+    chunk->start_ms = start_ms;
+    chunk->fd = open(path, writable ? O_RDWR : O_RDONLY); // flawfinder: ignore
+    if (chunk->fd < 0) {
+        LOG_ERROR("Failed to open rollup chunk %s: %s", path, strerror(errno));
+        return BDIX_ERROR_FILE_NOT_FOUND;
+    }
+
+    struct stat st;
+    if (fstat(chunk->fd, &st) != 0 || (size_t)st.st_size < sizeof(RollupFileHeader) ||
+        chunk_remap(chunk, (size_t)st.st_size) != BDIX_SUCCESS) {
+        LOG_WARN("Ignoring unreadable rollup chunk %s", path);
+        chunk_release(chunk);
+        return BDIX_ERROR;
+    }
+
+    RollupFileHeader header;
+    memcpy(&header, chunk->map, sizeof(header));
+    if (memcmp(header.magic, ROLLUP_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != ROLLUP_FORMAT_VERSION || header.record_size != sizeof(RollupRecord) ||
+        header.tier != (uint32_t)t || header.period_ms != tier->period_ms) {
+        LOG_WARN("Ignoring invalid rollup chunk %s", path);
+        chunk_release(chunk);
+        return BDIX_ERROR;
+    }
+
+    size_t offset = sizeof(RollupFileHeader);
+    while (offset + sizeof(RollupBlockHeader) <= chunk->map_size) {
+        RollupBlockHeader block;
+        memcpy(&block, chunk->map + offset, sizeof(block));
+        size_t need = sizeof(block) + (size_t)block.count * sizeof(RollupRecord);
+        if (offset + need > chunk->map_size) {
+            break;
+        }
+        chunk_push_block(chunk, block.start_ms, offset + sizeof(block), block.count);
+        offset += need;
+    }
+
+    if (offset != chunk->map_size) {
+        LOG_WARN("Rollup chunk %s ends with a partial block", path);
+        if (writable && ftruncate(chunk->fd, (off_t)offset) == 0) {
+            chunk_remap(chunk, offset);
+        }
+    }
+
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Create an empty chunk file holding only its header
+ */
+static int chunk_create(const RollupTierStore *tier, RollupTier t, int64_t start_ms,
+                        RollupChunk *chunk) {
+    char path[MAX_PATH_LENGTH + SMALL_BUFFER]; /* flawfinder: ignore - bounds checked with snprintf */
+    chunk_path(tier, start_ms, path, sizeof(path));
+
+    memset(chunk, 0, sizeof(*chunk));
+    chunk->start_ms = start_ms;
+    chunk->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644); // flawfinder: ignore
+    if (chunk->fd < 0) {
+        LOG_ERROR("Failed to create rollup chunk %s: %s", path, strerror(errno));
+        return BDIX_ERROR;
+    }
+
+    RollupFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ROLLUP_MAGIC, sizeof(header.magic));
+    header.version = ROLLUP_FORMAT_VERSION;
+    header.record_size = sizeof(RollupRecord);
+    header.tier = (uint32_t)t;
+    header.period_ms = tier->period_ms;
+    header.chunk_start_ms = start_ms;
+
+    if (pwrite(chunk->fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        chunk_remap(chunk, sizeof(header)) != BDIX_SUCCESS) {
+        LOG_ERROR("Failed to initialize rollup chunk %s", path);
+        chunk_release(chunk);
+        unlink(path);
+        return BDIX_ERROR;
+    }
+
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Append a chunk to a tier
+ */
+static void tier_push_chunk(RollupTierStore *tier, const RollupChunk *chunk) {
+    if (tier->chunk_count >= tier->chunk_capacity) {
+        tier->chunk_capacity = tier->chunk_capacity ? tier->chunk_capacity * 2
+                                                    : ROLLUP_INITIAL_CHUNKS;
+        tier->chunks = safe_realloc(tier->chunks, tier->chunk_capacity * sizeof(RollupChunk));
+    }
+    tier->chunks[tier->chunk_count++] = *chunk;
+}
+
+/**
+ * @brief qsort comparator for chunk start times
+ */
+static int compare_start(const void *a, const void *b) {
+    int64_t x = *(const int64_t*)a;
+    int64_t y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Open all chunk files of a tier, oldest first
+ */
+static void tier_load(RollupTierStore *tier, RollupTier t, bool writable) {
+    DIR *d = opendir(tier->dir);
+    if (!d) {
+        return;
+    }
+
+    int64_t *starts = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        long long start;
+        char suffix[8]; /* flawfinder: ignore - width limited in sscanf */
+        if (sscanf(entry->d_name, ROLLUP_CHUNK_PREFIX "%lld%7s", &start, suffix) != 2 || // flawfinder: ignore
+            strcmp(suffix, ROLLUP_CHUNK_SUFFIX) != 0) {
+            continue;
+        }
+        if (count >= capacity) {
+            capacity = capacity ? capacity * 2 : ROLLUP_INITIAL_CHUNKS;
+            starts = safe_realloc(starts, capacity * sizeof(int64_t));
+        }
+        starts[count++] = (int64_t)start;
+    }
+    closedir(d);
+
+    if (count > 1) {
+        qsort(starts, count, sizeof(int64_t), compare_start);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        RollupChunk chunk;
+        if (chunk_open(tier, t, starts[i], writable, &chunk) == BDIX_SUCCESS) {
+            tier_push_chunk(tier, &chunk);
+        }
+    }
+    free(starts);
+
+    // The watermark is the end of the newest block
+    for (size_t c = tier->chunk_count; c-- > 0;) {
+        const RollupChunk *chunk = &tier->chunks[c];
+        if (chunk->block_count > 0) {
+            tier->watermark_ms = chunk->blocks[chunk->block_count - 1].start_ms + tier->period_ms;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Append one period's records (sorted by server id) to a tier
+ */
+static int tier_append_block(RollupStore *store, RollupTier t, int64_t start_ms,
+                             const RollupRecord *records, uint32_t count) {
+    RollupTierStore *tier = &store->tiers[t];
+    int64_t chunk_start = floor_to(start_ms, tier->chunk_ms);
+    int ret = BDIX_SUCCESS;
+
+    pthread_rwlock_wrlock(&store->lock);
+
+    RollupChunk *chunk = tier->chunk_count > 0 ? &tier->chunks[tier->chunk_count - 1] : NULL;
+    if (!chunk || chunk->start_ms != chunk_start) {
+        RollupChunk created;
+        if (chunk_create(tier, t, chunk_start, &created) != BDIX_SUCCESS) {
+            pthread_rwlock_unlock(&store->lock);
+            return BDIX_ERROR;
+        }
+        tier_push_chunk(tier, &created);
+        chunk = &tier->chunks[tier->chunk_count - 1];
+    }
+
+    RollupBlockHeader header = { .start_ms = start_ms, .count = count, .reserved = 0 };
+    size_t offset = chunk->map_size;
+    size_t bytes = (size_t)count * sizeof(RollupRecord);
+
+    if (pwrite(chunk->fd, &header, sizeof(header), (off_t)offset) != (ssize_t)sizeof(header) ||
+        (bytes > 0 && pwrite(chunk->fd, records, bytes,
+                             (off_t)(offset + sizeof(header))) != (ssize_t)bytes) ||
+        chunk_remap(chunk, offset + sizeof(header) + bytes) != BDIX_SUCCESS) {
+        LOG_ERROR("Failed to append %s rollup block: %s", g_tier_names[t], strerror(errno));
+        ret = BDIX_ERROR;
+    } else {
+        chunk_push_block(chunk, start_ms, offset + sizeof(header), count);
+        tier->watermark_ms = start_ms + tier->period_ms;
+        atomic_fetch_add(&store->records_written, count);
+    }
+
+    pthread_rwlock_unlock(&store->lock);
+    return ret;
+}
+
+/* ---------- Store lifecycle ---------- */
+
+/**
+ * @brief Open (or create) the rollup tiers inside a history directory
+ */
+RollupStore* rollup_open(const char *dir, HistoryStore *history, const RollupConfig *config) {
+    /* flawfinder: ignore - dir is null checked and null-terminated */
+    if (!dir || !config || strlen(dir) == 0 || strlen(dir) >= MAX_PATH_LENGTH - 32 ||
+        config->grace_ms < 0 || config->interval_ms <= 0) {
+        LOG_ERROR("Invalid rollup configuration");
+        return NULL;
+    }
+
+    RollupStore *store = safe_calloc(1, sizeof(RollupStore));
+    store->config = *config;
+    store->history = history;
+    atomic_store(&store->shutdown, false);
+    atomic_store(&store->passes, 0);
+    atomic_store(&store->records_written, 0);
+
+    if (pthread_rwlock_init(&store->lock, NULL) != 0) {
+        LOG_ERROR("Failed to initialize rollup lock");
+        free(store);
+        return NULL;
+    }
+
+    for (int t = 0; t < ROLLUP_TIER_COUNT; t++) {
+        RollupTierStore *tier = &store->tiers[t];
+        tier->period_ms = g_tier_period_ms[t];
+        tier->chunk_ms = g_tier_chunk_ms[t];
+        snprintf(tier->dir, sizeof(tier->dir), "%s/rollup-%s", dir, g_tier_names[t]); // flawfinder: ignore
+
+        if (!config->read_only && mkdir(tier->dir, 0755) != 0 && errno != EEXIST) {
+            LOG_ERROR("Failed to create rollup directory %s: %s", tier->dir, strerror(errno));
+            rollup_close(store);
+            return NULL;
+        }
+
+        tier_load(tier, (RollupTier)t, !config->read_only);
+    }
+
+    return store;
+}
+
+/**
+ * @brief Stop compaction, unmap all chunks and free the store
+ */
+void rollup_close(RollupStore *store) {
+    if (!store) {
+        return;
+    }
+
+    rollup_stop(store);
+
+    for (int t = 0; t < ROLLUP_TIER_COUNT; t++) {
+        RollupTierStore *tier = &store->tiers[t];
+        for (size_t c = 0; c < tier->chunk_count; c++) {
+            chunk_release(&tier->chunks[c]);
+        }
+        free(tier->chunks);
+    }
+
+    pthread_rwlock_destroy(&store->lock);
+    free(store);
+}
+
+/* ---------- Compaction ---------- */
+
+/**
+ * @brief Open-addressing table of aggregates keyed by (server id, period)
+ */
+typedef struct {
+    RollupRecord *entries;          // count == 0 marks an empty slot
+    size_t capacity;
+    size_t used;
+    int64_t period_ms;
+} AggTable;
+
+/**
+ * @brief Hash of an aggregate key
+ */
+static size_t agg_hash(uint64_t id, int64_t start_ms) {
+    uint64_t h = id ^ ((uint64_t)start_ms * 0x9E3779B97F4A7C15ULL);
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return (size_t)h;
+}
+
+/**
+ * @brief Find a slot for a key in an entry array
+ */
+static RollupRecord* agg_slot(RollupRecord *entries, size_t capacity, uint64_t id, int64_t start_ms) {
+    size_t mask = capacity - 1;
+    size_t i = agg_hash(id, start_ms) & mask;
+    while (entries[i].count != 0 &&
+           (entries[i].server_id != id || entries[i].start_ms != start_ms)) {
+        i = (i + 1) & mask;
+    }
+    return &entries[i];
+}
+
+/**
+ * @brief Get (or create) the aggregate for a server and timestamp
+ */
+static RollupRecord* agg_get(AggTable *table, uint64_t id, int64_t ts) {
+    int64_t start = floor_to(ts, table->period_ms);
+
+    if ((table->used + 1) * 2 > table->capacity) {
+        size_t new_capacity = table->capacity * 2;
+        RollupRecord *entries = safe_calloc(new_capacity, sizeof(RollupRecord));
+        for (size_t i = 0; i < table->capacity; i++) {
+            if (table->entries[i].count != 0) {
+                *agg_slot(entries, new_capacity, table->entries[i].server_id,
+                          table->entries[i].start_ms) = table->entries[i];
+            }
+        }
+        free(table->entries);
+        table->entries = entries;
+        table->capacity = new_capacity;
+    }
+
+    RollupRecord *slot = agg_slot(table->entries, table->capacity, id, start);
+    if (slot->count == 0) {
+        memset(slot, 0, sizeof(*slot));
+        slot->server_id = id;
+        slot->start_ms = start;
+        table->used++;
+    }
+    return slot;
+}
+
+/**
+ * @brief history_scan() visitor folding raw records into minute aggregates
+ */
+static bool agg_visit_raw(const HistoryRecord *record, void *ctx) {
+    AggTable *table = ctx;
+    rollup_record_add(agg_get(table, record->server_id, record->timestamp_ms),
+                      (ServerStatus)record->status, record->latency_ms);
+    return true;
+}
+
+/**
+ * @brief Fold a finer tier's blocks in [from_ms, to_ms) into the table
+ */
+static void agg_fold_tier(const RollupTierStore *tier, int64_t from_ms, int64_t to_ms,
+                          AggTable *table) {
+    for (size_t c = 0; c < tier->chunk_count; c++) {
+        const RollupChunk *chunk = &tier->chunks[c];
+        if (chunk->start_ms >= to_ms || chunk->start_ms + tier->chunk_ms <= from_ms) {
+            continue;
+        }
+        for (size_t b = 0; b < chunk->block_count; b++) {
+            const RollupBlock *block = &chunk->blocks[b];
+            if (block->start_ms < from_ms || block->start_ms >= to_ms) {
+                continue;
+            }
+            const RollupRecord *records = (const RollupRecord*)(chunk->map + block->offset);
+            for (uint32_t i = 0; i < block->count; i++) {
+                RollupRecord *dst = agg_get(table, records[i].server_id, records[i].start_ms);
+                rollup_record_merge(dst, &records[i]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief qsort comparator ordering aggregates by period, then server id
+ */
+static int compare_aggregate(const void *a, const void *b) {
+    const RollupRecord *x = a;
+    const RollupRecord *y = b;
+    if (x->start_ms != y->start_ms) {
+        return (x->start_ms > y->start_ms) - (x->start_ms < y->start_ms);
+    }
+    return (x->server_id > y->server_id) - (x->server_id < y->server_id);
+}
+
+/**
+ * @brief Oldest timestamp available as compaction input for a tier
+ */
+static bool tier_source_oldest(RollupStore *store, RollupTier t, int64_t *oldest_ms) {
+    if (t == ROLLUP_TIER_MINUTE) {
+        return store->history && history_oldest(store->history, oldest_ms);
+    }
+
+    const RollupTierStore *lower = &store->tiers[t - 1];
+    for (size_t c = 0; c < lower->chunk_count; c++) {
+        if (lower->chunks[c].block_count > 0) {
+            *oldest_ms = lower->chunks[c].blocks[0].start_ms;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Compact the closed periods of one tier
+ */
+static int compact_tier(RollupStore *store, RollupTier t, int64_t now_ms) {
+    RollupTierStore *tier = &store->tiers[t];
+    int64_t period = tier->period_ms;
+
+    int64_t start = tier->watermark_ms;
+    if (start == 0) {
+        int64_t oldest;
+        if (!tier_source_oldest(store, t, &oldest)) {
+            return BDIX_SUCCESS;
+        }
+        start = floor_to(oldest, period);
+    }
+
+    // A period is closed once its source has moved past it
+    int64_t end;
+    if (t == ROLLUP_TIER_MINUTE) {
+        end = floor_to(now_ms - store->config.grace_ms, period);
+    } else {
+        int64_t lower = store->tiers[t - 1].watermark_ms;
+        if (lower == 0) {
+            return BDIX_SUCCESS;
+        }
+        end = floor_to(lower, period);
+    }
+    end = MIN(end, start + ROLLUP_MAX_PERIODS_PER_PASS * period);
+    if (end <= start) {
+        return BDIX_SUCCESS;
+    }
+
+    AggTable table = {
+        .entries = safe_calloc(ROLLUP_INITIAL_AGG, sizeof(RollupRecord)),
+        .capacity = ROLLUP_INITIAL_AGG,
+        .used = 0,
+        .period_ms = period
+    };
+
+    // Only this thread appends, so the finer tier can be read without the lock
+    if (t == ROLLUP_TIER_MINUTE) {
+        history_scan(store->history, start, end, agg_visit_raw, &table);
+    } else {
+        agg_fold_tier(&store->tiers[t - 1], start, end, &table);
+    }
+
+    // Compact the table into a sorted array in place
+    size_t n = 0;
+    for (size_t i = 0; i < table.capacity; i++) {
+        if (table.entries[i].count != 0) {
+            table.entries[n++] = table.entries[i];
+        }
+    }
+    qsort(table.entries, n, sizeof(RollupRecord), compare_aggregate);
+
+    int ret = BDIX_SUCCESS;
+    int64_t last_written = INT64_MIN;
+    for (size_t i = 0; i < n && ret == BDIX_SUCCESS;) {
+        size_t j = i;
+        while (j < n && table.entries[j].start_ms == table.entries[i].start_ms) {
+            j++;
+        }
+        ret = tier_append_block(store, t, table.entries[i].start_ms,
+                                &table.entries[i], (uint32_t)(j - i));
+        last_written = table.entries[i].start_ms;
+        i = j;
+    }
+
+    // An empty block marks the end of the pass so idle periods are not rescanned
+    if (ret == BDIX_SUCCESS && last_written != end - period) {
+        ret = tier_append_block(store, t, end - period, NULL, 0);
+    }
+
+    LOG_DEBUG("Compacted %s rollups up to %lld (%zu records)",
+              g_tier_names[t], (long long)end, n);
+
+    free(table.entries);
+    return ret;
+}
+
+/**
+ * @brief Delete chunks and raw segments past their retention
+ */
+static void apply_retention(RollupStore *store, int64_t now_ms) {
+    pthread_rwlock_wrlock(&store->lock);
+
+    for (int t = 0; t < ROLLUP_TIER_COUNT; t++) {
+        RollupTierStore *tier = &store->tiers[t];
+        int64_t cutoff = now_ms - store->config.retention_ms[t];
+        size_t removed = 0;
+
+        // Keep the newest chunk so the watermark survives
+        while (removed + 1 < tier->chunk_count &&
+               tier->chunks[removed].start_ms + tier->chunk_ms <= cutoff) {
+            char path[MAX_PATH_LENGTH + SMALL_BUFFER]; /* flawfinder: ignore - bounds checked with snprintf */
+            chunk_path(tier, tier->chunks[removed].start_ms, path, sizeof(path));
+            chunk_release(&tier->chunks[removed]);
+            unlink(path);
+            removed++;
+        }
+
+        if (removed > 0) {
+            memmove(tier->chunks, tier->chunks + removed,
+                    (tier->chunk_count - removed) * sizeof(RollupChunk));
+            tier->chunk_count -= removed;
+            LOG_DEBUG("Removed %zu expired %s rollup chunks", removed, g_tier_names[t]);
+        }
+    }
+
+    int64_t compacted = store->tiers[ROLLUP_TIER_MINUTE].watermark_ms;
+    pthread_rwlock_unlock(&store->lock);
+
+    // Raw history is only dropped once it is covered by minute rollups
+    if (store->history && compacted > 0) {
+        history_prune(store->history, MIN(now_ms - store->config.raw_retention_ms, compacted));
+    }
+}
+
+/**
+ * @brief Run one compaction and retention pass
+ */
+int rollup_compact(RollupStore *store, int64_t now_ms) {
+    if (!store) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+    if (store->config.read_only) {
+        return BDIX_ERROR;
+    }
+
+    int ret = BDIX_SUCCESS;
+    for (int t = 0; t < ROLLUP_TIER_COUNT; t++) {
+        if (compact_tier(store, (RollupTier)t, now_ms) != BDIX_SUCCESS) {
+            ret = BDIX_ERROR;
+        }
+    }
+
+    apply_retention(store, now_ms);
+    atomic_fetch_add(&store->passes, 1);
+    return ret;
+}
+
+/**
+ * @brief Background compaction loop
+ */
+static void* compactor_thread(void *arg) {
+    RollupStore *store = arg;
+
+    while (!atomic_load(&store->shutdown)) {
+        rollup_compact(store, history_now_ms());
+
+        double wake = get_time_ms() + store->config.interval_ms;
+        while (!atomic_load(&store->shutdown) && get_time_ms() < wake) {
+            sleep_ms(ROLLUP_POLL_INTERVAL_MS);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Start background compaction every interval_ms
+ */
+int rollup_start(RollupStore *store) {
+    if (!store || store->config.read_only) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+    if (store->thread_running) {
+        return BDIX_SUCCESS;
+    }
+
+    atomic_store(&store->shutdown, false);
+    if (pthread_create(&store->thread, NULL, compactor_thread, store) != 0) {
+        LOG_ERROR("Failed to start rollup compactor");
+        return BDIX_ERROR_THREAD;
+    }
+
+    store->thread_running = true;
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Stop background compaction (idempotent)
+ */
+void rollup_stop(RollupStore *store) {
+    if (!store || !store->thread_running) {
+        return;
+    }
+
+    atomic_store(&store->shutdown, true);
+    pthread_join(store->thread, NULL);
+    store->thread_running = false;
+}
+
+/* ---------- Queries ---------- */
+
+/**
+ * @brief Merge a server's records of a tier for blocks in [from_ms, to_ms)
+ */
+static void tier_sum(const RollupTierStore *tier, uint64_t id, int64_t from_ms, int64_t to_ms,
+                     RollupAggregate *out) {
+    for (size_t c = 0; c < tier->chunk_count; c++) {
+        const RollupChunk *chunk = &tier->chunks[c];
+        if (chunk->start_ms >= to_ms || chunk->start_ms + tier->chunk_ms <= from_ms) {
+            continue;
+        }
+        for (size_t b = 0; b < chunk->block_count; b++) {
+            const RollupBlock *block = &chunk->blocks[b];
+            if (block->start_ms < from_ms || block->start_ms >= to_ms) {
+                continue;
+            }
+
+            // Records are sorted by server id within a block
+            const RollupRecord *records = (const RollupRecord*)(chunk->map + block->offset);
+            size_t lo = 0;
+            size_t hi = block->count;
+            while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (records[mid].server_id < id) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            if (lo < block->count && records[lo].server_id == id) {
+                rollup_aggregate_merge(out, &records[lo]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief history_query() visitor adding raw records to an aggregate
+ */
+static bool aggregate_visit_raw(const HistoryRecord *record, void *ctx) {
+    rollup_aggregate_add(ctx, (ServerStatus)record->status, record->latency_ms);
+    return true;
+}
+
+/**
+ * @brief Cover [from_ms, to_ms) with tier t and finer tiers (lock held)
+ */
+static void aggregate_range(RollupStore *store, int t, uint64_t id, int64_t from_ms,
+                            int64_t to_ms, RollupAggregate *out) {
+    if (from_ms >= to_ms) {
+        return;
+    }
+
+    if (t < 0) {
+        if (store->history) {
+            history_query(store->history, id, from_ms, to_ms - 1, aggregate_visit_raw, out);
+        }
+        return;
+    }
+
+    const RollupTierStore *tier = &store->tiers[t];
+    int64_t inner_from = ceil_to(from_ms, tier->period_ms);
+    int64_t inner_to = MIN(floor_to(to_ms, tier->period_ms), tier->watermark_ms);
+
+    if (tier->watermark_ms == 0 || inner_from >= inner_to) {
+        aggregate_range(store, t - 1, id, from_ms, to_ms, out);
+        return;
+    }
+
+    tier_sum(tier, id, inner_from, inner_to, out);
+    aggregate_range(store, t - 1, id, from_ms, inner_from, out);
+    aggregate_range(store, t - 1, id, inner_to, to_ms, out);
+}
+
+/**
+ * @brief Aggregate a server's checks over [from_ms, to_ms)
+ */
+int rollup_aggregate(RollupStore *store, uint64_t server_id, int64_t from_ms, int64_t to_ms,
+                     RollupAggregate *out) {
+    if (!store || !out || from_ms > to_ms) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->server_id = server_id;
+    out->start_ms = from_ms;
+
+    pthread_rwlock_rdlock(&store->lock);
+    aggregate_range(store, ROLLUP_TIER_COUNT - 1, server_id, from_ms, to_ms, out);
+    pthread_rwlock_unlock(&store->lock);
+
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Print rollup counters
+ */
+/* flawfinder: ignore - all printf calls below use compile-time constant format strings */
+void rollup_print_stats(const RollupStore *store) {
+    if (!store) {
+        return;
+    }
+
+    printf("Rollups: %zu passes, %zu records written (chunks: 1m %zu, 1h %zu, 1d %zu)\n", // flawfinder: ignore
+           atomic_load(&store->passes), atomic_load(&store->records_written),
+           store->tiers[ROLLUP_TIER_MINUTE].chunk_count,
+           store->tiers[ROLLUP_TIER_HOUR].chunk_count,
+           store->tiers[ROLLUP_TIER_DAY].chunk_count);
+}
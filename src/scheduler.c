@@ -0,0 +1,270 @@
+/**
+ * @file scheduler.c
+ * @brief Adaptive per-server check scheduling implementation
+ * @version 1.0.0
+ */
+
+#include "scheduler.h"
+
+// Longest single sleep so stop requests are noticed promptly
+#define SCHED_POLL_INTERVAL_MS 250
+
+// Stop flag set from signal handlers
+static _Atomic bool g_stop_requested = false;
+
+/**
+ * @brief Get default scheduler configuration
+ */
+SchedulerConfig scheduler_get_default_config(void) {
+    return (SchedulerConfig){
+        .min_interval_s = SCHED_DEFAULT_MIN_INTERVAL,
+        .base_interval_s = SCHED_DEFAULT_BASE_INTERVAL,
+        .max_interval_s = SCHED_DEFAULT_MAX_INTERVAL,
+        .growth_factor = 1.5,
+        .shrink_factor = 4.0,
+        .latency_tolerance = 0.5,
+        .min_excursion_ms = 20.0,
+        .stable_threshold = 2
+    };
+}
+
+/**
+ * @brief Validate scheduler configuration bounds
+ */
+bool scheduler_config_validate(const SchedulerConfig *config) {
+    if (!config) {
+        return false;
+    }
+
+    if (config->min_interval_s <= 0.0 || config->max_interval_s < config->min_interval_s) {
+        LOG_WARN("Invalid scheduler bounds: min=%.1fs max=%.1fs",
+                 config->min_interval_s, config->max_interval_s);
+        return false;
+    }
+
+    if (config->growth_factor < 1.0 || config->shrink_factor < 1.0) {
+        LOG_WARN("Scheduler growth and shrink factors must be >= 1.0");
+        return false;
+    }
+
+    return config->latency_tolerance >= 0.0 && config->min_excursion_ms >= 0.0;
+}
+
+/**
+ * @brief Clamp an interval to the configured bounds
+ */
+static double clamp_interval(double interval_s, const SchedulerConfig *config) {
+    if (interval_s < config->min_interval_s) {
+        return config->min_interval_s;
+    }
+    if (interval_s > config->max_interval_s) {
+        return config->max_interval_s;
+    }
+    return interval_s;
+}
+
+/**
+ * @brief Reset a server's schedule so it is due immediately
+ */
+void scheduler_reset_server(Server *server, const SchedulerConfig *config) {
+    if (!server || !config) {
+        return;
+    }
+
+    server->schedule = (ServerSchedule){
+        .interval_s = clamp_interval(config->base_interval_s, config),
+        .next_check_ms = 0.0,
+        .stable_checks = 0
+    };
+}
+
+/**
+ * @brief Adapt a server's interval after a check completed
+ */
+void scheduler_on_result(Server *server, ServerStatus prev_status, double prev_latency_ms,
+                         const SchedulerConfig *config, double now_ms) {
+    if (!server || !config) {
+        return;
+    }
+
+    ServerSchedule *sched = &server->schedule;
+    double interval = sched->interval_s > 0.0 ? sched->interval_s : config->base_interval_s;
+
+    // Only up/down flips count: ERROR <-> TIMEOUT on a dead server is no change
+    bool changed = prev_status != BDIX_STATUS_UNKNOWN &&
+                   (prev_status == BDIX_STATUS_ONLINE) != (server->status == BDIX_STATUS_ONLINE);
+
+    bool excursion = false;
+    if (!changed && server->status == BDIX_STATUS_ONLINE &&
+        prev_latency_ms > 0.0 && server->latency_ms >= 0.0) {
+        double delta = fabs(server->latency_ms - prev_latency_ms);
+        excursion = delta > config->min_excursion_ms &&
+                    delta > prev_latency_ms * config->latency_tolerance;
+    }
+
+    if (changed) {
+        interval = config->min_interval_s;
+        sched->stable_checks = 0;
+    } else if (excursion) {
+        interval /= config->shrink_factor;
+        sched->stable_checks = 0;
+    } else if (prev_status != BDIX_STATUS_UNKNOWN) {
+        sched->stable_checks++;
+        if (sched->stable_checks >= config->stable_threshold) {
+            interval *= config->growth_factor;
+        }
+    }
+
+    sched->interval_s = clamp_interval(interval, config);
+    sched->next_check_ms = now_ms + sched->interval_s * 1000.0;
+
+    LOG_DEBUG("Scheduled %s in %.1fs (changed=%d, excursion=%d, stable=%u)",
+              server->url, sched->interval_s, changed, excursion, sched->stable_checks);
+}
+
+/**
+ * @brief Check whether a server is due for a check
+ */
+bool scheduler_is_due(const Server *server, double now_ms) {
+    if (!server) {
+        return false;
+    }
+
+    return server->schedule.next_check_ms <= now_ms;
+}
+
+/**
+ * @brief Request the monitoring loop to stop
+ */
+void scheduler_stop(void) {
+    atomic_store(&g_stop_requested, true);
+}
+
+/**
+ * @brief Check one category's due servers and reschedule them
+ *
+ * @return Earliest next due time among the category's servers
+ */
+static double run_due_servers(ServerCategory *category, const CheckerConfig *checker_config,
+                              const SchedulerConfig *config, int thread_count,
+                              CheckerStats *stats, size_t *due, ServerStatus *prev_status,
+                              double *prev_latency) {
+    double now = get_time_ms();
+    size_t due_count = 0;
+
+    for (size_t i = 0; i < category->count; i++) {
+        Server *server = &category->servers[i];
+        if (scheduler_is_due(server, now)) {
+            due[due_count] = i;
+            prev_status[due_count] = server->status;
+            prev_latency[due_count] = server->latency_ms;
+            due_count++;
+        }
+    }
+
+    if (due_count > 0) {
+        LOG_DEBUG("Checking %zu due servers in '%s'", due_count, category->name);
+        checker_check_servers(category, due, due_count, checker_config, thread_count, stats);
+
+        double done = get_time_ms();
+        for (size_t i = 0; i < due_count; i++) {
+            scheduler_on_result(&category->servers[due[i]], prev_status[i],
+                                prev_latency[i], config, done);
+        }
+    }
+
+    double next_due = INFINITY;
+    for (size_t i = 0; i < category->count; i++) {
+        next_due = MIN(next_due, category->servers[i].schedule.next_check_ms);
+    }
+    return next_due;
+}
+
+/**
+ * @brief Run continuous monitoring until scheduler_stop() is called
+ */
+int scheduler_run(ServerData *data, const CheckerConfig *checker_config,
+                  const SchedulerConfig *config, int thread_count,
+                  bool check_ftp, bool check_tv, bool check_others,
+                  CheckerStats *stats) {
+    if (!data || !checker_config || !config) {
+        LOG_ERROR("Invalid parameters for scheduler run");
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    if (!scheduler_config_validate(config)) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    ServerCategory *categories[CATEGORY_COUNT];
+    size_t category_count = 0;
+    size_t max_count = 0;
+
+    if (check_ftp) categories[category_count++] = &data->ftp;
+    if (check_tv) categories[category_count++] = &data->tv;
+    if (check_others) categories[category_count++] = &data->others;
+
+    for (size_t c = 0; c < category_count; c++) {
+        max_count = MAX(max_count, categories[c]->count);
+        for (size_t i = 0; i < categories[c]->count; i++) {
+            scheduler_reset_server(&categories[c]->servers[i], config);
+        }
+    }
+
+    if (max_count == 0) {
+        LOG_INFO("No servers to monitor");
+        return BDIX_SUCCESS;
+    }
+
+    // Scratch buffers reused across rounds
+    size_t *due = safe_calloc(max_count, sizeof(size_t));
+    ServerStatus *prev_status = safe_calloc(max_count, sizeof(ServerStatus));
+    double *prev_latency = safe_calloc(max_count, sizeof(double));
+
+    // One curl pool for every round instead of one per due batch
+    CheckerConfig round_config = *checker_config;
+    ThreadPool *pool = NULL;
+    if (checker_config->engine != CHECK_ENGINE_TCP && !checker_config->pool) {
+        pool = checker_create_pool(checker_config, thread_count, stats);
+        if (!pool) {
+            LOG_ERROR("Failed to create thread pool");
+            free(due);
+            free(prev_status);
+            free(prev_latency);
+            return BDIX_ERROR_THREAD;
+        }
+        round_config.pool = pool;
+    }
+
+    LOG_INFO("Monitoring with adaptive intervals (%.0fs - %.0fs)",
+             config->min_interval_s, config->max_interval_s);
+
+    atomic_store(&g_stop_requested, false);
+
+    while (!atomic_load(&g_stop_requested)) {
+        double next_due = INFINITY;
+
+        for (size_t c = 0; c < category_count && !atomic_load(&g_stop_requested); c++) {
+            double category_due = run_due_servers(categories[c], &round_config, config,
+                                                  thread_count, stats, due,
+                                                  prev_status, prev_latency);
+            next_due = MIN(next_due, category_due);
+        }
+
+        // Sleep until the next server is due, waking periodically for stop requests
+        double wait_ms = next_due - get_time_ms();
+        while (wait_ms > 0.0 && !atomic_load(&g_stop_requested)) {
+            long chunk = (long)MIN(wait_ms, (double)SCHED_POLL_INTERVAL_MS);
+            sleep_ms(MAX(chunk, 1L));
+            wait_ms = next_due - get_time_ms();
+        }
+    }
+
+    thread_pool_destroy(pool);
+    free(due);
+    free(prev_status);
+    free(prev_latency);
+
+    LOG_INFO("Monitoring stopped");
+    return BDIX_SUCCESS;
+}
@@ -33,6 +33,7 @@ const char* server_status_name(ServerStatus status) {
         case BDIX_STATUS_OFFLINE: return "OFFLINE";
         case BDIX_STATUS_TIMEOUT: return "TIMEOUT";
         case BDIX_STATUS_ERROR:   return "ERROR";
+        case BDIX_STATUS_CUTOFF:  return "CUTOFF";
         default:                  return "INVALID";
     }
 }
@@ -142,6 +143,10 @@ int server_category_add(ServerCategory *category, const char *url) {
     server->latency_ms = -1.0;
     server->response_code = 0;
     server->last_checked = 0;
+    server->timing = (ServerTiming){0};
+    server->schedule = (ServerSchedule){0};
+    server->transition = (ServerTransition){0};
+    server->metrics = (ServerMetrics){0};
 
     category->count++;
 
@@ -179,10 +184,123 @@ void server_update_status(Server *server, ServerStatus status,
     server->response_code = response_code;
     server->last_checked = time(NULL);
 
+    server_metrics_record(server);
+
     LOG_DEBUG("Updated server %s: status=%s, latency=%.2fms, code=%ld",
               server->url, server_status_name(status), latency_ms, response_code);
 }
 
+/**
+ * @brief Record the server's current status and latency as a new sample
+ */
+void server_metrics_record(Server *server) {
+    if (!server || server->status == BDIX_STATUS_UNKNOWN) {
+        return;
+    }
+
+    ServerMetrics *m = &server->metrics;
+    bool up = server->status == BDIX_STATUS_ONLINE;
+
+    // Evict the oldest sample once the ring is full
+    if (m->count == SERVER_SAMPLE_RING) {
+        if (m->samples[m->head].status == BDIX_STATUS_ONLINE) {
+            m->up_count--;
+        }
+    } else {
+        m->count++;
+    }
+
+    m->samples[m->head] = (ServerSample){
+        .latency_ms = (float)server->latency_ms,
+        .status = server->status
+    };
+    m->head = (m->head + 1) % SERVER_SAMPLE_RING;
+
+    if (!up) {
+        return;
+    }
+    m->up_count++;
+
+    double latency = server->latency_ms;
+    if (!m->has_latency) {
+        m->ewma_latency_ms = latency;
+        m->has_latency = true;
+    } else {
+        double delta = fabs(latency - m->last_up_latency_ms);
+        m->ewma_latency_ms += SERVER_EWMA_ALPHA * (latency - m->ewma_latency_ms);
+        m->jitter_ms += SERVER_JITTER_GAIN * (delta - m->jitter_ms);
+    }
+    m->last_up_latency_ms = latency;
+}
+
+/**
+ * @brief Rolling uptime over the samples in the ring
+ */
+double server_uptime_pct(const Server *server) {
+    if (!server || server->metrics.count == 0) {
+        return -1.0;
+    }
+
+    return 100.0 * server->metrics.up_count / server->metrics.count;
+}
+
+/**
+ * @brief Latency quantile over the ONLINE samples in the ring
+ */
+double server_latency_quantile(const Server *server, double q) {
+    if (!server || server->metrics.up_count == 0) {
+        return -1.0;
+    }
+
+    // Insertion sort: the ring holds at most SERVER_SAMPLE_RING samples
+    const ServerMetrics *m = &server->metrics;
+    float sorted[SERVER_SAMPLE_RING];
+    unsigned n = 0;
+    for (unsigned i = 0; i < m->count; i++) {
+        if (m->samples[i].status != BDIX_STATUS_ONLINE) {
+            continue;
+        }
+        float value = m->samples[i].latency_ms;
+        unsigned j = n++;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+
+    q = q < 0.0 ? 0.0 : (q > 1.0 ? 1.0 : q);
+    unsigned rank = (unsigned)ceil(q * n);
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+/**
+ * @brief Find the online server with the lowest EWMA latency among stable ones
+ */
+const Server* server_data_fastest_stable(const ServerData *data, double min_uptime_pct) {
+    if (!data) {
+        return NULL;
+    }
+
+    const ServerCategory *categories[] = { &data->ftp, &data->tv, &data->others };
+    const Server *best = NULL;
+
+    for (size_t c = 0; c < ARRAY_SIZE(categories); c++) {
+        for (size_t i = 0; i < categories[c]->count; i++) {
+            const Server *s = &categories[c]->servers[i];
+            if (s->status != BDIX_STATUS_ONLINE || !s->metrics.has_latency ||
+                server_uptime_pct(s) < min_uptime_pct) {
+                continue;
+            }
+            if (!best || s->metrics.ewma_latency_ms < best->metrics.ewma_latency_ms) {
+                best = s;
+            }
+        }
+    }
+
+    return best;
+}
+
 /**
  * @brief Initialize server data structure
  */
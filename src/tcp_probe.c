@@ -0,0 +1,1084 @@
+/**
+ * @file tcp_probe.c
+ * @brief TCP connect reachability sweep from a single thread
+ * @version 1.0.0
+ */
+
+#include "common.h"
+#include "tcp_probe.h"
+#include "cancel.h"
+#include "rate_limit.h"
+#include "thread_pool.h"
+#include "trace.h"
+#include "uring.h"
+#include <curl/curl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+/**
+ * @brief One server's host:port, for sorting
+ */
+typedef struct {
+    char host[MEDIUM_BUFFER]; /* flawfinder: ignore - bounds checked in rate_limiter_extract_host */
+    int port;
+    size_t server;
+    size_t target;                  // Index of the shared host:port target
+} TcpEntry;
+
+/**
+ * @brief One distinct host:port and its connection attempt
+ */
+typedef struct {
+    const char *host;
+    int port;
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    bool resolved;
+    double dns_ms;
+    int fd;                         // Open while the connect is in flight
+    double start_ms;
+    size_t first;                   // Range of entries (servers) sharing this target
+    size_t last;
+} TcpTarget;
+
+/**
+ * @brief Name lookup job for the resolver pool
+ */
+typedef struct {
+    TcpTarget *target;
+    const struct curl_slist *pins;
+} TcpResolveJob;
+
+/**
+ * @brief Sweep state
+ */
+typedef struct {
+    Server *const *servers;
+    const TcpEntry *entries;
+    TcpTarget *targets;
+    size_t count;                   // Targets
+    size_t done;
+    TcpProbeCallback on_result;
+    void *ctx;
+    CancelToken *cancel;
+} TcpSweep;
+
+/**
+ * @brief Operations of an io_uring probe chain, tagged in the low byte of user_data
+ */
+typedef enum {
+    URING_OP_CONNECT,
+    URING_OP_CONNECT_TIMEOUT,
+    URING_OP_SEND,
+    URING_OP_RECV,
+    URING_OP_RECV_TIMEOUT,
+    URING_OP_CLOSE
+} UringOp;
+
+#define URING_CONNECT_CHAIN 2       // CONNECT -> LINK_TIMEOUT
+#define URING_HTTP_CHAIN 5          // ... -> WRITE_FIXED -> READ_FIXED -> LINK_TIMEOUT
+#define URING_SLOT_SIZE (TCP_PROBE_REQUEST_MAX + TCP_PROBE_RESPONSE_MAX)
+
+/**
+ * @brief One io_uring probe: a connect to a target, or a HEAD request for one server
+ */
+typedef struct {
+    size_t target;
+    size_t entry;                   // Server entry in HTTP mode
+    int fd;
+    unsigned slot;                  // Registered buffer slot in HTTP mode
+    int pending;                    // CQEs of the chain still to come
+    double start_ms;
+    double connect_ms;              // Completion times, relative to start_ms
+    double sent_ms;
+    double done_ms;
+    int connect_res;
+    int send_res;
+    int recv_res;
+    size_t received;                // Status line bytes read so far
+    struct __kernel_timespec recv_timeout; // What is left of the response deadline
+} UringJob;
+
+/**
+ * @brief io_uring sweep state
+ */
+typedef struct {
+    TcpSweep *sweep;
+    TcpProbeMode mode;
+    UringRing *ring;
+    size_t limit;                   // Probes in flight
+    UringJob *jobs;
+    size_t job_count;
+    uint8_t *buffers;               // limit slots of URING_SLOT_SIZE, registered as buffer 0
+    unsigned *free_slots;
+    size_t free_count;
+    size_t closes_pending;
+    bool cancelled;                 // Results are dropped once set
+    struct __kernel_timespec connect_timeout;
+    struct __kernel_timespec response_timeout;
+    int response_timeout_ms;
+} UringSweep;
+
+/**
+ * @brief Get default TCP sweep configuration
+ */
+TcpProbeConfig tcp_probe_get_default_config(void) {
+    return (TcpProbeConfig){
+        .timeout_ms = HTTP_CONNECT_TIMEOUT * 1000,
+        .response_timeout_ms = HTTP_TIMEOUT_SECONDS * 1000,
+        .max_in_flight = 0,
+        .resolver_threads = DEFAULT_THREADS,
+        .resolve = NULL,
+        .mode = TCP_PROBE_CONNECT,
+        .io_uring = false,
+        .cancel = NULL
+    };
+}
+
+/**
+ * @brief Check whether a URL can be probed in TCP_PROBE_HTTP_HEAD mode
+ */
+bool tcp_probe_supports_http(const char *url) {
+    return url && strncasecmp(url, "http://", 7) == 0;
+}
+
+/**
+ * @brief Parse the port of a URL, defaulting by scheme
+ */
+int tcp_probe_url_port(const char *url) {
+    if (!url) {
+        return 80;
+    }
+
+    const char *start = strstr(url, "://");
+    int port = 80;
+    if (start) {
+        size_t scheme_len = (size_t)(start - url);
+        if (scheme_len == 5 && strncasecmp(url, "https", 5) == 0) {
+            port = 443;
+        } else if (scheme_len == 3 && strncasecmp(url, "ftp", 3) == 0) {
+            port = 21;
+        }
+        start += 3;
+    } else {
+        start = url;
+    }
+
+    // Port follows the host, after an optional userinfo and IPv6 brackets
+    const char *authority_end = start + strcspn(start, "/?#");
+    const char *at = memchr(start, '@', (size_t)(authority_end - start));
+    if (at) {
+        start = at + 1;
+    }
+    if (*start == '[') {
+        const char *bracket = memchr(start, ']', (size_t)(authority_end - start));
+        start = bracket ? bracket + 1 : authority_end;
+    }
+    const char *colon = memchr(start, ':', (size_t)(authority_end - start));
+    if (colon && colon + 1 < authority_end) {
+        char *endptr;
+        long val = strtol(colon + 1, &endptr, 10);
+        if (endptr == authority_end && val > 0 && val <= 65535) {
+            port = (int)val;
+        }
+    }
+    return port;
+}
+
+/**
+ * @brief Resolve a numeric or named host into the target's address
+ */
+static bool lookup_address(TcpTarget *target, const char *host, int flags) {
+    char service[16]; /* flawfinder: ignore - bounds checked with snprintf */
+    snprintf(service, sizeof(service), "%d", target->port); // flawfinder: ignore
+
+    struct addrinfo hints;
+    struct addrinfo *result = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = flags;
+
+    if (getaddrinfo(host, service, &hints, &result) != 0 || !result) {
+        return false;
+    }
+    bool ok = result->ai_addrlen <= sizeof(target->addr);
+    if (ok) {
+        memcpy(&target->addr, result->ai_addr, result->ai_addrlen);
+        target->addr_len = result->ai_addrlen;
+    }
+    freeaddrinfo(result);
+    return ok;
+}
+
+/**
+ * @brief Use a "host:port:address[,address...]" pin if one matches the target
+ */
+static bool apply_pin(TcpTarget *target, const struct curl_slist *pins) {
+    for (const struct curl_slist *pin = pins; pin; pin = pin->next) {
+        const char *entry = pin->data;
+        if (!entry || *entry == '-') {
+            continue;  // Removal entries
+        }
+        if (*entry == '+') {
+            entry++;
+        }
+
+        const char *port_start = strchr(entry, ':');
+        const char *addr_start = port_start ? strchr(port_start + 1, ':') : NULL;
+        if (!addr_start) {
+            continue;
+        }
+        size_t host_len = (size_t)(port_start - entry);
+        bool host_match = (host_len == 1 && *entry == '*') ||
+                          (host_len == strlen(target->host) && /* flawfinder: ignore - host is null-terminated */
+                           strncasecmp(entry, target->host, host_len) == 0);
+        if (!host_match || atoi(port_start + 1) != target->port) {
+            continue;
+        }
+
+        // First address, without IPv6 brackets
+        char address[SMALL_BUFFER]; /* flawfinder: ignore - bounds checked below */
+        const char *a = addr_start + 1;
+        size_t len = strcspn(a, ",");
+        if (*a == '[' && len >= 2 && a[len - 1] == ']') {
+            a++;
+            len -= 2;
+        }
+        if (len == 0 || len >= sizeof(address)) {
+            continue;
+        }
+        memcpy(address, a, len);
+        address[len] = '\0';
+        return lookup_address(target, address, AI_NUMERICHOST);
+    }
+    return false;
+}
+
+/**
+ * @brief Thread pool worker: resolve one target
+ */
+static void* resolve_worker(void *arg) {
+    TcpResolveJob *job = (TcpResolveJob*)arg;
+    TcpTarget *target = job->target;
+
+    double start = get_time_ms();
+    target->resolved = apply_pin(target, job->pins) ||
+                       lookup_address(target, target->host, 0);
+    target->dns_ms = get_time_ms() - start;
+    if (!target->resolved) {
+        LOG_DEBUG("TCP probe could not resolve %s", target->host);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Resolve every target, in parallel when more than one thread is allowed
+ */
+static void resolve_targets(TcpTarget *targets, size_t count, const TcpProbeConfig *config) {
+    TcpResolveJob *jobs = safe_malloc(count * sizeof(TcpResolveJob));
+    for (size_t i = 0; i < count; i++) {
+        jobs[i] = (TcpResolveJob){ .target = &targets[i], .pins = config->resolve };
+    }
+
+    int threads = config->resolver_threads;
+    ThreadPool *pool = NULL;
+    if (threads > 1 && count > 1) {
+        pool = thread_pool_create((size_t)threads < count ? (size_t)threads : count);
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!pool || thread_pool_add_work(pool, resolve_worker, &jobs[i]) != BDIX_SUCCESS) {
+            resolve_worker(&jobs[i]);
+        }
+    }
+    if (pool) {
+        thread_pool_wait(pool);
+        thread_pool_destroy(pool);
+    }
+    free(jobs);
+}
+
+/**
+ * @brief Number of connects to keep in flight, raising the descriptor limit if allowed
+ */
+static size_t in_flight_limit(const TcpProbeConfig *config, size_t count) {
+    size_t limit = config->max_in_flight;
+    struct rlimit rl;
+    if (limit == 0 && getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+        rlim_t wanted = (rlim_t)count + TCP_PROBE_FD_RESERVE;
+        if (rl.rlim_cur != RLIM_INFINITY && rl.rlim_cur < wanted && rl.rlim_max > rl.rlim_cur) {
+            struct rlimit raised = {
+                .rlim_cur = rl.rlim_max == RLIM_INFINITY || rl.rlim_max > wanted ? wanted : rl.rlim_max,
+                .rlim_max = rl.rlim_max
+            };
+            if (setrlimit(RLIMIT_NOFILE, &raised) == 0) {
+                rl.rlim_cur = raised.rlim_cur;
+            }
+        }
+        if (rl.rlim_cur == RLIM_INFINITY) {
+            limit = count;
+        } else if (rl.rlim_cur > 2 * TCP_PROBE_FD_RESERVE) {
+            limit = (size_t)(rl.rlim_cur - TCP_PROBE_FD_RESERVE);
+        } else {
+            limit = TCP_PROBE_FD_RESERVE;
+        }
+    } else if (limit == 0) {
+        limit = TCP_PROBE_MAX_EVENTS;
+    }
+    return limit < count ? limit : count;
+}
+
+/**
+ * @brief Make close() send a reset instead of FIN: no TIME_WAIT on either side
+ */
+static void set_abort_close(int fd) {
+    struct linger abort_close = { .l_onoff = 1, .l_linger = 0 };
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &abort_close, sizeof(abort_close));
+}
+
+/**
+ * @brief Record a result on one server and report it
+ */
+static void report_server(TcpSweep *sweep, Server *server, ServerStatus status, double latency_ms,
+                          const ServerTiming *timing, long response_code) {
+    server->timing = *timing;
+    server_update_status(server, status, latency_ms, response_code);
+    if (sweep->on_result) {
+        sweep->on_result(server, sweep->ctx);
+    }
+}
+
+/**
+ * @brief Record a connect result on all servers of a target
+ */
+static void report_target(TcpSweep *sweep, const TcpTarget *target, ServerStatus status, double elapsed_ms) {
+    ServerTiming timing = { .dns_ms = target->dns_ms };
+    if (status == BDIX_STATUS_ONLINE) {
+        timing.connect_ms = elapsed_ms;
+        timing.total_ms = elapsed_ms;
+    }
+    for (size_t e = target->first; e <= target->last; e++) {
+        report_server(sweep, sweep->servers[sweep->entries[e].server], status, elapsed_ms, &timing, 0);
+    }
+}
+
+/**
+ * @brief Close a target's socket and record its result on all of its servers
+ */
+static void finish_target(TcpSweep *sweep, TcpTarget *target, ServerStatus status, double elapsed_ms) {
+    if (target->fd >= 0) {
+        set_abort_close(target->fd);
+        close(target->fd);
+        target->fd = -1;
+    }
+    report_target(sweep, target, status, elapsed_ms);
+    sweep->done++;
+}
+
+/**
+ * @brief Start a non-blocking connect
+ *
+ * @return true if the connect is in flight, false if it already finished
+ */
+static bool start_connect(TcpSweep *sweep, TcpTarget *target, int epoll_fd, size_t index) {
+    if (!target->resolved) {
+        finish_target(sweep, target, BDIX_STATUS_ERROR, 0.0);
+        return false;
+    }
+
+    target->start_ms = get_time_ms();
+    target->fd = socket(target->addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (target->fd < 0) {
+        LOG_WARN("TCP probe socket failed: %s", strerror(errno));
+        finish_target(sweep, target, BDIX_STATUS_ERROR, 0.0);
+        return false;
+    }
+
+    if (connect(target->fd, (const struct sockaddr*)&target->addr, target->addr_len) == 0) {
+        finish_target(sweep, target, BDIX_STATUS_ONLINE, get_time_ms() - target->start_ms);
+        return false;
+    }
+    if (errno != EINPROGRESS) {
+        ServerStatus status = errno == ECONNREFUSED ? BDIX_STATUS_OFFLINE : BDIX_STATUS_ERROR;
+        finish_target(sweep, target, status, get_time_ms() - target->start_ms);
+        return false;
+    }
+
+    struct epoll_event event = { .events = EPOLLOUT, .data.u64 = index };
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, target->fd, &event) != 0) {
+        finish_target(sweep, target, BDIX_STATUS_ERROR, 0.0);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Connect to every target, keeping up to limit connects in flight
+ *
+ * Targets are started in index order with the same timeout, so the oldest
+ * one still in flight always has the earliest deadline.
+ */
+static int run_sweep(TcpSweep *sweep, size_t limit, int timeout_ms) {
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        LOG_ERROR("Failed to create epoll instance: %s", strerror(errno));
+        return BDIX_ERROR_NETWORK;
+    }
+
+    struct epoll_event events[TCP_PROBE_MAX_EVENTS];
+    size_t next = 0;
+    size_t oldest = 0;
+    size_t in_flight = 0;
+    int ret = BDIX_SUCCESS;
+
+    while (sweep->done < sweep->count && !cancel_token_check(sweep->cancel)) {
+        while (in_flight < limit && next < sweep->count) {
+            if (start_connect(sweep, &sweep->targets[next], epoll_fd, next)) {
+                in_flight++;
+            }
+            next++;
+        }
+
+        // Expire connects past their deadline
+        double now = get_time_ms();
+        while (oldest < next) {
+            TcpTarget *target = &sweep->targets[oldest];
+            if (target->fd >= 0) {
+                if (now - target->start_ms < timeout_ms) {
+                    break;
+                }
+                finish_target(sweep, target, BDIX_STATUS_TIMEOUT, now - target->start_ms);
+                in_flight--;
+            }
+            oldest++;
+        }
+        if (in_flight == 0) {
+            continue;
+        }
+
+        double deadline = sweep->targets[oldest].start_ms + timeout_ms;
+        int wait_ms = cancel_token_wait_ms(sweep->cancel, deadline > now ? (int)(deadline - now) + 1 : 0);
+        int ready = epoll_wait(epoll_fd, events, TCP_PROBE_MAX_EVENTS, wait_ms);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("TCP probe epoll_wait failed: %s", strerror(errno));
+            ret = BDIX_ERROR_NETWORK;
+            break;
+        }
+
+        now = get_time_ms();
+        for (int i = 0; i < ready; i++) {
+            TcpTarget *target = &sweep->targets[events[i].data.u64];
+            if (target->fd < 0) {
+                continue;
+            }
+            int error = 0;
+            socklen_t len = sizeof(error);
+            getsockopt(target->fd, SOL_SOCKET, SO_ERROR, &error, &len);
+
+            ServerStatus status;
+            if (error == 0) {
+                status = BDIX_STATUS_ONLINE;
+            } else if (error == ECONNREFUSED) {
+                status = BDIX_STATUS_OFFLINE;
+            } else if (error == ETIMEDOUT) {
+                status = BDIX_STATUS_TIMEOUT;
+            } else {
+                status = BDIX_STATUS_ERROR;
+                LOG_DEBUG("TCP connect to %s:%d failed: %s", target->host, target->port, strerror(error));
+            }
+            finish_target(sweep, target, status, now - target->start_ms);
+            in_flight--;
+        }
+    }
+
+    // Only reached early on epoll failure or cancellation, which leaves servers untouched
+    bool cancelled = ret == BDIX_SUCCESS;
+    for (size_t i = 0; i < sweep->count; i++) {
+        TcpTarget *target = &sweep->targets[i];
+        if (target->fd >= 0 && cancelled) {
+            set_abort_close(target->fd);
+            close(target->fd);
+            target->fd = -1;
+        } else if (target->fd >= 0) {
+            finish_target(sweep, target, BDIX_STATUS_ERROR, 0.0);
+        }
+    }
+    close(epoll_fd);
+    return ret;
+}
+
+/**
+ * @brief Write "HEAD <path> HTTP/1.1" for a plain HTTP URL into buf
+ *
+ * @return Request length, or 0 if the URL is not http:// or does not fit
+ */
+static size_t format_head_request(const char *url, char *buf, size_t size) {
+    if (!tcp_probe_supports_http(url)) {
+        return 0;
+    }
+    const char *authority = url + 7;
+    size_t authority_len = strcspn(authority, "/?#");
+    const char *path = authority + authority_len;
+    size_t path_len = strcspn(path, "#");
+
+    // Host header carries no userinfo
+    const char *at = memchr(authority, '@', authority_len);
+    if (at) {
+        authority_len -= (size_t)(at + 1 - authority);
+        authority = at + 1;
+    }
+    if (authority_len == 0) {
+        return 0;
+    }
+
+    int len = snprintf(buf, size, "HEAD %s%.*s HTTP/1.1\r\nHost: %.*s\r\nConnection: close\r\n\r\n", // flawfinder: ignore
+                       path_len == 0 || *path == '?' ? "/" : "", (int)path_len, path,
+                       (int)authority_len, authority);
+    return len > 0 && (size_t)len < size ? (size_t)len : 0;
+}
+
+/**
+ * @brief Status code of an "HTTP/x.y NNN ..." status line, 0 if malformed
+ */
+static long parse_status_code(const char *response, size_t len) {
+    if (len < 12 || strncmp(response, "HTTP/", 5) != 0) {
+        return 0;
+    }
+    const char *space = memchr(response, ' ', len);
+    if (!space || (size_t)(space - response) + 4 > len) {
+        return 0;
+    }
+    long code = 0;
+    for (int i = 1; i <= 3; i++) {
+        if (!isdigit((unsigned char)space[i])) {
+            return 0;
+        }
+        code = code * 10 + (space[i] - '0');
+    }
+    return code;
+}
+
+static void uring_prep(struct io_uring_sqe *sqe, uint8_t opcode, int fd, const void *addr,
+                       uint32_t len, uint64_t off, size_t job, UringOp op) {
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)addr;
+    sqe->len = len;
+    sqe->off = off;
+    sqe->user_data = ((uint64_t)job << 8) | (uint64_t)op;
+}
+
+/**
+ * @brief Make room for count SQEs, submitting what is queued if needed
+ *
+ * @return false if the submission queue stays full
+ */
+static bool uring_reserve(UringSweep *us, unsigned count) {
+    if (uring_sq_space(us->ring) < count) {
+        uring_submit(us->ring, 0);
+    }
+    return uring_sq_space(us->ring) >= count;
+}
+
+/**
+ * @brief Queue a close for a finished probe's socket
+ */
+static void uring_close(UringSweep *us, int fd) {
+    if (!uring_reserve(us, 1)) {
+        close(fd);
+        return;
+    }
+    struct io_uring_sqe *sqe = uring_get_sqe(us->ring);
+    uring_prep(sqe, IORING_OP_CLOSE, fd, NULL, 0, 0, 0, URING_OP_CLOSE);
+    us->closes_pending++;
+}
+
+/**
+ * @brief Classify a finished probe, record it and release its socket and slot
+ */
+static void uring_finish_job(UringSweep *us, UringJob *job) {
+    TcpSweep *sweep = us->sweep;
+    const TcpTarget *target = &sweep->targets[job->target];
+
+    ServerStatus status;
+    long response_code = 0;
+    if (!target->resolved || job->fd < 0) {
+        status = BDIX_STATUS_ERROR;
+    } else if (job->connect_res < 0) {
+        int error = -job->connect_res;
+        if (error == ECANCELED || error == ETIMEDOUT) {
+            status = BDIX_STATUS_TIMEOUT;
+        } else if (error == ECONNREFUSED && us->mode == TCP_PROBE_CONNECT) {
+            status = BDIX_STATUS_OFFLINE;
+        } else {
+            status = BDIX_STATUS_ERROR;
+            LOG_DEBUG("TCP connect to %s:%d failed: %s", target->host, target->port, strerror(error));
+        }
+    } else if (us->mode == TCP_PROBE_CONNECT) {
+        status = BDIX_STATUS_ONLINE;
+    } else if (job->send_res < 0) {
+        status = BDIX_STATUS_ERROR;
+    } else if (job->recv_res == -ECANCELED) {
+        status = BDIX_STATUS_TIMEOUT;
+    } else {
+        const char *response = (const char*)us->buffers + (size_t)job->slot * URING_SLOT_SIZE +
+                               TCP_PROBE_REQUEST_MAX;
+        response_code = job->recv_res > 0 ? parse_status_code(response, (size_t)job->recv_res) : 0;
+        if (response_code == 0) {
+            status = BDIX_STATUS_ERROR;
+        } else if (response_code >= 200 && response_code < 400) {
+            status = BDIX_STATUS_ONLINE;
+        } else {
+            status = BDIX_STATUS_OFFLINE;
+        }
+    }
+
+    if (us->cancelled) {
+        if (us->mode == TCP_PROBE_HTTP_HEAD) {
+            us->free_slots[us->free_count++] = job->slot;
+        }
+    } else if (us->mode == TCP_PROBE_CONNECT) {
+        double elapsed = job->fd < 0 ? 0.0 : job->connect_ms;
+        report_target(sweep, target, status, elapsed);
+    } else {
+        ServerTiming timing = { .dns_ms = target->dns_ms };
+        double elapsed = job->fd < 0 ? 0.0 : job->done_ms;
+        if (job->connect_res >= 0 && job->fd >= 0) {
+            timing.connect_ms = job->connect_ms;
+            if (job->send_res >= 0 && job->recv_res > 0) {
+                timing.server_ms = job->done_ms - job->sent_ms;
+                timing.total_ms = job->done_ms;
+            }
+        }
+        Server *server = sweep->servers[sweep->entries[job->entry].server];
+        report_server(sweep, server, status, elapsed, &timing, response_code);
+        us->free_slots[us->free_count++] = job->slot;
+    }
+
+    if (job->fd >= 0) {
+        uring_close(us, job->fd);
+        job->fd = -1;
+    }
+}
+
+/**
+ * @brief Open a socket and queue the probe's linked chain
+ *
+ * @return true if the probe is in flight, false if it already finished
+ */
+static bool uring_start_job(UringSweep *us, size_t index) {
+    UringJob *job = &us->jobs[index];
+    TcpTarget *target = &us->sweep->targets[job->target];
+    bool http = us->mode == TCP_PROBE_HTTP_HEAD;
+
+    if (http) {
+        job->slot = us->free_slots[--us->free_count];
+    }
+    if (!target->resolved) {
+        uring_finish_job(us, job);
+        return false;
+    }
+
+    size_t request_len = 0;
+    uint8_t *slot = us->buffers ? us->buffers + (size_t)job->slot * URING_SLOT_SIZE : NULL;
+    if (http) {
+        Server *server = us->sweep->servers[us->sweep->entries[job->entry].server];
+        request_len = format_head_request(server->url, (char*)slot, TCP_PROBE_REQUEST_MAX);
+        if (request_len == 0) {
+            LOG_DEBUG("Cannot build a HEAD request for %s", server->url);
+            uring_finish_job(us, job);
+            return false;
+        }
+    }
+
+    // Blocking socket: io_uring polls it itself when an operation cannot complete
+    job->fd = socket(target->addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (job->fd < 0) {
+        LOG_WARN("TCP probe socket failed: %s", strerror(errno));
+        uring_finish_job(us, job);
+        return false;
+    }
+    set_abort_close(job->fd);
+
+    // Keep each chain within one submission; with the space reserved every SQE below is there
+    int chain = http ? URING_HTTP_CHAIN : URING_CONNECT_CHAIN;
+    if (!uring_reserve(us, (unsigned)chain)) {
+        LOG_WARN("io_uring submission queue stayed full, probe of %s:%d failed",
+                 target->host, target->port);
+        job->connect_res = -EBUSY;
+        uring_finish_job(us, job);
+        return false;
+    }
+
+    job->start_ms = get_time_ms();
+    job->pending = chain;
+    struct io_uring_sqe *sqe = uring_get_sqe(us->ring);
+    uring_prep(sqe, IORING_OP_CONNECT, job->fd, &target->addr, 0, target->addr_len, index, URING_OP_CONNECT);
+    sqe->flags = IOSQE_IO_LINK;
+
+    sqe = uring_get_sqe(us->ring);
+    uring_prep(sqe, IORING_OP_LINK_TIMEOUT, -1, &us->connect_timeout, 1, 0, index, URING_OP_CONNECT_TIMEOUT);
+    if (!http) {
+        return true;
+    }
+    sqe->flags = IOSQE_IO_LINK;
+
+    sqe = uring_get_sqe(us->ring);
+    uring_prep(sqe, IORING_OP_WRITE_FIXED, job->fd, slot, (uint32_t)request_len, 0, index, URING_OP_SEND);
+    sqe->flags = IOSQE_IO_LINK;
+
+    sqe = uring_get_sqe(us->ring);
+    uring_prep(sqe, IORING_OP_READ_FIXED, job->fd, slot + TCP_PROBE_REQUEST_MAX,
+               TCP_PROBE_RESPONSE_MAX - 1, 0, index, URING_OP_RECV);
+    sqe->flags = IOSQE_IO_LINK;
+
+    sqe = uring_get_sqe(us->ring);
+    uring_prep(sqe, IORING_OP_LINK_TIMEOUT, -1, &us->response_timeout, 1, 0, index, URING_OP_RECV_TIMEOUT);
+    return true;
+}
+
+/**
+ * @brief Queue another read when a probe has only part of the status line
+ *
+ * The read gets what is left of the response deadline as its linked timeout.
+ *
+ * @return true if a read was queued
+ */
+static bool uring_continue_read(UringSweep *us, UringJob *job, size_t index) {
+    uint8_t *response = us->buffers + (size_t)job->slot * URING_SLOT_SIZE + TCP_PROBE_REQUEST_MAX;
+    if (us->cancelled || job->received >= TCP_PROBE_RESPONSE_MAX - 1 ||
+        memchr(response, '\n', job->received)) {
+        return false;
+    }
+
+    double left_ms = us->response_timeout_ms - (job->done_ms - job->sent_ms);
+    long long left_ns = left_ms > 1.0 ? (long long)(left_ms * 1000000.0) : 1000000LL;
+    job->recv_timeout.tv_sec = left_ns / 1000000000LL;
+    job->recv_timeout.tv_nsec = left_ns % 1000000000LL;
+
+    if (!uring_reserve(us, 2)) {
+        LOG_DEBUG("io_uring submission queue stayed full, status line left partial");
+        return false;
+    }
+    struct io_uring_sqe *sqe = uring_get_sqe(us->ring);
+    uring_prep(sqe, IORING_OP_READ_FIXED, job->fd, response + job->received,
+               (uint32_t)(TCP_PROBE_RESPONSE_MAX - 1 - job->received), 0, index, URING_OP_RECV);
+    sqe->flags = IOSQE_IO_LINK;
+
+    sqe = uring_get_sqe(us->ring);
+    uring_prep(sqe, IORING_OP_LINK_TIMEOUT, -1, &job->recv_timeout, 1, 0, index, URING_OP_RECV_TIMEOUT);
+    job->pending += 2;
+    return true;
+}
+
+/**
+ * @brief Record one completion; finishes the probe once its whole chain is done
+ *
+ * @return true if a probe finished
+ */
+static bool uring_complete(UringSweep *us, const struct io_uring_cqe *cqe) {
+    UringOp op = (UringOp)(cqe->user_data & 0xff);
+    if (op == URING_OP_CLOSE) {
+        us->closes_pending--;
+        return false;
+    }
+
+    size_t index = (size_t)(cqe->user_data >> 8);
+    UringJob *job = &us->jobs[index];
+    double elapsed = get_time_ms() - job->start_ms;
+    switch (op) {
+        case URING_OP_CONNECT:
+            job->connect_res = cqe->res;
+            job->connect_ms = elapsed;
+            break;
+        case URING_OP_SEND:
+            job->send_res = cqe->res;
+            job->sent_ms = elapsed;
+            break;
+        case URING_OP_RECV:
+            job->done_ms = elapsed;
+            if (cqe->res > 0) {
+                // Status lines may arrive in pieces: read on until the line ends
+                job->received += (size_t)cqe->res;
+                job->recv_res = (int)job->received;
+                uring_continue_read(us, job, index);
+            } else {
+                job->recv_res = cqe->res == 0 && job->received > 0 ? (int)job->received : cqe->res;
+            }
+            break;
+        default:
+            break;  // Linked timeouts: the operation they guard reports -ECANCELED
+    }
+    if (--job->pending > 0) {
+        return false;
+    }
+    uring_finish_job(us, job);
+    return true;
+}
+
+/**
+ * @brief Set up the ring, and registered buffers for HTTP probes
+ *
+ * @return BDIX_SUCCESS, or BDIX_ERROR_UNSUPPORTED before anything was probed
+ */
+static int uring_sweep_init(UringSweep *us, const TcpProbeConfig *config, size_t count) {
+    memset(us, 0, sizeof(*us));
+    us->mode = config->mode;
+    us->ring = uring_create(TCP_PROBE_URING_ENTRIES);
+    if (!us->ring) {
+        LOG_WARN("Failed to set up io_uring: %s", strerror(errno));
+        return BDIX_ERROR_UNSUPPORTED;
+    }
+
+    // Every probe in flight may have its chain plus a close outstanding
+    unsigned chain = config->mode == TCP_PROBE_HTTP_HEAD ? URING_HTTP_CHAIN : URING_CONNECT_CHAIN;
+    size_t cq_limit = uring_cq_entries(us->ring) / (chain + 1);
+    us->limit = in_flight_limit(config, count);
+    if (us->limit > cq_limit) {
+        us->limit = cq_limit;
+    }
+
+    us->connect_timeout.tv_sec = config->timeout_ms / 1000;
+    us->connect_timeout.tv_nsec = (long long)(config->timeout_ms % 1000) * 1000000;
+    us->response_timeout.tv_sec = config->response_timeout_ms / 1000;
+    us->response_timeout.tv_nsec = (long long)(config->response_timeout_ms % 1000) * 1000000;
+    us->response_timeout_ms = config->response_timeout_ms;
+
+    if (config->mode == TCP_PROBE_HTTP_HEAD) {
+        us->buffers = safe_malloc(us->limit * URING_SLOT_SIZE);
+        struct iovec region = { .iov_base = us->buffers, .iov_len = us->limit * URING_SLOT_SIZE };
+        if (uring_register_buffers(us->ring, &region, 1) != BDIX_SUCCESS) {
+            free(us->buffers);
+            uring_destroy(us->ring);
+            us->ring = NULL;
+            return BDIX_ERROR_UNSUPPORTED;
+        }
+        us->free_slots = safe_malloc(us->limit * sizeof(unsigned));
+        for (size_t i = 0; i < us->limit; i++) {
+            us->free_slots[i] = (unsigned)(us->limit - 1 - i);
+        }
+        us->free_count = us->limit;
+    }
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Stop reporting and make the probes in flight fail right away
+ */
+static void uring_cancel_jobs(UringSweep *us, size_t started) {
+    us->cancelled = true;
+    for (size_t i = 0; i < started; i++) {
+        if (us->jobs[i].pending > 0 && us->jobs[i].fd >= 0) {
+            shutdown(us->jobs[i].fd, SHUT_RDWR);
+        }
+    }
+}
+
+static void uring_sweep_cleanup(UringSweep *us) {
+    uring_destroy(us->ring);
+    free(us->buffers);
+    free(us->free_slots);
+    free(us->jobs);
+}
+
+/**
+ * @brief Run every probe through the ring, keeping up to limit chains in flight
+ *
+ * New chains and finished sockets' closes go out with the same
+ * io_uring_enter() that waits for the next completions.
+ */
+static int run_uring_sweep(UringSweep *us, TcpSweep *sweep, size_t entry_count) {
+    us->sweep = sweep;
+    us->job_count = us->mode == TCP_PROBE_HTTP_HEAD ? entry_count : sweep->count;
+    us->jobs = safe_calloc(us->job_count, sizeof(UringJob));
+    for (size_t i = 0; i < us->job_count; i++) {
+        us->jobs[i].fd = -1;
+        us->jobs[i].target = us->mode == TCP_PROBE_HTTP_HEAD ? sweep->entries[i].target : i;
+        us->jobs[i].entry = i;
+    }
+
+    size_t next = 0;
+    size_t finished = 0;
+    size_t in_flight = 0;
+    int ret = BDIX_SUCCESS;
+    while (finished < us->job_count) {
+        if (!us->cancelled && cancel_token_check(sweep->cancel)) {
+            uring_cancel_jobs(us, next);
+        }
+        while (!us->cancelled && in_flight < us->limit && next < us->job_count) {
+            if (uring_start_job(us, next)) {
+                in_flight++;
+            } else {
+                finished++;
+            }
+            next++;
+        }
+        if (in_flight == 0) {
+            if (us->cancelled) {
+                break;
+            }
+            continue;
+        }
+
+        int submitted = uring_submit_timeout(us->ring, 1, cancel_token_wait_ms(sweep->cancel, -1));
+        if (submitted < 0 && submitted != -EINTR && submitted != -EBUSY && submitted != -EAGAIN &&
+            submitted != -ETIME) {
+            LOG_ERROR("TCP probe io_uring_enter failed: %s", strerror(-submitted));
+            ret = BDIX_ERROR_NETWORK;
+            break;
+        }
+
+        struct io_uring_cqe cqe;
+        while (uring_peek_cqe(us->ring, &cqe)) {
+            if (uring_complete(us, &cqe)) {
+                finished++;
+                in_flight--;
+            }
+        }
+    }
+
+    // Wait for the last closes so no socket outlives the ring
+    while (ret == BDIX_SUCCESS && us->closes_pending > 0) {
+        int submitted = uring_submit(us->ring, 1);
+        if (submitted < 0 && submitted != -EINTR) {
+            break;
+        }
+        struct io_uring_cqe cqe;
+        while (uring_peek_cqe(us->ring, &cqe)) {
+            uring_complete(us, &cqe);
+        }
+    }
+
+    // Only reached early on io_uring failure
+    if (ret != BDIX_SUCCESS) {
+        uring_destroy(us->ring);
+        us->ring = NULL;
+        for (size_t i = 0; i < us->job_count; i++) {
+            UringJob *job = &us->jobs[i];
+            if (i >= next || job->pending > 0) {
+                if (job->fd >= 0) {
+                    close(job->fd);
+                    job->fd = -1;
+                }
+                if (us->mode == TCP_PROBE_HTTP_HEAD && i >= next) {
+                    // Earlier probes have returned their slots by now
+                    job->slot = us->free_slots[--us->free_count];
+                }
+                uring_finish_job(us, job);
+            }
+        }
+    }
+    return ret;
+}
+
+static int compare_entries(const void *a, const void *b) {
+    const TcpEntry *x = (const TcpEntry*)a;
+    const TcpEntry *y = (const TcpEntry*)b;
+    int cmp = strcmp(x->host, y->host);
+    return cmp != 0 ? cmp : (x->port > y->port) - (x->port < y->port);
+}
+
+/**
+ * @brief Connect to every server's host:port and record the result
+ */
+int tcp_probe_servers(Server *const *servers, size_t count, const TcpProbeConfig *config,
+                      TcpProbeCallback on_result, void *ctx) {
+    if (!servers || !config || config->timeout_ms <= 0 ||
+        (config->mode == TCP_PROBE_HTTP_HEAD && (!config->io_uring || config->response_timeout_ms <= 0))) {
+        LOG_ERROR("Invalid parameters for TCP probe");
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+    if (count == 0) {
+        return BDIX_SUCCESS;
+    }
+
+    // Set up the ring first: HTTP probes must fail before touching any server
+    UringSweep uring;
+    bool use_uring = false;
+    if (config->io_uring) {
+        int ret = uring_sweep_init(&uring, config, count);
+        if (ret != BDIX_SUCCESS && config->mode == TCP_PROBE_HTTP_HEAD) {
+            return ret;
+        }
+        use_uring = ret == BDIX_SUCCESS;
+        if (!use_uring) {
+            LOG_WARN("TCP sweep falls back to epoll");
+        }
+    }
+
+    uint64_t sweep_start = trace_begin();
+
+    // Sort by host:port so servers sharing one are connected to once
+    TcpEntry *entries = safe_malloc(count * sizeof(TcpEntry));
+    size_t valid = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (rate_limiter_extract_host(servers[i]->url, entries[valid].host,
+                                      sizeof(entries[valid].host)) == BDIX_SUCCESS) {
+            entries[valid].port = tcp_probe_url_port(servers[i]->url);
+            entries[valid].server = i;
+            valid++;
+        } else {
+            server_update_status(servers[i], BDIX_STATUS_ERROR, 0.0, 0);
+            if (on_result) {
+                on_result(servers[i], ctx);
+            }
+        }
+    }
+    qsort(entries, valid, sizeof(TcpEntry), compare_entries);
+
+    TcpTarget *targets = safe_calloc(valid > 0 ? valid : 1, sizeof(TcpTarget));
+    size_t unique = 0;
+    for (size_t i = 0; i < valid; i++) {
+        if (unique == 0 || compare_entries(&entries[targets[unique - 1].first], &entries[i]) != 0) {
+            targets[unique] = (TcpTarget){
+                .host = entries[i].host,
+                .port = entries[i].port,
+                .fd = -1,
+                .first = i
+            };
+            unique++;
+        }
+        targets[unique - 1].last = i;
+        entries[i].target = unique - 1;
+    }
+
+    int ret = BDIX_SUCCESS;
+    if (unique > 0) {
+        resolve_targets(targets, unique, config);
+
+        TcpSweep sweep = {
+            .servers = servers,
+            .entries = entries,
+            .targets = targets,
+            .count = unique,
+            .on_result = on_result,
+            .ctx = ctx,
+            .cancel = config->cancel
+        };
+        if (use_uring) {
+            LOG_DEBUG("io_uring %s sweep: %zu servers, %zu host:port targets, %zu in flight",
+                      config->mode == TCP_PROBE_HTTP_HEAD ? "HTTP" : "TCP", count, unique, uring.limit);
+            ret = run_uring_sweep(&uring, &sweep, valid);
+        } else {
+            size_t limit = in_flight_limit(config, unique);
+            LOG_DEBUG("TCP sweep: %zu servers, %zu host:port targets, %zu in flight",
+                      count, unique, limit);
+            ret = run_sweep(&sweep, limit, config->timeout_ms);
+        }
+    }
+
+    if (use_uring) {
+        uring_sweep_cleanup(&uring);
+    }
+    free(targets);
+    free(entries);
+    trace_end(TRACE_CAT_CHECK, use_uring ? "uring_sweep" : "tcp_sweep", sweep_start, NULL);
+    return ret;
+}
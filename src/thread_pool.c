@@ -5,17 +5,405 @@
  */
 
 #include "thread_pool.h"
+#include "trace.h"
+#include "metrics.h"
+
+/**
+ * @brief Convert a monotonic time in milliseconds to a timespec
+ */
+static struct timespec ms_to_timespec(double ms) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ms / 1000.0);
+    ts.tv_nsec = (long)((ms - (double)ts.tv_sec * 1000.0) * 1000000.0);
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    } else if (ts.tv_nsec < 0) {
+        ts.tv_nsec = 0;
+    }
+    return ts;
+}
+
+// Shared by all pools
+static Metric *g_metric_queue_depth = NULL;
+static Metric *g_metric_active = NULL;
+static Metric *g_metric_queue_wait = NULL;
+static Metric *g_metric_tasks = NULL;
+static Metric *g_metric_run = NULL;
+static Metric *g_metric_lock_contended = NULL;
+static pthread_once_t g_metrics_once = PTHREAD_ONCE_INIT;
+
+// Pool whose worker the current thread is, so it never blocks on its own bounded queue
+static _Thread_local ThreadPool *t_worker_pool = NULL;
+
+/**
+ * @brief Register the pool metrics (once, via g_metrics_once)
+ */
+static void register_metrics(void) {
+    g_metric_queue_depth = metrics_gauge("bdix_pool_queue_depth", "Work items queued or deferred in all pools");
+    g_metric_active = metrics_gauge("bdix_pool_active_workers", "Workers running a work item");
+    g_metric_queue_wait = metrics_histogram("bdix_pool_queue_wait_ms", "Time from run queue to worker");
+    g_metric_tasks = metrics_counter("bdix_pool_tasks_total", "Work items executed");
+    g_metric_run = metrics_histogram("bdix_pool_run_ms", "Time a worker spends on a work item");
+    g_metric_lock_contended = metrics_counter("bdix_pool_lock_contended_total",
+                                              "Queue mutex acquisitions that had to block");
+}
+
+/**
+ * @brief Record a duration in a histogram
+ */
+void thread_pool_histogram_add(ThreadPoolHistogram *hist, double ms) {
+    ms = MAX(ms, 0.0);
+    double us = ms * 1000.0;
+    size_t bucket = 0;
+    while (bucket < THREAD_POOL_HIST_BUCKETS - 1 && us >= (double)((uint64_t)1 << bucket)) {
+        bucket++;
+    }
+    hist->counts[bucket]++;
+    hist->count++;
+    hist->sum_ms += ms;
+    hist->max_ms = MAX(hist->max_ms, ms);
+}
+
+/**
+ * @brief Estimate a quantile from a histogram
+ */
+double thread_pool_histogram_quantile(const ThreadPoolHistogram *hist, double q) {
+    if (!hist || hist->count == 0) {
+        return 0.0;
+    }
+    double rank = MIN(MAX(q, 0.0), 1.0) * (double)hist->count;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < THREAD_POOL_HIST_BUCKETS; b++) {
+        if (hist->counts[b] == 0) {
+            continue;
+        }
+        if ((double)(seen + hist->counts[b]) >= rank) {
+            double lower_us = b > 0 ? (double)((uint64_t)1 << (b - 1)) : 0.0;
+            double upper_us = b < THREAD_POOL_HIST_BUCKETS - 1 ?
+                              (double)((uint64_t)1 << b) : hist->max_ms * 1000.0;
+            double fraction = (rank - (double)seen) / (double)hist->counts[b];
+            double us = lower_us + fraction * (MAX(upper_us, lower_us) - lower_us);
+            return MIN(us / 1000.0, hist->max_ms);
+        }
+        seen += hist->counts[b];
+    }
+    return hist->max_ms;
+}
+
+/**
+ * @brief Lock queue_mutex, counting the acquisitions that had to block
+ */
+static void lock_queue(ThreadPool *pool) {
+    if (pthread_mutex_trylock(&pool->queue_mutex) == 0) {
+        pool->lock_acquisitions++;
+        return;
+    }
+    double start_ms = get_time_ms();
+    pthread_mutex_lock(&pool->queue_mutex);
+    pool->lock_acquisitions++;
+    pool->lock_contended++;
+    thread_pool_histogram_add(&pool->lock_wait_hist, get_time_ms() - start_ms);
+    metrics_add(g_metric_lock_contended, 1);
+}
+
+/**
+ * @brief Submitted task with its result
+ */
+struct ThreadPoolTask {
+    ThreadPool *pool;
+    ThreadPoolGroup *group;         // Optional
+    thread_pool_func_t function;    // Set for submitted tasks
+    thread_pool_then_t then;        // Set for continuations
+    void *arg;
+    void *input;                    // Result of the task a continuation follows
+    void *result;                   // Valid once done
+    bool done;                      // Protected by task_mutex
+    ThreadPoolTask *continuations;  // Queued when this task finishes (protected by task_mutex)
+    ThreadPoolTask *next;           // Next continuation of the same task
+    _Atomic unsigned refs;          // The handle, plus the pool until the task finished
+};
+
+/**
+ * @brief Task group
+ */
+struct ThreadPoolGroup {
+    ThreadPool *pool;
+    size_t pending;                 // Unfinished tasks (protected by task_mutex)
+    ThreadPoolGroup *prev;          // Pool's list of groups (protected by task_mutex)
+    ThreadPoolGroup *next;
+};
+
+static bool runs_before(const WorkItem *a, const WorkItem *b) {
+    return a->priority < b->priority || (a->priority == b->priority && a->seq < b->seq);
+}
+
+/**
+ * @brief Append a work item to the run queue (queue_mutex must be held)
+ */
+static void enqueue_locked(ThreadPool *pool, WorkItem *work) {
+    work->queued_ms = get_time_ms();
+    work->next = NULL;
+    pool->run_count++;
+
+    if (pool->prioritized) {
+        if (pool->heap_count == pool->heap_capacity) {
+            pool->heap_capacity = pool->heap_capacity ? pool->heap_capacity * 2 : 64;
+            pool->heap = safe_realloc(pool->heap, pool->heap_capacity * sizeof(WorkItem*));
+        }
+        size_t i = pool->heap_count++;
+        while (i > 0 && runs_before(work, pool->heap[(i - 1) / 2])) {
+            pool->heap[i] = pool->heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        pool->heap[i] = work;
+        return;
+    }
+
+    if (pool->work_queue_tail) {
+        pool->work_queue_tail->next = work;
+    } else {
+        pool->work_queue_head = work;
+    }
+    pool->work_queue_tail = work;
+}
+
+/**
+ * @brief Take the next item from the run queue (queue_mutex must be held)
+ *
+ * @return Work item or NULL if the run queue is empty
+ */
+static WorkItem* dequeue_locked(ThreadPool *pool) {
+    if (pool->prioritized) {
+        if (pool->heap_count == 0) {
+            return NULL;
+        }
+        WorkItem *top = pool->heap[0];
+        WorkItem *last = pool->heap[--pool->heap_count];
+        size_t i = 0;
+        for (;;) {
+            size_t child = 2 * i + 1;
+            if (child >= pool->heap_count) {
+                break;
+            }
+            if (child + 1 < pool->heap_count && runs_before(pool->heap[child + 1], pool->heap[child])) {
+                child++;
+            }
+            if (!runs_before(pool->heap[child], last)) {
+                break;
+            }
+            pool->heap[i] = pool->heap[child];
+            i = child;
+        }
+        if (pool->heap_count > 0) {
+            pool->heap[i] = last;
+        }
+        pool->run_count--;
+        return top;
+    }
+
+    WorkItem *work = pool->work_queue_head;
+    if (work) {
+        pool->work_queue_head = work->next;
+        if (pool->work_queue_head == NULL) {
+            pool->work_queue_tail = NULL;
+        }
+        pool->run_count--;
+    }
+    return work;
+}
+
+/**
+ * @brief Items queued or deferred, not counting ranges (queue_mutex must be held)
+ */
+static size_t queued_locked(const ThreadPool *pool) {
+    return atomic_load(&pool->pending_count) - pool->range_remaining;
+}
+
+/**
+ * @brief Check whether a range index can be handed out (queue_mutex must be held)
+ *
+ * On a bounded pool, ranges pause while the queue is full: indices that
+ * re-queue themselves (deferrals, retries) bypass the capacity, and would
+ * otherwise pile up one deferred item per index.
+ */
+static bool range_claimable_locked(const ThreadPool *pool) {
+    return pool->ranges_head != NULL &&
+           (pool->queue_capacity == 0 || queued_locked(pool) < pool->queue_capacity);
+}
+
+/**
+ * @brief Hand out the next index of the oldest range (queue_mutex must be held)
+ *
+ * @param slot Work item to describe the claimed index in
+ * @return slot, or NULL if no range index can be handed out
+ */
+static WorkItem* claim_range_locked(ThreadPool *pool, WorkItem *slot) {
+    if (!range_claimable_locked(pool)) {
+        return NULL;
+    }
+    ThreadPoolRange *range = pool->ranges_head;
+
+    memset(slot, 0, sizeof(*slot));
+    slot->range = range->function;
+    slot->arg = range->ctx;
+    slot->index = range->next++;
+    slot->queued_ms = range->added_ms;
+    pool->range_remaining--;
+
+    if (range->next == range->count) {
+        pool->ranges_head = range->next_range;
+        if (pool->ranges_head == NULL) {
+            pool->ranges_tail = NULL;
+        }
+        free(range);
+    }
+    return slot;
+}
+
+/**
+ * @brief Check for work a worker could start now (queue_mutex must be held)
+ */
+static bool runnable_locked(const ThreadPool *pool) {
+    return pool->run_count > 0 || range_claimable_locked(pool);
+}
+
+/**
+ * @brief Move deferred items whose time has come to the run queue
+ *
+ * Must be called with queue_mutex held.
+ *
+ * @return Number of items promoted
+ */
+static size_t promote_ready_locked(ThreadPool *pool, double now_ms) {
+    size_t promoted = 0;
+
+    while (pool->delayed_head && pool->delayed_head->ready_ms <= now_ms) {
+        WorkItem *work = pool->delayed_head;
+        pool->delayed_head = work->next;
+        enqueue_locked(pool, work);
+        promoted++;
+    }
+
+    return promoted;
+}
+
+static void* worker_thread(void *arg);
+
+/**
+ * @brief CPU time used by the whole process in milliseconds
+ */
+static double process_cpu_ms(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) {
+        return 0.0;
+    }
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+/**
+ * @brief Set the concurrency limit, starting workers as needed (queue_mutex must be held)
+ */
+static void set_concurrency_locked(ThreadPool *pool, size_t limit) {
+    limit = MIN(MAX(limit, (size_t)MIN_THREADS), pool->thread_capacity);
+
+    while (pool->thread_count < limit) {
+        if (pthread_create(&pool->threads[pool->thread_count], NULL, worker_thread,
+                           &pool->workers[pool->thread_count]) != 0) {
+            LOG_WARN("Failed to start worker thread %zu, keeping %zu", pool->thread_count,
+                     pool->thread_count);
+            pool->thread_capacity = pool->thread_count;
+            limit = pool->thread_count;
+            break;
+        }
+        pool->thread_count++;
+    }
+
+    if (limit > atomic_exchange(&pool->concurrency, limit)) {
+        pthread_cond_broadcast(&pool->work_cond);
+        pool->work_signals++;
+    }
+}
+
+/**
+ * @brief Adjust the concurrency limit once per interval (queue_mutex must be held)
+ */
+static void tune_locked(ThreadPool *pool, double now_ms) {
+    ThreadPoolTuner *t = &pool->tuner;
+    double elapsed_ms = now_ms - t->epoch_start_ms;
+    if (!t->enabled || elapsed_ms < t->interval_ms || atomic_load(&pool->shutdown)) {
+        return;
+    }
+
+    double cpu_ms = process_cpu_ms();
+    double cpu_share = (cpu_ms - t->epoch_cpu_ms) / (elapsed_ms * t->cpus);
+    double throughput = (double)t->completed * 1000.0 / elapsed_ms;
+    double run_ms = t->completed > 0 ? t->run_ms / (double)t->completed : 0.0;
+    double wait_ms = t->dequeued > 0 ? t->wait_ms / (double)t->dequeued : 0.0;
+
+    size_t limit = atomic_load(&pool->concurrency);
+    size_t next = limit;
+    bool saturated = atomic_load(&pool->working_count) >= limit;
+    bool backlog = runnable_locked(pool) || (t->completed > 0 && wait_ms > run_ms * 0.1);
+
+    if (backlog && saturated) {
+        // Work waits for a worker: grow while that pays off
+        bool overloaded = cpu_share > THREAD_POOL_TUNE_CPU_HIGH ||
+                          (t->raised && t->completed > 0 && t->last_throughput > 0.0 &&
+                           throughput < t->last_throughput * (1.0 - THREAD_POOL_TUNE_DROP) &&
+                           run_ms > t->last_run_ms * THREAD_POOL_TUNE_INFLATION);
+        if (overloaded) {
+            next = limit - limit / 4;
+            t->slow_start = false;
+        } else {
+            next = t->slow_start ? limit * 2 : limit + THREAD_POOL_TUNE_STEP;
+        }
+    } else if (!backlog && t->completed > 0) {
+        // Little's law: the load needs throughput x run time workers
+        size_t needed = (size_t)ceil(throughput * run_ms / 1000.0 * 1.25) + 1;
+        if (needed < limit) {
+            next = MAX(needed, limit - limit / 4);
+        }
+    }
+    next = MIN(MAX(next, (size_t)MIN_THREADS), pool->thread_capacity);
+
+    if (next != limit) {
+        LOG_DEBUG("Pool concurrency %zu -> %zu (%.0f/s, run %.1f ms, wait %.1f ms, CPU %.0f%%)",
+                  limit, next, throughput, run_ms, wait_ms, cpu_share * 100.0);
+        set_concurrency_locked(pool, next);
+        next = atomic_load(&pool->concurrency);
+        t->adjustments++;
+    }
+    if (backlog && saturated) {
+        t->settled = next;
+    }
+    t->peak = MAX(t->peak, next);
+    t->raised = next > limit;
+    if (t->completed > 0) {
+        t->last_throughput = throughput;
+        t->last_run_ms = run_ms;
+    }
+
+    t->epoch_start_ms = now_ms;
+    t->epoch_cpu_ms = cpu_ms;
+    t->completed = 0;
+    t->run_ms = 0.0;
+    t->dequeued = 0;
+    t->wait_ms = 0.0;
+}
 
 /**
  * @brief Worker thread function
  */
 static void* worker_thread(void *arg) {
-    ThreadPool *pool = (ThreadPool*)arg;
+    ThreadPoolWorker *self = (ThreadPoolWorker*)arg;
+    ThreadPool *pool = self ? self->pool : NULL;
 
     if (!pool) {
         LOG_ERROR("Worker thread received NULL pool");
         return NULL;
     }
+    t_worker_pool = pool;
 
     LOG_DEBUG("Worker thread %lu started", (unsigned long)pthread_self());
 
@@ -23,11 +411,40 @@ static void* worker_thread(void *arg) {
         WorkItem *work = NULL;
 
         // Lock queue mutex to get work
-        pthread_mutex_lock(&pool->queue_mutex);
+        uint64_t lock_start = trace_begin();
+        lock_queue(pool);
+        trace_end(TRACE_CAT_POOL, "queue_lock", lock_start, NULL);
 
-        // Wait for work or shutdown signal
-        while (pool->work_queue_head == NULL && !atomic_load(&pool->shutdown)) {
-            pthread_cond_wait(&pool->work_cond, &pool->queue_mutex);
+        // Wait for work, a deferred item becoming ready, or shutdown
+        bool woken = false;
+        while (!atomic_load(&pool->shutdown)) {
+            size_t promoted = promote_ready_locked(pool, get_time_ms());
+
+            // Wake other idle workers for any additional promoted items
+            for (size_t i = 1; i < promoted; i++) {
+                pthread_cond_signal(&pool->work_cond);
+                pool->work_signals++;
+            }
+
+            // Workers beyond the concurrency limit stay parked
+            if (runnable_locked(pool) &&
+                atomic_load(&pool->working_count) < atomic_load(&pool->concurrency)) {
+                break;
+            }
+
+            if (woken) {
+                self->stats.empty_wakeups++;
+            }
+            double idle_start_ms = get_time_ms();
+            if (pool->delayed_head) {
+                struct timespec deadline = ms_to_timespec(pool->delayed_head->ready_ms);
+                pthread_cond_timedwait(&pool->work_cond, &pool->queue_mutex, &deadline);
+            } else {
+                pthread_cond_wait(&pool->work_cond, &pool->queue_mutex);
+            }
+            self->stats.idle_ms += get_time_ms() - idle_start_ms;
+            self->stats.wakeups++;
+            woken = true;
         }
 
         // Check for shutdown
@@ -36,33 +453,70 @@ static void* worker_thread(void *arg) {
             break;
         }
 
-        // Get work from queue
-        work = pool->work_queue_head;
+        // Get work from queue, then from the ranges
+        WorkItem claimed;
+        work = dequeue_locked(pool);
+        if (work && pool->space_waiters > 0) {
+            pthread_cond_signal(&pool->space_cond);
+        }
+        if (!work) {
+            work = claim_range_locked(pool, &claimed);
+        }
+        double queue_wait_ms = 0.0;
         if (work) {
-            pool->work_queue_head = work->next;
-            if (pool->work_queue_head == NULL) {
-                pool->work_queue_tail = NULL;
-            }
+            // Count as working before releasing the lock so waiters never
+            // observe an item that is neither pending nor working
+            atomic_fetch_add(&pool->working_count, 1);
             atomic_fetch_sub(&pool->pending_count, 1);
+            queue_wait_ms = get_time_ms() - work->queued_ms;
+            pool->tuner.dequeued++;
+            pool->tuner.wait_ms += queue_wait_ms;
+            thread_pool_histogram_add(&pool->queue_wait_hist, queue_wait_ms);
         }
 
         pthread_mutex_unlock(&pool->queue_mutex);
 
         // Execute work
         if (work) {
-            atomic_fetch_add(&pool->working_count, 1);
+            metrics_gauge_add(g_metric_queue_depth, -1.0);
+            metrics_gauge_add(g_metric_active, 1.0);
+            metrics_observe(g_metric_queue_wait, queue_wait_ms);
 
-            if (work->function) {
+            if (work->trace_us != 0) {
+                trace_record(TRACE_CAT_POOL, "queued", work->trace_us, trace_clock_us(), NULL);
+            }
+
+            uint64_t run_start = trace_begin();
+            double run_start_ms = get_time_ms();
+            if (work->range) {
+                work->range(work->arg, work->index);
+            } else if (work->function) {
                 work->function(work->arg);
             }
+            double run_end_ms = get_time_ms();
+            trace_end(TRACE_CAT_POOL, "run", run_start, NULL);
 
-            free(work);
+            double run_ms = run_end_ms - run_start_ms;
+            if (work != &claimed) {
+                free(work);
+            }
+            metrics_gauge_add(g_metric_active, -1.0);
+            metrics_add(g_metric_tasks, 1);
+            metrics_observe(g_metric_run, run_ms);
 
+            // Signal that work is done; this worker still counts as working
+            // while tuning, so a full pool reads as saturated, and waiters
+            // only see it finish once its run is recorded
+            lock_queue(pool);
+            pool->tuner.completed++;
+            pool->tuner.run_ms += run_ms;
+            tune_locked(pool, run_end_ms);
+            thread_pool_histogram_add(&pool->run_hist, run_ms);
+            self->stats.busy_ms += run_ms;
+            self->stats.tasks++;
             atomic_fetch_sub(&pool->working_count, 1);
-
-            // Signal that work is done
-            pthread_mutex_lock(&pool->queue_mutex);
             pthread_cond_signal(&pool->done_cond);
+            pool->done_signals++;
             pthread_mutex_unlock(&pool->queue_mutex);
         }
     }
@@ -72,23 +526,75 @@ static void* worker_thread(void *arg) {
 }
 
 /**
- * @brief Create and initialize a thread pool
+ * @brief Get default pool configuration
  */
-ThreadPool* thread_pool_create(size_t thread_count) {
-    if (thread_count == 0 || thread_count > MAX_THREADS) {
-        LOG_ERROR("Invalid thread count: %zu", thread_count);
+ThreadPoolConfig thread_pool_get_default_config(void) {
+    return (ThreadPoolConfig){
+        .threads = DEFAULT_THREADS,
+        .max_threads = DEFAULT_AUTOTUNE_MAX_THREADS,
+        .prioritized = false,
+        .autotune = false,
+        .tune_interval_ms = THREAD_POOL_TUNE_INTERVAL_MS,
+        .queue_capacity = 0
+    };
+}
+
+/**
+ * @brief Create a thread pool from a configuration
+ */
+ThreadPool* thread_pool_create_with_config(const ThreadPoolConfig *config) {
+    if (!config) {
+        LOG_ERROR("Invalid parameters for thread pool creation");
+        return NULL;
+    }
+    size_t thread_count = config->threads;
+    size_t capacity = config->autotune ? config->max_threads : thread_count;
+    if (thread_count == 0 || (!config->autotune && thread_count > MAX_THREADS) ||
+        capacity < thread_count || capacity > MAX_AUTOTUNE_THREADS ||
+        (config->autotune && !(config->tune_interval_ms > 0.0))) {
+        LOG_ERROR("Invalid thread count: %zu (ceiling %zu)", thread_count, capacity);
         return NULL;
     }
 
-    LOG_INFO("Creating thread pool with %zu threads", thread_count);
+    if (config->autotune) {
+        LOG_INFO("Creating thread pool with %zu threads, autotuning up to %zu", thread_count, capacity);
+    } else {
+        LOG_INFO("Creating thread pool with %zu threads", thread_count);
+    }
+    pthread_once(&g_metrics_once, register_metrics);
 
     // Allocate thread pool structure
     ThreadPool *pool = safe_calloc(1, sizeof(ThreadPool));
 
     // Initialize fields
     pool->thread_count = thread_count;
+    pool->thread_capacity = capacity;
+    pool->created_ms = get_time_ms();
+    atomic_store(&pool->concurrency, thread_count);
+    pool->tuner = (ThreadPoolTuner){
+        .enabled = config->autotune,
+        .interval_ms = config->tune_interval_ms,
+        .cpus = (double)MAX(sysconf(_SC_NPROCESSORS_ONLN), 1L),
+        .epoch_start_ms = get_time_ms(),
+        .epoch_cpu_ms = process_cpu_ms(),
+        .slow_start = true,
+        .settled = thread_count,
+        .peak = thread_count
+    };
     pool->work_queue_head = NULL;
     pool->work_queue_tail = NULL;
+    pool->prioritized = config->prioritized;
+    pool->run_count = 0;
+    pool->heap = NULL;
+    pool->heap_count = 0;
+    pool->heap_capacity = 0;
+    pool->next_seq = 0;
+    pool->delayed_head = NULL;
+    pool->ranges_head = NULL;
+    pool->ranges_tail = NULL;
+    pool->range_remaining = 0;
+    pool->queue_capacity = config->queue_capacity;
+    pool->space_waiters = 0;
     atomic_store(&pool->working_count, 0);
     atomic_store(&pool->pending_count, 0);
     atomic_store(&pool->shutdown, false);
@@ -100,27 +606,73 @@ ThreadPool* thread_pool_create(size_t thread_count) {
         return NULL;
     }
 
-    if (pthread_cond_init(&pool->work_cond, NULL) != 0) {
+    // Deferred work and timed waits use the monotonic clock of get_time_ms()
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+
+    if (pthread_cond_init(&pool->work_cond, &cond_attr) != 0) {
         LOG_ERROR("Failed to initialize work condition");
+        pthread_condattr_destroy(&cond_attr);
         pthread_mutex_destroy(&pool->queue_mutex);
         free(pool);
         return NULL;
     }
 
-    if (pthread_cond_init(&pool->done_cond, NULL) != 0) {
+    if (pthread_cond_init(&pool->done_cond, &cond_attr) != 0) {
         LOG_ERROR("Failed to initialize done condition");
+        pthread_condattr_destroy(&cond_attr);
+        pthread_cond_destroy(&pool->work_cond);
+        pthread_mutex_destroy(&pool->queue_mutex);
+        free(pool);
+        return NULL;
+    }
+
+    if (pthread_cond_init(&pool->space_cond, &cond_attr) != 0) {
+        LOG_ERROR("Failed to initialize space condition");
+        pthread_condattr_destroy(&cond_attr);
+        pthread_cond_destroy(&pool->done_cond);
+        pthread_cond_destroy(&pool->work_cond);
+        pthread_mutex_destroy(&pool->queue_mutex);
+        free(pool);
+        return NULL;
+    }
+
+    // Task completion has its own lock, off the queue path
+    if (pthread_mutex_init(&pool->task_mutex, NULL) != 0) {
+        LOG_ERROR("Failed to initialize task mutex");
+        pthread_condattr_destroy(&cond_attr);
+        pthread_cond_destroy(&pool->space_cond);
+        pthread_cond_destroy(&pool->done_cond);
+        pthread_cond_destroy(&pool->work_cond);
+        pthread_mutex_destroy(&pool->queue_mutex);
+        free(pool);
+        return NULL;
+    }
+
+    if (pthread_cond_init(&pool->task_cond, &cond_attr) != 0) {
+        LOG_ERROR("Failed to initialize task condition");
+        pthread_condattr_destroy(&cond_attr);
+        pthread_mutex_destroy(&pool->task_mutex);
+        pthread_cond_destroy(&pool->space_cond);
+        pthread_cond_destroy(&pool->done_cond);
         pthread_cond_destroy(&pool->work_cond);
         pthread_mutex_destroy(&pool->queue_mutex);
         free(pool);
         return NULL;
     }
+    pthread_condattr_destroy(&cond_attr);
 
-    // Allocate thread array
-    pool->threads = safe_calloc(thread_count, sizeof(pthread_t));
+    // Allocate thread array and the worker slots
+    pool->threads = safe_calloc(capacity, sizeof(pthread_t));
+    pool->workers = safe_calloc(capacity, sizeof(ThreadPoolWorker));
+    for (size_t i = 0; i < capacity; i++) {
+        pool->workers[i].pool = pool;
+    }
 
     // Create worker threads
     for (size_t i = 0; i < thread_count; i++) {
-        if (pthread_create(&pool->threads[i], NULL, worker_thread, pool) != 0) {
+        if (pthread_create(&pool->threads[i], NULL, worker_thread, &pool->workers[i]) != 0) {
             LOG_ERROR("Failed to create worker thread %zu", i);
 
             // Set shutdown flag and cleanup
@@ -133,6 +685,10 @@ ThreadPool* thread_pool_create(size_t thread_count) {
             }
 
             free(pool->threads);
+            free(pool->workers);
+            pthread_cond_destroy(&pool->task_cond);
+            pthread_mutex_destroy(&pool->task_mutex);
+            pthread_cond_destroy(&pool->space_cond);
             pthread_cond_destroy(&pool->done_cond);
             pthread_cond_destroy(&pool->work_cond);
             pthread_mutex_destroy(&pool->queue_mutex);
@@ -145,10 +701,106 @@ ThreadPool* thread_pool_create(size_t thread_count) {
     return pool;
 }
 
+/**
+ * @brief Create and initialize a thread pool
+ */
+ThreadPool* thread_pool_create(size_t thread_count) {
+    ThreadPoolConfig config = thread_pool_get_default_config();
+    config.threads = thread_count;
+    return thread_pool_create_with_config(&config);
+}
+
+/**
+ * @brief Create a thread pool that runs queued work by priority
+ */
+ThreadPool* thread_pool_create_prioritized(size_t thread_count) {
+    ThreadPoolConfig config = thread_pool_get_default_config();
+    config.threads = thread_count;
+    config.prioritized = true;
+    return thread_pool_create_with_config(&config);
+}
+
+/**
+ * @brief Get the concurrency of a pool
+ */
+ThreadPoolConcurrency thread_pool_get_concurrency(ThreadPool *pool) {
+    ThreadPoolConcurrency c = {0};
+    if (!pool) {
+        return c;
+    }
+    lock_queue(pool);
+    c.limit = atomic_load(&pool->concurrency);
+    c.settled = pool->tuner.settled;
+    c.peak = pool->tuner.peak;
+    c.threads = pool->thread_count;
+    c.adjustments = pool->tuner.adjustments;
+    pthread_mutex_unlock(&pool->queue_mutex);
+    return c;
+}
+
+/**
+ * @brief Take a snapshot of a pool's scheduling statistics
+ */
+int thread_pool_get_stats(ThreadPool *pool, ThreadPoolStats *stats) {
+    if (!pool || !stats) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    lock_queue(pool);
+    stats->elapsed_ms = get_time_ms() - pool->created_ms;
+    stats->threads = pool->thread_count;
+    stats->pending = atomic_load(&pool->pending_count);
+    stats->working = atomic_load(&pool->working_count);
+    stats->queue_wait = pool->queue_wait_hist;
+    stats->run = pool->run_hist;
+    stats->lock_wait = pool->lock_wait_hist;
+    stats->lock_acquisitions = pool->lock_acquisitions;
+    stats->lock_contended = pool->lock_contended;
+    stats->work_signals = pool->work_signals;
+    stats->done_signals = pool->done_signals;
+    stats->done_wakeups = pool->done_wakeups;
+    stats->producer_waits = pool->producer_waits;
+    stats->producer_wait_ms = pool->producer_wait_ms;
+    stats->workers = safe_calloc(MAX(pool->thread_count, (size_t)1), sizeof(ThreadPoolWorkerStats));
+    for (size_t i = 0; i < pool->thread_count; i++) {
+        stats->workers[i] = pool->workers[i].stats;
+    }
+    pthread_mutex_unlock(&pool->queue_mutex);
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Release the per-worker array of a snapshot
+ */
+void thread_pool_stats_free(ThreadPoolStats *stats) {
+    if (!stats) {
+        return;
+    }
+    free(stats->workers);
+    stats->workers = NULL;
+}
+
 /**
  * @brief Add work to the thread pool
  */
 int thread_pool_add_work(ThreadPool *pool, thread_pool_func_t function, void *arg) {
+    return thread_pool_add_work_priority(pool, function, arg, 0.0, 0.0);
+}
+
+/**
+ * @brief Add work that must not start before a delay has elapsed
+ */
+int thread_pool_add_work_delayed(ThreadPool *pool, thread_pool_func_t function,
+                                 void *arg, double delay_ms) {
+    return thread_pool_add_work_priority(pool, function, arg, 0.0, delay_ms);
+}
+
+/**
+ * @brief Queue a work item, waiting for room in a bounded queue unless told not to
+ */
+static int submit_work(ThreadPool *pool, thread_pool_func_t function, void *arg,
+                       double priority, double delay_ms, bool wait_for_space) {
     if (!pool || !function) {
         LOG_ERROR("Invalid parameters for adding work");
         return BDIX_ERROR_INVALID_INPUT;
@@ -159,35 +811,162 @@ int thread_pool_add_work(ThreadPool *pool, thread_pool_func_t function, void *ar
         return BDIX_ERROR;
     }
 
+    uint64_t enqueue_start = trace_begin();
+    bool delayed = delay_ms > 0.0;
+
     // Create work item
     WorkItem *work = safe_malloc(sizeof(WorkItem));
     work->function = function;
     work->arg = arg;
+    work->ready_ms = delayed ? get_time_ms() + delay_ms : 0.0;
+    work->trace_us = enqueue_start;
+    work->range = NULL;
+    work->index = 0;
+    work->priority = priority;
     work->next = NULL;
 
-    // Add to queue
-    pthread_mutex_lock(&pool->queue_mutex);
+    lock_queue(pool);
 
-    if (pool->work_queue_tail) {
-        pool->work_queue_tail->next = work;
+    // Workers feeding their own pool never wait, or a full queue could stall it
+    if (pool->queue_capacity > 0 && t_worker_pool != pool &&
+        queued_locked(pool) >= pool->queue_capacity) {
+        if (!wait_for_space) {
+            pthread_mutex_unlock(&pool->queue_mutex);
+            free(work);
+            return BDIX_ERROR_BUSY;
+        }
+        double wait_start_ms = get_time_ms();
+        pool->space_waiters++;
+        while (!atomic_load(&pool->shutdown) && queued_locked(pool) >= pool->queue_capacity) {
+            pthread_cond_wait(&pool->space_cond, &pool->queue_mutex);
+        }
+        pool->space_waiters--;
+        pool->producer_waits++;
+        pool->producer_wait_ms += get_time_ms() - wait_start_ms;
+        if (atomic_load(&pool->shutdown)) {
+            pthread_mutex_unlock(&pool->queue_mutex);
+            free(work);
+            LOG_WARN("Cannot add work to shutdown pool");
+            return BDIX_ERROR;
+        }
+    }
+
+    work->seq = pool->next_seq++;
+    if (delayed) {
+        // Insert in ready-time order
+        WorkItem **link = &pool->delayed_head;
+        while (*link && (*link)->ready_ms <= work->ready_ms) {
+            link = &(*link)->next;
+        }
+        work->next = *link;
+        *link = work;
     } else {
-        pool->work_queue_head = work;
+        enqueue_locked(pool, work);
     }
-    pool->work_queue_tail = work;
 
     atomic_fetch_add(&pool->pending_count, 1);
+    metrics_gauge_add(g_metric_queue_depth, 1.0);
 
-    // Signal worker thread
+    // Signal a worker; for delayed work it re-arms its timed wait for the earliest item
     pthread_cond_signal(&pool->work_cond);
+    pool->work_signals++;
 
     pthread_mutex_unlock(&pool->queue_mutex);
 
-    LOG_DEBUG("Work added to pool (pending: %zu)",
-              atomic_load(&pool->pending_count));
+    if (delayed) {
+        LOG_DEBUG("Delayed work added to pool (delay: %.1fms)", delay_ms);
+    } else {
+        trace_end(TRACE_CAT_POOL, "enqueue", enqueue_start, NULL);
+        LOG_DEBUG("Work added to pool (pending: %zu)",
+                  atomic_load(&pool->pending_count));
+    }
+
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Add work with a priority, optionally after a delay
+ */
+int thread_pool_add_work_priority(ThreadPool *pool, thread_pool_func_t function, void *arg,
+                                  double priority, double delay_ms) {
+    return submit_work(pool, function, arg, priority, delay_ms, true);
+}
+
+/**
+ * @brief Add work unless a bounded queue is full
+ */
+int thread_pool_try_add_work(ThreadPool *pool, thread_pool_func_t function, void *arg) {
+    return submit_work(pool, function, arg, 0.0, 0.0, false);
+}
+
+/**
+ * @brief Add work for indices 0..count-1 without queuing an item per index
+ */
+int thread_pool_add_range(ThreadPool *pool, thread_pool_range_func_t function, void *ctx,
+                          size_t count) {
+    if (!pool || !function) {
+        LOG_ERROR("Invalid parameters for adding a range");
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    if (atomic_load(&pool->shutdown)) {
+        LOG_WARN("Cannot add work to shutdown pool");
+        return BDIX_ERROR;
+    }
+    if (count == 0) {
+        return BDIX_SUCCESS;
+    }
+
+    ThreadPoolRange *range = safe_malloc(sizeof(ThreadPoolRange));
+    range->function = function;
+    range->ctx = ctx;
+    range->count = count;
+    range->next = 0;
+    range->added_ms = get_time_ms();
+    range->next_range = NULL;
+
+    lock_queue(pool);
+    if (pool->ranges_tail) {
+        pool->ranges_tail->next_range = range;
+    } else {
+        pool->ranges_head = range;
+    }
+    pool->ranges_tail = range;
+    pool->range_remaining += count;
+    atomic_fetch_add(&pool->pending_count, count);
+    metrics_gauge_add(g_metric_queue_depth, (double)count);
+
+    // Every idle worker can take an index
+    pthread_cond_broadcast(&pool->work_cond);
+    pool->work_signals++;
+    pthread_mutex_unlock(&pool->queue_mutex);
 
+    LOG_DEBUG("Range of %zu items added to pool", count);
     return BDIX_SUCCESS;
 }
 
+/**
+ * @brief Make all deferred work runnable now
+ */
+size_t thread_pool_release_delayed(ThreadPool *pool) {
+    if (!pool) {
+        return 0;
+    }
+
+    lock_queue(pool);
+    size_t released = promote_ready_locked(pool, INFINITY);
+    if (released > 0) {
+        pthread_cond_broadcast(&pool->work_cond);
+        pool->work_signals++;
+    }
+    pthread_mutex_unlock(&pool->queue_mutex);
+
+    if (released > 0) {
+        LOG_DEBUG("Released %zu deferred work items", released);
+    }
+    return released;
+}
+
 /**
  * @brief Wait for all work to complete
  */
@@ -198,21 +977,446 @@ int thread_pool_wait(ThreadPool *pool) {
     }
 
     LOG_DEBUG("Waiting for all work to complete...");
+    uint64_t wait_start = trace_begin();
 
-    pthread_mutex_lock(&pool->queue_mutex);
+    lock_queue(pool);
 
-    // Wait while there is pending work or working threads
+    // Wait while there is pending work or working threads; an autotuned
+    // pool is tuned from here too, since its workers may all be blocked
     while (atomic_load(&pool->pending_count) > 0 ||
            atomic_load(&pool->working_count) > 0) {
-        pthread_cond_wait(&pool->done_cond, &pool->queue_mutex);
+        if (pool->tuner.enabled) {
+            struct timespec wake = ms_to_timespec(get_time_ms() + pool->tuner.interval_ms);
+            pthread_cond_timedwait(&pool->done_cond, &pool->queue_mutex, &wake);
+            tune_locked(pool, get_time_ms());
+        } else {
+            pthread_cond_wait(&pool->done_cond, &pool->queue_mutex);
+        }
+        pool->done_wakeups++;
     }
 
     pthread_mutex_unlock(&pool->queue_mutex);
+    trace_end(TRACE_CAT_POOL, "wait", wait_start, NULL);
 
     LOG_DEBUG("All work completed");
     return BDIX_SUCCESS;
 }
 
+/**
+ * @brief Wait for all work to complete, giving up after a timeout
+ */
+int thread_pool_wait_timeout(ThreadPool *pool, int timeout_ms) {
+    if (!pool) {
+        LOG_ERROR("Cannot wait on NULL pool");
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    double deadline_ms = get_time_ms() + (timeout_ms > 0 ? timeout_ms : 0);
+    int ret = BDIX_SUCCESS;
+
+    lock_queue(pool);
+    while (atomic_load(&pool->pending_count) > 0 ||
+           atomic_load(&pool->working_count) > 0) {
+        double wake_ms = deadline_ms;
+        if (pool->tuner.enabled) {
+            wake_ms = MIN(wake_ms, get_time_ms() + pool->tuner.interval_ms);
+        }
+        struct timespec wake = ms_to_timespec(wake_ms);
+        int rc = pthread_cond_timedwait(&pool->done_cond, &pool->queue_mutex, &wake);
+        pool->done_wakeups++;
+        double now_ms = get_time_ms();
+        tune_locked(pool, now_ms);
+        if (rc == ETIMEDOUT && now_ms >= deadline_ms) {
+            ret = atomic_load(&pool->pending_count) > 0 || atomic_load(&pool->working_count) > 0 ?
+                  BDIX_ERROR : BDIX_SUCCESS;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&pool->queue_mutex);
+    return ret;
+}
+
+/**
+ * @brief Allocate a task holding two references, counted in its group
+ */
+static ThreadPoolTask* new_task(ThreadPool *pool, ThreadPoolGroup *group) {
+    ThreadPoolTask *task = safe_calloc(1, sizeof(ThreadPoolTask));
+    task->pool = pool;
+    task->group = group;
+    atomic_store(&task->refs, 2);
+    if (group) {
+        pthread_mutex_lock(&pool->task_mutex);
+        group->pending++;
+        pthread_mutex_unlock(&pool->task_mutex);
+    }
+    return task;
+}
+
+/**
+ * @brief Drop one reference, freeing the task with the last one
+ */
+static void unref_task(ThreadPoolTask *task) {
+    if (atomic_fetch_sub(&task->refs, 1) == 1) {
+        free(task);
+    }
+}
+
+static void dispatch_task(ThreadPoolTask *task);
+
+/**
+ * @brief Publish a task's result and queue its continuations
+ */
+static void finish_task(ThreadPoolTask *task, void *result) {
+    ThreadPool *pool = task->pool;
+
+    pthread_mutex_lock(&pool->task_mutex);
+    task->result = result;
+    task->done = true;
+    ThreadPoolTask *next = task->continuations;
+    task->continuations = NULL;
+    if (task->group) {
+        // Continuations were counted when chained, so the group stays busy
+        task->group->pending--;
+    }
+    pthread_cond_broadcast(&pool->task_cond);
+    pthread_mutex_unlock(&pool->task_mutex);
+
+    while (next) {
+        ThreadPoolTask *continuation = next;
+        next = continuation->next;
+        continuation->input = result;
+        dispatch_task(continuation);
+    }
+    unref_task(task);
+}
+
+/**
+ * @brief Work item function of a task
+ */
+static void* run_task(void *arg) {
+    ThreadPoolTask *task = (ThreadPoolTask*)arg;
+    void *result = task->then ? task->then(task->input, task->arg) : task->function(task->arg);
+    finish_task(task, result);
+    return NULL;
+}
+
+/**
+ * @brief Queue a task, finishing it without a result if the pool refuses it
+ */
+static void dispatch_task(ThreadPoolTask *task) {
+    if (atomic_load(&task->pool->shutdown) ||
+        thread_pool_add_work(task->pool, run_task, task) != BDIX_SUCCESS) {
+        finish_task(task, NULL);
+    }
+}
+
+/**
+ * @brief Leave a task or group wait (task_mutex must be held)
+ */
+static void leave_wait_locked(ThreadPool *pool) {
+    // A destroying pool waits for the last waiter before freeing the mutex
+    if (--pool->task_waiters == 0 && atomic_load(&pool->shutdown)) {
+        pthread_cond_broadcast(&pool->task_cond);
+    }
+}
+
+/**
+ * @brief Wait for a task to finish (task_mutex must be held)
+ *
+ * An autotuned pool is tuned each interval from here, since its workers
+ * may all be blocked on the tasks being waited for.
+ *
+ * @return ETIMEDOUT once deadline_ms (0 = none) has passed, 0 otherwise
+ */
+static int wait_task_locked(ThreadPool *pool, double deadline_ms) {
+    if (!pool->tuner.enabled) {
+        if (deadline_ms <= 0.0) {
+            return pthread_cond_wait(&pool->task_cond, &pool->task_mutex);
+        }
+        struct timespec deadline = ms_to_timespec(deadline_ms);
+        return pthread_cond_timedwait(&pool->task_cond, &pool->task_mutex, &deadline);
+    }
+
+    double wake_ms = get_time_ms() + pool->tuner.interval_ms;
+    if (deadline_ms > 0.0) {
+        wake_ms = MIN(wake_ms, deadline_ms);
+    }
+    struct timespec wake = ms_to_timespec(wake_ms);
+    pthread_cond_timedwait(&pool->task_cond, &pool->task_mutex, &wake);
+
+    // Tasks finish under task_mutex alone, so drop it rather than nest the locks
+    pthread_mutex_unlock(&pool->task_mutex);
+    lock_queue(pool);
+    double now_ms = get_time_ms();
+    tune_locked(pool, now_ms);
+    pthread_mutex_unlock(&pool->queue_mutex);
+    pthread_mutex_lock(&pool->task_mutex);
+    return deadline_ms > 0.0 && now_ms >= deadline_ms ? ETIMEDOUT : 0;
+}
+
+/**
+ * @brief Submit work and get a handle to its result
+ */
+ThreadPoolTask* thread_pool_submit(ThreadPool *pool, ThreadPoolGroup *group,
+                                   thread_pool_func_t function, void *arg) {
+    if (!pool || !function || (group && group->pool != pool)) {
+        LOG_ERROR("Invalid parameters for task submission");
+        return NULL;
+    }
+
+    ThreadPoolTask *task = new_task(pool, group);
+    task->function = function;
+    task->arg = arg;
+    if (thread_pool_add_work(pool, run_task, task) != BDIX_SUCCESS) {
+        if (group) {
+            pthread_mutex_lock(&pool->task_mutex);
+            group->pending--;
+            pthread_cond_broadcast(&pool->task_cond);
+            pthread_mutex_unlock(&pool->task_mutex);
+        }
+        free(task);
+        return NULL;
+    }
+    return task;
+}
+
+/**
+ * @brief Run a continuation on the result of a task once it finishes
+ */
+ThreadPoolTask* thread_pool_task_then(ThreadPoolTask *task, thread_pool_then_t function, void *arg) {
+    if (!task || !function) {
+        LOG_ERROR("Invalid parameters for task continuation");
+        return NULL;
+    }
+
+    ThreadPool *pool = task->pool;
+    ThreadPoolTask *continuation = new_task(pool, task->group);
+    continuation->then = function;
+    continuation->arg = arg;
+
+    // Chained continuations are queued in the order they were added
+    pthread_mutex_lock(&pool->task_mutex);
+    bool done = task->done;
+    if (done) {
+        continuation->input = task->result;
+    } else {
+        ThreadPoolTask **link = &task->continuations;
+        while (*link) {
+            link = &(*link)->next;
+        }
+        *link = continuation;
+    }
+    pthread_mutex_unlock(&pool->task_mutex);
+
+    if (done) {
+        dispatch_task(continuation);
+    }
+    return continuation;
+}
+
+/**
+ * @brief Wait for a task and get its result
+ */
+void* thread_pool_task_wait(ThreadPoolTask *task) {
+    if (!task) {
+        return NULL;
+    }
+
+    ThreadPool *pool = task->pool;
+    pthread_mutex_lock(&pool->task_mutex);
+    pool->task_waiters++;
+    while (!task->done) {
+        wait_task_locked(pool, 0.0);
+    }
+    void *result = task->result;
+    leave_wait_locked(pool);
+    pthread_mutex_unlock(&pool->task_mutex);
+    return result;
+}
+
+/**
+ * @brief Wait until any of several tasks has finished
+ */
+size_t thread_pool_task_wait_any(ThreadPoolTask *const *tasks, size_t count) {
+    if (!tasks || count == 0 || !tasks[0]) {
+        LOG_ERROR("Invalid parameters for waiting on tasks");
+        return count;
+    }
+    ThreadPool *pool = tasks[0]->pool;
+    for (size_t i = 1; i < count; i++) {
+        if (!tasks[i] || tasks[i]->pool != pool) {
+            LOG_ERROR("Cannot wait on tasks of different pools");
+            return count;
+        }
+    }
+
+    pthread_mutex_lock(&pool->task_mutex);
+    pool->task_waiters++;
+    for (;;) {
+        for (size_t i = 0; i < count; i++) {
+            if (tasks[i]->done) {
+                leave_wait_locked(pool);
+                pthread_mutex_unlock(&pool->task_mutex);
+                return i;
+            }
+        }
+        wait_task_locked(pool, 0.0);
+    }
+}
+
+/**
+ * @brief Check whether a task has finished
+ */
+bool thread_pool_task_done(ThreadPoolTask *task) {
+    if (!task) {
+        return false;
+    }
+    pthread_mutex_lock(&task->pool->task_mutex);
+    bool done = task->done;
+    pthread_mutex_unlock(&task->pool->task_mutex);
+    return done;
+}
+
+/**
+ * @brief Release a task handle
+ */
+void thread_pool_task_release(ThreadPoolTask *task) {
+    if (task) {
+        unref_task(task);
+    }
+}
+
+/**
+ * @brief Create a task group in a pool
+ */
+ThreadPoolGroup* thread_pool_group_create(ThreadPool *pool) {
+    if (!pool) {
+        LOG_ERROR("Cannot create a task group without a pool");
+        return NULL;
+    }
+    ThreadPoolGroup *group = safe_calloc(1, sizeof(ThreadPoolGroup));
+    group->pool = pool;
+
+    pthread_mutex_lock(&pool->task_mutex);
+    group->next = pool->groups;
+    if (pool->groups) {
+        pool->groups->prev = group;
+    }
+    pool->groups = group;
+    pthread_mutex_unlock(&pool->task_mutex);
+    return group;
+}
+
+/**
+ * @brief Add work to a group without keeping a handle
+ */
+int thread_pool_group_add_work(ThreadPoolGroup *group, thread_pool_func_t function, void *arg) {
+    if (!group || !function) {
+        LOG_ERROR("Invalid parameters for adding work to a group");
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+    ThreadPoolTask *task = thread_pool_submit(group->pool, group, function, arg);
+    if (!task) {
+        return BDIX_ERROR;
+    }
+    thread_pool_task_release(task);
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Wait until every task of a group has finished
+ */
+int thread_pool_group_wait(ThreadPoolGroup *group) {
+    if (!group) {
+        LOG_ERROR("Cannot wait on NULL group");
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    ThreadPool *pool = group->pool;
+    pthread_mutex_lock(&pool->task_mutex);
+    pool->task_waiters++;
+    while (group->pending > 0) {
+        wait_task_locked(pool, 0.0);
+    }
+    leave_wait_locked(pool);
+    pthread_mutex_unlock(&pool->task_mutex);
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Wait for a group, giving up after a timeout
+ */
+int thread_pool_group_wait_timeout(ThreadPoolGroup *group, int timeout_ms) {
+    if (!group) {
+        LOG_ERROR("Cannot wait on NULL group");
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    ThreadPool *pool = group->pool;
+    double deadline_ms = get_time_ms() + (timeout_ms > 0 ? timeout_ms : 0);
+    int ret = BDIX_SUCCESS;
+
+    pthread_mutex_lock(&pool->task_mutex);
+    pool->task_waiters++;
+    while (group->pending > 0) {
+        if (wait_task_locked(pool, deadline_ms) == ETIMEDOUT) {
+            ret = group->pending > 0 ? BDIX_ERROR : BDIX_SUCCESS;
+            break;
+        }
+    }
+    leave_wait_locked(pool);
+    pthread_mutex_unlock(&pool->task_mutex);
+    return ret;
+}
+
+/**
+ * @brief Get the number of unfinished tasks in a group
+ */
+size_t thread_pool_group_pending(ThreadPoolGroup *group) {
+    if (!group) {
+        return 0;
+    }
+    pthread_mutex_lock(&group->pool->task_mutex);
+    size_t pending = group->pending;
+    pthread_mutex_unlock(&group->pool->task_mutex);
+    return pending;
+}
+
+/**
+ * @brief Wait for a group and free it
+ */
+void thread_pool_group_destroy(ThreadPoolGroup *group) {
+    if (!group) {
+        return;
+    }
+    thread_pool_group_wait(group);
+
+    ThreadPool *pool = group->pool;
+    pthread_mutex_lock(&pool->task_mutex);
+    if (group->prev) {
+        group->prev->next = group->next;
+    } else {
+        pool->groups = group->next;
+    }
+    if (group->next) {
+        group->next->prev = group->prev;
+    }
+    pthread_mutex_unlock(&pool->task_mutex);
+    free(group);
+}
+
+/**
+ * @brief Free a queued work item, setting aside those that carry a task
+ */
+static void drop_work(WorkItem *work, WorkItem **orphans) {
+    if (work->function == run_task) {
+        work->next = *orphans;
+        *orphans = work;
+    } else {
+        free(work);
+    }
+}
+
 /**
  * @brief Destroy thread pool and free resources
  */
@@ -226,9 +1430,10 @@ void thread_pool_destroy(ThreadPool *pool) {
     // Set shutdown flag
     atomic_store(&pool->shutdown, true);
 
-    // Wake up all worker threads
-    pthread_mutex_lock(&pool->queue_mutex);
+    // Wake up all worker threads and blocked submitters
+    lock_queue(pool);
     pthread_cond_broadcast(&pool->work_cond);
+    pthread_cond_broadcast(&pool->space_cond);
     pthread_mutex_unlock(&pool->queue_mutex);
 
     // Wait for all threads to exit
@@ -237,25 +1442,66 @@ void thread_pool_destroy(ThreadPool *pool) {
         LOG_DEBUG("Joined worker thread %zu", i);
     }
 
-    // Free any remaining work items in queue
-    pthread_mutex_lock(&pool->queue_mutex);
+    // Free any remaining work items in queue, keeping back unfinished tasks
+    WorkItem *orphans = NULL;
+    lock_queue(pool);
 
     WorkItem *work = pool->work_queue_head;
     while (work) {
         WorkItem *next = work->next;
-        free(work);
+        drop_work(work, &orphans);
+        work = next;
+    }
+
+    work = pool->delayed_head;
+    while (work) {
+        WorkItem *next = work->next;
+        drop_work(work, &orphans);
         work = next;
     }
+    for (size_t i = 0; i < pool->heap_count; i++) {
+        drop_work(pool->heap[i], &orphans);
+    }
+    free(pool->heap);
+    while (pool->ranges_head) {
+        ThreadPoolRange *next = pool->ranges_head->next_range;
+        free(pool->ranges_head);
+        pool->ranges_head = next;
+    }
+    metrics_gauge_add(g_metric_queue_depth, -(double)atomic_load(&pool->pending_count));
 
     pthread_mutex_unlock(&pool->queue_mutex);
 
+    // Tasks that never ran finish without a result, so their waiters return
+    while (orphans) {
+        WorkItem *next = orphans->next;
+        finish_task((ThreadPoolTask*)orphans->arg, NULL);
+        free(orphans);
+        orphans = next;
+    }
+    pthread_mutex_lock(&pool->task_mutex);
+    while (pool->task_waiters > 0) {
+        pthread_cond_wait(&pool->task_cond, &pool->task_mutex);
+    }
+    // No one waits on them any more: groups go with the pool
+    while (pool->groups) {
+        ThreadPoolGroup *next = pool->groups->next;
+        free(pool->groups);
+        pool->groups = next;
+    }
+    pthread_mutex_unlock(&pool->task_mutex);
+
     // Destroy synchronization primitives
+    pthread_cond_destroy(&pool->task_cond);
+    pthread_mutex_destroy(&pool->task_mutex);
+    pthread_cond_destroy(&pool->space_cond);
     pthread_cond_destroy(&pool->done_cond);
     pthread_cond_destroy(&pool->work_cond);
     pthread_mutex_destroy(&pool->queue_mutex);
 
     // Free thread array
     free(pool->threads);
+    free(pool->workers);
 
     // Free pool structure
     free(pool);
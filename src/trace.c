@@ -0,0 +1,263 @@
+/**
+ * @file trace.c
+ * @brief Span tracer writing Chrome trace-event JSON
+ * @version 1.0.0
+ */
+
+#include "trace.h"
+#include <inttypes.h>
+
+/**
+ * @brief One complete ("X") span
+ */
+typedef struct {
+    const char *category;
+    const char *name;
+    const char *detail;
+    uint64_t start_us;
+    uint64_t duration_us;
+} TraceEvent;
+
+/**
+ * @brief Fixed block of events, chained per thread
+ */
+typedef struct TraceChunk {
+    struct TraceChunk *next;
+    size_t count;
+    TraceEvent events[TRACE_CHUNK_EVENTS];
+} TraceChunk;
+
+/**
+ * @brief Events of one thread (written only by that thread)
+ */
+typedef struct TraceBuffer {
+    struct TraceBuffer *next;       // Registration list link
+    unsigned tid;                   // Trace thread id
+    TraceChunk *head;
+    TraceChunk *tail;
+} TraceBuffer;
+
+_Atomic bool g_trace_enabled = false;
+
+static TraceBuffer *_Atomic g_trace_buffers = NULL;
+static _Atomic unsigned g_trace_next_tid = 1;
+static _Atomic unsigned g_trace_generation = 0;
+static _Atomic size_t g_trace_events = 0;
+static _Atomic size_t g_trace_dropped = 0;
+static uint64_t g_trace_origin_us = 0;
+static char g_trace_path[MAX_PATH_LENGTH]; /* flawfinder: ignore - bounds checked with safe_strncpy */
+
+// Buffer of the calling thread, valid while its generation matches
+static _Thread_local TraceBuffer *t_trace_buffer = NULL;
+static _Thread_local unsigned t_trace_generation = 0;
+
+/**
+ * @brief Monotonic clock in microseconds
+ */
+uint64_t trace_clock_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+/**
+ * @brief Get (or create and register) the calling thread's buffer
+ */
+static TraceBuffer* thread_buffer(void) {
+    unsigned generation = atomic_load_explicit(&g_trace_generation, memory_order_acquire);
+    if (t_trace_buffer && t_trace_generation == generation) {
+        return t_trace_buffer;
+    }
+
+    TraceBuffer *buffer = safe_calloc(1, sizeof(TraceBuffer));
+    buffer->tid = atomic_fetch_add(&g_trace_next_tid, 1);
+
+    // Lock-free push onto the registration list
+    TraceBuffer *head = atomic_load(&g_trace_buffers);
+    do {
+        buffer->next = head;
+    } while (!atomic_compare_exchange_weak(&g_trace_buffers, &head, buffer));
+
+    t_trace_buffer = buffer;
+    t_trace_generation = generation;
+    return buffer;
+}
+
+/**
+ * @brief Record a complete span
+ */
+void trace_record(const char *category, const char *name, uint64_t start_us,
+                  uint64_t end_us, const char *detail) {
+    if (!atomic_load_explicit(&g_trace_enabled, memory_order_acquire) || !name) {
+        return;
+    }
+
+    if (atomic_fetch_add_explicit(&g_trace_events, 1, memory_order_relaxed) >= TRACE_MAX_EVENTS) {
+        atomic_fetch_add_explicit(&g_trace_dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    TraceBuffer *buffer = thread_buffer();
+    TraceChunk *chunk = buffer->tail;
+    if (!chunk || chunk->count == TRACE_CHUNK_EVENTS) {
+        TraceChunk *fresh = safe_malloc(sizeof(TraceChunk));
+        fresh->next = NULL;
+        fresh->count = 0;
+        if (chunk) {
+            chunk->next = fresh;
+        } else {
+            buffer->head = fresh;
+        }
+        buffer->tail = fresh;
+        chunk = fresh;
+    }
+
+    chunk->events[chunk->count++] = (TraceEvent){
+        .category = category ? category : "",
+        .name = name,
+        .detail = detail,
+        .start_us = start_us,
+        .duration_us = end_us > start_us ? end_us - start_us : 0
+    };
+}
+
+/**
+ * @brief Get number of dropped spans
+ */
+size_t trace_dropped_count(void) {
+    return atomic_load(&g_trace_dropped);
+}
+
+/**
+ * @brief Start recording spans
+ */
+int trace_start(const char *path) {
+    if (!path || path[0] == '\0') {
+        LOG_ERROR("Invalid trace file path");
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+
+    if (atomic_load(&g_trace_enabled)) {
+        LOG_WARN("Tracing already started");
+        return BDIX_ERROR;
+    }
+
+    safe_strncpy(g_trace_path, path, sizeof(g_trace_path));
+    g_trace_origin_us = trace_clock_us();
+    atomic_store(&g_trace_events, 0);
+    atomic_store(&g_trace_dropped, 0);
+    atomic_store(&g_trace_next_tid, 1);
+
+    // Invalidate buffers cached by threads from a previous trace
+    atomic_fetch_add_explicit(&g_trace_generation, 1, memory_order_release);
+    atomic_store(&g_trace_enabled, true);
+
+    LOG_INFO("Tracing to %s", g_trace_path);
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Write a JSON string with escaping
+ */
+static void write_json_string(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fputc('\\', f);
+            fputc(c, f);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c); // flawfinder: ignore
+        } else {
+            fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+/**
+ * @brief Write all buffers as trace-event JSON
+ */
+/* flawfinder: ignore - all fprintf calls below use compile-time constant format strings */
+static int write_trace(const TraceBuffer *buffers, size_t *written) {
+    FILE *f = fopen(g_trace_path, "w"); // flawfinder: ignore
+    if (!f) {
+        LOG_ERROR("Failed to open trace file %s: %s", g_trace_path, strerror(errno));
+        return BDIX_ERROR_FILE_NOT_FOUND;
+    }
+
+    pid_t pid = getpid();
+    bool first = true;
+    *written = 0;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"); // flawfinder: ignore
+    for (const TraceBuffer *buffer = buffers; buffer; buffer = buffer->next) {
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u," // flawfinder: ignore
+                "\"args\":{\"name\":\"thread %u\"}}",
+                first ? "" : ",\n", (int)pid, buffer->tid, buffer->tid);
+        first = false;
+
+        for (const TraceChunk *chunk = buffer->head; chunk; chunk = chunk->next) {
+            for (size_t i = 0; i < chunk->count; i++) {
+                const TraceEvent *e = &chunk->events[i];
+                uint64_t ts = e->start_us > g_trace_origin_us ? e->start_us - g_trace_origin_us : 0;
+
+                fprintf(f, ",\n{\"name\":"); // flawfinder: ignore
+                write_json_string(f, e->name);
+                fprintf(f, ",\"cat\":"); // flawfinder: ignore
+                write_json_string(f, e->category);
+                fprintf(f, ",\"ph\":\"X\",\"ts\":%" PRIu64 ",\"dur\":%" PRIu64 // flawfinder: ignore
+                        ",\"pid\":%d,\"tid\":%u",
+                        ts, e->duration_us, (int)pid, buffer->tid);
+                if (e->detail) {
+                    fprintf(f, ",\"args\":{\"detail\":"); // flawfinder: ignore
+                    write_json_string(f, e->detail);
+                    fputc('}', f);
+                }
+                fputc('}', f);
+                (*written)++;
+            }
+        }
+    }
+    fprintf(f, "\n]}\n"); // flawfinder: ignore
+
+    if (fclose(f) != 0) {
+        LOG_ERROR("Failed to write trace file %s", g_trace_path);
+        return BDIX_ERROR;
+    }
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Stop recording, write the trace and free buffers
+ */
+int trace_stop(void) {
+    if (!atomic_exchange(&g_trace_enabled, false)) {
+        return BDIX_SUCCESS;
+    }
+
+    TraceBuffer *buffers = atomic_exchange(&g_trace_buffers, NULL);
+    size_t written = 0;
+    int ret = write_trace(buffers, &written);
+
+    while (buffers) {
+        TraceBuffer *next = buffers->next;
+        TraceChunk *chunk = buffers->head;
+        while (chunk) {
+            TraceChunk *next_chunk = chunk->next;
+            free(chunk);
+            chunk = next_chunk;
+        }
+        free(buffers);
+        buffers = next;
+    }
+
+    if (ret == BDIX_SUCCESS) {
+        size_t dropped = atomic_load(&g_trace_dropped);
+        if (dropped > 0) {
+            LOG_WARN("Trace buffer full, %zu spans dropped", dropped);
+        }
+        LOG_INFO("Wrote %zu spans to %s", written, g_trace_path);
+    }
+    return ret;
+}
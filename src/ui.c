@@ -5,6 +5,7 @@
  */
 
 #include "ui.h"
+#include "trace.h"
 #include <stdarg.h>
 
 #ifdef _WIN32
@@ -53,6 +54,7 @@ int ui_init(const UIConfig *config) {
             .show_only_ok = false,
             .show_progress = true,
             .show_latency = true,
+            .show_timing = false,
             .use_colors = true,
             .verbose = true
         };
@@ -76,7 +78,9 @@ void ui_cleanup(void) {
 void ui_safe_print(const char *format, ...) {
     if (!format) return;
 
+    uint64_t lock_start = trace_begin();
     pthread_mutex_lock(&g_print_mutex);
+    trace_end(TRACE_CAT_UI, "print_lock", lock_start, NULL);
 
     va_list args;
     va_start(args, format);
@@ -266,6 +270,7 @@ const char* ui_get_status_color(ServerStatus status) {
         case BDIX_STATUS_ONLINE:  return COLOR_SUCCESS;
         case BDIX_STATUS_OFFLINE: return COLOR_ERROR;
         case BDIX_STATUS_TIMEOUT: return COLOR_WARNING;
+        case BDIX_STATUS_CUTOFF:  return COLOR_WARNING;
         case BDIX_STATUS_ERROR:   return COLOR_LATENCY; // Or maybe COLOR_ERROR if that fits better
         default:             return COLOR_RESET;
     }
@@ -294,6 +299,41 @@ void ui_print_server_stats(const ServerData *data) {
     printf("%sOther Servers:%s  %5zu\n", c_info, c_reset, data->others.count); // flawfinder: ignore
     printf("%s───────────────────────────────────────%s\n", c_header, c_reset); // flawfinder: ignore
     printf("%sTotal Servers:%s  %5zu\n", c_success, c_reset, total); // flawfinder: ignore
+
+    // Recent-sample metrics, only once servers have been checked
+    const ServerCategory *categories[] = { &data->ftp, &data->tv, &data->others };
+    size_t sampled = 0;
+    size_t stable = 0;
+    double uptime_sum = 0.0;
+    for (size_t c = 0; c < ARRAY_SIZE(categories); c++) {
+        for (size_t i = 0; i < categories[c]->count; i++) {
+            double uptime = server_uptime_pct(&categories[c]->servers[i]);
+            if (uptime >= 0.0) {
+                sampled++;
+                uptime_sum += uptime;
+                if (uptime >= SERVER_STABLE_UPTIME_PCT) {
+                    stable++;
+                }
+            }
+        }
+    }
+
+    if (sampled > 0) {
+        const Server *fastest = server_data_fastest_stable(data, SERVER_STABLE_UPTIME_PCT);
+
+        printf("%s───────────────────────────────────────%s\n", c_header, c_reset); // flawfinder: ignore
+        printf("%sChecked:%s        %5zu\n", c_info, c_reset, sampled); // flawfinder: ignore
+        printf("%sStable:%s         %5zu (uptime >= %.0f%%)\n", // flawfinder: ignore
+               c_info, c_reset, stable, SERVER_STABLE_UPTIME_PCT);
+        printf("%sAvg Uptime:%s     %6.1f%%\n", c_info, c_reset, uptime_sum / sampled); // flawfinder: ignore
+        if (fastest) {
+            printf("%sFastest Stable:%s %s\n", c_success, c_reset, fastest->url); // flawfinder: ignore
+            printf("                 %.2f ms avg, %.2f ms jitter, %.1f%% up\n", // flawfinder: ignore
+                   fastest->metrics.ewma_latency_ms, fastest->metrics.jitter_ms,
+                   server_uptime_pct(fastest));
+        }
+    }
+
     printf("%s═══════════════════════════════════════%s\n", c_header, c_reset); // flawfinder: ignore
     printf("\n"); // flawfinder: ignore
 }
@@ -325,14 +365,22 @@ static void write_servers_to_file(FILE *f, const char *title, const ServerCatego
     if (!has_online) return;
 
     fprintf(f, "## %s Servers\n\n", title); // flawfinder: ignore
-    fprintf(f, "| Server URL | Latency |\n"); // flawfinder: ignore
-    fprintf(f, "|------------|--------|\n"); // flawfinder: ignore
+    fprintf(f, "| Server URL | Latency | DNS | Connect | TLS | Server | Avg Latency | Jitter | Uptime | ICMP min/avg |\n"); // flawfinder: ignore
+    fprintf(f, "|------------|--------|-----|---------|-----|--------|-------------|--------|--------|--------------|\n"); // flawfinder: ignore
 
     for (size_t i = 0; i < cat->count; i++) {
-        if (cat->servers[i].status == BDIX_STATUS_ONLINE) {
-            fprintf(f, "| [%s](%s) | %.2f ms |\n", // flawfinder: ignore
-                    cat->servers[i].url, cat->servers[i].url,
-                    cat->servers[i].latency_ms);
+        const Server *s = &cat->servers[i];
+        if (s->status == BDIX_STATUS_ONLINE) {
+            char ping[SMALL_BUFFER] = "-"; /* flawfinder: ignore - bounds checked with snprintf */
+            if (s->ping.received > 0) {
+                snprintf(ping, sizeof(ping), "%.2f / %.2f ms", s->ping.min_ms, s->ping.avg_ms); // flawfinder: ignore
+            }
+            fprintf(f, "| [%s](%s) | %.2f ms | %.2f ms | %.2f ms | %.2f ms | %.2f ms " // flawfinder: ignore
+                    "| %.2f ms | %.2f ms | %.1f%% (%u) | %s |\n",
+                    s->url, s->url, s->latency_ms,
+                    s->timing.dns_ms, s->timing.connect_ms, s->timing.tls_ms, s->timing.server_ms,
+                    s->metrics.ewma_latency_ms, s->metrics.jitter_ms,
+                    server_uptime_pct(s), s->metrics.count, ping);
         }
     }
     fprintf(f, "\n"); // flawfinder: ignore
@@ -413,6 +461,32 @@ void ui_print_check_result(const Server *server, const char *category,
                       color, server_status_name(server->status), c_reset);
     }
 
+    // Smoothed metrics once a server has a few samples (watch / repeated checks)
+    if (is_online && g_ui_config.show_latency && server->metrics.count > 1) {
+        offset += snprintf(buffer + offset, sizeof(buffer) - offset, // flawfinder: ignore
+                      " | %savg %6.2f ±%5.2f ms, up %5.1f%%%s",
+                      c_latency, server->metrics.ewma_latency_ms, server->metrics.jitter_ms,
+                      server_uptime_pct(server), c_reset);
+    }
+
+    // Where the time went: name lookup, handshakes, origin
+    if (is_online && g_ui_config.show_timing) {
+        offset += snprintf(buffer + offset, sizeof(buffer) - offset, // flawfinder: ignore
+                      " | %sdns %.1f tcp %.1f tls %.1f srv %.1f ms%s",
+                      c_latency, server->timing.dns_ms, server->timing.connect_ms,
+                      server->timing.tls_ms, server->timing.server_ms, c_reset);
+    }
+
+    // Raw RTT from the ICMP probe, also for hosts whose HTTP check failed
+    if (server->ping.received > 0) {
+        offset += snprintf(buffer + offset, sizeof(buffer) - offset, // flawfinder: ignore
+                      " | %sicmp %.2f/%.2f ms%s",
+                      c_latency, server->ping.min_ms, server->ping.avg_ms, c_reset);
+    } else if (server->ping.sent > 0) {
+        offset += snprintf(buffer + offset, sizeof(buffer) - offset, // flawfinder: ignore
+                      " | %sicmp no reply%s", color, c_reset);
+    }
+
     // Format progress
     if (g_ui_config.show_progress) {
         offset += snprintf(buffer + offset, sizeof(buffer) - offset, // flawfinder: ignore
@@ -427,6 +501,28 @@ void ui_print_check_result(const Server *server, const char *category,
     ui_safe_print("%s", buffer);
 }
 
+/**
+ * @brief Print the fastest online servers of a set, fastest first
+ */
+void ui_print_fastest_servers(const char *category, const Server *const *servers, size_t count) {
+    if (!servers || count == 0) return;
+
+    const char *c_header = get_color(COLOR_HEADER);
+    const char *c_url = get_color(COLOR_URL);
+    const char *c_latency = get_color(COLOR_LATENCY);
+    const char *c_reset = get_color(COLOR_RESET);
+
+    printf("\n"); // flawfinder: ignore
+    printf("%s═══════════════════════════════════════%s\n", c_header, c_reset); // flawfinder: ignore
+    printf("%s  FASTEST %zu: %s%s\n", c_header, count, category ? category : "", c_reset); // flawfinder: ignore
+    printf("%s═══════════════════════════════════════%s\n", c_header, c_reset); // flawfinder: ignore
+    for (size_t i = 0; i < count; i++) {
+        printf("%3zu. %s%8.2f ms%s  %s%s%s\n", i + 1, c_latency, servers[i]->latency_ms, c_reset, // flawfinder: ignore
+               c_url, servers[i]->url, c_reset);
+    }
+    printf("%s═══════════════════════════════════════%s\n", c_header, c_reset); // flawfinder: ignore
+}
+
 /**
  * @brief Print progress bar
  */
@@ -473,6 +569,8 @@ bool ui_get_input(const char *prompt, char *buffer, size_t size) {
         return false;
     }
 
+    // Pending log lines belong above the prompt
+    log_flush();
     ui_print_colored(COLOR_PROMPT, "\n%s", prompt);
 
     if (!fgets(buffer, size, stdin)) {
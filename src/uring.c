@@ -0,0 +1,260 @@
+/**
+ * @file uring.c
+ * @brief Minimal io_uring ring on top of the raw system calls
+ * @version 1.0.0
+ */
+
+#define _DEFAULT_SOURCE // syscall(), MAP_POPULATE
+
+#include "common.h"
+#include "uring.h"
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#define URING_PROBE_OPS 256         // Opcode slots requested from IORING_REGISTER_PROBE
+
+/**
+ * @brief Mapped submission and completion rings
+ */
+struct UringRing {
+    int fd;
+    unsigned sq_entries;
+    unsigned cq_entries;
+    unsigned features;              // IORING_FEAT_* reported by setup
+    unsigned *sq_head;              // Shared with the kernel
+    unsigned *sq_tail;
+    unsigned sq_mask;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    unsigned sqe_tail;              // SQEs handed out, published on submit
+    void *ring_ptr;
+    size_t ring_size;
+    size_t sqes_size;
+};
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags,
+                              const void *arg, size_t arg_size) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size);
+}
+
+static int sys_io_uring_register(int fd, unsigned opcode, const void *arg, unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/**
+ * @brief Create a ring
+ */
+UringRing* uring_create(unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_COOP_TASKRUN;
+    int fd = sys_io_uring_setup(entries, &params);
+    if (fd < 0 && errno == EINVAL) {
+        // Kernels before 5.19 reject the flag
+        memset(&params, 0, sizeof(params));
+        fd = sys_io_uring_setup(entries, &params);
+    }
+    if (fd < 0) {
+        return NULL;
+    }
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        close(fd);
+        errno = ENOSYS;
+        return NULL;
+    }
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    size_t ring_size = sq_size > cq_size ? sq_size : cq_size;
+    size_t sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    uint8_t *ring_ptr = mmap(NULL, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             fd, IORING_OFF_SQ_RING);
+    if (ring_ptr == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    void *sqes = mmap(NULL, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        munmap(ring_ptr, ring_size);
+        close(fd);
+        return NULL;
+    }
+
+    UringRing *ring = safe_calloc(1, sizeof(UringRing));
+    ring->fd = fd;
+    ring->sq_entries = params.sq_entries;
+    ring->cq_entries = params.cq_entries;
+    ring->features = params.features;
+    ring->sq_head = (unsigned*)(ring_ptr + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(ring_ptr + params.sq_off.tail);
+    ring->sq_mask = *(unsigned*)(ring_ptr + params.sq_off.ring_mask);
+    ring->cq_head = (unsigned*)(ring_ptr + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(ring_ptr + params.cq_off.tail);
+    ring->cq_mask = *(unsigned*)(ring_ptr + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(ring_ptr + params.cq_off.cqes);
+    ring->sqes = sqes;
+    ring->sqe_tail = *ring->sq_tail;
+    ring->ring_ptr = ring_ptr;
+    ring->ring_size = ring_size;
+    ring->sqes_size = sqes_size;
+
+    // SQE slots are always submitted in order, so the index array is the identity
+    unsigned *array = (unsigned*)(ring_ptr + params.sq_off.array);
+    for (unsigned i = 0; i < params.sq_entries; i++) {
+        array[i] = i;
+    }
+    return ring;
+}
+
+/**
+ * @brief Unmap and close a ring
+ */
+void uring_destroy(UringRing *ring) {
+    if (!ring) {
+        return;
+    }
+    munmap(ring->sqes, ring->sqes_size);
+    munmap(ring->ring_ptr, ring->ring_size);
+    close(ring->fd);
+    free(ring);
+}
+
+/**
+ * @brief Completion queue size of a ring
+ */
+unsigned uring_cq_entries(const UringRing *ring) {
+    return ring ? ring->cq_entries : 0;
+}
+
+/**
+ * @brief Free submission queue slots
+ */
+unsigned uring_sq_space(const UringRing *ring) {
+    return ring->sq_entries - (ring->sqe_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE));
+}
+
+/**
+ * @brief Get a zeroed submission queue entry
+ */
+struct io_uring_sqe* uring_get_sqe(UringRing *ring) {
+    if (uring_sq_space(ring) == 0) {
+        return NULL;
+    }
+    struct io_uring_sqe *sqe = &ring->sqes[ring->sqe_tail & ring->sq_mask];
+    ring->sqe_tail++;
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+/**
+ * @brief Submit queued SQEs and optionally wait for completions
+ */
+int uring_submit(UringRing *ring, unsigned wait_nr) {
+    __atomic_store_n(ring->sq_tail, ring->sqe_tail, __ATOMIC_RELEASE);
+    // Includes SQEs a previous call could not submit
+    unsigned pending = ring->sqe_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (pending == 0 && wait_nr == 0) {
+        return 0;
+    }
+    int ret = sys_io_uring_enter(ring->fd, pending, wait_nr, wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0,
+                                 NULL, 0);
+    return ret < 0 ? -errno : ret;
+}
+
+/**
+ * @brief Submit queued SQEs and wait for completions, at most timeout_ms
+ */
+int uring_submit_timeout(UringRing *ring, unsigned wait_nr, int timeout_ms) {
+    if (wait_nr == 0 || timeout_ms < 0 || !(ring->features & IORING_FEAT_EXT_ARG)) {
+        return uring_submit(ring, wait_nr);
+    }
+    __atomic_store_n(ring->sq_tail, ring->sqe_tail, __ATOMIC_RELEASE);
+    unsigned pending = ring->sqe_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+
+    struct __kernel_timespec ts = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_nsec = (long long)(timeout_ms % 1000) * 1000000
+    };
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.ts = (uint64_t)(uintptr_t)&ts;
+    int ret = sys_io_uring_enter(ring->fd, pending, wait_nr, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                                 &arg, sizeof(arg));
+    return ret < 0 ? -errno : ret;
+}
+
+/**
+ * @brief Pop the next completion if there is one
+ */
+bool uring_peek_cqe(UringRing *ring, struct io_uring_cqe *cqe) {
+    unsigned head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    *cqe = ring->cqes[head & ring->cq_mask];
+    __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * @brief Register fixed buffers for IORING_OP_READ_FIXED/WRITE_FIXED
+ */
+int uring_register_buffers(UringRing *ring, const struct iovec *iovecs, unsigned count) {
+    if (!ring || !iovecs || count == 0) {
+        return BDIX_ERROR_INVALID_INPUT;
+    }
+    if (sys_io_uring_register(ring->fd, IORING_REGISTER_BUFFERS, iovecs, count) != 0) {
+        LOG_WARN("Failed to register io_uring buffers: %s", strerror(errno));
+        return BDIX_ERROR_MEMORY;
+    }
+    return BDIX_SUCCESS;
+}
+
+/**
+ * @brief Ask the kernel whether the opcodes the probes use are supported
+ */
+static bool probe_opcodes(void) {
+    UringRing *ring = uring_create(8);
+    if (!ring) {
+        return false;
+    }
+
+    size_t size = sizeof(struct io_uring_probe) + URING_PROBE_OPS * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = safe_calloc(1, size);
+    bool ok = sys_io_uring_register(ring->fd, IORING_REGISTER_PROBE, probe, URING_PROBE_OPS) == 0;
+
+    static const uint8_t required[] = {
+        IORING_OP_CONNECT, IORING_OP_LINK_TIMEOUT, IORING_OP_READ_FIXED,
+        IORING_OP_WRITE_FIXED, IORING_OP_CLOSE
+    };
+    for (size_t i = 0; ok && i < ARRAY_SIZE(required); i++) {
+        ok = required[i] <= probe->last_op && (probe->ops[required[i]].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    free(probe);
+    uring_destroy(ring);
+    return ok;
+}
+
+/**
+ * @brief Check whether io_uring can be used for socket probes
+ */
+bool uring_available(void) {
+    static atomic_int cached = 0;   // 0 unknown, 1 usable, -1 not usable
+    int state = atomic_load(&cached);
+    if (state == 0) {
+        state = probe_opcodes() ? 1 : -1;
+        atomic_store(&cached, state);
+    }
+    return state > 0;
+}
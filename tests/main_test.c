@@ -33,15 +33,89 @@ extern int test_server_category_add(void);
 extern int test_server_category_resize(void);
 extern int test_server_data_lifecycle(void);
 extern int test_server_update_status(void);
+extern int test_server_metrics(void);
 
 extern int test_checker_init_cleanup(void);
 extern int test_checker_config(void);
 extern int test_checker_stats(void);
+extern int test_checker_mock_farm(void);
+extern int test_checker_adaptive_timeout(void);
+extern int test_checker_adaptive_dead_mirror(void);
+extern int test_checker_fastest(void);
+extern int test_checker_fastest_uring(void);
+extern int test_checker_retry(void);
+extern int test_checker_retry_budget_exhausted(void);
+extern int test_checker_hedge(void);
+extern int test_checker_sweep_deadline(void);
+extern int test_checker_priority(void);
+extern int test_checker_dead_timeout(void);
+extern int test_checker_autotune(void);
+extern int test_checker_shared_pool(void);
 
 extern int test_config_load_string(void);
 extern int test_config_load_invalid(void);
 extern int test_config_sample_creation(void);
 
+extern int test_scheduler_config(void);
+extern int test_scheduler_stretch_when_stable(void);
+extern int test_scheduler_shrink_on_change(void);
+
+extern int test_thread_pool_basic(void);
+extern int test_thread_pool_delayed(void);
+extern int test_thread_pool_wait_timeout(void);
+extern int test_thread_pool_release_delayed(void);
+extern int test_thread_pool_priority(void);
+extern int test_thread_pool_autotune(void);
+extern int test_thread_pool_autotune_workers(void);
+extern int test_thread_pool_stats(void);
+extern int test_thread_pool_tasks(void);
+extern int test_thread_pool_bounded(void);
+
+extern int test_rate_limit_extract_host(void);
+extern int test_rate_limit_token_bucket(void);
+extern int test_rate_limit_concurrency_cap(void);
+extern int test_rate_limit_waiters(void);
+
+extern int test_alert_detect_transition(void);
+extern int test_alert_webhook_delivery(void);
+
+extern int test_history_append_and_query(void);
+extern int test_history_restore(void);
+
+extern int test_rollup_sketch(void);
+extern int test_rollup_compaction(void);
+
+extern int test_query_rank_and_filter(void);
+
+extern int test_trace_chrome_json(void);
+
+extern int test_log_levels(void);
+extern int test_log_async_threads(void);
+
+extern int test_metrics_registry(void);
+extern int test_metrics_socket(void);
+
+extern int test_icmp_localhost(void);
+extern int test_icmp_servers_share_host(void);
+
+extern int test_tcp_probe_url_port(void);
+extern int test_tcp_probe_sweep(void);
+extern int test_tcp_probe_checker_engine(void);
+extern int test_tcp_probe_sweep_uring(void);
+extern int test_tcp_probe_cancel(void);
+
+extern int test_uring_ring(void);
+extern int test_uring_http_head(void);
+extern int test_uring_split_status_line(void);
+extern int test_uring_checker(void);
+
+extern int test_cancel_token_deadline(void);
+extern int test_cancel_token_sockets(void);
+extern int test_cancel_token_parent(void);
+
+extern int test_retry_budget(void);
+extern int test_retry_backoff(void);
+
 int main(void) {
     printf(TEST_COLOR_BOLD "Running BDIX Server Monitor Test Suite...\n\n" TEST_COLOR_RESET); // flawfinder: ignore
 
@@ -52,6 +126,7 @@ int main(void) {
     RUN_TEST(test_server_category_resize);
     RUN_TEST(test_server_data_lifecycle);
     RUN_TEST(test_server_update_status);
+    RUN_TEST(test_server_metrics);
     printf("\n"); // flawfinder: ignore
 
     // Checker Tests
@@ -59,6 +134,19 @@ int main(void) {
     RUN_TEST(test_checker_init_cleanup);
     RUN_TEST(test_checker_config);
     RUN_TEST(test_checker_stats);
+    RUN_TEST(test_checker_mock_farm);
+    RUN_TEST(test_checker_adaptive_timeout);
+    RUN_TEST(test_checker_adaptive_dead_mirror);
+    RUN_TEST(test_checker_fastest);
+    RUN_TEST(test_checker_fastest_uring);
+    RUN_TEST(test_checker_retry);
+    RUN_TEST(test_checker_retry_budget_exhausted);
+    RUN_TEST(test_checker_hedge);
+    RUN_TEST(test_checker_sweep_deadline);
+    RUN_TEST(test_checker_priority);
+    RUN_TEST(test_checker_dead_timeout);
+    RUN_TEST(test_checker_autotune);
+    RUN_TEST(test_checker_shared_pool);
     printf("\n"); // flawfinder: ignore
 
     // Config Tests
@@ -66,6 +154,111 @@ int main(void) {
     RUN_TEST(test_config_load_string);
     RUN_TEST(test_config_load_invalid);
     RUN_TEST(test_config_sample_creation);
+    printf("\n"); // flawfinder: ignore
+
+    // Scheduler Tests
+    printf(TEST_COLOR_BOLD "--- Scheduler Module Tests ---\n" TEST_COLOR_RESET); // flawfinder: ignore
+    RUN_TEST(test_scheduler_config);
+    RUN_TEST(test_scheduler_stretch_when_stable);
+    RUN_TEST(test_scheduler_shrink_on_change);
+    printf("\n"); // flawfinder: ignore
+
+    // Thread Pool Tests
+    printf(TEST_COLOR_BOLD "--- Thread Pool Module Tests ---\n" TEST_COLOR_RESET); // flawfinder: ignore
+    RUN_TEST(test_thread_pool_basic);
+    RUN_TEST(test_thread_pool_delayed);
+    RUN_TEST(test_thread_pool_wait_timeout);
+    RUN_TEST(test_thread_pool_release_delayed);
+    RUN_TEST(test_thread_pool_priority);
+    RUN_TEST(test_thread_pool_autotune);
+    RUN_TEST(test_thread_pool_autotune_workers);
+    RUN_TEST(test_thread_pool_stats);
+    RUN_TEST(test_thread_pool_tasks);
+    RUN_TEST(test_thread_pool_bounded);
+    printf("\n"); // flawfinder: ignore
+
+    // Rate Limit Tests
+    printf(TEST_COLOR_BOLD "--- Rate Limit Module Tests ---\n" TEST_COLOR_RESET); // flawfinder: ignore
+    RUN_TEST(test_rate_limit_extract_host);
+    RUN_TEST(test_rate_limit_token_bucket);
+    RUN_TEST(test_rate_limit_concurrency_cap);
+    RUN_TEST(test_rate_limit_waiters);
+    printf("\n"); // flawfinder: ignore
+
+    // Alert Tests
+    printf(TEST_COLOR_BOLD "--- Alert Module Tests ---\n" TEST_COLOR_RESET); // flawfinder: ignore
+    RUN_TEST(test_alert_detect_transition);
+    RUN_TEST(test_alert_webhook_delivery);
+    printf("\n"); // flawfinder: ignore
+
+    // History Tests
+    printf(TEST_COLOR_BOLD "--- History Module Tests ---\n" TEST_COLOR_RESET); // flawfinder: ignore
+    RUN_TEST(test_history_append_and_query);
+    RUN_TEST(test_history_restore);
+    printf("\n"); // flawfinder: ignore
+
+    // Rollup Tests
+    printf(TEST_COLOR_BOLD "--- Rollup Module Tests ---\n" TEST_COLOR_RESET); // flawfinder: ignore
+    RUN_TEST(test_rollup_sketch);
+    RUN_TEST(test_rollup_compaction);
+    printf("\n"); // flawfinder: ignore
+
+    // Query Tests
+    printf(TEST_COLOR_BOLD "--- Query Module Tests ---\n" TEST_COLOR_RESET); // flawfinder: ignore
+    RUN_TEST(test_query_rank_and_filter);
+    printf("\n"); // flawfinder: ignore
+
+    // Trace Tests
+    printf(TEST_COLOR_BOLD "--- Trace Module Tests ---\n" TEST_COLOR_RESET); // flawfinder: ignore
+    RUN_TEST(test_trace_chrome_json);
+    printf("\n"); // flawfinder: ignore
+
+    // Log Tests
+    printf(TEST_COLOR_BOLD "--- Log Module Tests ---\n" TEST_COLOR_RESET); // flawfinder: ignore
+    RUN_TEST(test_log_levels);
+    RUN_TEST(test_log_async_threads);
+    printf("\n"); // flawfinder: ignore
+
+    // Metrics Tests
+    printf(TEST_COLOR_BOLD "--- Metrics Module Tests ---\n" TEST_COLOR_RESET); // flawfinder: ignore
+    RUN_TEST(test_metrics_registry);
+    RUN_TEST(test_metrics_socket);
+    printf("\n"); // flawfinder: ignore
+
+    // ICMP Tests
+    printf(TEST_COLOR_BOLD "--- ICMP Module Tests ---\n" TEST_COLOR_RESET); // flawfinder: ignore
+    RUN_TEST(test_icmp_localhost);
+    RUN_TEST(test_icmp_servers_share_host);
+    printf("\n"); // flawfinder: ignore
+
+    // TCP Probe Tests
+    printf(TEST_COLOR_BOLD "--- TCP Probe Module Tests ---\n" TEST_COLOR_RESET); // flawfinder: ignore
+    RUN_TEST(test_tcp_probe_url_port);
+    RUN_TEST(test_tcp_probe_sweep);
+    RUN_TEST(test_tcp_probe_checker_engine);
+    RUN_TEST(test_tcp_probe_sweep_uring);
+    RUN_TEST(test_tcp_probe_cancel);
+    printf("\n"); // flawfinder: ignore
+
+    // io_uring Tests
+    printf(TEST_COLOR_BOLD "--- io_uring Module Tests ---\n" TEST_COLOR_RESET); // flawfinder: ignore
+    RUN_TEST(test_uring_ring);
+    RUN_TEST(test_uring_http_head);
+    RUN_TEST(test_uring_split_status_line);
+    RUN_TEST(test_uring_checker);
+    printf("\n"); // flawfinder: ignore
+
+    // Cancellation Tests
+    printf(TEST_COLOR_BOLD "--- Cancellation Module Tests ---\n" TEST_COLOR_RESET); // flawfinder: ignore
+    RUN_TEST(test_cancel_token_deadline);
+    RUN_TEST(test_cancel_token_sockets);
+    RUN_TEST(test_cancel_token_parent);
+    printf("\n"); // flawfinder: ignore
+
+    // Retry Tests
+    printf(TEST_COLOR_BOLD "--- Retry Module Tests ---\n" TEST_COLOR_RESET); // flawfinder: ignore
+    RUN_TEST(test_retry_budget);
+    RUN_TEST(test_retry_backoff);
 
     PRINT_TEST_SUMMARY();
 
@@ -0,0 +1,498 @@
+/**
+ * @file mock_farm.c
+ * @brief Loopback HTTP server emulating many BDIX hosts for tests and benchmarks
+ * @version 1.0.0
+ */
+
+#include "mock_farm.h"
+#include <curl/curl.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+#define MOCK_FARM_MAX_EVENTS 256
+#define MOCK_FARM_NOT_SCHEDULED SIZE_MAX
+
+/**
+ * @brief Client connection
+ */
+struct MockConn {
+    int fd;
+    size_t length;                  // Request bytes received
+    bool handled;                   // Request complete and dispatched
+    double due_ms;                  // When the delayed response is sent
+    int status_code;                // Delayed response status
+    size_t heap_index;              // Position in the timer heap
+    MockConn *prev;                 // Open connections list
+    MockConn *next;
+    char request[MOCK_FARM_MAX_REQUEST]; /* flawfinder: ignore - bounds checked on every recv */
+};
+
+/**
+ * @brief Next pseudo-random number (xorshift64*)
+ */
+static uint64_t farm_next_random(MockFarm *farm) {
+    farm->rng ^= farm->rng >> 12;
+    farm->rng ^= farm->rng << 25;
+    farm->rng ^= farm->rng >> 27;
+    return farm->rng * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief Uniform double in (0, 1)
+ */
+static double farm_uniform(MockFarm *farm) {
+    return ((farm_next_random(farm) >> 11) + 0.5) / 9007199254740992.0;
+}
+
+/**
+ * @brief Sample a response delay from a host's log-normal distribution
+ */
+static double farm_sample_delay(MockFarm *farm, const MockHostProfile *profile) {
+    if (profile->latency_ms <= 0.0) {
+        return 0.0;
+    }
+    if (profile->latency_sigma <= 0.0) {
+        return profile->latency_ms;
+    }
+
+    // Box-Muller standard normal
+    double z = sqrt(-2.0 * log(farm_uniform(farm))) * cos(2.0 * 3.14159265358979323846 * farm_uniform(farm));
+    return profile->latency_ms * exp(profile->latency_sigma * z);
+}
+
+/* ---------- Timer heap ---------- */
+
+static void heap_swap(MockFarm *farm, size_t a, size_t b) {
+    MockConn *tmp = farm->timers[a];
+    farm->timers[a] = farm->timers[b];
+    farm->timers[b] = tmp;
+    farm->timers[a]->heap_index = a;
+    farm->timers[b]->heap_index = b;
+}
+
+static void heap_sift_up(MockFarm *farm, size_t i) {
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (farm->timers[parent]->due_ms <= farm->timers[i]->due_ms) {
+            break;
+        }
+        heap_swap(farm, i, parent);
+        i = parent;
+    }
+}
+
+static void heap_sift_down(MockFarm *farm, size_t i) {
+    for (;;) {
+        size_t smallest = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+        if (left < farm->timer_count && farm->timers[left]->due_ms < farm->timers[smallest]->due_ms) {
+            smallest = left;
+        }
+        if (right < farm->timer_count && farm->timers[right]->due_ms < farm->timers[smallest]->due_ms) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            return;
+        }
+        heap_swap(farm, i, smallest);
+        i = smallest;
+    }
+}
+
+static void heap_push(MockFarm *farm, MockConn *conn) {
+    if (farm->timer_count == farm->timer_capacity) {
+        farm->timer_capacity = farm->timer_capacity ? farm->timer_capacity * 2 : 64;
+        farm->timers = safe_realloc(farm->timers, farm->timer_capacity * sizeof(MockConn*));
+    }
+    conn->heap_index = farm->timer_count;
+    farm->timers[farm->timer_count++] = conn;
+    heap_sift_up(farm, conn->heap_index);
+}
+
+static void heap_remove(MockFarm *farm, MockConn *conn) {
+    size_t i = conn->heap_index;
+    if (i == MOCK_FARM_NOT_SCHEDULED) {
+        return;
+    }
+
+    conn->heap_index = MOCK_FARM_NOT_SCHEDULED;
+    farm->timer_count--;
+    if (i == farm->timer_count) {
+        return;
+    }
+    farm->timers[i] = farm->timers[farm->timer_count];
+    farm->timers[i]->heap_index = i;
+    heap_sift_up(farm, i);
+    heap_sift_down(farm, farm->timers[i]->heap_index);
+}
+
+/* ---------- Connections ---------- */
+
+/**
+ * @brief Close a connection (with a reset if requested) and free it
+ */
+static void conn_close(MockFarm *farm, MockConn *conn, bool reset) {
+    heap_remove(farm, conn);
+    epoll_ctl(farm->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+
+    if (reset) {
+        struct linger lg = { .l_onoff = 1, .l_linger = 0 };
+        setsockopt(conn->fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    }
+    close(conn->fd);
+
+    if (conn->prev) {
+        conn->prev->next = conn->next;
+    } else {
+        farm->open = conn->next;
+    }
+    if (conn->next) {
+        conn->next->prev = conn->prev;
+    }
+    free(conn);
+}
+
+/**
+ * @brief Reason phrase of a status code
+ */
+static const char* status_reason(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 301: return "Moved Permanently";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 500: return "Internal Server Error";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        default: return "Status";
+    }
+}
+
+/**
+ * @brief Send the response of a virtual host and close
+ */
+static void conn_respond(MockFarm *farm, MockConn *conn, int status_code) {
+    char reply[128]; /* flawfinder: ignore - bounds checked with snprintf */
+    int len = snprintf(reply, sizeof(reply), // flawfinder: ignore
+                       "HTTP/1.1 %d %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+                       status_code, status_reason(status_code));
+    if (len > 0 && send(conn->fd, reply, (size_t)len, MSG_NOSIGNAL) == len) {
+        atomic_fetch_add(&farm->responses, 1);
+    }
+    conn_close(farm, conn, false);
+}
+
+/**
+ * @brief Virtual host index from the request's Host header (SIZE_MAX if unknown)
+ */
+static size_t request_host(const char *request) {
+    for (const char *line = strchr(request, '\n'); line; line = strchr(line + 1, '\n')) {
+        const char *h = line + 1;
+        if (strncmp(h, "Host:", 5) != 0 && strncmp(h, "host:", 5) != 0) {
+            continue;
+        }
+        h += 5;
+        while (*h == ' ') {
+            h++;
+        }
+        if (h[0] != 'v' || h[1] != 'h' || !isdigit((unsigned char)h[2])) {
+            return SIZE_MAX;
+        }
+        return (size_t)strtoull(h + 2, NULL, 10);
+    }
+    return SIZE_MAX;
+}
+
+/**
+ * @brief Dispatch a complete request according to the host profile
+ */
+static void conn_dispatch(MockFarm *farm, MockConn *conn) {
+    conn->handled = true;
+    atomic_fetch_add(&farm->requests, 1);
+
+    size_t host = request_host(conn->request);
+    pthread_mutex_lock(&farm->profile_mutex);
+    MockHostProfile *shared = host < farm->host_count ? &farm->profiles[host] : &farm->fallback;
+    const MockHostProfile current = *shared;
+    if (shared->drop_requests > 0) {
+        shared->drop_requests--;
+    }
+    pthread_mutex_unlock(&farm->profile_mutex);
+    const MockHostProfile *profile = &current;
+
+    // Lost requests look like a blackhole to this one client
+    if (profile->drop_requests > 0 ||
+        (profile->loss_pct > 0.0 && farm_uniform(farm) * 100.0 < profile->loss_pct)) {
+        atomic_fetch_add(&farm->blackholed, 1);
+        return;
+    }
+
+    switch (profile->behavior) {
+        case MOCK_RESET:
+            atomic_fetch_add(&farm->resets, 1);
+            conn_close(farm, conn, true);
+            return;
+        case MOCK_BLACKHOLE:
+            // Held open until the client gives up
+            atomic_fetch_add(&farm->blackholed, 1);
+            return;
+        case MOCK_RESPOND:
+            break;
+    }
+
+    double delay = farm_sample_delay(farm, profile);
+    if (delay <= 0.0) {
+        conn_respond(farm, conn, profile->status_code);
+        return;
+    }
+    conn->due_ms = get_time_ms() + delay;
+    conn->status_code = profile->status_code;
+    heap_push(farm, conn);
+}
+
+/**
+ * @brief Accept all pending connections
+ */
+static void farm_accept(MockFarm *farm) {
+    for (;;) {
+        int fd = accept(farm->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            return;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+        MockConn *conn = safe_calloc(1, sizeof(MockConn));
+        conn->fd = fd;
+        conn->heap_index = MOCK_FARM_NOT_SCHEDULED;
+        conn->next = farm->open;
+        if (farm->open) {
+            farm->open->prev = conn;
+        }
+        farm->open = conn;
+
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = conn };
+        if (epoll_ctl(farm->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            conn_close(farm, conn, false);
+        }
+    }
+}
+
+/**
+ * @brief Read from a connection and dispatch once the headers are complete
+ */
+static void conn_read(MockFarm *farm, MockConn *conn) {
+    for (;;) {
+        char *dst = conn->request + conn->length;
+        size_t room = sizeof(conn->request) - 1 - conn->length;
+        char discard[256]; /* flawfinder: ignore - bounded recv */
+        if (room == 0 || conn->handled) {
+            // Drain anything after the request (or an oversized request)
+            dst = discard;
+            room = sizeof(discard);
+        }
+
+        ssize_t n = recv(conn->fd, dst, room, 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            conn_close(farm, conn, false);
+            return;
+        }
+        if (n < 0) {
+            return;
+        }
+        if (dst == discard) {
+            continue;
+        }
+
+        conn->length += (size_t)n;
+        conn->request[conn->length] = '\0';
+        if (strstr(conn->request, "\r\n\r\n")) {
+            conn_dispatch(farm, conn);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Event loop
+ */
+static void* farm_thread(void *arg) {
+    MockFarm *farm = (MockFarm*)arg;
+    struct epoll_event events[MOCK_FARM_MAX_EVENTS];
+
+    for (;;) {
+        int timeout = -1;
+        if (farm->timer_count > 0) {
+            double wait = farm->timers[0]->due_ms - get_time_ms();
+            timeout = wait > 0.0 ? (int)ceil(wait) : 0;
+        }
+
+        int n = epoll_wait(farm->epoll_fd, events, MOCK_FARM_MAX_EVENTS, timeout);
+        if (n < 0 && errno != EINTR) {
+            LOG_ERROR("Mock farm epoll_wait failed: %s", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            void *ptr = events[i].data.ptr;
+            if (ptr == &farm->wake_fd) {
+                return NULL;
+            }
+            if (ptr == &farm->listen_fd) {
+                farm_accept(farm);
+                continue;
+            }
+            conn_read(farm, (MockConn*)ptr);
+        }
+
+        // Send responses whose delay has elapsed
+        double now = get_time_ms();
+        while (farm->timer_count > 0 && farm->timers[0]->due_ms <= now) {
+            MockConn *conn = farm->timers[0];
+            heap_remove(farm, conn);
+            conn_respond(farm, conn, conn->status_code);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Start a farm on an ephemeral loopback port
+ */
+MockFarm* mock_farm_start(size_t host_count) {
+    MockFarm *farm = safe_calloc(1, sizeof(MockFarm));
+    farm->listen_fd = -1;
+    farm->epoll_fd = -1;
+    farm->wake_fd = -1;
+    farm->host_count = host_count;
+    farm->profiles = safe_calloc(host_count > 0 ? host_count : 1, sizeof(MockHostProfile));
+    farm->fallback = (MockHostProfile){ .behavior = MOCK_RESPOND, .status_code = 404 };
+    farm->rng = 0x9E3779B97F4A7C15ULL ^ (uint64_t)get_time_ms();
+    for (size_t i = 0; i < host_count; i++) {
+        farm->profiles[i] = (MockHostProfile){ .behavior = MOCK_RESPOND, .status_code = 200 };
+    }
+    pthread_mutex_init(&farm->profile_mutex, NULL);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    int one = 1;
+
+    farm->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (farm->listen_fd < 0 ||
+        setsockopt(farm->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        bind(farm->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(farm->listen_fd, SOMAXCONN) != 0 ||
+        getsockname(farm->listen_fd, (struct sockaddr*)&addr, &addr_len) != 0) {
+        LOG_ERROR("Mock farm failed to listen: %s", strerror(errno));
+        goto fail;
+    }
+    farm->port = ntohs(addr.sin_port);
+
+    farm->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    farm->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (farm->epoll_fd < 0 || farm->wake_fd < 0) {
+        LOG_ERROR("Mock farm failed to create epoll instance: %s", strerror(errno));
+        goto fail;
+    }
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &farm->listen_fd };
+    struct epoll_event wake = { .events = EPOLLIN, .data.ptr = &farm->wake_fd };
+    if (epoll_ctl(farm->epoll_fd, EPOLL_CTL_ADD, farm->listen_fd, &ev) != 0 ||
+        epoll_ctl(farm->epoll_fd, EPOLL_CTL_ADD, farm->wake_fd, &wake) != 0) {
+        LOG_ERROR("Mock farm failed to register sockets: %s", strerror(errno));
+        goto fail;
+    }
+
+    if (pthread_create(&farm->thread, NULL, farm_thread, farm) != 0) {
+        LOG_ERROR("Mock farm failed to start its thread");
+        goto fail;
+    }
+    return farm;
+
+fail:
+    if (farm->wake_fd >= 0) close(farm->wake_fd);
+    if (farm->epoll_fd >= 0) close(farm->epoll_fd);
+    if (farm->listen_fd >= 0) close(farm->listen_fd);
+    pthread_mutex_destroy(&farm->profile_mutex);
+    free(farm->profiles);
+    free(farm);
+    return NULL;
+}
+
+/**
+ * @brief Stop the farm, close all connections and free it
+ */
+void mock_farm_stop(MockFarm *farm) {
+    if (!farm) {
+        return;
+    }
+
+    uint64_t one = 1;
+    if (write(farm->wake_fd, &one, sizeof(one)) == (ssize_t)sizeof(one)) {
+        pthread_join(farm->thread, NULL);
+    } else {
+        pthread_cancel(farm->thread);
+        pthread_join(farm->thread, NULL);
+    }
+
+    while (farm->open) {
+        conn_close(farm, farm->open, false);
+    }
+
+    close(farm->wake_fd);
+    close(farm->epoll_fd);
+    close(farm->listen_fd);
+    free(farm->timers);
+    pthread_mutex_destroy(&farm->profile_mutex);
+    free(farm->profiles);
+    free(farm);
+}
+
+/**
+ * @brief Set the profile of one virtual host
+ */
+void mock_farm_set_profile(MockFarm *farm, size_t host, const MockHostProfile *profile) {
+    if (farm && profile && host < farm->host_count) {
+        pthread_mutex_lock(&farm->profile_mutex);
+        farm->profiles[host] = *profile;
+        pthread_mutex_unlock(&farm->profile_mutex);
+    }
+}
+
+/**
+ * @brief Format the URL of a virtual host
+ */
+void mock_farm_url(const MockFarm *farm, size_t host, char *url, size_t size) {
+    snprintf(url, size, "http://" MOCK_FARM_HOST_FORMAT ":%d/", host, farm->port); // flawfinder: ignore
+}
+
+/**
+ * @brief Build CURLOPT_RESOLVE entries pinning every virtual host to the farm
+ */
+struct curl_slist* mock_farm_resolve_list(const MockFarm *farm) {
+    char entry[128]; /* flawfinder: ignore - bounds checked with snprintf */
+
+#if LIBCURL_VERSION_NUM >= 0x075600
+    snprintf(entry, sizeof(entry), "*:%d:127.0.0.1", farm->port); // flawfinder: ignore
+    return curl_slist_append(NULL, entry);
+#else
+    struct curl_slist *list = NULL;
+    for (size_t i = 0; i < farm->host_count; i++) {
+        snprintf(entry, sizeof(entry), MOCK_FARM_HOST_FORMAT ":%d:127.0.0.1", i, farm->port); // flawfinder: ignore
+        struct curl_slist *next = curl_slist_append(list, entry);
+        if (!next) {
+            curl_slist_free_all(list);
+            return NULL;
+        }
+        list = next;
+    }
+    return list;
+#endif
+}
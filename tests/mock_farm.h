@@ -0,0 +1,114 @@
+/**
+ * @file mock_farm.h
+ * @brief Loopback HTTP server emulating many BDIX hosts for tests and benchmarks
+ * @version 1.0.0
+ */
+
+#ifndef BDIX_MOCK_FARM_H
+#define BDIX_MOCK_FARM_H
+
+#include "../include/common.h"
+#include <pthread.h>
+
+struct curl_slist;
+
+// Virtual host names are MOCK_FARM_HOST_FORMAT with the host index
+#define MOCK_FARM_HOST_FORMAT "vh%05zu.mock.bdix"
+#define MOCK_FARM_MAX_REQUEST 2048
+
+/**
+ * @brief What a virtual host does with a request
+ */
+typedef enum {
+    MOCK_RESPOND,                   // Reply with status_code after the sampled latency
+    MOCK_RESET,                     // Abort the connection with a TCP reset
+    MOCK_BLACKHOLE                  // Read the request and never answer
+} MockBehavior;
+
+/**
+ * @brief Behavior and latency distribution of one virtual host
+ */
+typedef struct {
+    MockBehavior behavior;
+    int status_code;                // HTTP status for MOCK_RESPOND
+    double latency_ms;              // Median response delay
+    double latency_sigma;           // Log-normal shape (0 = fixed delay)
+    double loss_pct;                // Share of requests silently dropped (transient loss)
+    unsigned drop_requests;         // Next requests to drop before behaving normally
+} MockHostProfile;
+
+/**
+ * @brief Client connection (private to mock_farm.c)
+ */
+typedef struct MockConn MockConn;
+
+/**
+ * @brief Mock HTTP farm (one epoll thread on a loopback port)
+ */
+typedef struct {
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;                    // eventfd used to stop the loop
+    int port;
+    MockHostProfile *profiles;      // Indexed by virtual host number (protected by profile_mutex)
+    size_t host_count;
+    MockHostProfile fallback;       // For unknown Host headers
+    pthread_mutex_t profile_mutex;  // Profiles change while the farm thread serves them
+    MockConn *open;                 // Open connections
+    MockConn **timers;              // Min-heap of delayed responses
+    size_t timer_count;
+    size_t timer_capacity;
+    uint64_t rng;
+    pthread_t thread;
+    _Atomic size_t requests;        // Complete requests received
+    _Atomic size_t responses;       // Responses sent
+    _Atomic size_t resets;
+    _Atomic size_t blackholed;
+} MockFarm;
+
+/**
+ * @brief Start a farm on an ephemeral loopback port
+ *
+ * @param host_count Number of virtual hosts (all MOCK_RESPOND 200 without delay)
+ * @return Pointer to farm or NULL on error
+ */
+MockFarm* mock_farm_start(size_t host_count);
+
+/**
+ * @brief Stop the farm, close all connections and free it
+ *
+ * @param farm Pointer to farm
+ */
+void mock_farm_stop(MockFarm *farm);
+
+/**
+ * @brief Set the profile of one virtual host (safe while traffic is served)
+ *
+ * @param farm Pointer to farm
+ * @param host Host index
+ * @param profile Pointer to profile
+ */
+void mock_farm_set_profile(MockFarm *farm, size_t host, const MockHostProfile *profile);
+
+/**
+ * @brief Format the URL of a virtual host
+ *
+ * @param farm Pointer to farm
+ * @param host Host index
+ * @param url Output buffer
+ * @param size Buffer size
+ */
+void mock_farm_url(const MockFarm *farm, size_t host, char *url, size_t size);
+
+/**
+ * @brief Build CURLOPT_RESOLVE entries pinning every virtual host to the farm
+ *
+ * Uses a single wildcard entry where libcurl supports it (7.86+),
+ * otherwise one entry per host.
+ *
+ * @param farm Pointer to farm
+ * @return List to pass as CheckerConfig.resolve (free with curl_slist_free_all())
+ */
+struct curl_slist* mock_farm_resolve_list(const MockFarm *farm);
+
+#endif // BDIX_MOCK_FARM_H
@@ -0,0 +1,136 @@
+#include "test_common.h"
+#include "../include/alert.h"
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/**
+ * @brief Minimal one-shot HTTP stand-in that records a request body
+ */
+typedef struct {
+    int listen_fd;
+    char request[4096]; // flawfinder: ignore
+    size_t length;
+} HttpStandIn;
+
+static void* http_stand_in_thread(void *arg) {
+    HttpStandIn *srv = (HttpStandIn*)arg;
+
+    int fd = accept(srv->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    // Read headers and body until the announced Content-Length has arrived
+    while (srv->length < sizeof(srv->request) - 1) {
+        ssize_t n = recv(fd, srv->request + srv->length, sizeof(srv->request) - 1 - srv->length, 0);
+        if (n <= 0) {
+            break;
+        }
+        srv->length += (size_t)n;
+        srv->request[srv->length] = '\0';
+
+        char *body = strstr(srv->request, "\r\n\r\n");
+        char *cl = strstr(srv->request, "Content-Length:");
+        if (body && cl && (size_t)(srv->request + srv->length - (body + 4)) >= (size_t)atol(cl + 15)) {
+            break;
+        }
+    }
+
+    const char *reply = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    send(fd, reply, strlen(reply), MSG_NOSIGNAL); // flawfinder: ignore
+    close(fd);
+    return NULL;
+}
+
+int test_alert_detect_transition(void) {
+    Server s;
+    memset(&s, 0, sizeof(Server));
+    ServerStatus from = BDIX_STATUS_UNKNOWN;
+
+    // Baseline, then a single flap must not confirm with 2-of-3
+    s.status = BDIX_STATUS_ONLINE;
+    TEST_ASSERT(!alert_detect_transition(&s, 2, 3, &from), "Baseline should not alert");
+    s.status = BDIX_STATUS_TIMEOUT;
+    TEST_ASSERT(!alert_detect_transition(&s, 2, 3, &from), "Single failure should not alert");
+    s.status = BDIX_STATUS_ONLINE;
+    TEST_ASSERT(!alert_detect_transition(&s, 2, 3, &from), "Recovery should not alert");
+
+    // Two failures out of three confirm the outage
+    s.status = BDIX_STATUS_ERROR;
+    TEST_ASSERT(alert_detect_transition(&s, 2, 3, &from), "Second failure in window should alert");
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_ONLINE, from);
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_ERROR, s.transition.confirmed);
+
+    // Staying down does not re-alert
+    s.status = BDIX_STATUS_TIMEOUT;
+    TEST_ASSERT(!alert_detect_transition(&s, 2, 3, &from), "Still down should not alert");
+
+    // Wider window than confirmations: the reset window holds window_m observations
+    memset(&s, 0, sizeof(Server));
+    s.status = BDIX_STATUS_OFFLINE;
+    TEST_ASSERT(!alert_detect_transition(&s, 2, 6, &from), "Baseline should not alert");
+    s.status = BDIX_STATUS_ONLINE;
+    TEST_ASSERT(!alert_detect_transition(&s, 2, 6, &from), "Single recovery should not alert");
+    TEST_ASSERT(alert_detect_transition(&s, 2, 6, &from), "Second recovery should alert");
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_OFFLINE, from);
+    s.status = BDIX_STATUS_OFFLINE;
+    TEST_ASSERT(!alert_detect_transition(&s, 2, 6, &from), "Single failure after recovery should not alert");
+    TEST_ASSERT(alert_detect_transition(&s, 2, 6, &from), "Second failure should alert");
+
+    return 1;
+}
+
+int test_alert_webhook_delivery(void) {
+    HttpStandIn srv;
+    memset(&srv, 0, sizeof(srv));
+
+    srv.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    TEST_ASSERT(srv.listen_fd >= 0, "Failed to create listen socket");
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+
+    TEST_ASSERT(bind(srv.listen_fd, (struct sockaddr*)&addr, sizeof(addr)) == 0, "bind failed");
+    TEST_ASSERT(listen(srv.listen_fd, 1) == 0, "listen failed");
+    TEST_ASSERT(getsockname(srv.listen_fd, (struct sockaddr*)&addr, &len) == 0, "getsockname failed");
+
+    pthread_t thread;
+    TEST_ASSERT(pthread_create(&thread, NULL, http_stand_in_thread, &srv) == 0, "thread failed");
+
+    AlertConfig cfg = alert_get_default_config();
+    cfg.sink = ALERT_SINK_WEBHOOK;
+    cfg.flush_interval_ms = 10;
+    cfg.sink_timeout_seconds = 5;
+    snprintf(cfg.target, sizeof(cfg.target), "http://127.0.0.1:%d/hook", ntohs(addr.sin_port)); // flawfinder: ignore
+
+    AlertManager *manager = alert_manager_create(&cfg);
+    TEST_ASSERT_NOT_NULL(manager);
+
+    AlertEvent event = {
+        .from = BDIX_STATUS_ONLINE,
+        .to = BDIX_STATUS_TIMEOUT,
+        .latency_ms = 12.5,
+        .response_code = 0,
+        .timestamp = time(NULL)
+    };
+    safe_strncpy(event.url, "http://mirror.example.bd", sizeof(event.url));
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, alert_enqueue(manager, &event));
+
+    alert_manager_flush(manager);
+    pthread_join(thread, NULL);
+    close(srv.listen_fd);
+
+    TEST_ASSERT_EQUAL_INT(1, atomic_load(&manager->delivered));
+    TEST_ASSERT(strstr(srv.request, "POST /hook") != NULL, "Expected POST to webhook path");
+    TEST_ASSERT(strstr(srv.request, "http://mirror.example.bd") != NULL, "Event URL missing from body");
+    TEST_ASSERT(strstr(srv.request, "TIMEOUT") != NULL, "Event status missing from body");
+
+    alert_manager_destroy(manager);
+    return 1;
+}
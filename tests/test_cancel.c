@@ -0,0 +1,94 @@
+#include "test_common.h"
+#include "../include/cancel.h"
+#include <sys/socket.h>
+
+int test_cancel_token_deadline(void) {
+    CancelToken token;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, cancel_token_init(&token));
+
+    TEST_ASSERT(!cancel_token_check(&token), "Fresh token is cancelled");
+    TEST_ASSERT_EQUAL_INT(100, cancel_token_wait_ms(&token, 100));
+    TEST_ASSERT_EQUAL_INT(-1, cancel_token_wait_ms(&token, -1));
+    TEST_ASSERT(!cancel_token_check(NULL), "NULL token is cancelled");
+
+    // The earliest deadline wins
+    double now = get_time_ms();
+    cancel_token_set_deadline(&token, now + 60.0);
+    cancel_token_set_deadline(&token, now + 5000.0);
+    int wait_ms = cancel_token_wait_ms(&token, -1);
+    TEST_ASSERT(wait_ms > 0 && wait_ms <= 60, "Wait not clamped to the deadline");
+    TEST_ASSERT_EQUAL_INT(10, cancel_token_wait_ms(&token, 10));
+    TEST_ASSERT(!cancel_token_check(&token), "Cancelled before the deadline");
+
+    sleep_ms(80);
+    TEST_ASSERT(cancel_token_check(&token), "Not cancelled after the deadline");
+    TEST_ASSERT_EQUAL_INT(0, cancel_token_wait_ms(&token, 100));
+
+    cancel_token_destroy(&token);
+    return 1;
+}
+
+int test_cancel_token_sockets(void) {
+    CancelToken token;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, cancel_token_init(&token));
+
+    int kept[2];
+    int removed[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, kept));
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, removed));
+    TEST_ASSERT(cancel_token_add_fd(&token, kept[0]), "Registration refused");
+    TEST_ASSERT(cancel_token_add_fd(&token, removed[0]), "Registration refused");
+    cancel_token_remove_fd(&token, removed[0]);
+
+    // A blocked read on a registered socket returns once cancelled
+    cancel_token_cancel(&token);
+    char byte; /* flawfinder: ignore - single byte read */
+    TEST_ASSERT_EQUAL_INT(0, (int)recv(kept[0], &byte, 1, 0));
+    TEST_ASSERT_EQUAL_INT(-1, (int)recv(removed[0], &byte, 1, MSG_DONTWAIT));
+    TEST_ASSERT(cancel_token_check(&token), "Not cancelled");
+    TEST_ASSERT(!cancel_token_add_fd(&token, removed[0]), "Registered after cancel");
+
+    for (int i = 0; i < 2; i++) {
+        close(kept[i]);
+        close(removed[i]);
+    }
+    cancel_token_destroy(&token);
+    return 1;
+}
+
+int test_cancel_token_parent(void) {
+    CancelToken parent;
+    CancelToken child;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, cancel_token_init(&parent));
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, cancel_token_init_child(&child, &parent));
+
+    // A child polls for its parent and never outlives the parent's deadline
+    TEST_ASSERT_EQUAL_INT(CANCEL_POLL_MS, cancel_token_wait_ms(&child, -1));
+    cancel_token_set_deadline(&parent, get_time_ms() + 40.0);
+    int wait_ms = cancel_token_wait_ms(&child, -1);
+    TEST_ASSERT(wait_ms > 0 && wait_ms <= 40, "Child wait not clamped to the parent deadline");
+    sleep_ms(60);
+    TEST_ASSERT(cancel_token_check(&child), "Child outlived the parent deadline");
+    TEST_ASSERT(cancel_token_check(&parent), "Parent not cancelled at its deadline");
+    cancel_token_destroy(&child);
+    cancel_token_destroy(&parent);
+
+    // A requested cancel shuts down the child's sockets at its next check
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, cancel_token_init(&parent));
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, cancel_token_init_child(&child, &parent));
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    TEST_ASSERT(cancel_token_add_fd(&child, fds[0]), "Registration refused");
+    cancel_token_request(&parent);
+    TEST_ASSERT_EQUAL_INT(0, cancel_token_wait_ms(&parent, 100));
+    TEST_ASSERT(!atomic_load(&child.cancelled), "Request cancelled the child directly");
+    TEST_ASSERT(cancel_token_check(&child), "Child not cancelled with its parent");
+    char byte; /* flawfinder: ignore - single byte read */
+    TEST_ASSERT_EQUAL_INT(0, (int)recv(fds[0], &byte, 1, 0));
+
+    close(fds[0]);
+    close(fds[1]);
+    cancel_token_destroy(&child);
+    cancel_token_destroy(&parent);
+    return 1;
+}
@@ -1,5 +1,8 @@
 #include "test_common.h"
 #include "../include/checker.h"
+#include "../include/uring.h"
+#include "mock_farm.h"
+#include <curl/curl.h>
 
 int test_checker_init_cleanup(void) {
     // Just verify we can init and cleanup without crashing
@@ -30,6 +33,7 @@ int test_checker_stats(void) {
     memset(&s, 0, sizeof(Server));
     s.status = BDIX_STATUS_ONLINE;
     s.latency_ms = 100.0;
+    s.timing = (ServerTiming){ .dns_ms = 10.0, .connect_ms = 20.0, .server_ms = 70.0, .total_ms = 100.0 };
 
     checker_stats_update(&stats, &s);
 
@@ -45,5 +49,633 @@ int test_checker_stats(void) {
     TEST_ASSERT_EQUAL_INT(1, stats.online_count);
     TEST_ASSERT_EQUAL_INT(1, stats.offline_count);
 
+    // Phase averages only count online checks
+    ServerTiming avg = checker_stats_get_avg_timing(&stats);
+    TEST_ASSERT(avg.dns_ms == 10.0 && avg.connect_ms == 20.0, "Handshake averages mismatch");
+    TEST_ASSERT(avg.tls_ms == 0.0 && avg.server_ms == 70.0, "Server average mismatch");
+
+    return 1;
+}
+
+int test_checker_adaptive_timeout(void) {
+    CheckerConfig cfg = checker_get_default_config();
+    AdaptiveTimeoutPolicy policy = checker_get_default_adaptive_timeout();
+    long timeout_ms;
+    long connect_ms;
+
+    Server s;
+    memset(&s, 0, sizeof(s));
+    strcpy(s.url, "http://test.com"); // flawfinder: ignore
+
+    // No policy: the global timeouts
+    TEST_ASSERT(!checker_server_deadlines(&s, &cfg, &timeout_ms, &connect_ms), "Adapted without a policy");
+    TEST_ASSERT_EQUAL_INT(cfg.timeout_seconds * 1000, (int)timeout_ms);
+    TEST_ASSERT_EQUAL_INT(cfg.connect_timeout_seconds * 1000, (int)connect_ms);
+
+    // Too little history: still global
+    cfg.adaptive_timeout = &policy;
+    for (unsigned i = 0; i + 1 < policy.min_samples; i++) {
+        server_update_status(&s, BDIX_STATUS_ONLINE, 8.0, 200);
+    }
+    TEST_ASSERT(!checker_server_deadlines(&s, &cfg, &timeout_ms, &connect_ms), "Adapted on too few samples");
+
+    // Fast server: clamped to the floor, connect deadline never longer
+    server_update_status(&s, BDIX_STATUS_ONLINE, 8.0, 200);
+    TEST_ASSERT(checker_server_deadlines(&s, &cfg, &timeout_ms, &connect_ms), "Known server not adapted");
+    TEST_ASSERT_EQUAL_INT(policy.floor_ms, (int)timeout_ms);
+    TEST_ASSERT_EQUAL_INT(policy.floor_ms, (int)connect_ms);
+
+    // Slower server: quantile times multiplier
+    for (int i = 0; i < SERVER_SAMPLE_RING; i++) {
+        server_update_status(&s, BDIX_STATUS_ONLINE, 300.0, 200);
+    }
+    checker_server_deadlines(&s, &cfg, &timeout_ms, &connect_ms);
+    TEST_ASSERT_EQUAL_INT((int)(300.0 * policy.multiplier), (int)timeout_ms);
+    TEST_ASSERT_EQUAL_INT(cfg.connect_timeout_seconds * 1000 < timeout_ms ?
+                          cfg.connect_timeout_seconds * 1000 : (int)timeout_ms, (int)connect_ms);
+
+    // The first timeout earns one check with the full deadline, later ones do not
+    server_update_status(&s, BDIX_STATUS_TIMEOUT, 1200.0, 0);
+    TEST_ASSERT(!checker_server_deadlines(&s, &cfg, &timeout_ms, &connect_ms), "No full retry after a timeout");
+    server_update_status(&s, BDIX_STATUS_TIMEOUT, 10000.0, 0);
+    TEST_ASSERT(checker_server_deadlines(&s, &cfg, &timeout_ms, &connect_ms), "Dead server kept the full deadline");
+
+    // Ceiling and the global timeout bound the deadline
+    policy.ceiling_ms = 700;
+    checker_server_deadlines(&s, &cfg, &timeout_ms, &connect_ms);
+    TEST_ASSERT_EQUAL_INT(700, (int)timeout_ms);
+    policy.ceiling_ms = 0;
+    policy.multiplier = 1000.0;
+    TEST_ASSERT(!checker_server_deadlines(&s, &cfg, &timeout_ms, &connect_ms), "Deadline above the global one");
+    TEST_ASSERT_EQUAL_INT(cfg.timeout_seconds * 1000, (int)timeout_ms);
+    return 1;
+}
+
+int test_checker_adaptive_dead_mirror(void) {
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_init());
+
+    MockFarm *farm = mock_farm_start(1);
+    TEST_ASSERT_NOT_NULL(farm);
+    const MockHostProfile blackhole = { .behavior = MOCK_BLACKHOLE };
+    mock_farm_set_profile(farm, 0, &blackhole);
+
+    // A mirror that used to answer in a few milliseconds stops answering
+    Server s;
+    memset(&s, 0, sizeof(s));
+    mock_farm_url(farm, 0, s.url, sizeof(s.url));
+    for (int i = 0; i < 10; i++) {
+        server_update_status(&s, BDIX_STATUS_ONLINE, 8.0, 200);
+    }
+
+    AdaptiveTimeoutPolicy policy = checker_get_default_adaptive_timeout();
+    CheckerConfig cfg = checker_get_default_config();
+    cfg.timeout_seconds = 5;
+    cfg.adaptive_timeout = &policy;
+    cfg.resolve = mock_farm_resolve_list(farm);
+
+    double start = get_time_ms();
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_check_server(&s, &cfg));
+    double elapsed = get_time_ms() - start;
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_CUTOFF, s.status);
+    TEST_ASSERT(elapsed < policy.floor_ms * 3.0, "Dead mirror held the full timeout");
+
+    // The cut-off earns one check with the full deadline
+    long timeout_ms, connect_ms;
+    TEST_ASSERT(!checker_server_deadlines(&s, &cfg, &timeout_ms, &connect_ms), "No full retry after a cut-off");
+
+    curl_slist_free_all(cfg.resolve);
+    mock_farm_stop(farm);
+    checker_cleanup();
+    return 1;
+}
+
+int test_checker_mock_farm(void) {
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_init());
+
+    MockFarm *farm = mock_farm_start(4);
+    TEST_ASSERT_NOT_NULL(farm);
+
+    const MockHostProfile slow = { .behavior = MOCK_RESPOND, .status_code = 200, .latency_ms = 30.0 };
+    const MockHostProfile failing = { .behavior = MOCK_RESPOND, .status_code = 503 };
+    const MockHostProfile reset = { .behavior = MOCK_RESET };
+    const MockHostProfile blackhole = { .behavior = MOCK_BLACKHOLE };
+    mock_farm_set_profile(farm, 0, &slow);
+    mock_farm_set_profile(farm, 1, &failing);
+    mock_farm_set_profile(farm, 2, &reset);
+    mock_farm_set_profile(farm, 3, &blackhole);
+
+    CheckerConfig cfg = checker_get_default_config();
+    cfg.timeout_seconds = 1;
+    cfg.resolve = mock_farm_resolve_list(farm);
+    TEST_ASSERT_NOT_NULL(cfg.resolve);
+
+    const ServerStatus expected[] = {
+        BDIX_STATUS_ONLINE, BDIX_STATUS_OFFLINE, BDIX_STATUS_ERROR, BDIX_STATUS_TIMEOUT
+    };
+    Server s;
+    for (size_t i = 0; i < 4; i++) {
+        memset(&s, 0, sizeof(s));
+        mock_farm_url(farm, i, s.url, sizeof(s.url));
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_check_server(&s, &cfg));
+        TEST_ASSERT_EQUAL_INT(expected[i], s.status);
+        if (i == 0) {
+            TEST_ASSERT(s.latency_ms >= 30.0, "Host latency not applied");
+            TEST_ASSERT(s.timing.server_ms >= 30.0, "Host latency not attributed to the server phase");
+            TEST_ASSERT(s.timing.tls_ms == 0.0, "Plain HTTP reported a TLS handshake");
+            TEST_ASSERT(s.timing.total_ms >= s.timing.dns_ms + s.timing.connect_ms + s.timing.server_ms,
+                        "Phases exceed total time");
+        } else if (i == 1) {
+            TEST_ASSERT_EQUAL_INT(503, (int)s.response_code);
+        }
+    }
+
+    // Every request reached the farm through the pinned names
+    TEST_ASSERT_EQUAL_INT(4, (int)atomic_load(&farm->requests));
+    TEST_ASSERT_EQUAL_INT(2, (int)atomic_load(&farm->responses));
+    TEST_ASSERT_EQUAL_INT(1, (int)atomic_load(&farm->resets));
+    TEST_ASSERT_EQUAL_INT(1, (int)atomic_load(&farm->blackholed));
+
+    curl_slist_free_all(cfg.resolve);
+    mock_farm_stop(farm);
+    checker_cleanup();
+    return 1;
+}
+
+/**
+ * @brief Find the 5 fastest of 30 mirrors while 10 blackholed ones hold their connections
+ */
+static int check_fastest(bool io_uring) {
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_init());
+
+    MockFarm *farm = mock_farm_start(40);
+    TEST_ASSERT_NOT_NULL(farm);
+    const MockHostProfile blackhole = { .behavior = MOCK_BLACKHOLE };
+    for (size_t i = 0; i < 10; i++) {
+        mock_farm_set_profile(farm, i, &blackhole);
+    }
+
+    ServerCategory category;
+    server_category_init(&category, CATEGORY_FTP, "FTP");
+    for (size_t i = 0; i < 40; i++) {
+        char url[MAX_URL_LENGTH]; /* flawfinder: ignore - bounds checked in mock_farm_url */
+        mock_farm_url(farm, i, url, sizeof(url));
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, server_category_add(&category, url));
+    }
+
+    CheckerConfig config = checker_get_default_config();
+    config.verbose = false;
+    config.timeout_seconds = 5;
+    config.io_uring = io_uring;
+    config.top_k = 5;
+    config.top_k_grace_ms = 50;
+    config.resolve = mock_farm_resolve_list(farm);
+    CheckerStats stats;
+    checker_stats_init(&stats);
+
+    double start = get_time_ms();
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_check_category(&category, &config, 16, &stats));
+    double elapsed = get_time_ms() - start;
+    TEST_ASSERT(elapsed < 2000.0, "Blackholed mirrors held the set to the full timeout");
+
+    // Every server was either checked or left untouched and counted as cancelled
+    size_t checked = atomic_load(&stats.total_checked);
+    size_t cancelled = atomic_load(&stats.cancelled_count);
+    TEST_ASSERT(atomic_load(&stats.online_count) >= 5, "Fewer than K servers online");
+    TEST_ASSERT(cancelled >= 10, "Blackholed checks not cancelled");
+    TEST_ASSERT_EQUAL_INT(40, (int)(checked + cancelled));
+    size_t untouched = 0;
+    for (size_t i = 0; i < 40; i++) {
+        if (category.servers[i].metrics.count == 0) {
+            TEST_ASSERT_EQUAL_INT(BDIX_STATUS_UNKNOWN, category.servers[i].status);
+            untouched++;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT((int)cancelled, (int)untouched);
+
+    curl_slist_free_all(config.resolve);
+    server_category_free(&category);
+    mock_farm_stop(farm);
+    checker_cleanup();
+    return 1;
+}
+
+int test_checker_fastest(void) {
+    return check_fastest(false);
+}
+
+int test_checker_fastest_uring(void) {
+    if (!uring_available()) {
+        printf(TEST_COLOR_YELLOW "  [SKIP] io_uring not available" TEST_COLOR_RESET "\n"); // flawfinder: ignore
+        return 1;
+    }
+    return check_fastest(true);
+}
+
+/**
+ * @brief Check a small farm whose first host drops its first request
+ */
+static int check_retry(const RetryConfig *retry_config, ServerStatus expected, size_t retried) {
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_init());
+
+    MockFarm *farm = mock_farm_start(4);
+    TEST_ASSERT_NOT_NULL(farm);
+    const MockHostProfile lossy = { .behavior = MOCK_RESPOND, .status_code = 200, .drop_requests = 1 };
+    mock_farm_set_profile(farm, 0, &lossy);
+
+    ServerCategory category;
+    server_category_init(&category, CATEGORY_FTP, "FTP");
+    for (size_t i = 0; i < 4; i++) {
+        char url[MAX_URL_LENGTH]; /* flawfinder: ignore - bounds checked in mock_farm_url */
+        mock_farm_url(farm, i, url, sizeof(url));
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, server_category_add(&category, url));
+    }
+
+    RetryBudget *budget = retry_budget_create(retry_config);
+    TEST_ASSERT_NOT_NULL(budget);
+    CheckerConfig config = checker_get_default_config();
+    config.verbose = false;
+    config.timeout_seconds = 1;
+    config.retry = budget;
+    config.resolve = mock_farm_resolve_list(farm);
+    CheckerStats stats;
+    checker_stats_init(&stats);
+
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_check_category(&category, &config, 4, &stats));
+    TEST_ASSERT_EQUAL_INT(expected, category.servers[0].status);
+    TEST_ASSERT_EQUAL_INT((int)retried, (int)atomic_load(&stats.retried_count));
+    TEST_ASSERT_EQUAL_INT(4, (int)atomic_load(&stats.total_checked));
+    for (size_t i = 1; i < 4; i++) {
+        TEST_ASSERT_EQUAL_INT(BDIX_STATUS_ONLINE, category.servers[i].status);
+    }
+
+    retry_budget_destroy(budget);
+    curl_slist_free_all(config.resolve);
+    server_category_free(&category);
+    mock_farm_stop(farm);
+    checker_cleanup();
+    return 1;
+}
+
+int test_checker_retry(void) {
+    RetryConfig retry_config = retry_get_default_config();
+    retry_config.max_retries = 2;
+    retry_config.backoff_ms = 10.0;
+    return check_retry(&retry_config, BDIX_STATUS_ONLINE, 1);
+}
+
+int test_checker_retry_budget_exhausted(void) {
+    RetryConfig retry_config = retry_get_default_config();
+    retry_config.max_retries = 2;
+    retry_config.backoff_ms = 10.0;
+    retry_config.budget_pct = 0.0;
+    retry_config.budget_burst = 0.0;
+    return check_retry(&retry_config, BDIX_STATUS_TIMEOUT, 0);
+}
+
+int test_checker_hedge(void) {
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_init());
+
+    MockFarm *farm = mock_farm_start(1);
+    TEST_ASSERT_NOT_NULL(farm);
+    Server server;
+    memset(&server, 0, sizeof(server));
+    mock_farm_url(farm, 0, server.url, sizeof(server.url));
+
+    RetryConfig retry_config = retry_get_default_config();
+    retry_config.hedge_quantile = 0.9;
+    RetryBudget *budget = retry_budget_create(&retry_config);
+    TEST_ASSERT_NOT_NULL(budget);
+    CheckerConfig config = checker_get_default_config();
+    config.timeout_seconds = 5;
+    config.retry = budget;
+    config.resolve = mock_farm_resolve_list(farm);
+
+    // Without history nothing is hedged
+    for (int i = 0; i < RETRY_HEDGE_MIN_SAMPLES; i++) {
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_check_server(&server, &config));
+        TEST_ASSERT_EQUAL_INT(BDIX_STATUS_ONLINE, server.status);
+    }
+    TEST_ASSERT_EQUAL_INT(0, (int)atomic_load(&budget->hedges));
+
+    // No hedge is sent while the host has no rate limiter slot free
+    RateLimitConfig rate_config = rate_limiter_get_default_config();
+    rate_config.max_concurrent = 1;
+    RateLimiter *limiter = rate_limiter_create(&rate_config);
+    TEST_ASSERT_NOT_NULL(limiter);
+    size_t held;
+    double retry_ms;
+    TEST_ASSERT(rate_limiter_try_acquire(limiter, server.url, &held, &retry_ms, NULL), "Slot for the check");
+    config.rate_limiter = limiter;
+    config.timeout_seconds = 1;
+    const MockHostProfile lossy = { .behavior = MOCK_RESPOND, .status_code = 200, .drop_requests = 1 };
+    mock_farm_set_profile(farm, 0, &lossy);
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_check_server(&server, &config));
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_TIMEOUT, server.status);
+    TEST_ASSERT_EQUAL_INT(0, (int)atomic_load(&budget->hedges));
+    rate_limiter_release(limiter, held);
+
+    // A lost request is answered by the hedge instead of running into the timeout
+    mock_farm_set_profile(farm, 0, &lossy);
+    double start = get_time_ms();
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_check_server(&server, &config));
+    double elapsed = get_time_ms() - start;
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_ONLINE, server.status);
+    TEST_ASSERT(elapsed < 1000.0, "Lost request not hedged");
+    TEST_ASSERT_EQUAL_INT(1, (int)atomic_load(&budget->hedges));
+
+    rate_limiter_destroy(limiter);
+    retry_budget_destroy(budget);
+    curl_slist_free_all(config.resolve);
+    mock_farm_stop(farm);
+    checker_cleanup();
+    return 1;
+}
+
+int test_checker_sweep_deadline(void) {
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_init());
+
+    // Five blackholes hold their checks, five resets wait for a long retry backoff
+    MockFarm *farm = mock_farm_start(20);
+    TEST_ASSERT_NOT_NULL(farm);
+    const MockHostProfile blackhole = { .behavior = MOCK_BLACKHOLE };
+    const MockHostProfile reset = { .behavior = MOCK_RESET };
+    for (size_t i = 0; i < 10; i++) {
+        mock_farm_set_profile(farm, i, i < 5 ? &blackhole : &reset);
+    }
+
+    ServerCategory category;
+    ServerCategory later;
+    server_category_init(&category, CATEGORY_FTP, "FTP");
+    server_category_init(&later, CATEGORY_TV, "TV");
+    for (size_t i = 0; i < 20; i++) {
+        char url[MAX_URL_LENGTH]; /* flawfinder: ignore - bounds checked in mock_farm_url */
+        mock_farm_url(farm, i, url, sizeof(url));
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, server_category_add(&category, url));
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, server_category_add(&later, url));
+    }
+
+    RetryConfig retry_config = retry_get_default_config();
+    retry_config.max_retries = 2;
+    retry_config.backoff_ms = 5000.0;
+    RetryBudget *budget = retry_budget_create(&retry_config);
+    TEST_ASSERT_NOT_NULL(budget);
+    CancelToken sweep;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, cancel_token_init(&sweep));
+    CheckerConfig config = checker_get_default_config();
+    config.verbose = false;
+    config.timeout_seconds = 5;
+    config.retry = budget;
+    config.cancel = &sweep;
+    config.resolve = mock_farm_resolve_list(farm);
+    CheckerStats stats;
+    checker_stats_init(&stats);
+
+    double start = get_time_ms();
+    cancel_token_set_deadline(&sweep, start + 300.0);
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_check_category(&category, &config, 8, &stats));
+    double elapsed = get_time_ms() - start;
+    TEST_ASSERT(elapsed < 2000.0, "Sweep outlived its deadline");
+
+    // Partial results are kept, the unfinished checks are counted as cancelled
+    TEST_ASSERT_EQUAL_INT(10, (int)atomic_load(&stats.online_count));
+    TEST_ASSERT_EQUAL_INT(10, (int)atomic_load(&stats.cancelled_count));
+    TEST_ASSERT_EQUAL_INT(5, (int)atomic_load(&stats.retried_count));
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_UNKNOWN, category.servers[0].status);
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_UNKNOWN, category.servers[5].status);
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_ONLINE, category.servers[10].status);
+
+    // Sets started after the cancel are skipped
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_check_category(&later, &config, 8, &stats));
+    TEST_ASSERT_EQUAL_INT(30, (int)atomic_load(&stats.cancelled_count));
+    TEST_ASSERT_EQUAL_INT(10, (int)atomic_load(&stats.total_checked));
+
+    cancel_token_destroy(&sweep);
+    retry_budget_destroy(budget);
+    curl_slist_free_all(config.resolve);
+    server_category_free(&category);
+    server_category_free(&later);
+    mock_farm_stop(farm);
+    checker_cleanup();
+    return 1;
+}
+
+/**
+ * @brief Previously online mirrors are checked first, dead ones last
+ */
+int test_checker_priority(void) {
+    Server fresh;
+    memset(&fresh, 0, sizeof(fresh));
+    TEST_ASSERT(checker_server_priority(&fresh) == CHECKER_PRIORITY_UNKNOWN, "Fresh server not ranked unknown");
+
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_init());
+
+    // A fast and a slower mirror last in config order, three dead ones first
+    MockFarm *farm = mock_farm_start(6);
+    TEST_ASSERT_NOT_NULL(farm);
+    const MockHostProfile blackhole = { .behavior = MOCK_BLACKHOLE };
+    for (size_t i = 0; i < 3; i++) {
+        mock_farm_set_profile(farm, i, &blackhole);
+    }
+
+    ServerCategory category;
+    server_category_init(&category, CATEGORY_FTP, "FTP");
+    for (size_t i = 0; i < 6; i++) {
+        char url[MAX_URL_LENGTH]; /* flawfinder: ignore - bounds checked in mock_farm_url */
+        mock_farm_url(farm, i, url, sizeof(url));
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, server_category_add(&category, url));
+    }
+    for (size_t i = 0; i < 3; i++) {
+        for (int j = 0; j < CHECKER_DEAD_MIN_SAMPLES; j++) {
+            server_update_status(&category.servers[i], BDIX_STATUS_TIMEOUT, 5000.0, 0);
+        }
+    }
+    server_update_status(&category.servers[4], BDIX_STATUS_ONLINE, 40.0, 200);
+    server_update_status(&category.servers[5], BDIX_STATUS_ONLINE, 10.0, 200);
+
+    double dead = checker_server_priority(&category.servers[0]);
+    double unknown = checker_server_priority(&category.servers[3]);
+    double slow = checker_server_priority(&category.servers[4]);
+    double fast = checker_server_priority(&category.servers[5]);
+    TEST_ASSERT(fast < slow && slow < unknown && unknown < dead, "Servers ranked in the wrong order");
+
+    // Only results of this sweep count below
+    for (size_t i = 0; i < 6; i++) {
+        category.servers[i].status = BDIX_STATUS_UNKNOWN;
+    }
+
+    // One worker and K = 1: the first check decides which server is found
+    CheckerConfig config = checker_get_default_config();
+    config.verbose = false;
+    config.timeout_seconds = 5;
+    config.prioritize = true;
+    config.top_k = 1;
+    config.top_k_grace_ms = 0;
+    config.resolve = mock_farm_resolve_list(farm);
+    CheckerStats stats;
+    checker_stats_init(&stats);
+
+    double start = get_time_ms();
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_check_category(&category, &config, 1, &stats));
+    TEST_ASSERT(get_time_ms() - start < 2000.0, "Dead mirrors were checked before the live ones");
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_ONLINE, category.servers[5].status);
+    TEST_ASSERT_EQUAL_INT(1, (int)atomic_load(&stats.total_checked));
+    TEST_ASSERT_EQUAL_INT(5, (int)atomic_load(&stats.cancelled_count));
+    for (size_t i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_INT(BDIX_STATUS_UNKNOWN, category.servers[i].status);
+    }
+
+    curl_slist_free_all(config.resolve);
+    server_category_free(&category);
+    mock_farm_stop(farm);
+    checker_cleanup();
+    return 1;
+}
+
+/**
+ * @brief A mirror that failed every recent check gets the short dead-server timeout
+ */
+int test_checker_dead_timeout(void) {
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_init());
+
+    MockFarm *farm = mock_farm_start(1);
+    TEST_ASSERT_NOT_NULL(farm);
+    const MockHostProfile blackhole = { .behavior = MOCK_BLACKHOLE };
+    mock_farm_set_profile(farm, 0, &blackhole);
+
+    Server s;
+    memset(&s, 0, sizeof(s));
+    mock_farm_url(farm, 0, s.url, sizeof(s.url));
+
+    CheckerConfig cfg = checker_get_default_config();
+    cfg.timeout_seconds = 5;
+    cfg.dead_timeout_ms = 200;
+    cfg.resolve = mock_farm_resolve_list(farm);
+
+    // Too little history to call it dead yet
+    long timeout_ms, connect_timeout_ms;
+    for (int i = 0; i < CHECKER_DEAD_MIN_SAMPLES - 1; i++) {
+        server_update_status(&s, BDIX_STATUS_TIMEOUT, 5000.0, 0);
+    }
+    TEST_ASSERT(!checker_server_deadlines(&s, &cfg, &timeout_ms, &connect_timeout_ms),
+                "Dead timeout applied without enough samples");
+    TEST_ASSERT_EQUAL_INT(5000, (int)timeout_ms);
+
+    server_update_status(&s, BDIX_STATUS_ERROR, 0.0, 0);
+    TEST_ASSERT(checker_server_deadlines(&s, &cfg, &timeout_ms, &connect_timeout_ms),
+                "Dead timeout not applied");
+    TEST_ASSERT_EQUAL_INT(200, (int)timeout_ms);
+    TEST_ASSERT(connect_timeout_ms <= 200, "Connect timeout exceeds the dead timeout");
+
+    double start = get_time_ms();
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_check_server(&s, &cfg));
+    double elapsed = get_time_ms() - start;
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_TIMEOUT, s.status);
+    TEST_ASSERT(elapsed < 1000.0, "Dead mirror held the full timeout");
+
+    // One ONLINE sample in the ring and it is no longer dead
+    server_update_status(&s, BDIX_STATUS_ONLINE, 10.0, 200);
+    TEST_ASSERT(!checker_server_deadlines(&s, &cfg, &timeout_ms, &connect_timeout_ms),
+                "Dead timeout applied to a live server");
+
+    curl_slist_free_all(cfg.resolve);
+    mock_farm_stop(farm);
+    checker_cleanup();
+    return 1;
+}
+
+/**
+ * @brief An autotuned pool outgrows a small start when mirrors hold their connections
+ */
+int test_checker_autotune(void) {
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_init());
+
+    MockFarm *farm = mock_farm_start(40);
+    TEST_ASSERT_NOT_NULL(farm);
+    const MockHostProfile blackhole = { .behavior = MOCK_BLACKHOLE };
+    for (size_t i = 0; i < 30; i++) {
+        mock_farm_set_profile(farm, i, &blackhole);
+    }
+
+    ServerCategory category;
+    server_category_init(&category, CATEGORY_FTP, "FTP");
+    for (size_t i = 0; i < 40; i++) {
+        char url[MAX_URL_LENGTH]; /* flawfinder: ignore - bounds checked in mock_farm_url */
+        mock_farm_url(farm, i, url, sizeof(url));
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, server_category_add(&category, url));
+    }
+
+    // Two fixed threads would need 15 rounds of the 1 s timeout
+    CheckerConfig config = checker_get_default_config();
+    config.verbose = false;
+    config.timeout_seconds = 1;
+    config.connect_timeout_seconds = 1;
+    config.autotune_threads = true;
+    config.max_threads = 64;
+    config.resolve = mock_farm_resolve_list(farm);
+    CheckerStats stats;
+    checker_stats_init(&stats);
+
+    double start = get_time_ms();
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_check_category(&category, &config, 2, &stats));
+    double elapsed = get_time_ms() - start;
+    TEST_ASSERT(elapsed < 6000.0, "Autotuned pool stayed near its start size");
+    TEST_ASSERT_EQUAL_INT(40, (int)atomic_load(&stats.total_checked));
+    TEST_ASSERT_EQUAL_INT(10, (int)atomic_load(&stats.online_count));
+    size_t settled = atomic_load(&stats.settled_threads);
+    TEST_ASSERT(settled > 2 && settled <= 64, "Settled thread count not reported");
+    TEST_ASSERT(atomic_load(&stats.peak_threads) >= settled, "Peak below settled thread count");
+
+    curl_slist_free_all(config.resolve);
+    server_category_free(&category);
+    mock_farm_stop(farm);
+    checker_cleanup();
+    return 1;
+}
+
+/**
+ * @brief Sets checked through a caller's pool reuse it instead of creating their own
+ */
+int test_checker_shared_pool(void) {
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_init());
+
+    MockFarm *farm = mock_farm_start(10);
+    TEST_ASSERT_NOT_NULL(farm);
+    ServerCategory category;
+    server_category_init(&category, CATEGORY_FTP, "FTP");
+    for (size_t i = 0; i < 10; i++) {
+        char url[MAX_URL_LENGTH]; /* flawfinder: ignore - bounds checked in mock_farm_url */
+        mock_farm_url(farm, i, url, sizeof(url));
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, server_category_add(&category, url));
+    }
+
+    CheckerConfig config = checker_get_default_config();
+    config.verbose = false;
+    config.timeout_seconds = 2;
+    config.resolve = mock_farm_resolve_list(farm);
+    ThreadPool *pool = checker_create_pool(&config, 4, NULL);
+    TEST_ASSERT_NOT_NULL(pool);
+    config.pool = pool;
+
+    static const size_t first[] = { 0, 1, 2, 3 };
+    static const size_t second[] = { 4, 5, 6, 7, 8, 9 };
+    CheckerStats stats;
+    checker_stats_init(&stats);
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_check_servers(&category, first, 4, &config, 4, &stats));
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_check_servers(&category, second, 6, &config, 4, &stats));
+    TEST_ASSERT_EQUAL_INT(10, (int)atomic_load(&stats.online_count));
+
+    ThreadPoolStats pool_stats;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_get_stats(pool, &pool_stats));
+    TEST_ASSERT_EQUAL_INT(10, (int)pool_stats.run.count);
+    TEST_ASSERT_EQUAL_INT(4, (int)pool_stats.threads);
+    thread_pool_stats_free(&pool_stats);
+    thread_pool_destroy(pool);
+
+    TEST_ASSERT(checker_create_pool(NULL, 4, NULL) == NULL, "Pool created without a configuration");
+
+    curl_slist_free_all(config.resolve);
+    server_category_free(&category);
+    mock_farm_stop(farm);
+    checker_cleanup();
     return 1;
 }
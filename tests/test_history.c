@@ -0,0 +1,138 @@
+#include "test_common.h"
+#include "../include/history.h"
+#include <dirent.h>
+
+/**
+ * @brief Collects visited timestamps for assertions
+ */
+typedef struct {
+    int64_t timestamps[32];
+    size_t count;
+} HistoryCollector;
+
+static bool collect_record(const HistoryRecord *record, void *ctx) {
+    HistoryCollector *c = (HistoryCollector*)ctx;
+    if (c->count < ARRAY_SIZE(c->timestamps)) {
+        c->timestamps[c->count++] = record->timestamp_ms;
+    }
+    return true;
+}
+
+static void remove_store_dir(const char *dir) {
+    DIR *d = opendir(dir);
+    if (d) {
+        struct dirent *entry;
+        while ((entry = readdir(d)) != NULL) {
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            char path[MAX_PATH_LENGTH]; // flawfinder: ignore
+            snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name); // flawfinder: ignore
+            unlink(path);
+        }
+        closedir(d);
+    }
+    rmdir(dir);
+}
+
+int test_history_append_and_query(void) {
+    char dir[] = "/tmp/bdix-history-XXXXXX";
+    TEST_ASSERT(mkdtemp(dir) != NULL, "Failed to create temporary directory");
+
+    HistoryConfig cfg = history_get_default_config();
+    cfg.segment_records = 4;  // Force several segment rotations
+
+    HistoryStore *store = history_open(dir, &cfg);
+    TEST_ASSERT_NOT_NULL(store);
+
+    uint64_t a = history_server_id("http://a.example.bd");
+    uint64_t b = history_server_id("http://b.example.bd");
+    TEST_ASSERT(a != b, "Distinct URLs should get distinct ids");
+
+    // Interleave two servers, one record per second each
+    for (int i = 0; i < 10; i++) {
+        HistoryRecord ra = { .server_id = a, .timestamp_ms = i * 1000, .latency_ms = (float)i,
+                             .status = BDIX_STATUS_ONLINE, .response_code = 200 };
+        HistoryRecord rb = { .server_id = b, .timestamp_ms = i * 1000 + 500,
+                             .status = BDIX_STATUS_TIMEOUT };
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, history_append_record(store, &ra));
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, history_append_record(store, &rb));
+    }
+    TEST_ASSERT_EQUAL_INT(5, (int)store->segment_count);
+    history_close(store);
+
+    // Reopen for queries only; indexes are rebuilt from the mapped segments
+    cfg.read_only = true;
+    store = history_open(dir, &cfg);
+    TEST_ASSERT_NOT_NULL(store);
+    TEST_ASSERT_EQUAL_INT(5, (int)store->segment_count);
+
+    HistoryCollector c = {0};
+    size_t n = history_query(store, a, 3000, 7000, collect_record, &c);
+    TEST_ASSERT_EQUAL_INT(5, (int)n);
+    for (size_t i = 0; i < c.count; i++) {
+        TEST_ASSERT(c.timestamps[i] == (int64_t)(7 - i) * 1000, "Records should be newest first");
+    }
+
+    HistoryRecord extra = { .server_id = a, .timestamp_ms = 11000 };
+    TEST_ASSERT(history_append_record(store, &extra) != BDIX_SUCCESS,
+                "Read-only store should reject appends");
+    history_close(store);
+
+    // Appending after reopen continues in a fresh segment
+    cfg.read_only = false;
+    store = history_open(dir, &cfg);
+    TEST_ASSERT_NOT_NULL(store);
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, history_append_record(store, &extra));
+    memset(&c, 0, sizeof(c));
+    TEST_ASSERT_EQUAL_INT(11, (int)history_query(store, a, 0, INT64_MAX, collect_record, &c));
+    TEST_ASSERT(c.timestamps[0] == 11000, "Newest record should come first");
+    history_close(store);
+
+    remove_store_dir(dir);
+    return 1;
+}
+
+int test_history_restore(void) {
+    char dir[] = "/tmp/bdix-history-XXXXXX";
+    TEST_ASSERT(mkdtemp(dir) != NULL, "Failed to create temporary directory");
+
+    HistoryConfig cfg = history_get_default_config();
+    HistoryStore *store = history_open(dir, &cfg);
+    TEST_ASSERT_NOT_NULL(store);
+
+    // More results than the sample ring holds; only the newest are restored
+    const char *url = "http://a.example.bd";
+    uint64_t id = history_server_id(url);
+    for (int i = 0; i < SERVER_SAMPLE_RING + 8; i++) {
+        bool up = i % 4 != 0;
+        HistoryRecord record = { .server_id = id, .timestamp_ms = 1000000 + i * 1000,
+                                 .latency_ms = up ? 20.0f : 0.0f,
+                                 .status = up ? BDIX_STATUS_ONLINE : BDIX_STATUS_TIMEOUT,
+                                 .response_code = up ? 200 : 0 };
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, history_append_record(store, &record));
+    }
+
+    Server s;
+    memset(&s, 0, sizeof(s));
+    safe_strncpy(s.url, url, sizeof(s.url));
+    TEST_ASSERT_EQUAL_INT(SERVER_SAMPLE_RING, (int)history_restore(store, &s));
+    TEST_ASSERT_EQUAL_INT(SERVER_SAMPLE_RING, (int)s.metrics.count);
+    TEST_ASSERT_EQUAL_INT(SERVER_SAMPLE_RING * 3 / 4, (int)s.metrics.up_count);
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_ONLINE, s.status);
+    TEST_ASSERT_EQUAL_INT(200, (int)s.response_code);
+    TEST_ASSERT(fabs(s.metrics.ewma_latency_ms - 20.0) < 0.01, "Latency not restored");
+    TEST_ASSERT_EQUAL_INT(1000 + SERVER_SAMPLE_RING + 7, (int)s.last_checked);
+
+    // Servers without records are left alone
+    Server other;
+    memset(&other, 0, sizeof(other));
+    safe_strncpy(other.url, "http://b.example.bd", sizeof(other.url));
+    TEST_ASSERT_EQUAL_INT(0, (int)history_restore(store, &other));
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_UNKNOWN, other.status);
+    TEST_ASSERT_EQUAL_INT(0, (int)other.metrics.count);
+
+    history_close(store);
+    remove_store_dir(dir);
+    return 1;
+}
@@ -0,0 +1,79 @@
+#include "test_common.h"
+#include "../include/icmp.h"
+#include "../include/server.h"
+
+/**
+ * @brief Note that ping sockets are not permitted and the test is skipped
+ */
+static int skip_unavailable(void) {
+    printf(TEST_COLOR_YELLOW "  [SKIP] ICMP sockets not permitted (net.ipv4.ping_group_range)" // flawfinder: ignore
+           TEST_COLOR_RESET "\n");
+    return 1;
+}
+
+int test_icmp_localhost(void) {
+    if (!icmp_available()) {
+        return skip_unavailable();
+    }
+
+    IcmpConfig config = icmp_get_default_config();
+    config.samples = 4;
+    config.interval_ms = 5;
+    config.timeout_ms = 500;
+    config.resolver_threads = 4;
+
+    // Names are looked up on the resolver pool; localhost may also map to ::1
+    const char *hosts[] = { "127.0.0.1", "127.0.0.2", "localhost", "no-such-host.invalid" };
+    ServerPing results[4];
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, icmp_probe_hosts(hosts, 4, &config, results));
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_INT(4, (int)results[i].sent);
+        TEST_ASSERT_EQUAL_INT(4, (int)results[i].received);
+        TEST_ASSERT(results[i].min_ms > 0.0 && results[i].min_ms <= results[i].avg_ms,
+                    "min/avg RTT inconsistent");
+        TEST_ASSERT(results[i].avg_ms < 100.0, "Loopback RTT too high");
+    }
+
+    // Unresolvable hosts are reported as not probed
+    TEST_ASSERT_EQUAL_INT(0, (int)results[3].sent);
+    TEST_ASSERT_EQUAL_INT(0, (int)results[3].received);
+
+    // Invalid sample counts are rejected
+    config.samples = ICMP_MAX_SAMPLES + 1;
+    TEST_ASSERT_EQUAL_INT(BDIX_ERROR_INVALID_INPUT, icmp_probe_hosts(hosts, 4, &config, results));
+    return 1;
+}
+
+int test_icmp_servers_share_host(void) {
+    if (!icmp_available()) {
+        return skip_unavailable();
+    }
+
+    ServerCategory category;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, server_category_init(&category, CATEGORY_FTP, "FTP"));
+    server_category_add(&category, "http://127.0.0.1:8080/a");
+    server_category_add(&category, "https://127.0.0.1/b");
+    server_category_add(&category, "http://localhost/c");
+
+    Server *servers[3];
+    for (size_t i = 0; i < 3; i++) {
+        servers[i] = server_category_get(&category, i);
+    }
+
+    IcmpConfig config = icmp_get_default_config();
+    config.samples = 2;
+    config.interval_ms = 5;
+    config.timeout_ms = 500;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, icmp_probe_servers(servers, 3, &config));
+
+    // One probe per host: both 127.0.0.1 servers share its results
+    for (size_t i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_INT(2, (int)servers[i]->ping.sent);
+        TEST_ASSERT_EQUAL_INT(2, (int)servers[i]->ping.received);
+    }
+    TEST_ASSERT(servers[0]->ping.min_ms == servers[1]->ping.min_ms, "Shared host probed twice");
+
+    server_category_free(&category);
+    return 1;
+}
@@ -0,0 +1,92 @@
+#include "test_common.h"
+#include <pthread.h>
+
+#define LOG_TEST_THREADS 4
+#define LOG_TEST_MESSAGES 50
+
+static _Atomic int g_evaluated = 0;
+
+static int count_evaluation(void) {
+    return atomic_fetch_add(&g_evaluated, 1);
+}
+
+static void* log_worker(void *arg) {
+    int id = *(int*)arg;
+    for (int i = 0; i < LOG_TEST_MESSAGES; i++) {
+        LOG_WARN("worker %d message %d", id, i);
+        LOG_INFO("worker %d filtered %d", id, i);
+    }
+    return NULL;
+}
+
+static int count_lines(FILE *f, const char *needle) {
+    char line[LOG_MESSAGE_MAX + 2]; /* flawfinder: ignore - bounds checked with fgets */
+    int count = 0;
+    rewind(f);
+    while (fgets(line, sizeof(line), f)) {
+        if (strstr(line, needle)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+int test_log_levels(void) {
+    LogLevel level;
+    TEST_ASSERT(log_parse_level("DEBUG", &level) && level == LOG_LEVEL_DEBUG, "debug not parsed");
+    TEST_ASSERT(log_parse_level("warning", &level) && level == LOG_LEVEL_WARN, "warning not parsed");
+    TEST_ASSERT(log_parse_level("off", &level) && level == LOG_LEVEL_OFF, "off not parsed");
+    TEST_ASSERT(!log_parse_level("verbose", &level), "Unknown level accepted");
+
+    LogLevel saved = log_get_level();
+    FILE *out = tmpfile();
+    TEST_ASSERT_NOT_NULL(out);
+    log_set_streams(out, out);
+
+    // Arguments of disabled levels are not evaluated
+    log_set_level(LOG_LEVEL_ERROR);
+    LOG_WARN("skipped %d", count_evaluation());
+    LOG_ERROR("kept %d", count_evaluation());
+    TEST_ASSERT_EQUAL_INT(1, atomic_load(&g_evaluated));
+
+    // Synchronous mode writes immediately with the usual prefixes
+    TEST_ASSERT_EQUAL_INT(1, count_lines(out, "[ERROR] "));
+    TEST_ASSERT_EQUAL_INT(1, count_lines(out, "kept 0"));
+
+    log_set_level(saved);
+    log_set_streams(NULL, NULL);
+    fclose(out);
+    return 1;
+}
+
+int test_log_async_threads(void) {
+    LogLevel saved = log_get_level();
+    FILE *out = tmpfile();
+    TEST_ASSERT_NOT_NULL(out);
+    log_set_streams(out, out);
+    log_set_level(LOG_LEVEL_WARN);
+
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, log_start());
+
+    pthread_t threads[LOG_TEST_THREADS];
+    int ids[LOG_TEST_THREADS];
+    for (int i = 0; i < LOG_TEST_THREADS; i++) {
+        ids[i] = i;
+        pthread_create(&threads[i], NULL, log_worker, &ids[i]);
+    }
+    for (int i = 0; i < LOG_TEST_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    TEST_ASSERT_EQUAL_INT(0, (int)log_dropped_count());
+
+    // Everything buffered by the exited threads is written on stop
+    log_stop();
+    TEST_ASSERT_EQUAL_INT(LOG_TEST_THREADS * LOG_TEST_MESSAGES, count_lines(out, "[WARN] worker"));
+    TEST_ASSERT_EQUAL_INT(0, count_lines(out, "filtered"));
+    TEST_ASSERT_EQUAL_INT(1, count_lines(out, "worker 3 message 49\n"));
+
+    log_set_level(saved);
+    log_set_streams(NULL, NULL);
+    fclose(out);
+    return 1;
+}
@@ -0,0 +1,132 @@
+#include "test_common.h"
+#include "../include/metrics.h"
+#include <jansson.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+ * @brief Send a request to the metrics socket and read the whole reply
+ */
+static size_t fetch(const char *path, const char *request, char *buf, size_t size) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return 0;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    safe_strncpy(addr.sun_path, path, sizeof(addr.sun_path));
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return 0;
+    }
+
+    if (request && send(fd, request, strlen(request), 0) < 0) { /* flawfinder: ignore - literal request */
+        close(fd);
+        return 0;
+    }
+
+    size_t total = 0;
+    ssize_t n;
+    while (total < size - 1 && (n = recv(fd, buf + total, size - 1 - total, 0)) > 0) { /* flawfinder: ignore */
+        total += (size_t)n;
+    }
+    buf[total] = '\0';
+    close(fd);
+    return total;
+}
+
+/**
+ * @brief Find a metric in a JSON snapshot
+ */
+static json_t* find_metric(json_t *root, const char *name) {
+    size_t index;
+    json_t *entry;
+    json_array_foreach(json_object_get(root, "metrics"), index, entry) {
+        if (strcmp(json_string_value(json_object_get(entry, "name")), name) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+int test_metrics_registry(void) {
+    Metric *counter = metrics_counter("test_events_total", "Test counter");
+    Metric *gauge = metrics_gauge("test_depth", "Test gauge");
+    Metric *histogram = metrics_histogram("test_latency_ms", "Test histogram");
+    TEST_ASSERT(counter && gauge && histogram, "Registration failed");
+
+    // Same name and type returns the same metric; another type is refused
+    TEST_ASSERT(metrics_counter("test_events_total", "Again") == counter, "Duplicate counter created");
+    TEST_ASSERT(metrics_gauge("test_events_total", "Wrong type") == NULL, "Type conflict accepted");
+
+    metrics_add(counter, 3);
+    metrics_gauge_add(gauge, 5.0);
+    metrics_gauge_add(gauge, -2.0);
+    metrics_observe(histogram, 0.5);
+    metrics_observe(histogram, 40.0);
+    metrics_observe(histogram, 1e9);
+    metrics_add(NULL, 1);  // Unregistered handles are ignored
+
+    TEST_ASSERT(metrics_value(counter) == 3.0, "Counter value mismatch");
+    TEST_ASSERT(metrics_value(gauge) == 3.0, "Gauge value mismatch");
+    TEST_ASSERT(metrics_value(histogram) == 3.0, "Histogram count mismatch");
+
+    char *text = metrics_snapshot_json();
+    TEST_ASSERT_NOT_NULL(text);
+    json_error_t error;
+    json_t *root = json_loads(text, 0, &error);
+    free(text);
+    TEST_ASSERT_NOT_NULL(root);
+
+    json_t *entry = find_metric(root, "test_latency_ms");
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_EQUAL_STR("histogram", json_string_value(json_object_get(entry, "type")));
+    json_t *buckets = json_object_get(entry, "buckets");
+    TEST_ASSERT_EQUAL_INT(METRICS_BUCKETS, (int)json_array_size(buckets));
+    TEST_ASSERT_EQUAL_INT(1, (int)json_integer_value(json_object_get(json_array_get(buckets, 0), "count")));
+    TEST_ASSERT_EQUAL_INT(1, (int)json_integer_value(
+        json_object_get(json_array_get(buckets, METRICS_BUCKETS - 1), "count")));
+    json_decref(root);
+    return 1;
+}
+
+int test_metrics_socket(void) {
+    char dir[] = "/tmp/bdix-metrics-XXXXXX";
+    TEST_ASSERT(mkdtemp(dir) != NULL, "Failed to create temporary directory");
+    char path[MAX_PATH_LENGTH]; /* flawfinder: ignore - bounds checked with snprintf */
+    snprintf(path, sizeof(path), "%s/metrics.sock", dir); // flawfinder: ignore
+
+    metrics_add(metrics_counter("test_socket_total", "Socket test counter"), 7);
+
+    MetricsServer *server = metrics_server_start(path);
+    TEST_ASSERT_NOT_NULL(server);
+
+    static char reply[65536]; /* flawfinder: ignore - bounds checked in fetch */
+    TEST_ASSERT(fetch(path, "json\n", reply, sizeof(reply)) > 0, "No JSON reply");
+    json_error_t error;
+    json_t *root = json_loads(reply, 0, &error);
+    TEST_ASSERT_NOT_NULL(root);
+    json_t *entry = find_metric(root, "test_socket_total");
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_EQUAL_INT(7, (int)json_integer_value(json_object_get(entry, "value")));
+    json_decref(root);
+
+    // Binary snapshot starts with the magic and version
+    size_t size = fetch(path, "binary", reply, sizeof(reply));
+    TEST_ASSERT(size >= 20, "Binary reply too short");
+    uint32_t magic, version;
+    memcpy(&magic, reply, sizeof(magic));
+    memcpy(&version, reply + 4, sizeof(version));
+    TEST_ASSERT(magic == METRICS_BINARY_MAGIC, "Bad binary magic");
+    TEST_ASSERT(version == METRICS_BINARY_VERSION, "Bad binary version");
+
+    // Silent clients get JSON after the request timeout
+    TEST_ASSERT(fetch(path, NULL, reply, sizeof(reply)) > 0 && reply[0] == '{', "No default reply");
+
+    metrics_server_stop(server);
+    TEST_ASSERT(access(path, F_OK) != 0, "Socket not removed");
+    rmdir(dir);
+    return 1;
+}
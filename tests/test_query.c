@@ -0,0 +1,115 @@
+#include "test_common.h"
+#include "../include/query.h"
+#include <dirent.h>
+
+#define QUERY_TEST_SERVERS 300
+
+static void remove_tree(const char *dir) {
+    DIR *d = opendir(dir);
+    if (d) {
+        struct dirent *entry;
+        while ((entry = readdir(d)) != NULL) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+            char path[MAX_PATH_LENGTH]; // flawfinder: ignore
+            snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name); // flawfinder: ignore
+            if (unlink(path) != 0) {
+                remove_tree(path);
+            }
+        }
+        closedir(d);
+    }
+    rmdir(dir);
+}
+
+int test_query_rank_and_filter(void) {
+    char dir[] = "/tmp/bdix-query-XXXXXX";
+    TEST_ASSERT(mkdtemp(dir) != NULL, "Failed to create temporary directory");
+
+    ServerCategory ftp;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, server_category_init(&ftp, CATEGORY_FTP, "FTP"));
+
+    HistoryStore *history = history_open(dir, &(HistoryConfig){ .segment_records = 4096 });
+    TEST_ASSERT_NOT_NULL(history);
+
+    // Two hours of checks every 5 minutes; every fifth server drops one check in ten
+    const int64_t now = 19700 * ROLLUP_MS_PER_DAY + 3 * 3600000LL;
+    for (int i = 0; i < QUERY_TEST_SERVERS; i++) {
+        char url[64]; // flawfinder: ignore
+        snprintf(url, sizeof(url), "http://s%03d.example.bd", i); // flawfinder: ignore
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, server_category_add(&ftp, url));
+
+        uint64_t id = history_server_id(url);
+        for (int k = 0; k < 24; k++) {
+            bool down = (i % 5 == 0) && (k % 10 == 9);
+            HistoryRecord r = {
+                .server_id = id,
+                .timestamp_ms = now - 2 * 3600000LL + k * 300000LL,
+                .latency_ms = (float)(1000 - 3 * i),
+                .status = (int16_t)(down ? BDIX_STATUS_TIMEOUT : BDIX_STATUS_ONLINE)
+            };
+            TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, history_append_record(history, &r));
+        }
+    }
+
+    RollupConfig rcfg = rollup_get_default_config();
+    RollupStore *rollups = rollup_open(dir, history, &rcfg);
+    TEST_ASSERT_NOT_NULL(rollups);
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, rollup_compact(rollups, now));
+
+    // Fastest stable servers: the highest indexes, skipping every fifth
+    ServerCategory *categories[] = { &ftp };
+    QueryOptions options = query_get_default_options(now);
+    options.min_uptime_pct = 99.0;
+    options.top_n = 5;
+    QueryResultSet results;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, query_run(rollups, categories, 1, &options, 4, &results));
+    TEST_ASSERT_EQUAL_INT(QUERY_TEST_SERVERS, (int)results.scanned);
+    TEST_ASSERT_EQUAL_INT(5, (int)results.count);
+
+    const char *expected[] = {
+        "http://s299.example.bd", "http://s298.example.bd", "http://s297.example.bd",
+        "http://s296.example.bd", "http://s294.example.bd"
+    };
+    for (size_t i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_STR(expected[i], results.rows[i].url);
+        TEST_ASSERT_EQUAL_INT(24, (int)results.rows[i].aggregate.count);
+        TEST_ASSERT(results.rows[i].uptime_pct == 100.0, "Filtered row below uptime floor");
+    }
+    TEST_ASSERT(results.rows[0].p90_ms <= results.rows[4].p90_ms, "Rows not sorted by p90");
+
+    // CSV export keeps the ranking
+    char *csv = NULL;
+    size_t csv_size = 0;
+    FILE *out = open_memstream(&csv, &csv_size);
+    TEST_ASSERT_NOT_NULL(out);
+    options.format = QUERY_FORMAT_CSV;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, query_write_results(&results, &options, out));
+    fclose(out);
+    TEST_ASSERT(strncmp(csv, "rank,url,", 9) == 0, "Missing CSV header");
+    TEST_ASSERT(strstr(csv, "\n1,http://s299.example.bd,FTP,24,100.000,") != NULL, "Missing first CSV row");
+    free(csv);
+    query_results_free(&results);
+
+    // Ranking by uptime puts the flaky servers last; no top-N keeps all
+    options.sort = QUERY_SORT_UPTIME;
+    options.min_uptime_pct = 0.0;
+    options.top_n = 0;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, query_run(rollups, categories, 1, &options, 4, &results));
+    TEST_ASSERT_EQUAL_INT(QUERY_TEST_SERVERS, (int)results.count);
+    TEST_ASSERT(results.rows[0].uptime_pct == 100.0, "Best uptime should come first");
+    TEST_ASSERT(results.rows[results.count - 1].uptime_pct < 100.0, "Flaky servers should come last");
+    query_results_free(&results);
+
+    QuerySortKey key;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, query_parse_sort("p99", &key));
+    TEST_ASSERT(key == QUERY_SORT_P99, "p99 not parsed");
+    TEST_ASSERT(query_parse_sort("p95", &key) != BDIX_SUCCESS, "Unknown sort key accepted");
+
+    rollup_close(rollups);
+    history_close(history);
+    server_category_free(&ftp);
+    remove_tree(dir);
+    return 1;
+}
@@ -0,0 +1,140 @@
+#include "test_common.h"
+#include "../include/rate_limit.h"
+
+int test_rate_limit_extract_host(void) {
+    char host[MEDIUM_BUFFER]; // flawfinder: ignore
+
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS,
+                          rate_limiter_extract_host("http://Server1.FTPbd.net:8080/a", host, sizeof(host)));
+    TEST_ASSERT_EQUAL_STR("server1.ftpbd.net", host);
+
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS,
+                          rate_limiter_extract_host("https://user:pw@10.16.100.244/", host, sizeof(host)));
+    TEST_ASSERT_EQUAL_STR("10.16.100.244", host);
+
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS,
+                          rate_limiter_extract_host("http://[::1]:80/", host, sizeof(host)));
+    TEST_ASSERT_EQUAL_STR("::1", host);
+
+    TEST_ASSERT(rate_limiter_extract_host("http:///path", host, sizeof(host)) != BDIX_SUCCESS,
+                "Empty host should be rejected");
+    return 1;
+}
+
+int test_rate_limit_token_bucket(void) {
+    RateLimitConfig cfg = rate_limiter_get_default_config();
+    cfg.rate_per_sec = 1.0;
+    cfg.burst = 2.0;
+    cfg.max_concurrent = 0;
+
+    RateLimiter *limiter = rate_limiter_create(&cfg);
+    TEST_ASSERT_NOT_NULL(limiter);
+
+    size_t slot;
+    double retry_ms;
+
+    // Burst is available immediately, then the bucket runs dry
+    TEST_ASSERT(rate_limiter_try_acquire(limiter, "http://a.example/1", &slot, &retry_ms, NULL), "First token");
+    rate_limiter_release(limiter, slot);
+    TEST_ASSERT(rate_limiter_try_acquire(limiter, "http://a.example/2", &slot, &retry_ms, NULL), "Second token");
+    rate_limiter_release(limiter, slot);
+    TEST_ASSERT(!rate_limiter_try_acquire(limiter, "http://a.example/3", &slot, &retry_ms, NULL), "Bucket empty");
+    TEST_ASSERT(retry_ms >= RATE_LIMIT_MIN_RETRY_MS, "Throttled probe should get a retry delay");
+
+    // Other hosts have their own bucket
+    TEST_ASSERT(rate_limiter_try_acquire(limiter, "http://b.example/", &slot, &retry_ms, NULL), "Separate host");
+    rate_limiter_release(limiter, slot);
+
+    rate_limiter_destroy(limiter);
+    return 1;
+}
+
+int test_rate_limit_concurrency_cap(void) {
+    RateLimitConfig cfg = rate_limiter_get_default_config();
+    cfg.rate_per_sec = 1000.0;
+    cfg.burst = 100.0;
+    cfg.max_concurrent = 1;
+
+    RateLimiter *limiter = rate_limiter_create(&cfg);
+    TEST_ASSERT_NOT_NULL(limiter);
+
+    size_t first, second;
+    double retry_ms;
+
+    TEST_ASSERT(rate_limiter_try_acquire(limiter, "http://c.example/", &first, &retry_ms, NULL), "First slot");
+    TEST_ASSERT(!rate_limiter_try_acquire(limiter, "http://c.example/x", &second, &retry_ms, NULL),
+                "Second concurrent probe should be deferred");
+
+    rate_limiter_release(limiter, first);
+    TEST_ASSERT(rate_limiter_try_acquire(limiter, "http://c.example/x", &second, &retry_ms, NULL),
+                "Slot should be free after release");
+    rate_limiter_release(limiter, second);
+
+    rate_limiter_destroy(limiter);
+    return 1;
+}
+
+int test_rate_limit_waiters(void) {
+    RateLimitConfig cfg = rate_limiter_get_default_config();
+    cfg.rate_per_sec = 1.0;
+    cfg.burst = 1.0;
+    cfg.max_concurrent = 0;
+
+    RateLimiter *limiter = rate_limiter_create(&cfg);
+    TEST_ASSERT_NOT_NULL(limiter);
+
+    size_t slot;
+    double retry_ms;
+    size_t first = RATE_LIMIT_NO_SLOT;
+    size_t second = RATE_LIMIT_NO_SLOT;
+
+    TEST_ASSERT(rate_limiter_try_acquire(limiter, "http://w.example/", &slot, &retry_ms, NULL), "Drain bucket");
+    rate_limiter_release(limiter, slot);
+
+    // Repeated deferrals of one work item count it as a single waiter
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT(!rate_limiter_try_acquire(limiter, "http://w.example/a", &slot, &retry_ms, &first),
+                    "Bucket empty");
+        TEST_ASSERT(first != RATE_LIMIT_NO_SLOT, "Deferred probe should be registered");
+        TEST_ASSERT(retry_ms <= 1000.0, "Repeat deferral should not push the delay out");
+    }
+
+    TEST_ASSERT(!rate_limiter_try_acquire(limiter, "http://w.example/b", &slot, &retry_ms, &second),
+                "Bucket empty");
+    TEST_ASSERT(retry_ms > 1500.0, "Second waiter should queue behind the first");
+
+    // A cancelled waiter no longer holds back the others
+    rate_limiter_cancel_wait(limiter, &first);
+    TEST_ASSERT(first == RATE_LIMIT_NO_SLOT, "Cancel should reset the registration");
+    TEST_ASSERT(!rate_limiter_try_acquire(limiter, "http://w.example/b", &slot, &retry_ms, &second),
+                "Bucket empty");
+    TEST_ASSERT(retry_ms <= 1000.0, "Cancelled waiter should be dropped");
+
+    // Delays are clamped however many waiters pile up
+    for (int i = 0; i < 20; i++) {
+        size_t waiter = RATE_LIMIT_NO_SLOT;
+        rate_limiter_try_acquire(limiter, "http://w.example/c", &slot, &retry_ms, &waiter);
+    }
+    TEST_ASSERT(retry_ms <= RATE_LIMIT_MAX_RETRY_MS, "Delay should be clamped");
+
+    rate_limiter_destroy(limiter);
+
+    // Hitting only the concurrency cap is not a token deficit
+    cfg.rate_per_sec = 1000.0;
+    cfg.burst = 100.0;
+    cfg.max_concurrent = 1;
+    limiter = rate_limiter_create(&cfg);
+    TEST_ASSERT_NOT_NULL(limiter);
+
+    size_t held;
+    size_t waiter = RATE_LIMIT_NO_SLOT;
+    TEST_ASSERT(rate_limiter_try_acquire(limiter, "http://x.example/", &held, &retry_ms, NULL), "First slot");
+    TEST_ASSERT(!rate_limiter_try_acquire(limiter, "http://x.example/", &slot, &retry_ms, &waiter),
+                "Capped");
+    TEST_ASSERT(waiter == RATE_LIMIT_NO_SLOT, "Capped probe should not be counted as a waiter");
+    TEST_ASSERT(retry_ms <= RATE_LIMIT_MIN_RETRY_MS, "Capped probe should retry soon");
+    rate_limiter_release(limiter, held);
+
+    rate_limiter_destroy(limiter);
+    return 1;
+}
@@ -0,0 +1,72 @@
+#include "test_common.h"
+#include "../include/retry.h"
+
+int test_retry_budget(void) {
+    RetryConfig config = retry_get_default_config();
+    TEST_ASSERT_EQUAL_INT(0, config.max_retries);
+    TEST_ASSERT(config.hedge_quantile == 0.0, "Hedging on by default");
+
+    config.hedge_quantile = 1.0;
+    TEST_ASSERT(retry_budget_create(&config) == NULL, "Accepted quantile of 1");
+    config.hedge_quantile = 0.0;
+    config.max_retries = RETRY_MAX_RETRIES + 1;
+    TEST_ASSERT(retry_budget_create(&config) == NULL, "Accepted too many retries");
+    TEST_ASSERT(retry_budget_create(NULL) == NULL, "Accepted NULL config");
+
+    config.max_retries = 3;
+    config.budget_pct = 50.0;
+    config.budget_burst = 2.0;
+    RetryBudget *budget = retry_budget_create(&config);
+    TEST_ASSERT_NOT_NULL(budget);
+
+    // The burst is available at once, then half of each first attempt
+    TEST_ASSERT(retry_budget_withdraw(budget, false), "Fresh budget refused a retry");
+    TEST_ASSERT(retry_budget_withdraw(budget, true), "Fresh budget refused a hedge");
+    TEST_ASSERT(!retry_budget_withdraw(budget, false), "Spent budget granted a retry");
+    retry_budget_deposit(budget);
+    TEST_ASSERT(!retry_budget_withdraw(budget, false), "Half an attempt granted a retry");
+    retry_budget_deposit(budget);
+    TEST_ASSERT(retry_budget_withdraw(budget, false), "Refilled budget refused a retry");
+    TEST_ASSERT_EQUAL_INT(2, (int)atomic_load(&budget->retries));
+    TEST_ASSERT_EQUAL_INT(1, (int)atomic_load(&budget->hedges));
+    TEST_ASSERT_EQUAL_INT(2, (int)atomic_load(&budget->denied));
+
+    // An outage failing every check adds at most budget_pct of the load
+    size_t granted = 0;
+    for (int i = 0; i < 100; i++) {
+        retry_budget_deposit(budget);
+        granted += retry_budget_withdraw(budget, false) ? 1 : 0;
+    }
+    TEST_ASSERT_EQUAL_INT(50, (int)granted);
+
+    TEST_ASSERT(!retry_budget_withdraw(NULL, false), "NULL budget granted a retry");
+    retry_budget_deposit(NULL);
+    retry_budget_destroy(budget);
+    return 1;
+}
+
+int test_retry_backoff(void) {
+    RetryConfig config = retry_get_default_config();
+    config.backoff_ms = 100.0;
+    config.max_backoff_ms = 1000.0;
+    RetryBudget *budget = retry_budget_create(&config);
+    TEST_ASSERT_NOT_NULL(budget);
+
+    // Equal jitter: between half and all of the exponential delay
+    double first_min = 1e9;
+    double first_max = 0.0;
+    for (int i = 0; i < 200; i++) {
+        double first = retry_backoff_ms(budget, 1);
+        double third = retry_backoff_ms(budget, 3);
+        double capped = retry_backoff_ms(budget, 10);
+        TEST_ASSERT(first >= 50.0 && first <= 100.0, "First backoff out of range");
+        TEST_ASSERT(third >= 200.0 && third <= 400.0, "Third backoff out of range");
+        TEST_ASSERT(capped >= 500.0 && capped <= 1000.0, "Backoff not capped");
+        first_min = MIN(first_min, first);
+        first_max = MAX(first_max, first);
+    }
+    TEST_ASSERT(first_max - first_min > 20.0, "Backoff not jittered");
+
+    retry_budget_destroy(budget);
+    return 1;
+}
@@ -0,0 +1,158 @@
+#include "test_common.h"
+#include "../include/rollup.h"
+#include <dirent.h>
+
+static void remove_tree(const char *dir) {
+    DIR *d = opendir(dir);
+    if (d) {
+        struct dirent *entry;
+        while ((entry = readdir(d)) != NULL) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+            char path[MAX_PATH_LENGTH]; // flawfinder: ignore
+            snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name); // flawfinder: ignore
+            if (unlink(path) != 0) {
+                remove_tree(path);
+            }
+        }
+        closedir(d);
+    }
+    rmdir(dir);
+}
+
+int test_rollup_sketch(void) {
+    LatencySketch all = {0};
+    LatencySketch low = {0};
+    LatencySketch high = {0};
+
+    for (int i = 1; i <= 1000; i++) {
+        latency_sketch_add(&all, i);
+        latency_sketch_add(i <= 500 ? &low : &high, i);
+    }
+
+    double p50 = latency_sketch_quantile(&all, 0.5);
+    double p90 = latency_sketch_quantile(&all, 0.9);
+    TEST_ASSERT(fabs(p50 - 500.0) / 500.0 < 0.15, "p50 outside sketch error bound");
+    TEST_ASSERT(fabs(p90 - 900.0) / 900.0 < 0.15, "p90 outside sketch error bound");
+
+    // Merging partial sketches gives the same answer as one sketch
+    latency_sketch_merge(&low, &high);
+    TEST_ASSERT(memcmp(&low, &all, sizeof(all)) == 0, "Merged sketch should equal full sketch");
+
+    LatencySketch empty = {0};
+    TEST_ASSERT(latency_sketch_quantile(&empty, 0.5) < 0.0, "Empty sketch has no quantiles");
+
+    // Stored counts saturate, query-time sums of them do not
+    RollupRecord busy = {0};
+    for (int i = 0; i < 70000; i++) {
+        rollup_record_add(&busy, BDIX_STATUS_ONLINE, 10.0);
+    }
+    RollupRecord slow = {0};
+    for (int i = 0; i < 60000; i++) {
+        rollup_record_add(&slow, BDIX_STATUS_ONLINE, 1000.0);
+    }
+    uint32_t stored = 0;
+    for (size_t i = 0; i < ROLLUP_SKETCH_BUCKETS; i++) {
+        stored += busy.sketch.counts[i];
+    }
+    TEST_ASSERT_EQUAL_INT(UINT16_MAX, (int)stored);
+    RollupAggregate sum = {0};
+    for (int i = 0; i < 3; i++) {
+        rollup_aggregate_merge(&sum, &slow);
+    }
+    rollup_aggregate_merge(&sum, &busy);
+    TEST_ASSERT_EQUAL_INT(250000, (int)sum.up_count);
+    double p50_sum = rollup_aggregate_quantile(&sum, 0.5);
+    TEST_ASSERT(fabs(p50_sum - 1000.0) / 1000.0 < 0.15, "Merged p50 skewed by saturated counts");
+    TEST_ASSERT(rollup_aggregate_quantile(&(RollupAggregate){0}, 0.5) < 0.0, "Empty aggregate has a quantile");
+
+    RollupConfig cfg = rollup_get_default_config();
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, rollup_parse_retention("raw=12h,1d=2y", &cfg));
+    TEST_ASSERT(cfg.raw_retention_ms == 12 * 3600000LL, "raw retention not parsed");
+    TEST_ASSERT(cfg.retention_ms[ROLLUP_TIER_DAY] == 730 * ROLLUP_MS_PER_DAY, "1d retention not parsed");
+    TEST_ASSERT(cfg.retention_ms[ROLLUP_TIER_HOUR] == ROLLUP_DEFAULT_HOUR_RETENTION, "Unset tier changed");
+    TEST_ASSERT(rollup_parse_retention("2h=1d", &cfg) != BDIX_SUCCESS, "Unknown tier accepted");
+
+    return 1;
+}
+
+int test_rollup_compaction(void) {
+    char dir[] = "/tmp/bdix-rollup-XXXXXX";
+    TEST_ASSERT(mkdtemp(dir) != NULL, "Failed to create temporary directory");
+
+    HistoryConfig hcfg = history_get_default_config();
+    hcfg.segment_records = 64;
+    HistoryStore *history = history_open(dir, &hcfg);
+    TEST_ASSERT_NOT_NULL(history);
+
+    // Three hours of checks every 30s, starting on a day boundary
+    const int64_t t0 = 19700 * ROLLUP_MS_PER_DAY;
+    const int64_t span = 3 * 3600000LL;
+    const int64_t q_from = t0 + 90000;
+    const int64_t q_to = t0 + 2 * 3600000LL + 45000;
+    uint64_t id = history_server_id("http://a.example.bd");
+    uint64_t other = history_server_id("http://b.example.bd");
+    RollupAggregate expect_all = {0};
+    RollupAggregate expect_range = {0};
+
+    for (int64_t ts = t0, i = 0; ts < t0 + span; ts += 30000, i++) {
+        ServerStatus status = (i % 10 == 9) ? BDIX_STATUS_TIMEOUT : BDIX_STATUS_ONLINE;
+        HistoryRecord r = { .server_id = id, .timestamp_ms = ts,
+                            .latency_ms = (float)(10 + i % 10), .status = (int16_t)status };
+        HistoryRecord o = { .server_id = other, .timestamp_ms = ts + 1,
+                            .latency_ms = 99.0f, .status = BDIX_STATUS_ONLINE };
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, history_append_record(history, &r));
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, history_append_record(history, &o));
+
+        rollup_aggregate_add(&expect_all, status, r.latency_ms);
+        if (ts >= q_from && ts < q_to) {
+            rollup_aggregate_add(&expect_range, status, r.latency_ms);
+        }
+    }
+
+    RollupConfig cfg = rollup_get_default_config();
+    RollupStore *rollups = rollup_open(dir, history, &cfg);
+    TEST_ASSERT_NOT_NULL(rollups);
+
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, rollup_compact(rollups, t0 + span + 60000));
+    TEST_ASSERT(rollups->tiers[ROLLUP_TIER_MINUTE].watermark_ms == t0 + span, "Minutes not compacted");
+    TEST_ASSERT(rollups->tiers[ROLLUP_TIER_HOUR].watermark_ms == t0 + span, "Hours not compacted");
+    TEST_ASSERT(rollups->tiers[ROLLUP_TIER_DAY].watermark_ms == 0, "Open day must not be compacted");
+    RollupAggregate got;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, rollup_aggregate(rollups, id, t0, t0 + span, &got));
+    TEST_ASSERT_EQUAL_INT((int)expect_all.count, (int)got.count);
+    TEST_ASSERT_EQUAL_INT((int)expect_all.up_count, (int)got.up_count);
+    TEST_ASSERT(got.min_latency_ms == 10.0f && got.max_latency_ms == 18.0f, "Min/max mismatch");
+    TEST_ASSERT(fabs(got.sum_latency_ms - expect_all.sum_latency_ms) < 1e-6, "Sum mismatch");
+
+    // Unaligned edges are filled from the minute tier and raw history
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, rollup_aggregate(rollups, id, q_from, q_to, &got));
+    TEST_ASSERT_EQUAL_INT((int)expect_range.count, (int)got.count);
+    TEST_ASSERT_EQUAL_INT((int)expect_range.up_count, (int)got.up_count);
+    TEST_ASSERT(memcmp(&got.sketch, &expect_range.sketch, sizeof(got.sketch)) == 0, "Sketch mismatch");
+    rollup_close(rollups);
+
+    // Raw history is dropped once compacted; rollups still answer aligned ranges
+    cfg.raw_retention_ms = 1;
+    rollups = rollup_open(dir, history, &cfg);
+    TEST_ASSERT_NOT_NULL(rollups);
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, rollup_compact(rollups, t0 + span + 60000));
+    TEST_ASSERT_EQUAL_INT(1, (int)history->segment_count);  // Only the active segment survives
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, rollup_aggregate(rollups, id, t0, t0 + span, &got));
+    TEST_ASSERT_EQUAL_INT((int)expect_all.count, (int)got.count);
+    rollup_close(rollups);
+
+    // Rollups are persistent and queryable read-only
+    cfg.read_only = true;
+    rollups = rollup_open(dir, NULL, &cfg);
+    TEST_ASSERT_NOT_NULL(rollups);
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, rollup_aggregate(rollups, id, t0, t0 + span, &got));
+    TEST_ASSERT_EQUAL_INT((int)expect_all.count, (int)got.count);
+    TEST_ASSERT(fabs(rollup_aggregate_uptime_pct(&got) - 90.0) < 1e-9, "Uptime mismatch");
+    rollup_close(rollups);
+
+    history_close(history);
+    remove_tree(dir);
+    return 1;
+}
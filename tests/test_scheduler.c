@@ -0,0 +1,63 @@
+#include "test_common.h"
+#include "../include/scheduler.h"
+
+int test_scheduler_config(void) {
+    SchedulerConfig cfg = scheduler_get_default_config();
+    TEST_ASSERT(scheduler_config_validate(&cfg), "Default config should be valid");
+
+    cfg.min_interval_s = 100.0;
+    cfg.max_interval_s = 10.0;
+    TEST_ASSERT(!scheduler_config_validate(&cfg), "Inverted bounds should be rejected");
+
+    return 1;
+}
+
+int test_scheduler_stretch_when_stable(void) {
+    SchedulerConfig cfg = scheduler_get_default_config();
+    Server s;
+    memset(&s, 0, sizeof(Server));
+    scheduler_reset_server(&s, &cfg);
+
+    TEST_ASSERT(scheduler_is_due(&s, 0.0), "Reset server should be due immediately");
+
+    // Repeated identical online results should stretch up to the ceiling
+    s.status = BDIX_STATUS_ONLINE;
+    s.latency_ms = 50.0;
+    for (int i = 0; i < 50; i++) {
+        scheduler_on_result(&s, BDIX_STATUS_ONLINE, 50.0, &cfg, 0.0);
+    }
+    TEST_ASSERT(s.schedule.interval_s == cfg.max_interval_s, "Interval should reach maximum");
+    TEST_ASSERT(!scheduler_is_due(&s, 1000.0), "Stable server should not be due yet");
+
+    return 1;
+}
+
+int test_scheduler_shrink_on_change(void) {
+    SchedulerConfig cfg = scheduler_get_default_config();
+    Server s;
+    memset(&s, 0, sizeof(Server));
+    scheduler_reset_server(&s, &cfg);
+    s.schedule.interval_s = cfg.max_interval_s;
+
+    // Latency excursion shrinks by the shrink factor
+    s.status = BDIX_STATUS_ONLINE;
+    s.latency_ms = 400.0;
+    scheduler_on_result(&s, BDIX_STATUS_ONLINE, 50.0, &cfg, 0.0);
+    TEST_ASSERT(s.schedule.interval_s == cfg.max_interval_s / cfg.shrink_factor,
+                "Latency excursion should shrink interval");
+
+    // State change resets to the minimum
+    s.status = BDIX_STATUS_TIMEOUT;
+    scheduler_on_result(&s, BDIX_STATUS_ONLINE, 400.0, &cfg, 0.0);
+    TEST_ASSERT(s.schedule.interval_s == cfg.min_interval_s, "State change should reset interval");
+    TEST_ASSERT_EQUAL_INT(0, s.schedule.stable_checks);
+
+    // Flipping between failure statuses is no change: the server backs off
+    s.schedule.interval_s = cfg.max_interval_s;
+    s.status = BDIX_STATUS_ERROR;
+    scheduler_on_result(&s, BDIX_STATUS_TIMEOUT, 0.0, &cfg, 0.0);
+    TEST_ASSERT(s.schedule.interval_s == cfg.max_interval_s, "ERROR after TIMEOUT should not reset interval");
+    TEST_ASSERT_EQUAL_INT(1, s.schedule.stable_checks);
+
+    return 1;
+}
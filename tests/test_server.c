@@ -93,3 +93,40 @@ int test_server_update_status(void) {
 
     return 1;
 }
+
+int test_server_metrics(void) {
+    Server s;
+    memset(&s, 0, sizeof(Server));
+    strcpy(s.url, "http://test.com"); // flawfinder: ignore
+
+    TEST_ASSERT(server_uptime_pct(&s) < 0.0, "Unchecked server should have no uptime");
+    TEST_ASSERT(server_latency_quantile(&s, 0.5) < 0.0, "Unchecked server should have no quantile");
+
+    server_update_status(&s, BDIX_STATUS_ONLINE, 100.0, 200);
+    TEST_ASSERT(s.metrics.ewma_latency_ms == 100.0, "First sample seeds the EWMA");
+    TEST_ASSERT(s.metrics.jitter_ms == 0.0, "Single sample has no jitter");
+
+    server_update_status(&s, BDIX_STATUS_ONLINE, 200.0, 200);
+    TEST_ASSERT(fabs(s.metrics.ewma_latency_ms - 120.0) < 1e-9, "EWMA should move by alpha");
+    TEST_ASSERT(fabs(s.metrics.jitter_ms - 100.0 / 16.0) < 1e-9, "Jitter should use RFC 3550 gain");
+
+    // Failures lower uptime but leave latency metrics alone
+    server_update_status(&s, BDIX_STATUS_TIMEOUT, 10000.0, 0);
+    server_update_status(&s, BDIX_STATUS_ERROR, 0.0, 0);
+    TEST_ASSERT(fabs(server_uptime_pct(&s) - 50.0) < 1e-9, "Uptime should be 2 of 4");
+    TEST_ASSERT(fabs(s.metrics.ewma_latency_ms - 120.0) < 1e-9, "Failures must not move the EWMA");
+
+    // Quantiles cover ONLINE samples only (nearest rank)
+    TEST_ASSERT(server_latency_quantile(&s, 0.5) == 100.0, "Median of 100/200 should be 100");
+    TEST_ASSERT(server_latency_quantile(&s, 0.95) == 200.0, "p95 of 100/200 should be 200");
+    TEST_ASSERT(server_latency_quantile(&s, 0.0) == 100.0, "p0 should be the minimum");
+
+    // A full ring of successes evicts the failures
+    for (int i = 0; i < SERVER_SAMPLE_RING; i++) {
+        server_update_status(&s, BDIX_STATUS_ONLINE, 50.0, 200);
+    }
+    TEST_ASSERT_EQUAL_INT(SERVER_SAMPLE_RING, (int)s.metrics.count);
+    TEST_ASSERT(server_uptime_pct(&s) == 100.0, "Old failures should be evicted");
+
+    return 1;
+}
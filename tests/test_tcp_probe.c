@@ -0,0 +1,240 @@
+#include "test_common.h"
+#include "../include/tcp_probe.h"
+#include "../include/checker.h"
+#include "../include/uring.h"
+#include <curl/curl.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+/**
+ * @brief Open a loopback listener on an ephemeral port
+ */
+static int listen_loopback(int backlog, int *port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, backlog) != 0 ||
+        getsockname(fd, (struct sockaddr*)&addr, &len) != 0) {
+        close(fd);
+        return -1;
+    }
+    *port = ntohs(addr.sin_port);
+    return fd;
+}
+
+/**
+ * @brief Connect to a loopback port without waiting for accept
+ */
+static int connect_loopback(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)port);
+    connect(fd, (struct sockaddr*)&addr, sizeof(addr));
+    return fd;
+}
+
+static void count_result(Server *server, void *ctx) {
+    UNUSED(server);
+    (*(int*)ctx)++;
+}
+
+int test_tcp_probe_url_port(void) {
+    TEST_ASSERT_EQUAL_INT(80, tcp_probe_url_port("http://example.com/path"));
+    TEST_ASSERT_EQUAL_INT(443, tcp_probe_url_port("HTTPS://example.com"));
+    TEST_ASSERT_EQUAL_INT(21, tcp_probe_url_port("ftp://user:pw@example.com/"));
+    TEST_ASSERT_EQUAL_INT(8080, tcp_probe_url_port("http://example.com:8080/x:1"));
+    TEST_ASSERT_EQUAL_INT(8443, tcp_probe_url_port("https://[2001:db8::1]:8443/"));
+    TEST_ASSERT_EQUAL_INT(443, tcp_probe_url_port("https://[2001:db8::1]/"));
+    TEST_ASSERT_EQUAL_INT(80, tcp_probe_url_port("http://example.com:99999/"));
+    return 1;
+}
+
+/**
+ * @brief Sweep open, pinned, refused, filtered and unresolvable targets
+ */
+static int check_sweep(bool io_uring) {
+    int open_port, full_port, closed_port;
+    int open_fd = listen_loopback(16, &open_port);
+    int full_fd = listen_loopback(0, &full_port);
+    int closed_fd = listen_loopback(1, &closed_port);
+    TEST_ASSERT(open_fd >= 0 && full_fd >= 0 && closed_fd >= 0, "Failed to listen on loopback");
+    close(closed_fd);  // Connections to this port are refused
+
+    // Fill the accept queue so further SYNs are dropped and connects time out
+    int fillers[4];
+    for (int i = 0; i < 4; i++) {
+        fillers[i] = connect_loopback(full_port);
+    }
+    sleep_ms(50);
+
+    char urls[6][MAX_URL_LENGTH]; /* flawfinder: ignore - bounds checked with snprintf */
+    snprintf(urls[0], sizeof(urls[0]), "http://127.0.0.1:%d/a", open_port); // flawfinder: ignore
+    snprintf(urls[1], sizeof(urls[1]), "http://127.0.0.1:%d/b", open_port); // flawfinder: ignore
+    snprintf(urls[2], sizeof(urls[2]), "http://pinned.test:%d/", open_port); // flawfinder: ignore
+    snprintf(urls[3], sizeof(urls[3]), "http://127.0.0.1:%d/", closed_port); // flawfinder: ignore
+    snprintf(urls[4], sizeof(urls[4]), "http://127.0.0.1:%d/", full_port); // flawfinder: ignore
+    snprintf(urls[5], sizeof(urls[5]), "http://no-such-host.invalid:%d/", open_port); // flawfinder: ignore
+
+    ServerCategory category;
+    server_category_init(&category, CATEGORY_FTP, "FTP");
+    Server *servers[6];
+    for (size_t i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, server_category_add(&category, urls[i]));
+    }
+    for (size_t i = 0; i < 6; i++) {
+        servers[i] = server_category_get(&category, i);
+    }
+
+    char pin[MEDIUM_BUFFER]; /* flawfinder: ignore - bounds checked with snprintf */
+    snprintf(pin, sizeof(pin), "pinned.test:%d:127.0.0.1", open_port); // flawfinder: ignore
+    struct curl_slist *resolve = curl_slist_append(NULL, pin);
+
+    TcpProbeConfig config = tcp_probe_get_default_config();
+    config.timeout_ms = 300;
+    config.resolve = resolve;
+    config.io_uring = io_uring;
+
+    int results = 0;
+    double start = get_time_ms();
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, tcp_probe_servers(servers, 6, &config, count_result, &results));
+    double elapsed = get_time_ms() - start;
+    curl_slist_free_all(resolve);
+
+    TEST_ASSERT_EQUAL_INT(6, results);
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_ONLINE, servers[0]->status);
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_ONLINE, servers[1]->status);
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_ONLINE, servers[2]->status);
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_OFFLINE, servers[3]->status);
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_TIMEOUT, servers[4]->status);
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_ERROR, servers[5]->status);
+    TEST_ASSERT(servers[0]->timing.connect_ms > 0.0 &&
+                servers[0]->latency_ms == servers[0]->timing.connect_ms, "Connect time not recorded");
+
+    // Everything in flight at once: about one timeout, not one per host
+    TEST_ASSERT(elapsed < 300.0 * 3, "Sweep not concurrent");
+
+    // The open port was connected once for both of its servers
+    TEST_ASSERT(servers[0]->latency_ms == servers[1]->latency_ms, "Shared host:port connected twice");
+
+    for (int i = 0; i < 4; i++) {
+        close(fillers[i]);
+    }
+    close(full_fd);
+    close(open_fd);
+    server_category_free(&category);
+    return 1;
+}
+
+int test_tcp_probe_sweep(void) {
+    return check_sweep(false);
+}
+
+int test_tcp_probe_sweep_uring(void) {
+    if (!uring_available()) {
+        printf(TEST_COLOR_YELLOW "  [SKIP] io_uring not available" TEST_COLOR_RESET "\n"); // flawfinder: ignore
+        return 1;
+    }
+    return check_sweep(true);
+}
+
+int test_tcp_probe_checker_engine(void) {
+    int port;
+    int fd = listen_loopback(64, &port);
+    TEST_ASSERT(fd >= 0, "Failed to listen on loopback");
+
+    ServerCategory category;
+    server_category_init(&category, CATEGORY_FTP, "FTP");
+    for (int i = 0; i < 20; i++) {
+        char url[MAX_URL_LENGTH]; /* flawfinder: ignore - bounds checked with snprintf */
+        snprintf(url, sizeof(url), "http://127.0.0.1:%d/mirror%d", port, i); // flawfinder: ignore
+        server_category_add(&category, url);
+    }
+
+    CheckerConfig config = checker_get_default_config();
+    config.engine = CHECK_ENGINE_TCP;
+    config.verbose = false;
+    CheckerStats stats;
+    checker_stats_init(&stats);
+
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_check_category(&category, &config, 4, &stats));
+    TEST_ASSERT_EQUAL_INT(20, (int)atomic_load(&stats.total_checked));
+    TEST_ASSERT_EQUAL_INT(20, (int)atomic_load(&stats.online_count));
+    TEST_ASSERT(category.servers[19].metrics.count == 1, "Sample not recorded");
+
+    close(fd);
+    server_category_free(&category);
+    return 1;
+}
+
+/**
+ * @brief Cancel a sweep while a connect to a full accept queue is in flight
+ */
+static int check_cancel(bool io_uring) {
+    int open_port, full_port;
+    int open_fd = listen_loopback(16, &open_port);
+    int full_fd = listen_loopback(0, &full_port);
+    TEST_ASSERT(open_fd >= 0 && full_fd >= 0, "Failed to listen on loopback");
+    int fillers[4];
+    for (int i = 0; i < 4; i++) {
+        fillers[i] = connect_loopback(full_port);
+    }
+    sleep_ms(50);
+
+    ServerCategory category;
+    server_category_init(&category, CATEGORY_FTP, "FTP");
+    char url[MAX_URL_LENGTH]; /* flawfinder: ignore - bounds checked with snprintf */
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/", open_port); // flawfinder: ignore
+    server_category_add(&category, url);
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/", full_port); // flawfinder: ignore
+    server_category_add(&category, url);
+    Server *servers[2] = { server_category_get(&category, 0), server_category_get(&category, 1) };
+
+    CancelToken cancel;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, cancel_token_init(&cancel));
+    cancel_token_set_deadline(&cancel, get_time_ms() + 100.0);
+
+    TcpProbeConfig config = tcp_probe_get_default_config();
+    config.timeout_ms = 3000;
+    config.io_uring = io_uring;
+    config.cancel = &cancel;
+
+    int results = 0;
+    double start = get_time_ms();
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, tcp_probe_servers(servers, 2, &config, count_result, &results));
+    double elapsed = get_time_ms() - start;
+
+    TEST_ASSERT(elapsed < 1000.0, "Sweep ran past its cancellation");
+    TEST_ASSERT_EQUAL_INT(1, results);
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_ONLINE, servers[0]->status);
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_UNKNOWN, servers[1]->status);
+
+    cancel_token_destroy(&cancel);
+    for (int i = 0; i < 4; i++) {
+        close(fillers[i]);
+    }
+    close(full_fd);
+    close(open_fd);
+    server_category_free(&category);
+    return 1;
+}
+
+int test_tcp_probe_cancel(void) {
+    if (!check_cancel(false)) {
+        return 0;
+    }
+    if (!uring_available()) {
+        printf(TEST_COLOR_YELLOW "  [SKIP] io_uring not available" TEST_COLOR_RESET "\n"); // flawfinder: ignore
+        return 1;
+    }
+    return check_cancel(true);
+}
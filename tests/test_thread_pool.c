@@ -0,0 +1,517 @@
+#include "test_common.h"
+#include "../include/thread_pool.h"
+
+static _Atomic int g_counter = 0;
+
+static void* increment_task(void *arg) {
+    UNUSED(arg);
+    atomic_fetch_add(&g_counter, 1);
+    return NULL;
+}
+
+static atomic_bool g_gate_open;
+static int g_order[8];
+
+static void* gate_task(void *arg) {
+    UNUSED(arg);
+    while (!atomic_load(&g_gate_open)) {
+        sleep_ms(1);
+    }
+    return NULL;
+}
+
+static void* record_order_task(void *arg) {
+    g_order[atomic_fetch_add(&g_counter, 1)] = (int)(intptr_t)arg;
+    return NULL;
+}
+
+int test_thread_pool_basic(void) {
+    atomic_store(&g_counter, 0);
+
+    ThreadPool *pool = thread_pool_create(4);
+    TEST_ASSERT_NOT_NULL(pool);
+
+    for (int i = 0; i < 100; i++) {
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_add_work(pool, increment_task, NULL));
+    }
+    thread_pool_wait(pool);
+
+    TEST_ASSERT_EQUAL_INT(100, atomic_load(&g_counter));
+    TEST_ASSERT(thread_pool_is_idle(pool), "Pool should be idle after wait");
+
+    thread_pool_destroy(pool);
+    return 1;
+}
+
+int test_thread_pool_delayed(void) {
+    atomic_store(&g_counter, 0);
+
+    ThreadPool *pool = thread_pool_create(2);
+    TEST_ASSERT_NOT_NULL(pool);
+
+    double start = get_time_ms();
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_add_work_delayed(pool, increment_task, NULL, 50.0));
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_add_work(pool, increment_task, NULL));
+
+    thread_pool_wait(pool);
+    double elapsed = get_time_ms() - start;
+
+    TEST_ASSERT_EQUAL_INT(2, atomic_load(&g_counter));
+    TEST_ASSERT(elapsed >= 45.0, "Delayed work should not run early");
+
+    thread_pool_destroy(pool);
+    return 1;
+}
+
+int test_thread_pool_wait_timeout(void) {
+    atomic_store(&g_counter, 0);
+
+    ThreadPool *pool = thread_pool_create(2);
+    TEST_ASSERT_NOT_NULL(pool);
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_wait_timeout(pool, 0));
+
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_add_work_delayed(pool, increment_task, NULL, 200.0));
+    double start = get_time_ms();
+    TEST_ASSERT_EQUAL_INT(BDIX_ERROR, thread_pool_wait_timeout(pool, 20));
+    double elapsed = get_time_ms() - start;
+    TEST_ASSERT(elapsed >= 15.0 && elapsed < 150.0, "Timed wait did not return at its timeout");
+    TEST_ASSERT_EQUAL_INT(0, atomic_load(&g_counter));
+
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_wait_timeout(pool, 5000));
+    TEST_ASSERT_EQUAL_INT(1, atomic_load(&g_counter));
+
+    thread_pool_destroy(pool);
+    return 1;
+}
+
+int test_thread_pool_release_delayed(void) {
+    atomic_store(&g_counter, 0);
+
+    ThreadPool *pool = thread_pool_create(2);
+    TEST_ASSERT_NOT_NULL(pool);
+    TEST_ASSERT_EQUAL_INT(0, (int)thread_pool_release_delayed(pool));
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS,
+                              thread_pool_add_work_delayed(pool, increment_task, NULL, 10000.0 + i));
+    }
+    double start = get_time_ms();
+    TEST_ASSERT_EQUAL_INT(3, (int)thread_pool_release_delayed(pool));
+    thread_pool_wait(pool);
+    TEST_ASSERT(get_time_ms() - start < 1000.0, "Released work still waited for its delay");
+    TEST_ASSERT_EQUAL_INT(3, atomic_load(&g_counter));
+
+    thread_pool_destroy(pool);
+    return 1;
+}
+
+int test_thread_pool_priority(void) {
+    static const double priorities[] = { 5.0, 1.0, 3.0, 1.0, 2.0 };
+    static const int expected[] = { 1, 3, 4, 2, 0 };
+
+    for (int prioritized = 0; prioritized <= 1; prioritized++) {
+        atomic_store(&g_counter, 0);
+        atomic_store(&g_gate_open, false);
+
+        // One worker, held by the gate while the rest is queued
+        ThreadPool *pool = prioritized ? thread_pool_create_prioritized(1) : thread_pool_create(1);
+        TEST_ASSERT_NOT_NULL(pool);
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_add_work(pool, gate_task, NULL));
+        for (int i = 0; i < (int)ARRAY_SIZE(priorities); i++) {
+            TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS,
+                                  thread_pool_add_work_priority(pool, record_order_task,
+                                                                (void*)(intptr_t)i, priorities[i], 0.0));
+        }
+        // Deferred work keeps its priority once due
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS,
+                              thread_pool_add_work_priority(pool, record_order_task,
+                                                            (void*)(intptr_t)5, 0.5, 1.0));
+        sleep_ms(20);
+        atomic_store(&g_gate_open, true);
+        thread_pool_wait(pool);
+        thread_pool_destroy(pool);
+
+        TEST_ASSERT_EQUAL_INT(6, atomic_load(&g_counter));
+        if (prioritized) {
+            TEST_ASSERT_EQUAL_INT(5, g_order[0]);
+            for (int i = 0; i < (int)ARRAY_SIZE(expected); i++) {
+                TEST_ASSERT_EQUAL_INT(expected[i], g_order[i + 1]);
+            }
+        } else {
+            for (int i = 0; i < (int)ARRAY_SIZE(priorities); i++) {
+                TEST_ASSERT_EQUAL_INT(i, g_order[i]);
+            }
+        }
+    }
+    return 1;
+}
+
+static void* sleep_task(void *arg) {
+    sleep_ms((int)(intptr_t)arg);
+    atomic_fetch_add(&g_counter, 1);
+    return NULL;
+}
+
+static void* spin_task(void *arg) {
+    double until = get_time_ms() + (double)(intptr_t)arg;
+    while (get_time_ms() < until) {
+    }
+    atomic_fetch_add(&g_counter, 1);
+    return NULL;
+}
+
+int test_thread_pool_autotune(void) {
+    ThreadPoolConfig config = thread_pool_get_default_config();
+    config.threads = 2;
+    config.max_threads = 64;
+    config.autotune = true;
+    config.tune_interval_ms = 20.0;
+
+    // Blocking work barely uses the CPU: the pool grows well past its start
+    atomic_store(&g_counter, 0);
+    ThreadPool *pool = thread_pool_create_with_config(&config);
+    TEST_ASSERT_NOT_NULL(pool);
+    double start = get_time_ms();
+    for (int i = 0; i < 600; i++) {
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_add_work(pool, sleep_task, (void*)(intptr_t)20));
+    }
+    thread_pool_wait(pool);
+    double elapsed = get_time_ms() - start;
+    ThreadPoolConcurrency c = thread_pool_get_concurrency(pool);
+    thread_pool_destroy(pool);
+
+    TEST_ASSERT_EQUAL_INT(600, atomic_load(&g_counter));
+    TEST_ASSERT(c.settled >= 16, "Autotuned pool did not grow for blocking work");
+    TEST_ASSERT(c.peak <= 64 && c.threads <= 64, "Autotuned pool exceeded its ceiling");
+    TEST_ASSERT(elapsed < 600 * 20 / 2 / 3, "Autotuned pool was not faster than its start size");
+
+    // Busy work saturates the CPU: the pool stays near the core count
+    long cpus = MAX(sysconf(_SC_NPROCESSORS_ONLN), 1L);
+    atomic_store(&g_counter, 0);
+    pool = thread_pool_create_with_config(&config);
+    TEST_ASSERT_NOT_NULL(pool);
+    for (int i = 0; i < 100; i++) {
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_add_work(pool, spin_task, (void*)(intptr_t)5));
+    }
+    thread_pool_wait(pool);
+    c = thread_pool_get_concurrency(pool);
+    thread_pool_destroy(pool);
+
+    TEST_ASSERT_EQUAL_INT(100, atomic_load(&g_counter));
+    TEST_ASSERT(c.settled <= (size_t)MAX(4 * cpus, 8), "Autotuned pool grew for CPU-bound work");
+
+    // A fixed-size pool keeps its size; the autotuning ceiling is checked
+    pool = thread_pool_create(4);
+    TEST_ASSERT_NOT_NULL(pool);
+    c = thread_pool_get_concurrency(pool);
+    TEST_ASSERT_EQUAL_INT(4, (int)c.limit);
+    TEST_ASSERT_EQUAL_INT(4, (int)c.threads);
+    thread_pool_destroy(pool);
+
+    config.max_threads = MAX_AUTOTUNE_THREADS + 1;
+    TEST_ASSERT(thread_pool_create_with_config(&config) == NULL, "Ceiling above MAX_AUTOTUNE_THREADS accepted");
+    config.autotune = false;
+    config.threads = MAX_THREADS + 1;
+    TEST_ASSERT(thread_pool_create_with_config(&config) == NULL, "Fixed pool above MAX_THREADS accepted");
+    return 1;
+}
+
+int test_thread_pool_autotune_workers(void) {
+    ThreadPoolConfig config = thread_pool_get_default_config();
+    config.threads = 2;
+    config.max_threads = 64;
+    config.autotune = true;
+    config.tune_interval_ms = 20.0;
+
+    // Nobody waits on the pool: its workers alone have to grow it
+    atomic_store(&g_counter, 0);
+    ThreadPool *pool = thread_pool_create_with_config(&config);
+    TEST_ASSERT_NOT_NULL(pool);
+    double start = get_time_ms();
+    for (int i = 0; i < 600; i++) {
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_add_work(pool, sleep_task, (void*)(intptr_t)20));
+    }
+    while (atomic_load(&g_counter) < 600 && get_time_ms() - start < 10000.0) {
+        sleep_ms(5);
+    }
+    double elapsed = get_time_ms() - start;
+    ThreadPoolConcurrency c = thread_pool_get_concurrency(pool);
+    thread_pool_destroy(pool);
+
+    TEST_ASSERT_EQUAL_INT(600, atomic_load(&g_counter));
+    TEST_ASSERT(c.adjustments > 0 && c.peak > 2, "Workers never grew the pool");
+    TEST_ASSERT(elapsed < 600 * 20 / 2 / 3, "Worker-tuned pool was not faster than its start size");
+    return 1;
+}
+
+int test_thread_pool_stats(void) {
+    ThreadPoolHistogram hist = {0};
+    TEST_ASSERT(thread_pool_histogram_quantile(&hist, 0.5) == 0.0, "Empty histogram has a quantile");
+    thread_pool_histogram_add(&hist, 0.0005);
+    thread_pool_histogram_add(&hist, 1.0);
+    thread_pool_histogram_add(&hist, 3.0);
+    TEST_ASSERT_EQUAL_INT(3, (int)hist.count);
+    TEST_ASSERT_EQUAL_INT(1, (int)hist.counts[0]);
+    double median = thread_pool_histogram_quantile(&hist, 0.5);
+    TEST_ASSERT(median > 0.5 && median <= 1.1, "Histogram median outside the bucket of 1 ms");
+    TEST_ASSERT(thread_pool_histogram_quantile(&hist, 1.0) == 3.0, "Histogram maximum not clamped");
+
+    // One worker and ten 5 ms tasks: later tasks queue behind earlier ones
+    atomic_store(&g_counter, 0);
+    ThreadPool *pool = thread_pool_create(1);
+    TEST_ASSERT_NOT_NULL(pool);
+    sleep_ms(10);
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_add_work(pool, sleep_task, (void*)(intptr_t)5));
+    }
+    thread_pool_wait(pool);
+
+    ThreadPoolStats stats;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_get_stats(pool, &stats));
+    thread_pool_destroy(pool);
+
+    TEST_ASSERT_EQUAL_INT(10, atomic_load(&g_counter));
+    TEST_ASSERT_EQUAL_INT(1, (int)stats.threads);
+    TEST_ASSERT_EQUAL_INT(10, (int)stats.queue_wait.count);
+    TEST_ASSERT_EQUAL_INT(10, (int)stats.run.count);
+    TEST_ASSERT(stats.queue_wait.max_ms >= 30.0, "Queue wait of the last task not recorded");
+    double run_p50 = thread_pool_histogram_quantile(&stats.run, 0.5);
+    TEST_ASSERT(run_p50 >= 2.0 && run_p50 < 50.0, "Run time median far from 5 ms");
+    TEST_ASSERT_EQUAL_INT(10, (int)stats.workers[0].tasks);
+    TEST_ASSERT(stats.workers[0].busy_ms >= 45.0, "Worker busy time not recorded");
+    TEST_ASSERT(stats.workers[0].idle_ms >= 5.0 && stats.workers[0].wakeups >= 1,
+                "Worker idle time before the first task not recorded");
+    TEST_ASSERT_EQUAL_INT(10, (int)stats.done_signals);
+    TEST_ASSERT(stats.done_wakeups >= 1, "Waiter wakeups not counted");
+    TEST_ASSERT(stats.lock_acquisitions >= 30 && stats.lock_contended <= stats.lock_acquisitions,
+                "Queue lock acquisitions not counted");
+    TEST_ASSERT(stats.elapsed_ms >= 50.0, "Pool age not recorded");
+    thread_pool_stats_free(&stats);
+    TEST_ASSERT(stats.workers == NULL, "Snapshot workers not released");
+
+    TEST_ASSERT_EQUAL_INT(BDIX_ERROR_INVALID_INPUT, thread_pool_get_stats(NULL, &stats));
+    return 1;
+}
+
+static void* square_task(void *arg) {
+    intptr_t x = (intptr_t)arg;
+    return (void*)(x * x);
+}
+
+static void* add_then(void *result, void *arg) {
+    return (void*)((intptr_t)result + (intptr_t)arg);
+}
+
+static void* group_wait_task(void *arg) {
+    thread_pool_group_wait((ThreadPoolGroup*)arg);
+    atomic_fetch_add(&g_counter, 1);
+    return NULL;
+}
+
+static void* open_gate_later(void *arg) {
+    UNUSED(arg);
+    sleep_ms(50);
+    atomic_store(&g_gate_open, true);
+    return NULL;
+}
+
+int test_thread_pool_tasks(void) {
+    atomic_store(&g_gate_open, false);
+    ThreadPool *pool = thread_pool_create(2);
+    TEST_ASSERT_NOT_NULL(pool);
+
+    // Results come back through the handle, continuations see them
+    ThreadPoolTask *square = thread_pool_submit(pool, NULL, square_task, (void*)(intptr_t)7);
+    TEST_ASSERT_NOT_NULL(square);
+    ThreadPoolTask *plus = thread_pool_task_then(square, add_then, (void*)(intptr_t)1);
+    ThreadPoolTask *twice = thread_pool_task_then(plus, add_then, (void*)(intptr_t)10);
+    TEST_ASSERT_EQUAL_INT(60, (int)(intptr_t)thread_pool_task_wait(twice));
+    TEST_ASSERT_EQUAL_INT(49, (int)(intptr_t)thread_pool_task_wait(square));
+    TEST_ASSERT(thread_pool_task_done(plus), "Antecedent of a finished continuation not done");
+
+    // Chaining onto a finished task queues the continuation at once
+    ThreadPoolTask *late = thread_pool_task_then(square, add_then, (void*)(intptr_t)100);
+    TEST_ASSERT_EQUAL_INT(149, (int)(intptr_t)thread_pool_task_wait(late));
+    thread_pool_task_release(late);
+    thread_pool_task_release(twice);
+    thread_pool_task_release(plus);
+    thread_pool_task_release(square);
+
+    // A blocked group does not hold up another group in the same pool
+    ThreadPoolGroup *blocked = thread_pool_group_create(pool);
+    ThreadPoolGroup *quick = thread_pool_group_create(pool);
+    TEST_ASSERT_NOT_NULL(blocked);
+    TEST_ASSERT_NOT_NULL(quick);
+    ThreadPoolTask *gate = thread_pool_submit(pool, blocked, gate_task, NULL);
+    TEST_ASSERT_NOT_NULL(gate);
+    ThreadPoolTask *after_gate = thread_pool_task_then(gate, add_then, (void*)(intptr_t)5);
+    TEST_ASSERT_EQUAL_INT(2, (int)thread_pool_group_pending(blocked));
+
+    atomic_store(&g_counter, 0);
+    ThreadPoolTask *fast = thread_pool_submit(pool, quick, square_task, (void*)(intptr_t)3);
+    for (int i = 0; i < 20; i++) {
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_group_add_work(quick, increment_task, NULL));
+    }
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_group_wait(quick));
+    TEST_ASSERT_EQUAL_INT(20, atomic_load(&g_counter));
+    TEST_ASSERT_EQUAL_INT(0, (int)thread_pool_group_pending(quick));
+
+    ThreadPoolTask *pair[] = { gate, fast };
+    TEST_ASSERT_EQUAL_INT(1, (int)thread_pool_task_wait_any(pair, 2));
+    TEST_ASSERT_EQUAL_INT(BDIX_ERROR, thread_pool_group_wait_timeout(blocked, 20));
+    TEST_ASSERT(!thread_pool_task_done(gate), "Gated task finished early");
+
+    atomic_store(&g_gate_open, true);
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_group_wait_timeout(blocked, 5000));
+    TEST_ASSERT_EQUAL_INT(5, (int)(intptr_t)thread_pool_task_wait(after_gate));
+    TEST_ASSERT_EQUAL_INT(0, (int)thread_pool_task_wait_any(pair, 2));
+
+    thread_pool_task_release(after_gate);
+    thread_pool_task_release(gate);
+    thread_pool_task_release(fast);
+    thread_pool_group_destroy(quick);
+    thread_pool_group_destroy(blocked);
+
+    // Tasks share thread_pool_wait() with plain work
+    ThreadPoolTask *plain = thread_pool_submit(pool, NULL, square_task, (void*)(intptr_t)4);
+    thread_pool_wait(pool);
+    TEST_ASSERT(thread_pool_task_done(plain), "thread_pool_wait() returned before a task finished");
+    thread_pool_task_release(plain);
+
+    TEST_ASSERT(thread_pool_submit(NULL, NULL, square_task, NULL) == NULL, "Task without a pool accepted");
+    TEST_ASSERT(thread_pool_task_wait_any(NULL, 2) == 2, "wait_any accepted no tasks");
+    thread_pool_destroy(pool);
+
+    // Destroying a pool finishes tasks that never ran, releasing their waiters
+    atomic_store(&g_gate_open, false);
+    atomic_store(&g_counter, 0);
+    pool = thread_pool_create(1);
+    TEST_ASSERT_NOT_NULL(pool);
+    ThreadPoolGroup *orphans = thread_pool_group_create(pool);
+    TEST_ASSERT_NOT_NULL(orphans);
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_add_work(pool, gate_task, NULL));
+    ThreadPoolTask *queued = thread_pool_submit(pool, orphans, square_task, (void*)(intptr_t)5);
+    ThreadPoolTask *chained = thread_pool_task_then(queued, add_then, (void*)(intptr_t)1);
+    TEST_ASSERT_NOT_NULL(chained);
+
+    pthread_t waiter, opener;
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&waiter, NULL, group_wait_task, orphans));
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&opener, NULL, open_gate_later, NULL));
+    sleep_ms(20);
+    thread_pool_destroy(pool);
+    pthread_join(opener, NULL);
+    pthread_join(waiter, NULL);
+    TEST_ASSERT_EQUAL_INT(1, atomic_load(&g_counter));
+    // The group went with the pool
+    thread_pool_task_release(chained);
+    thread_pool_task_release(queued);
+    return 1;
+}
+
+static _Atomic size_t g_index_sum;
+static ThreadPool *g_feed_pool;
+
+static void* blocking_add_task(void *arg) {
+    thread_pool_add_work((ThreadPool*)arg, increment_task, NULL);
+    atomic_fetch_add(&g_counter, 100);
+    return NULL;
+}
+
+static void* feed_own_pool_task(void *arg) {
+    UNUSED(arg);
+    for (int i = 0; i < 10; i++) {
+        thread_pool_add_work(g_feed_pool, increment_task, NULL);
+    }
+    return NULL;
+}
+
+static void sum_index(void *ctx, size_t index) {
+    UNUSED(ctx);
+    atomic_fetch_add(&g_index_sum, index + 1);
+}
+
+static void defer_index(void *ctx, size_t index) {
+    UNUSED(index);
+    atomic_fetch_add(&g_index_sum, 1);
+    thread_pool_add_work_priority((ThreadPool*)ctx, increment_task, NULL, 0.0, 50.0);
+}
+
+int test_thread_pool_bounded(void) {
+    ThreadPoolConfig config = thread_pool_get_default_config();
+    config.threads = 1;
+    config.queue_capacity = 4;
+
+    // A full queue refuses try_add_work and blocks add_work until a worker takes an item
+    atomic_store(&g_counter, 0);
+    atomic_store(&g_gate_open, false);
+    ThreadPool *pool = thread_pool_create_with_config(&config);
+    TEST_ASSERT_NOT_NULL(pool);
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_add_work(pool, gate_task, NULL));
+    while (thread_pool_working_count(pool) == 0) {
+        sleep_ms(1);
+    }
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_try_add_work(pool, increment_task, NULL));
+    }
+    TEST_ASSERT_EQUAL_INT(BDIX_ERROR_BUSY, thread_pool_try_add_work(pool, increment_task, NULL));
+
+    pthread_t producer;
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&producer, NULL, blocking_add_task, pool));
+    sleep_ms(30);
+    TEST_ASSERT(atomic_load(&g_counter) < 100, "Submitter did not block on a full queue");
+
+    // Ranges do not count against the capacity
+    atomic_store(&g_index_sum, 0);
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_add_range(pool, sum_index, NULL, 1000));
+    TEST_ASSERT_EQUAL_INT(1004, (int)thread_pool_pending_count(pool));
+
+    atomic_store(&g_gate_open, true);
+    pthread_join(producer, NULL);
+    thread_pool_wait(pool);
+    ThreadPoolStats stats;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_get_stats(pool, &stats));
+    thread_pool_destroy(pool);
+
+    TEST_ASSERT_EQUAL_INT(105, atomic_load(&g_counter));
+    TEST_ASSERT_EQUAL_INT(1000 * 1001 / 2, (int)atomic_load(&g_index_sum));
+    TEST_ASSERT_EQUAL_INT(1, (int)stats.producer_waits);
+    TEST_ASSERT(stats.producer_wait_ms >= 20.0, "Blocked submission time not recorded");
+    TEST_ASSERT_EQUAL_INT(1006, (int)stats.workers[0].tasks);
+    thread_pool_stats_free(&stats);
+
+    // Workers feeding their own pool never block on it
+    config.queue_capacity = 1;
+    atomic_store(&g_counter, 0);
+    g_feed_pool = thread_pool_create_with_config(&config);
+    TEST_ASSERT_NOT_NULL(g_feed_pool);
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_add_work(g_feed_pool, feed_own_pool_task, NULL));
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_wait_timeout(g_feed_pool, 5000));
+    thread_pool_destroy(g_feed_pool);
+    TEST_ASSERT_EQUAL_INT(10, atomic_load(&g_counter));
+
+    // Indices that defer themselves stop being handed out while the queue is full
+    config.queue_capacity = 2;
+    atomic_store(&g_counter, 0);
+    atomic_store(&g_index_sum, 0);
+    pool = thread_pool_create_with_config(&config);
+    TEST_ASSERT_NOT_NULL(pool);
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_add_range(pool, defer_index, pool, 10));
+    sleep_ms(25);
+    TEST_ASSERT_EQUAL_INT(2, (int)atomic_load(&g_index_sum));
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_wait_timeout(pool, 5000));
+    thread_pool_destroy(pool);
+    TEST_ASSERT_EQUAL_INT(10, (int)atomic_load(&g_index_sum));
+    TEST_ASSERT_EQUAL_INT(10, atomic_load(&g_counter));
+
+    // A range on several workers hands out every index exactly once
+    atomic_store(&g_index_sum, 0);
+    pool = thread_pool_create(4);
+    TEST_ASSERT_NOT_NULL(pool);
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_add_range(pool, sum_index, NULL, 5000));
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, thread_pool_add_range(pool, sum_index, NULL, 0));
+    thread_pool_wait(pool);
+    TEST_ASSERT(thread_pool_is_idle(pool), "Pool not idle after its range");
+    thread_pool_destroy(pool);
+    TEST_ASSERT_EQUAL_INT(5000 * 5001 / 2, (int)atomic_load(&g_index_sum));
+    return 1;
+}
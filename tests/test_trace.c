@@ -0,0 +1,83 @@
+#include "test_common.h"
+#include "../include/trace.h"
+#include "../include/thread_pool.h"
+#include <jansson.h>
+
+#define TRACE_TEST_TASKS 64
+
+static void* traced_task(void *arg) {
+    uint64_t start = trace_begin();
+    atomic_fetch_add((_Atomic int*)arg, 1);
+    trace_end(TRACE_CAT_CHECK, "task", start, "http://example.bd/\"quoted\"");
+    return NULL;
+}
+
+int test_trace_chrome_json(void) {
+    // Nothing is recorded while tracing is off
+    TEST_ASSERT(trace_begin() == 0, "Span started while tracing is off");
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, trace_stop());
+
+    char path[] = "/tmp/bdix-trace-XXXXXX";
+    int fd = mkstemp(path);
+    TEST_ASSERT(fd >= 0, "Failed to create temporary file");
+    close(fd);
+
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, trace_start(path));
+
+    _Atomic int done = 0;
+    ThreadPool *pool = thread_pool_create(4);
+    TEST_ASSERT_NOT_NULL(pool);
+    for (int i = 0; i < TRACE_TEST_TASKS; i++) {
+        thread_pool_add_work(pool, traced_task, (void*)&done);
+    }
+    thread_pool_wait(pool);
+    thread_pool_destroy(pool);
+
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, trace_stop());
+    TEST_ASSERT(trace_begin() == 0, "Tracing still on after stop");
+
+    json_error_t error;
+    json_t *root = json_load_file(path, 0, &error);
+    unlink(path);
+    TEST_ASSERT_NOT_NULL(root);
+
+    json_t *events = json_object_get(root, "traceEvents");
+    TEST_ASSERT(json_is_array(events), "traceEvents missing");
+
+    int tasks = 0, enqueues = 0, queued = 0, metadata = 0;
+    size_t index;
+    json_t *event;
+    json_array_foreach(events, index, event) {
+        const char *name = json_string_value(json_object_get(event, "name"));
+        const char *ph = json_string_value(json_object_get(event, "ph"));
+        TEST_ASSERT(name && ph, "Event without name or phase");
+
+        if (strcmp(ph, "M") == 0) {
+            metadata++;
+            continue;
+        }
+        TEST_ASSERT_EQUAL_STR("X", ph);
+        TEST_ASSERT(json_is_integer(json_object_get(event, "ts")), "Span without timestamp");
+        TEST_ASSERT(json_is_integer(json_object_get(event, "dur")), "Span without duration");
+
+        if (strcmp(name, "task") == 0) {
+            const char *detail = json_string_value(json_object_get(json_object_get(event, "args"), "detail"));
+            TEST_ASSERT_EQUAL_STR("http://example.bd/\"quoted\"", detail);
+            tasks++;
+        } else if (strcmp(name, "enqueue") == 0) {
+            enqueues++;
+        } else if (strcmp(name, "queued") == 0) {
+            queued++;
+        }
+    }
+
+    // Submitting thread plus the workers that ran tasks
+    TEST_ASSERT(metadata >= 2, "Expected one buffer per recording thread");
+    TEST_ASSERT_EQUAL_INT(TRACE_TEST_TASKS, tasks);
+    TEST_ASSERT_EQUAL_INT(TRACE_TEST_TASKS, enqueues);
+    TEST_ASSERT_EQUAL_INT(TRACE_TEST_TASKS, queued);
+    TEST_ASSERT_EQUAL_INT(0, (int)trace_dropped_count());
+
+    json_decref(root);
+    return 1;
+}
@@ -0,0 +1,260 @@
+#include "test_common.h"
+#include "../include/uring.h"
+#include "../include/tcp_probe.h"
+#include "../include/checker.h"
+#include "mock_farm.h"
+#include <curl/curl.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+/**
+ * @brief Note that io_uring is not usable and the test is skipped
+ */
+static int skip_unavailable(void) {
+    printf(TEST_COLOR_YELLOW "  [SKIP] io_uring not available (kernel support or io_uring_disabled)" // flawfinder: ignore
+           TEST_COLOR_RESET "\n");
+    return 1;
+}
+
+static void count_result(Server *server, void *ctx) {
+    UNUSED(server);
+    (*(int*)ctx)++;
+}
+
+int test_uring_ring(void) {
+    if (!uring_available()) {
+        return skip_unavailable();
+    }
+
+    UringRing *ring = uring_create(8);
+    TEST_ASSERT_NOT_NULL(ring);
+    TEST_ASSERT(uring_cq_entries(ring) >= 8, "Completion queue too small");
+    TEST_ASSERT_EQUAL_INT(8, (int)uring_sq_space(ring));
+
+    // More SQEs than fit: the queue reports full until submitted
+    for (uint64_t i = 0; i < 8; i++) {
+        struct io_uring_sqe *sqe = uring_get_sqe(ring);
+        TEST_ASSERT_NOT_NULL(sqe);
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = i;
+    }
+    TEST_ASSERT(uring_get_sqe(ring) == NULL, "Full submission queue handed out an SQE");
+    TEST_ASSERT_EQUAL_INT(8, uring_submit(ring, 8));
+    TEST_ASSERT_EQUAL_INT(8, (int)uring_sq_space(ring));
+
+    struct io_uring_cqe cqe;
+    uint64_t seen = 0;
+    int completions = 0;
+    while (uring_peek_cqe(ring, &cqe)) {
+        TEST_ASSERT_EQUAL_INT(0, cqe.res);
+        seen |= 1ULL << cqe.user_data;
+        completions++;
+    }
+    TEST_ASSERT_EQUAL_INT(8, completions);
+    TEST_ASSERT(seen == 0xff, "Completion user_data mismatch");
+
+    uring_destroy(ring);
+    return 1;
+}
+
+int test_uring_http_head(void) {
+    if (!uring_available()) {
+        return skip_unavailable();
+    }
+
+    MockFarm *farm = mock_farm_start(5);
+    TEST_ASSERT_NOT_NULL(farm);
+
+    const MockHostProfile slow = { .behavior = MOCK_RESPOND, .status_code = 200, .latency_ms = 30.0 };
+    const MockHostProfile failing = { .behavior = MOCK_RESPOND, .status_code = 503 };
+    const MockHostProfile reset = { .behavior = MOCK_RESET };
+    const MockHostProfile blackhole = { .behavior = MOCK_BLACKHOLE };
+    const MockHostProfile redirect = { .behavior = MOCK_RESPOND, .status_code = 301 };
+    mock_farm_set_profile(farm, 0, &slow);
+    mock_farm_set_profile(farm, 1, &failing);
+    mock_farm_set_profile(farm, 2, &reset);
+    mock_farm_set_profile(farm, 3, &blackhole);
+    mock_farm_set_profile(farm, 4, &redirect);
+
+    ServerCategory category;
+    server_category_init(&category, CATEGORY_FTP, "FTP");
+    for (size_t i = 0; i < 5; i++) {
+        char url[MAX_URL_LENGTH]; /* flawfinder: ignore - bounds checked in mock_farm_url */
+        mock_farm_url(farm, i, url, sizeof(url));
+        TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, server_category_add(&category, url));
+    }
+    // Not plain HTTP: reported as an error instead of being probed
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, server_category_add(&category, "https://vh00000.mock.bdix/"));
+
+    Server *servers[6];
+    for (size_t i = 0; i < 6; i++) {
+        servers[i] = server_category_get(&category, i);
+    }
+
+    TcpProbeConfig config = tcp_probe_get_default_config();
+    config.mode = TCP_PROBE_HTTP_HEAD;
+    config.io_uring = true;
+    config.timeout_ms = 500;
+    config.response_timeout_ms = 300;
+    config.resolve = mock_farm_resolve_list(farm);
+
+    int results = 0;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, tcp_probe_servers(servers, 6, &config, count_result, &results));
+    curl_slist_free_all((struct curl_slist*)config.resolve);
+
+    TEST_ASSERT_EQUAL_INT(6, results);
+    const ServerStatus expected[] = {
+        BDIX_STATUS_ONLINE, BDIX_STATUS_OFFLINE, BDIX_STATUS_ERROR,
+        BDIX_STATUS_TIMEOUT, BDIX_STATUS_ONLINE, BDIX_STATUS_ERROR
+    };
+    for (size_t i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_INT(expected[i], servers[i]->status);
+    }
+    TEST_ASSERT_EQUAL_INT(200, (int)servers[0]->response_code);
+    TEST_ASSERT_EQUAL_INT(503, (int)servers[1]->response_code);
+    TEST_ASSERT_EQUAL_INT(301, (int)servers[4]->response_code);
+    TEST_ASSERT(servers[0]->timing.server_ms >= 30.0, "Host latency not attributed to the server phase");
+    TEST_ASSERT(servers[0]->latency_ms == servers[0]->timing.total_ms &&
+                servers[0]->timing.total_ms >= servers[0]->timing.connect_ms + servers[0]->timing.server_ms,
+                "Phases exceed total time");
+
+    // Every request reached the farm with the virtual host's Host header
+    TEST_ASSERT_EQUAL_INT(5, (int)atomic_load(&farm->requests));
+    TEST_ASSERT_EQUAL_INT(1, (int)atomic_load(&farm->blackholed));
+
+    server_category_free(&category);
+    mock_farm_stop(farm);
+    return 1;
+}
+
+/**
+ * @brief One-shot HTTP stand-in that sends its status line in two pieces
+ */
+typedef struct {
+    int listen_fd;
+} SplitStatusServer;
+
+static void* split_status_thread(void *arg) {
+    SplitStatusServer *srv = (SplitStatusServer*)arg;
+
+    int fd = accept(srv->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return NULL;
+    }
+    char request[MOCK_FARM_MAX_REQUEST]; /* flawfinder: ignore - bounded by sizeof(request) */
+    size_t length = 0;
+    while (length < sizeof(request) - 1) {
+        ssize_t n = recv(fd, request + length, sizeof(request) - 1 - length, 0); /* flawfinder: ignore */
+        if (n <= 0) {
+            break;
+        }
+        length += (size_t)n;
+        request[length] = '\0';
+        if (strstr(request, "\r\n\r\n")) {
+            break;
+        }
+    }
+
+    const char *head = "HTTP/1.1 2";
+    const char *tail = "04 No Content\r\nConnection: close\r\n\r\n";
+    send(fd, head, strlen(head), MSG_NOSIGNAL); // flawfinder: ignore
+    sleep_ms(30);
+    send(fd, tail, strlen(tail), MSG_NOSIGNAL); // flawfinder: ignore
+    close(fd);
+    return NULL;
+}
+
+int test_uring_split_status_line(void) {
+    if (!uring_available()) {
+        return skip_unavailable();
+    }
+
+    SplitStatusServer srv = { .listen_fd = socket(AF_INET, SOCK_STREAM, 0) };
+    TEST_ASSERT(srv.listen_fd >= 0, "Failed to create listen socket");
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    TEST_ASSERT(bind(srv.listen_fd, (struct sockaddr*)&addr, sizeof(addr)) == 0, "bind failed");
+    TEST_ASSERT(listen(srv.listen_fd, 1) == 0, "listen failed");
+    TEST_ASSERT(getsockname(srv.listen_fd, (struct sockaddr*)&addr, &len) == 0, "getsockname failed");
+
+    pthread_t thread;
+    TEST_ASSERT(pthread_create(&thread, NULL, split_status_thread, &srv) == 0, "thread failed");
+
+    ServerCategory category;
+    server_category_init(&category, CATEGORY_FTP, "FTP");
+    char url[MAX_URL_LENGTH]; /* flawfinder: ignore - bounds checked with snprintf */
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/", ntohs(addr.sin_port)); // flawfinder: ignore
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, server_category_add(&category, url));
+    Server *server = server_category_get(&category, 0);
+
+    TcpProbeConfig config = tcp_probe_get_default_config();
+    config.mode = TCP_PROBE_HTTP_HEAD;
+    config.io_uring = true;
+    config.timeout_ms = 500;
+    config.response_timeout_ms = 1000;
+
+    // The first piece alone is no status line: the probe must read on
+    int results = 0;
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, tcp_probe_servers(&server, 1, &config, count_result, &results));
+    pthread_join(thread, NULL);
+    close(srv.listen_fd);
+
+    TEST_ASSERT_EQUAL_INT(1, results);
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_ONLINE, server->status);
+    TEST_ASSERT_EQUAL_INT(204, (int)server->response_code);
+    TEST_ASSERT(server->timing.server_ms >= 30.0, "Second piece not waited for");
+
+    server_category_free(&category);
+    return 1;
+}
+
+int test_uring_checker(void) {
+    if (!uring_available()) {
+        return skip_unavailable();
+    }
+
+    MockFarm *farm = mock_farm_start(32);
+    TEST_ASSERT_NOT_NULL(farm);
+    const MockHostProfile failing = { .behavior = MOCK_RESPOND, .status_code = 503 };
+    mock_farm_set_profile(farm, 7, &failing);
+
+    ServerCategory category;
+    server_category_init(&category, CATEGORY_FTP, "FTP");
+    for (size_t i = 0; i < 32; i++) {
+        char url[MAX_URL_LENGTH]; /* flawfinder: ignore - bounds checked in mock_farm_url */
+        mock_farm_url(farm, i, url, sizeof(url));
+        server_category_add(&category, url);
+    }
+    // Left to the curl pool, which fails the TLS handshake against the farm
+    char url[MAX_URL_LENGTH]; /* flawfinder: ignore - bounds checked with snprintf */
+    snprintf(url, sizeof(url), "https://127.0.0.1:%d/", farm->port); // flawfinder: ignore
+    server_category_add(&category, url);
+
+    CheckerConfig config = checker_get_default_config();
+    config.io_uring = true;
+    config.verbose = false;
+    config.timeout_seconds = 2;
+    config.resolve = mock_farm_resolve_list(farm);
+    CheckerStats stats;
+    checker_stats_init(&stats);
+
+    TEST_ASSERT_EQUAL_INT(BDIX_SUCCESS, checker_check_category(&category, &config, 4, &stats));
+    TEST_ASSERT_EQUAL_INT(33, (int)atomic_load(&stats.total_checked));
+    TEST_ASSERT_EQUAL_INT(31, (int)atomic_load(&stats.online_count));
+    TEST_ASSERT_EQUAL_INT(1, (int)atomic_load(&stats.offline_count));
+    TEST_ASSERT_EQUAL_INT(BDIX_STATUS_OFFLINE, category.servers[7].status);
+    TEST_ASSERT(category.servers[31].metrics.count == 1, "Sample not recorded");
+
+    // Only the HTTPS server went through curl
+    TEST_ASSERT_EQUAL_INT(32, (int)atomic_load(&farm->requests));
+
+    curl_slist_free_all(config.resolve);
+    server_category_free(&category);
+    mock_farm_stop(farm);
+    return 1;
+}